@@ -0,0 +1,131 @@
+#include "frame_client.h"
+
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FrameRingReader::~FrameRingReader(){
+    this->Close();
+}
+
+bool FrameRingReader::Open(const std::string& name){
+    this->Close();
+
+#ifdef _WIN32
+    HANDLE m = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (m == NULL) return false;
+    void* v = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (v == nullptr || VirtualQuery(v, &info, sizeof(info)) == 0) {
+        if (v != nullptr) UnmapViewOfFile(v);
+        CloseHandle(m);
+        return false;
+    }
+    this->mapping = m;
+    this->base = static_cast<uint8_t*>(v);
+    this->size = info.RegionSize;
+#else
+    // a name with more than the leading slash is a file
+    bool isFile = name.find('/', 1) != std::string::npos;
+    int fd = isFile ? ::open(name.c_str(), O_RDWR) : shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FrameRingHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* v = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+    if (v == MAP_FAILED) return false;
+    this->base = static_cast<uint8_t*>(v);
+    this->size = static_cast<std::size_t>(st.st_size);
+#endif
+
+    FrameRingHeader* h = reinterpret_cast<FrameRingHeader*>(this->base);
+    uint32_t magic = std::atomic_ref<uint32_t>(h->magic).load(std::memory_order_acquire);
+    bool valid = magic == FRAME_RING_MAGIC && h->version == FRAME_RING_VERSION &&
+        h->headerSize >= sizeof(FrameRingHeader) && h->slotCount > 0 &&
+        h->slotSize >= sizeof(FrameSlotHeader) + uint64_t(h->maxWidth) * h->maxHeight * 4 &&
+        h->slotsOffset >= h->headerSize && h->slotsOffset % 64 == 0 && h->slotSize % 64 == 0 &&
+        h->slotsOffset + uint64_t(h->slotSize) * h->slotCount <= this->size;
+    if (!valid) {
+        this->Close();
+        return false;
+    }
+
+    this->header = h;
+    return true;
+}
+
+void FrameRingReader::Close(){
+    if (this->base == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(this->base);
+    CloseHandle(this->mapping);
+    this->mapping = nullptr;
+#else
+    munmap(this->base, this->size);
+#endif
+    this->base = nullptr;
+    this->header = nullptr;
+    this->size = 0;
+}
+
+uint64_t FrameRingReader::Latest(){
+    FrameRingHeader* h = reinterpret_cast<FrameRingHeader*>(this->base);
+    std::atomic_ref<uint64_t>(h->readerPolls).fetch_add(1, std::memory_order_relaxed);
+    return std::atomic_ref<uint64_t>(h->latest).load(std::memory_order_acquire);
+}
+
+bool FrameRingReader::Next(uint64_t last, FrameView& out){
+    uint64_t latest = this->Latest();
+    // the publisher restarting counts from 1 again, so anything other than
+    // last is new
+    if (latest == 0 || latest == last) return false;
+    return this->Acquire(latest, out);
+}
+
+FrameSlotHeader* FrameRingReader::slot(uint64_t number) const {
+    std::size_t index = static_cast<std::size_t>((number - 1) % this->header->slotCount);
+    return reinterpret_cast<FrameSlotHeader*>(this->base + this->header->slotsOffset + index * this->header->slotSize);
+}
+
+bool FrameRingReader::Acquire(uint64_t number, FrameView& out) const {
+    if (number == 0) return false;
+    FrameSlotHeader* s = this->slot(number);
+    std::atomic_ref<uint64_t> sequence(s->sequence);
+    if (sequence.load(std::memory_order_acquire) != 2 * number) return false;
+
+    out.number = number;
+    out.time = s->time;
+    out.width = s->width;
+    out.height = s->height;
+    out.stride = s->stride;
+    out.format = s->format;
+    out.sourceWidth = s->sourceWidth;
+    out.sourceHeight = s->sourceHeight;
+    out.motion = s->motion;
+    out.pixels = reinterpret_cast<const uint8_t*>(s) + sizeof(FrameSlotHeader);
+
+    // the fields above may be torn if the slot was reused meanwhile
+    if (!this->StillValid(out)) return false;
+    if (out.width > this->header->maxWidth || out.height > this->header->maxHeight || out.stride < out.width * 4 ||
+        uint64_t(out.stride) * out.height > this->header->slotSize - sizeof(FrameSlotHeader)) {
+        return false;
+    }
+    return true;
+}
+
+bool FrameRingReader::StillValid(const FrameView& frame) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::atomic_ref<uint64_t> sequence(this->slot(frame.number)->sequence);
+    return sequence.load(std::memory_order_relaxed) == 2 * frame.number;
+}
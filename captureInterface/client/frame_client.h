@@ -0,0 +1,71 @@
+#ifndef FRAME_CLIENT_H
+#define FRAME_CLIENT_H
+
+#include "frame_ring_format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A frame in the ring, pointing straight into the shared memory.
+struct FrameView {
+    uint64_t number = 0;
+    int64_t time = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    uint32_t format = 0;
+    uint32_t sourceWidth = 0;
+    uint32_t sourceHeight = 0;
+    float motion = 0.0f;
+    const uint8_t* pixels = nullptr;
+};
+
+// Reads frames from the capture interface's frame ring without locks or
+// copies. The publisher never waits for readers, so a frame can be
+// overwritten while it is used: check StillValid after reading the pixels
+// and drop whatever was computed from them if it fails. A slot is reused
+// FRAME_RING_SLOTS frames later, which gives a reader that many frame
+// times to finish with one.
+//
+// Builds on windows and on posix systems, without the rest of the
+// capture interface.
+class FrameRingReader {
+
+public:
+    FrameRingReader(){};
+    ~FrameRingReader();
+
+    // name is a mapping name on windows (FRAME_RING_MAPPING), elsewhere a
+    // shm_open name (FRAME_RING_SHM) or a file path
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const { return this->header != nullptr; };
+
+    // number of the newest complete frame, 0 if there is none yet. also
+    // tells the publisher a reader is there, it stops publishing when
+    // nobody polls.
+    uint64_t Latest();
+    // the newest frame if it is newer than last, false otherwise
+    bool Next(uint64_t last, FrameView& out);
+    // false if frame number isn't in the ring, either not written yet,
+    // being written or already overwritten
+    bool Acquire(uint64_t number, FrameView& out) const;
+    bool StillValid(const FrameView& frame) const;
+
+private:
+    const FrameRingHeader* header = nullptr;
+    uint8_t* base = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+
+    FrameSlotHeader* slot(uint64_t number) const;
+
+    // deleting the copy constructor to prevent copies
+    FrameRingReader(const FrameRingReader& obj) = delete;
+    void operator=(FrameRingReader const&) = delete;
+};
+
+#endif
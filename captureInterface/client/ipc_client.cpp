@@ -0,0 +1,162 @@
+#include "ipc_client.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+IpcClient::~IpcClient(){
+    this->Close();
+}
+
+bool IpcClient::Connect(const std::string& name){
+    this->Close();
+
+#ifdef _WIN32
+    while (true) {
+        HANDLE h = CreateFileA(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+        if (h != INVALID_HANDLE_VALUE) {
+            this->pipe = h;
+            break;
+        }
+        // every instance is taken until the server creates the next one
+        if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeA(name.c_str(), 2000)) return false;
+    }
+#else
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (name.size() >= sizeof(addr.sun_path)) return false;
+    name.copy(addr.sun_path, name.size());
+
+    int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s < 0) return false;
+    if (::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(s);
+        return false;
+    }
+    this->fd = s;
+#endif
+    return true;
+}
+
+void IpcClient::Close(){
+#ifdef _WIN32
+    if (this->pipe != nullptr) CloseHandle(this->pipe);
+    this->pipe = nullptr;
+#else
+    if (this->fd >= 0) ::close(this->fd);
+    this->fd = -1;
+#endif
+    this->out.clear();
+    this->in.clear();
+    this->inPos = 0;
+}
+
+bool IpcClient::IsOpen() const {
+#ifdef _WIN32
+    return this->pipe != nullptr;
+#else
+    return this->fd >= 0;
+#endif
+}
+
+std::size_t IpcClient::read(char* buf, std::size_t n){
+#ifdef _WIN32
+    DWORD got = 0;
+    if (!ReadFile(this->pipe, buf, static_cast<DWORD>(n), &got, NULL)) return 0;
+    return got;
+#else
+    while (true) {
+        ssize_t got = ::read(this->fd, buf, n);
+        if (got >= 0) return static_cast<std::size_t>(got);
+        if (errno != EINTR) return 0;
+    }
+#endif
+}
+
+bool IpcClient::write(const char* buf, std::size_t n){
+    while (n > 0) {
+#ifdef _WIN32
+        DWORD put = 0;
+        if (!WriteFile(this->pipe, buf, static_cast<DWORD>(n), &put, NULL)) return false;
+#else
+        ssize_t put = ::send(this->fd, buf, n, MSG_NOSIGNAL);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+#endif
+        buf += put;
+        n -= static_cast<std::size_t>(put);
+    }
+    return true;
+}
+
+uint32_t IpcClient::Queue(uint16_t type, std::string_view payload){
+    uint32_t id = this->nextId++;
+    // 0 is for pushes
+    if (this->nextId == 0) this->nextId = 1;
+    IpcFrame(this->out, id, type, 0, payload);
+    return id;
+}
+
+bool IpcClient::Flush(){
+    if (!this->IsOpen()) return false;
+    bool ok = this->write(this->out.data(), this->out.size());
+    this->out.clear();
+    return ok;
+}
+
+uint32_t IpcClient::Send(uint16_t type, std::string_view payload){
+    uint32_t id = this->Queue(type, payload);
+    return this->Flush() ? id : 0;
+}
+
+bool IpcClient::Receive(IpcMessage& out){
+    char chunk[64 * 1024];
+
+    while (this->IsOpen()) {
+        std::size_t available = this->in.size() - this->inPos;
+        if (available >= sizeof(uint32_t)) {
+            uint32_t length;
+            std::memcpy(&length, this->in.data() + this->inPos, sizeof(length));
+            if (length < sizeof(IpcHeader) || length > IPC_MAX_MESSAGE) {
+                this->Close();
+                return false;
+            }
+            if (available - sizeof(uint32_t) >= length) {
+                const char* body = this->in.data() + this->inPos + sizeof(uint32_t);
+                std::memcpy(&out.header, body, sizeof(IpcHeader));
+                out.payload.assign(body + sizeof(IpcHeader), length - sizeof(IpcHeader));
+                this->inPos += sizeof(uint32_t) + length;
+                return true;
+            }
+        }
+
+        // drop the parsed messages before reading more
+        this->in.erase(0, this->inPos);
+        this->inPos = 0;
+        std::size_t n = this->read(chunk, sizeof(chunk));
+        if (n == 0) {
+            this->Close();
+            return false;
+        }
+        this->in.append(chunk, n);
+    }
+    return false;
+}
+
+bool IpcClient::Call(uint16_t type, std::string_view payload, IpcMessage& out, void (*pushes)(const IpcMessage&)){
+    uint32_t id = this->Send(type, payload);
+    if (id == 0) return false;
+
+    while (this->Receive(out)) {
+        if (out.header.id == id) return true;
+        if (out.header.id == 0 && pushes != nullptr) pushes(out);
+    }
+    return false;
+}
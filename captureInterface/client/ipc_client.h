@@ -0,0 +1,70 @@
+#ifndef IPC_CLIENT_H
+#define IPC_CLIENT_H
+
+#include "ipc_protocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// A response or a push (id 0) from the capture interface.
+struct IpcMessage {
+    IpcHeader header{};
+    std::string payload;
+
+    IpcReader Reader() const { return IpcReader(payload.data(), payload.size()); };
+};
+
+// Client of the capture interface's local API, see ipc_protocol.h.
+//
+// Queue only buffers a request, Flush writes everything queued in one go,
+// so a batch of pipelined requests costs one write. Responses come back in
+// the order the requests were sent. Not thread safe, one thread sends and
+// receives.
+//
+// Builds on windows and on posix systems, without the rest of the
+// capture interface.
+class IpcClient {
+
+public:
+    IpcClient(){};
+    ~IpcClient();
+
+    // name is a pipe name on windows, a socket path elsewhere
+    bool Connect(const std::string& name);
+    void Close();
+    bool IsOpen() const;
+
+    // returns the request id
+    uint32_t Queue(uint16_t type, std::string_view payload);
+    bool Flush();
+    // Queue and Flush, 0 if the write failed
+    uint32_t Send(uint16_t type, std::string_view payload);
+
+    // waits for the next message, false once the connection is closed
+    bool Receive(IpcMessage& out);
+    // sends a request and waits for its response. responses to earlier
+    // requests are dropped, pushes are dropped unless pushes is given.
+    bool Call(uint16_t type, std::string_view payload, IpcMessage& out, void (*pushes)(const IpcMessage&) = nullptr);
+
+private:
+#ifdef _WIN32
+    void* pipe = nullptr;
+#else
+    int fd = -1;
+#endif
+    uint32_t nextId = 1;
+    std::string out;
+    std::string in;
+    std::size_t inPos = 0;
+
+    std::size_t read(char* buf, std::size_t n);
+    bool write(const char* buf, std::size_t n);
+
+    // deleting the copy constructor to prevent copies
+    IpcClient(const IpcClient& obj) = delete;
+    void operator=(IpcClient const&) = delete;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "preview_client.h"
+
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+PreviewReader::~PreviewReader(){
+    this->Close();
+}
+
+bool PreviewReader::Open(const std::string& name){
+    this->Close();
+
+#ifdef _WIN32
+    HANDLE m = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (m == NULL) return false;
+    void* v = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (v == nullptr || VirtualQuery(v, &info, sizeof(info)) == 0) {
+        if (v != nullptr) UnmapViewOfFile(v);
+        CloseHandle(m);
+        return false;
+    }
+    this->mapping = m;
+    this->base = static_cast<uint8_t*>(v);
+    this->size = info.RegionSize;
+#else
+    // a name with more than the leading slash is a file
+    bool isFile = name.find('/', 1) != std::string::npos;
+    int fd = isFile ? ::open(name.c_str(), O_RDWR) : shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(PreviewHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* v = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+    if (v == MAP_FAILED) return false;
+    this->base = static_cast<uint8_t*>(v);
+    this->size = static_cast<std::size_t>(st.st_size);
+#endif
+
+    PreviewHeader* h = reinterpret_cast<PreviewHeader*>(this->base);
+    uint32_t magic = std::atomic_ref<uint32_t>(h->magic).load(std::memory_order_acquire);
+    bool valid = magic == PREVIEW_MAGIC && h->version == PREVIEW_VERSION &&
+        h->headerSize >= sizeof(PreviewHeader) && h->bufferCount == PREVIEW_BUFFERS &&
+        h->bufferSize >= sizeof(PreviewFrameHeader) + uint64_t(h->maxWidth) * h->maxHeight * 4 &&
+        h->buffersOffset >= h->headerSize && h->buffersOffset % 64 == 0 && h->bufferSize % 64 == 0 &&
+        h->buffersOffset + uint64_t(h->bufferSize) * h->bufferCount <= this->size;
+    if (!valid) {
+        this->Close();
+        return false;
+    }
+
+    this->header = h;
+    return true;
+}
+
+void PreviewReader::Close(){
+    if (this->base == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(this->base);
+    CloseHandle(this->mapping);
+    this->mapping = nullptr;
+#else
+    munmap(this->base, this->size);
+#endif
+    this->base = nullptr;
+    this->header = nullptr;
+    this->size = 0;
+}
+
+bool PreviewReader::Acquire(PreviewView& out){
+    std::atomic_ref<uint64_t>(this->header->readerPolls).fetch_add(1, std::memory_order_relaxed);
+
+    // swap the newest buffer in if there is a fresh one, the publisher
+    // moves on to the buffer we give up
+    std::atomic_ref<uint32_t> state(this->header->state);
+    uint32_t current = state.load(std::memory_order_acquire);
+    while (PreviewFresh(current)) {
+        uint32_t next = PreviewState(PreviewLatest(current), PreviewLatest(current), false);
+        if (state.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            current = next;
+            break;
+        }
+    }
+
+    uint32_t index = PreviewReading(current);
+    if (index >= this->header->bufferCount) return false;
+
+    const uint8_t* b = this->base + this->header->buffersOffset + std::size_t(index) * this->header->bufferSize;
+    const PreviewFrameHeader* f = reinterpret_cast<const PreviewFrameHeader*>(b);
+    if (f->width > this->header->maxWidth || f->height > this->header->maxHeight || f->stride < f->width * 4 ||
+        uint64_t(f->stride) * f->height > this->header->bufferSize - sizeof(PreviewFrameHeader)) {
+        return false;
+    }
+
+    out.number = f->number;
+    out.time = f->time;
+    out.width = f->width;
+    out.height = f->height;
+    out.stride = f->stride;
+    out.format = f->format;
+    out.sourceWidth = f->sourceWidth;
+    out.sourceHeight = f->sourceHeight;
+    out.pixels = b + sizeof(PreviewFrameHeader);
+    return true;
+}
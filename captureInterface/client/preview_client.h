@@ -0,0 +1,60 @@
+#ifndef PREVIEW_CLIENT_H
+#define PREVIEW_CLIENT_H
+
+#include "preview_format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A preview frame, pointing straight into the shared memory.
+struct PreviewView {
+    uint64_t number = 0;
+    int64_t time = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    uint32_t format = 0;
+    uint32_t sourceWidth = 0;
+    uint32_t sourceHeight = 0;
+    const uint8_t* pixels = nullptr;
+};
+
+// Reads the capture interface's live preview without locks or copies. The
+// frame from Acquire belongs to the reader until the next Acquire, the
+// publisher writes around it. Only one reader per preview, a second one
+// would take frames out from under the first.
+//
+// Builds on windows and on posix systems, without the rest of the
+// capture interface.
+class PreviewReader {
+
+public:
+    PreviewReader(){};
+    ~PreviewReader();
+
+    // name is a mapping name on windows (PREVIEW_MAPPING), elsewhere a
+    // shm_open name (PREVIEW_SHM) or a file path
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const { return this->header != nullptr; };
+
+    // takes the newest frame, the one already held if nothing newer was
+    // published. false before the first frame. also tells the publisher a
+    // reader is there, it stops publishing when nobody polls.
+    bool Acquire(PreviewView& out);
+
+private:
+    PreviewHeader* header = nullptr;
+    uint8_t* base = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+
+    // deleting the copy constructor to prevent copies
+    PreviewReader(const PreviewReader& obj) = delete;
+    void operator=(PreviewReader const&) = delete;
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#include "win_types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// posted to subscribed threads after a new config has been published (WM_APP + 1)
+static const UINT WM_CONFIG_CHANGED = 0x8000 + 1;
+
+enum CaptureQuality {
+    QUALITY_LOW,
+    QUALITY_MEDIUM,
+    QUALITY_HIGH
+};
+
+// ids match the hotkey ids handled by the event loop
+enum HotkeyId {
+    HOTKEY_QUIT = 1,
+    HOTKEY_START_CAPTURE = 2,
+    HOTKEY_STOP_CAPTURE = 3,
+    HOTKEY_LOG_PROCESSES = 4,
+    HOTKEY_BUILD_REEL = 5,
+    HOTKEY_COUNT = 5
+};
+
+struct Hotkey {
+    UINT modifiers;
+    UINT vk;
+};
+
+struct CropRect {
+    int x = 0;
+    int y = 0;
+    // zero width or height means no cropping
+    int width = 0;
+    int height = 0;
+};
+
+// Capture settings applied while a particular game is being captured.
+struct CaptureProfile {
+    std::string name = "default";
+    int fps = 60;
+    int width = 1920;
+    int height = 1080;
+    int bitrateKbps = 12000;
+    CropRect crop;
+    int replaySeconds = 30;
+};
+
+// Parsed settings. Published once and never modified, a reload publishes a
+// new one with a higher version.
+struct AppConfig {
+    uint64_t version = 0;
+
+    int captureSeconds = 30;
+    CaptureQuality quality = QUALITY_HIGH;
+    bool audio = true;
+
+    // indexed by HotkeyId - 1
+    Hotkey hotkeys[HOTKEY_COUNT] = {
+        { 0x0001, 'Q' }, // MOD_ALT
+        { 0x0001, 'R' },
+        { 0x0001, 'E' },
+        { 0x0001, 'W' },
+        { 0x0001, 'H' },
+    };
+
+    // [profile.<name>] sections, always holds a profile named "default"
+    std::vector<CaptureProfile> profiles = { CaptureProfile() };
+    // [games] section, lower case executable name to profile name
+    std::unordered_map<std::string, std::string> gameProfiles;
+
+    // shared memory frame ring for out of process plugins, see frame_ring.h
+    bool frameRing = true;
+    // empty for the named mapping
+    std::string frameRingFile;
+
+    // live preview for the gui, see preview.h
+    bool preview = true;
+    // empty for the named mapping
+    std::string previewFile;
+    int previewFps = 10;
+    // at most, frames are shrunk by whole factors
+    int previewHeight = 360;
+
+    // local api for the gui, see ipc_server.h
+    bool ipc = true;
+    // empty for IPC_DEFAULT_NAME
+    std::string ipcName;
+
+    // highlight reels, see reel_builder.h
+    int reelCount = 5;
+    bool reelPrecise = false;
+    std::string ffmpegPath = "ffmpeg";
+
+    // compress finished log segments, see log_sink.h
+    bool logCompress = false;
+
+    std::string pluginDirectory = "plugins";
+    // budget of a single plugin callback
+    int pluginInstructions = 1000000;
+    int pluginTimeMs = 5;
+    // a plugin overrunning its budget PluginHost::MAX_OVERRUNS times within
+    // this many seconds is disabled
+    int pluginOverrunWindowS = 60;
+
+    const Hotkey& GetHotkey(HotkeyId id) const { return hotkeys[id - 1]; };
+    // returns nullptr if there is no profile with that name
+    const CaptureProfile* FindProfile(std::string_view name) const {
+        for (const CaptureProfile& p: profiles) {
+            if (p.name == name) return &p;
+        }
+        return nullptr;
+    };
+};
+
+// Owns the config file. Hot paths read settings through Current(), a single
+// atomic load of a pointer to an immutable config, no locks or string
+// lookups. Replaced configs are kept alive until exit, so a pointer obtained
+// from Current() can be cached and stays valid.
+//
+// File format is `key = value` lines with '#' comments and optional
+// `[section]` headers, which prefix the keys that follow with `section.`.
+class ConfigStore {
+
+public:
+    static ConfigStore& Instance();
+
+    // parses the file and publishes it. false if it can't be read, the
+    // current config (the defaults before the first load) stays published.
+    // settings with an invalid value are logged and keep their default
+    bool Load(const std::string& filename);
+    // parses the loaded file again, keeps the current config if it can't be read
+    bool Reload();
+
+    const AppConfig* Current() const { return this->current.load(std::memory_order_acquire); };
+    const std::string& Filename() const { return this->filename; };
+
+    // threads that get WM_CONFIG_CHANGED after every reload
+    void Subscribe(DWORD threadId);
+
+private:
+    std::atomic<const AppConfig*> current{nullptr};
+    std::vector<std::unique_ptr<AppConfig>> published;
+    std::vector<DWORD> subscribers;
+    std::string filename;
+    std::mutex mutex;
+
+    bool parse(AppConfig& config);
+    void publish(std::unique_ptr<AppConfig> config);
+
+    ConfigStore();
+
+    // deleting the copy constructor to prevent copies
+    ConfigStore(const ConfigStore& obj) = delete;
+    void operator=(ConfigStore const&) = delete;
+};
+
+static ConfigStore& CONFIG = ConfigStore::Instance();
+
+#endif
@@ -1,27 +1,70 @@
 #ifndef APPLICATION_DATA_H
 #define APPLICATION_DATA_H
 
+#include "win_types.h"
+
+#include <atomic>
+#include <cstdint>
 #include <mutex>
-#include <string>
-#include <windef.h>
+#include <string_view>
+#include <type_traits>
+
+enum CaptureState {
+    CAPTURE_IDLE,
+    CAPTURE_RECORDING
+};
+
+// Immutable copy of the application state. Fixed size so it can be copied
+// out of the seqlock without allocating.
+struct AppState {
+    uint64_t version;
+    HWND gameWin;
+    CaptureState captureState;
+    uint32_t titleLength;
+    uint32_t profileLength;
+    char title[256];
+    char profile[64];
+
+    std::string_view Title() const { return std::string_view(title, titleLength); };
+    std::string_view Profile() const { return std::string_view(profile, profileLength); };
+};
 
 class AppData {
 
 public:
     static AppData& Instance();
-    void SetGameWin(HWND hwnd, std::string title);
-    std::pair<HWND, std::string> GetCurrentGameWin();
+
+    // readers never lock or allocate, they only retry when a write lands
+    // while they are copying
+    AppState Snapshot() const;
+
+    // titles and profiles longer than AppState holds are cut at a utf-8
+    // code point boundary
+    void SetGameWin(HWND hwnd, std::string_view title);
+    void SetCaptureState(CaptureState state);
+    void SetProfile(std::string_view profile);
 
 private:
     // Static pointer to the Singleton instance
     static AppData* instancePtr;
     static std::mutex instMutex;
 
-    std::pair<HWND, std::string> currentGameWin;
+    static_assert(std::is_trivially_copyable_v<AppState>);
+    static constexpr std::size_t STATE_WORDS = (sizeof(AppState) + 7) / 8;
+
+    // seqlock, odd while a write is in progress. the state is stored as
+    // atomic words so readers racing a writer are well defined
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> words[STATE_WORDS] = {};
+    // serialises writers
+    std::mutex writeMutex;
 
     bool hasInit = false;
 
     AppData(){};
+
+    template <typename F>
+    void update(F change);
     
     // deleting the copy constructor to prevent copies
     AppData(const AppData& obj) = delete;
@@ -0,0 +1,60 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// The last few seconds of captured audio as interleaved float samples. The
+// audio capture writes into it, detectors copy out frames by their absolute
+// position since Configure, so a slow reader can tell when it fell behind.
+class AudioRing {
+
+public:
+    static AudioRing& Instance();
+
+    // drops everything written so far
+    void Configure(uint32_t sampleRate, uint32_t channels, uint32_t seconds);
+    void Write(const float* samples, std::size_t frames);
+
+    // copies up to frames frames starting at frame start, returns how many
+    // were copied. starts that were already overwritten are moved up to the
+    // oldest frame still held, check the returned start.
+    std::size_t Read(uint64_t& start, float* out, std::size_t frames) const;
+    // blocks until frames past frame have been written, the ring is
+    // configured again or the timeout passes
+    bool Wait(uint64_t frame, std::chrono::milliseconds timeout);
+
+    uint64_t Written() const;
+    // counts Configure calls, frame positions of an older generation mean
+    // nothing in the current one
+    uint64_t Generation() const;
+    uint32_t SampleRate() const;
+    uint32_t Channels() const;
+    // steady clock time of a frame, in microseconds
+    int64_t TimeOf(uint64_t frame) const;
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<float> samples;
+    uint32_t sampleRate = 48000;
+    uint32_t channels = 2;
+    std::size_t capacity = 0;
+    uint64_t written = 0;
+    uint64_t generation = 0;
+    int64_t startTime = 0;
+
+    AudioRing(){};
+
+    // deleting the copy constructor to prevent copies
+    AudioRing(const AudioRing& obj) = delete;
+    void operator=(AudioRing const&) = delete;
+};
+
+static AudioRing& AUDIORING = AudioRing::Instance();
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef CAPTURE_PROFILES_H
+#define CAPTURE_PROFILES_H
+
+#include "app_config.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Buffers the capture pipeline needs for a profile, allocated and touched up
+// front so switching to them doesn't fault in pages mid capture.
+struct PipelineResources {
+    CaptureProfile profile;
+    std::vector<std::vector<uint8_t>> framePool;
+};
+
+struct ProfileSwitchStats {
+    uint64_t switches;
+    uint64_t lastMicros;
+    uint64_t maxMicros;
+};
+
+// Chooses the capture profile of the current game and owns the pipeline
+// resources of the active profile. Resources for a profile are prepared on
+// the task handler as soon as a game is known (at launch or detection), so
+// activating it is a pointer swap.
+//
+// Readers hold the resources they use through the shared pointer Active()
+// returns, copying it takes a lock of its own that is only held for the
+// reference count increment. Replaced resources are kept on a retired list and freed by Build
+// or Activate once no reader holds them, so the capture thread doesn't end
+// up freeing them. Past MAX_RETIRED the oldest are let go anyway and the
+// last reader frees them.
+class ProfileManager {
+
+public:
+    static ProfileManager& Instance();
+
+    // [games] override from the config, then the games database default,
+    // then the "default" profile
+    CaptureProfile Resolve(std::string_view exeName);
+
+    // queues background allocation of the profile for exeName
+    void Prepare(std::string_view exeName);
+    // switches the active profile, allocating inline if it wasn't prepared
+    void Activate(std::string_view exeName);
+
+    // only called by the PrepareProfile task
+    void Build(const CaptureProfile& profile);
+
+    // null until the first Activate
+    std::shared_ptr<const PipelineResources> Active() const;
+    ProfileSwitchStats Stats() const;
+    std::size_t Retired();
+
+private:
+    static constexpr int POOL_FRAMES = 4;
+    static constexpr std::size_t MAX_RETIRED = 4;
+
+    using Resources = std::shared_ptr<const PipelineResources>;
+
+    std::mutex mutex;
+    Resources prepared;
+    std::vector<Resources> retired;
+    // not the main mutex, readers never wait for a Build or Activate
+    mutable std::mutex activeMutex;
+    Resources active;
+
+    std::atomic<uint64_t> switches{0};
+    std::atomic<uint64_t> lastMicros{0};
+    std::atomic<uint64_t> maxMicros{0};
+
+    static Resources allocate(const CaptureProfile& profile);
+    // returns the replaced resources
+    Resources swapActive(Resources next);
+    // moves retired resources no reader holds into release, and the oldest
+    // past MAX_RETIRED. needs the lock, release is freed without it
+    void reclaim(std::vector<Resources>& release);
+
+    ProfileManager(){};
+
+    // deleting the copy constructor to prevent copies
+    ProfileManager(const ProfileManager& obj) = delete;
+    void operator=(ProfileManager const&) = delete;
+};
+
+static ProfileManager& PROFILES = ProfileManager::Instance();
+
+#endif
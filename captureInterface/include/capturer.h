@@ -11,6 +11,8 @@ public:
     static Capturer& Instance();
     bool Init();
     void Capture();
+    // called when a game process starts, before it has a window
+    void Prepare();
 
     void StartCapture();
     void EndCapture();
@@ -0,0 +1,117 @@
+#ifndef CLIP_LIBRARY_H
+#define CLIP_LIBRARY_H
+
+#include "trigram_index.h"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct ClipRecord {
+    uint64_t id;
+    // seconds since the unix epoch
+    int64_t timestamp;
+    uint32_t durationMs;
+    std::string game;
+    std::string title;
+    std::string path;
+    // lowercase and sorted
+    std::vector<std::string> tags;
+};
+
+struct ClipFilter {
+    // empty matches every game
+    std::string game;
+    int64_t from = INT64_MIN;
+    int64_t to = INT64_MAX;
+    // a clip has to carry every tag
+    std::vector<std::string> tags;
+    std::size_t limit = 100;
+};
+
+// Local index of saved clips. Every change is appended to a log file and the
+// in memory indexes are rebuilt by replaying it on startup. A bad record at
+// the end of the log (crash mid write) is truncated away, one that is
+// followed by good records is skipped and the log compacted.
+//
+// Clips are kept in time order, with per game and per tag lists that are
+// also time ordered, so a filtered listing walks the smallest matching list
+// backwards from the end of the time range.
+class ClipLibrary {
+
+public:
+    static ClipLibrary& Instance();
+
+    bool Open(const std::string& filename);
+    // forgets the clips as well, Open replays them again
+    void Close();
+
+    // returns the id given to the clip, 0 if it couldn't be written
+    uint64_t Add(ClipRecord clip);
+    bool Remove(uint64_t id);
+    bool SetTags(uint64_t id, std::vector<std::string> tags);
+
+    // newest first
+    std::vector<ClipRecord> List(const ClipFilter& filter) const;
+    // typo tolerant search over titles, game names and tags
+    std::vector<ClipRecord> Search(std::string_view query, std::size_t limit) const;
+    std::vector<std::string> Games() const;
+    bool Find(uint64_t id, ClipRecord& out) const;
+    std::size_t Size() const;
+
+    // adds the clips of every sidecar in directory that aren't in the
+    // library yet, returns how many were added
+    std::size_t Import(const std::string& directory);
+
+    // rewrites the log with only the live clips
+    bool Compact();
+
+private:
+    // slots into clips, ordered by (timestamp, id)
+    using SlotList = std::vector<uint32_t>;
+
+    mutable std::shared_mutex mutex;
+    std::string filename;
+    std::ofstream log;
+    uint64_t nextId = 1;
+    // log records that no longer describe a live clip
+    std::size_t garbage = 0;
+
+    std::vector<ClipRecord> clips;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<uint64_t, uint32_t> byId;
+    SlotList byTime;
+    std::map<std::string, SlotList, std::less<>> byGame;
+    std::map<std::string, SlotList, std::less<>> byTag;
+    TrigramIndex text;
+
+    // false if the log ends in a bad record, valid is where it starts.
+    // skipped counts the bytes of damaged records before it
+    bool replay(const std::string& data, std::size_t& valid, std::size_t& skipped);
+    // applies the record at data, returns its size or 0 if it's torn or corrupt
+    std::size_t replayRecord(const char* data, std::size_t size);
+    bool append(const std::string& record);
+
+    void insert(ClipRecord clip);
+    void erase(uint32_t slot);
+    void retag(uint32_t slot, std::vector<std::string> tags);
+    void insertSorted(SlotList& list, uint32_t slot);
+    void eraseSorted(SlotList& list, uint32_t slot);
+    void indexText(const ClipRecord& clip);
+    bool before(uint32_t a, uint32_t b) const;
+    bool matches(const ClipRecord& clip, const SlotList* gameList, uint32_t slot, const std::vector<std::string>& tags) const;
+
+    ClipLibrary(){};
+
+    // deleting the copy constructor to prevent copies
+    ClipLibrary(const ClipLibrary& obj) = delete;
+    void operator=(ClipLibrary const&) = delete;
+};
+
+static ClipLibrary& CLIPLIB = ClipLibrary::Instance();
+
+#endif
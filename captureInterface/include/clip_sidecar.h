@@ -0,0 +1,75 @@
+#ifndef CLIP_SIDECAR_H
+#define CLIP_SIDECAR_H
+
+#include "clip_sidecar_format.h"
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Everything a sidecar holds, used to write one.
+struct ClipMetadata {
+    int64_t timestamp = 0;
+    uint32_t durationMs = 0;
+    uint32_t fps = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bitrateKbps = 0;
+    uint32_t gameId = 0;
+    ClipUploadState uploadState = UPLOAD_NONE;
+    uint32_t uploadProgress = 0;
+    std::string game;
+    std::string title;
+    std::string uploadUrl;
+    std::vector<ClipSidecarKeyframe> keyframes;
+    std::vector<ClipSidecarMarker> markers;
+};
+
+// Read only view of a clip's metadata sidecar. Opening maps the file and
+// checks that every section and string lies inside it, after that the
+// accessors read straight from the mapping.
+class ClipSidecar {
+
+public:
+    ClipSidecar(){};
+
+    bool Open(const std::string& filename);
+    void Close();
+    // checks and views a sidecar already in memory, data has to stay valid
+    // and 8 byte aligned while the view is used
+    bool View(const uint8_t* data, std::size_t size);
+    bool IsOpen() const { return this->header != nullptr; };
+
+    const ClipSidecarHeader& Header() const { return *this->header; };
+    std::string_view Game() const;
+    std::string_view Title() const;
+    std::string_view UploadUrl() const;
+    std::span<const ClipSidecarKeyframe> Keyframes() const;
+    std::span<const ClipSidecarMarker> Markers() const;
+    // last keyframe at or before time, nullptr if there is none
+    const ClipSidecarKeyframe* KeyframeBefore(int64_t time) const;
+
+    // the sidecar of a video lives next to it
+    static std::string PathFor(std::string_view videoPath);
+    static std::string Encode(const ClipMetadata& metadata);
+    // written to a temporary file first, so readers never see half a sidecar
+    static bool Write(const std::string& filename, const ClipMetadata& metadata);
+    static bool SetUploadState(const std::string& filename, ClipUploadState state, uint32_t progress);
+
+private:
+    MappedFile file;
+    const ClipSidecarHeader* header = nullptr;
+    const uint8_t* base = nullptr;
+
+    std::string_view string(uint32_t offset, uint32_t length) const;
+
+    // deleting the copy constructor to prevent copies
+    ClipSidecar(const ClipSidecar& obj) = delete;
+    void operator=(ClipSidecar const&) = delete;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef CLIP_SIDECAR_FORMAT_H
+#define CLIP_SIDECAR_FORMAT_H
+
+#include <cstdint>
+
+// On disk layout of a clip's metadata sidecar (<video>.msc), written by
+// ClipSidecar::Write and read in place through a memory mapping.
+//
+//     ClipSidecarHeader
+//     ClipSidecarKeyframe keyframes[keyframeCount]   sorted by time
+//     ClipSidecarMarker markers[markerCount]         sorted by time
+//     char strings[stringsSize]                      game, title and upload url
+//
+// Sections start on 8 byte boundaries. Readers accept any header with the
+// same major version and a headerSize of at least their own header, so
+// fields can be appended to the header without breaking older readers.
+// uploadState and uploadProgress sit at fixed offsets and are updated in
+// place while a clip uploads.
+// All integers are little endian.
+
+#define SIDECAR_MAGIC 0x4353534d // "MSSC"
+#define SIDECAR_VERSION_MAJOR 1
+#define SIDECAR_VERSION_MINOR 0
+
+enum ClipUploadState : uint32_t {
+    UPLOAD_NONE = 0,
+    UPLOAD_PENDING = 1,
+    UPLOAD_RUNNING = 2,
+    UPLOAD_DONE = 3,
+    UPLOAD_FAILED = 4,
+};
+
+enum ClipMarkerKind : uint32_t {
+    MARKER_MANUAL = 0,
+    MARKER_AUDIO = 1,
+    MARKER_MOTION = 2,
+    MARKER_TEMPLATE = 3,
+    MARKER_PLUGIN = 4,
+};
+
+struct ClipSidecarHeader {
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint32_t headerSize;
+    uint32_t fileSize;
+
+    // seconds since the unix epoch
+    int64_t timestamp;
+    uint32_t durationMs;
+    uint32_t fps;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bitrateKbps;
+    uint32_t gameId;
+
+    uint32_t uploadState;
+    // permille
+    uint32_t uploadProgress;
+
+    uint32_t keyframesOffset;
+    uint32_t keyframeCount;
+    uint32_t markersOffset;
+    uint32_t markerCount;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+
+    uint32_t gameOffset;
+    uint32_t gameLength;
+    uint32_t titleOffset;
+    uint32_t titleLength;
+    uint32_t uploadUrlOffset;
+    uint32_t uploadUrlLength;
+};
+
+struct ClipSidecarKeyframe {
+    // microseconds from the start of the clip
+    int64_t time;
+    // byte offset of the keyframe's packet in the video file
+    uint64_t fileOffset;
+};
+
+struct ClipSidecarMarker {
+    // microseconds from the start of the clip
+    int64_t time;
+    uint32_t durationMs;
+    uint32_t kind;
+    float score;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ClipSidecarHeader) == 104, "sidecar header layout changed");
+static_assert(sizeof(ClipSidecarKeyframe) == 16, "sidecar keyframe layout changed");
+static_assert(sizeof(ClipSidecarMarker) == 24, "sidecar marker layout changed");
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef DOWNSCALE_H
+#define DOWNSCALE_H
+
+#include <cstdint>
+#include <vector>
+
+// working memory of the downscalers, kept by the caller across frames so
+// a frame doesn't allocate. grows to the widest frame it has seen.
+struct DownscaleScratch {
+    std::vector<uint16_t> sums;
+    std::vector<uint32_t> lumaSums;
+};
+
+// smallest integer factor that shrinks width x height to fit maxWidth x maxHeight
+uint32_t DownscaleFactor(uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight);
+
+// averages every factor x factor block of a BGRA frame into one BGRA pixel.
+// out holds (height / factor) rows of (width / factor) pixels, partial
+// blocks at the right and bottom edges are left out. factor is 1 to 16.
+void DownscaleBgra(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t factor, uint8_t* out, uint32_t outStride, DownscaleScratch& scratch);
+
+// averages every factor x factor block of a BGRA frame into one luma byte
+// (BT.601 weights). luma holds (width / factor) * (height / factor) bytes,
+// partial blocks are left out the same way. factor is 1 to 16.
+void DownscaleLuma(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t factor, uint8_t* luma, DownscaleScratch& scratch);
+
+#endif
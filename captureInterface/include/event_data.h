@@ -4,9 +4,12 @@
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <string_view>
 
 enum EventType {
-    HOTKEY
+    HOTKEY,
+    GAME_LAUNCH,
+    TEMPLATE_MATCH
 };
 
 struct HotKeyData {
@@ -14,8 +17,22 @@ struct HotKeyData {
     int vks;
 };
 
+struct ProcessData {
+    unsigned long pid;
+};
+
+struct TemplateMatchData {
+    // index into the loaded templates, see TemplateMatcher::Name
+    int index;
+    float score;
+    // steady clock time of the frame in microseconds
+    long long time;
+};
+
 union EventData{
     HotKeyData hotkeyData;
+    ProcessData processData;
+    TemplateMatchData templateMatchData;
 };
 
 class Event {
@@ -23,11 +40,17 @@ public:
     Event(EventType type, EventData data): eventType(type), eventData(data){};
     EventType GetEventType(){ return this->eventType; };
     EventData GetEventData(){ return this->eventData; };
-    std::string GetEventTypeStr(){ 
+    std::string_view GetEventTypeStr(){ 
         switch(this->eventType){
             case HOTKEY: 
                 return "Hotkey";
                 break;
+            case GAME_LAUNCH: 
+                return "GameLaunch";
+                break;
+            case TEMPLATE_MATCH: 
+                return "TemplateMatch";
+                break;
             default: 
                 return "no event type";
                 break;
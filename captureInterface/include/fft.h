@@ -0,0 +1,47 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <cstddef>
+#include <vector>
+
+// Forward FFT of real input with a power of two size of at least 8. The
+// real input is packed into a complex FFT of half the size, which runs as
+// one radix-4 pass followed by radix-2 passes vectorised four butterflies
+// at a time, on split real and imaginary arrays.
+//
+// A RealFft keeps scratch space, use one per thread.
+class RealFft {
+
+public:
+    explicit RealFft(std::size_t size);
+
+    std::size_t Size() const { return this->size; };
+    // number of output bins, Size() / 2 + 1
+    std::size_t Bins() const { return this->half + 1; };
+
+    // unnormalised spectrum, re and im hold Bins() values each
+    void Forward(const float* in, float* re, float* im);
+    // magnitude of every bin
+    void Magnitudes(const float* in, float* out);
+
+private:
+    std::size_t size;
+    std::size_t half;
+
+    std::vector<unsigned> bitReverse;
+    // twiddles of the radix-2 passes, one run of len / 2 per pass
+    std::vector<float> twiddleRe;
+    std::vector<float> twiddleIm;
+    // twiddles for splitting the packed spectrum into the real one
+    std::vector<float> splitRe;
+    std::vector<float> splitIm;
+
+    std::vector<float> workRe;
+    std::vector<float> workIm;
+    std::vector<float> outRe;
+    std::vector<float> outIm;
+
+    void complexFft();
+};
+
+#endif
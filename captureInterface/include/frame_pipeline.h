@@ -0,0 +1,45 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "downscale.h"
+#include "motion.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per frame analysis and sharing of captured frames. Every frame is
+// downscaled once to fit the frame ring (at most 640x360, more only for
+// captures past 16 times that). The motion score,
+// the ring and the preview work from that copy instead of reading the full
+// frame again. Template matching needs the captured size and gets the frame
+// itself.
+class FramePipeline {
+
+public:
+    static FramePipeline& Instance();
+
+    // called by the capturer with every frame it has mapped, from one thread
+    void Process(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride, int64_t time);
+
+private:
+    // the shared downscaled frame, BGRA without row padding
+    std::vector<uint8_t> small;
+    DownscaleScratch scratch;
+    MotionAnalyser motion;
+    // replay window of the active profile in frames, the motion timeline is
+    // resized when it changes
+    std::size_t replayFrames = 0;
+
+    void sizeTimeline();
+
+    FramePipeline();
+
+    // deleting the copy constructor to prevent copies
+    FramePipeline(const FramePipeline& obj) = delete;
+    void operator=(FramePipeline const&) = delete;
+};
+
+static FramePipeline& PIPELINE = FramePipeline::Instance();
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include "frame_ring_format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <windef.h>
+
+// Publishes downscaled frames and their analysis results into shared
+// memory for out of process plugins, see frame_ring_format.h for the
+// layout. Readers map it and read in place without locks or copies.
+//
+// The ring is a named mapping by default. Under wine, Open can be given a
+// file such as Z:\dev\shm\macroscale_frames instead, which linux processes
+// open with shm_open(FRAME_RING_SHM).
+class FrameRing {
+
+public:
+    static FrameRing& Instance();
+
+    // file empty for the named mapping
+    bool Open(const std::string& file);
+    void Close();
+    bool IsOpen() const { return this->header != nullptr; };
+
+    // called by FramePipeline for every frame, from one thread, with the
+    // frame it already downscaled to fit the ring and its motion score.
+    // source is the captured size. does nothing while no reader polls the ring.
+    void Publish(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+        uint32_t sourceWidth, uint32_t sourceHeight, int64_t time, float motion);
+
+private:
+    // frames are only published this long after the last reader poll
+    static constexpr int64_t READER_TIMEOUT_MICROS = 2000000;
+
+    HANDLE file = NULL;
+    HANDLE mapping = NULL;
+    uint8_t* view = nullptr;
+    FrameRingHeader* header = nullptr;
+
+    uint64_t frame = 0;
+    uint64_t lastPolls = 0;
+    int64_t lastPollTime = 0;
+
+    FrameRing(){};
+    ~FrameRing();
+
+    // deleting the copy constructor to prevent copies
+    FrameRing(const FrameRing& obj) = delete;
+    void operator=(FrameRing const&) = delete;
+};
+
+static FrameRing& FRAMES = FrameRing::Instance();
+
+#endif
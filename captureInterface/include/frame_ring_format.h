@@ -0,0 +1,74 @@
+#ifndef FRAME_RING_FORMAT_H
+#define FRAME_RING_FORMAT_H
+
+#include <cstdint>
+
+// Layout of the shared memory frame ring, written by FrameRing and read by
+// client/frame_client.h. Only depends on the standard library so clients
+// can build it anywhere.
+//
+//     FrameRingHeader
+//     slots[slotCount], slotSize bytes each, 64 byte aligned:
+//         FrameSlotHeader
+//         uint8_t pixels[]        BGRA, height rows of stride bytes
+//
+// Frame n (counting from 1) goes into slot (n - 1) % slotCount. A slot's
+// sequence is 2n - 1 while frame n is written and 2n once it is complete,
+// header.latest is n after that. Readers check the sequence before and
+// after using a slot (a seqlock), there are no locks on either side.
+// sequence, latest and readerPolls are accessed atomically.
+
+#define FRAME_RING_MAGIC 0x474e5246 // "FRNG"
+#define FRAME_RING_VERSION 1
+
+// mapping name on windows, shm_open name elsewhere
+#define FRAME_RING_MAPPING "Local\\macroscale_frames"
+#define FRAME_RING_SHM "/macroscale_frames"
+
+#define FRAME_RING_SLOTS 8
+#define FRAME_RING_MAX_WIDTH 640
+#define FRAME_RING_MAX_HEIGHT 360
+
+enum FrameFormat : uint32_t {
+    FRAME_BGRA = 0,
+};
+
+struct FrameRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    uint32_t slotsOffset;
+    uint32_t maxWidth;
+    uint32_t maxHeight;
+
+    // number of the newest complete frame, 0 before the first one
+    uint64_t latest;
+    // readers bump this when they poll, the publisher skips the downscale
+    // while it doesn't change
+    uint64_t readerPolls;
+
+    uint32_t reserved[4];
+};
+
+struct FrameSlotHeader {
+    uint64_t sequence;
+    // publisher's steady clock in microseconds
+    int64_t time;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t format;
+    // size of the captured frame before downscaling
+    uint32_t sourceWidth;
+    uint32_t sourceHeight;
+    // motion score of the frame, see MeanAbsDiff
+    float motion;
+    uint32_t reserved[5];
+};
+
+static_assert(sizeof(FrameRingHeader) == 64, "frame ring header layout changed");
+static_assert(sizeof(FrameSlotHeader) == 64, "frame slot header layout changed");
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef GAME_DB_H
+#define GAME_DB_H
+
+#include "game_db_format.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+struct GameInfo {
+    std::string_view title;
+    uint32_t gameId;
+    std::string_view profile;
+};
+
+// Lookup of canonical game titles, ids and default capture profiles.
+// Opening only maps the file and checks the header, nothing is parsed.
+class GameDb {
+
+public:
+    static GameDb& Instance();
+
+    bool Open(const std::string& filename);
+    bool IsOpen() const { return this->header != nullptr; };
+
+    // key is an executable name or hash, matched case insensitively
+    std::optional<GameInfo> Lookup(std::string_view key) const;
+
+private:
+    MappedFile file;
+    const GameDbHeader* header = nullptr;
+    const uint32_t* seeds = nullptr;
+    const uint32_t* slots = nullptr;
+    const GameDbRecord* records = nullptr;
+    const char* strings = nullptr;
+
+    GameDb(){};
+
+    // deleting the copy constructor to prevent copies
+    GameDb(const GameDb& obj) = delete;
+    void operator=(GameDb const&) = delete;
+};
+
+static GameDb& GAMEDB = GameDb::Instance();
+
+#endif
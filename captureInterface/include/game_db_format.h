@@ -0,0 +1,72 @@
+#ifndef GAME_DB_FORMAT_H
+#define GAME_DB_FORMAT_H
+
+#include <cstdint>
+#include <string_view>
+
+// On disk layout of the known games database (games.db), written by
+// tools/build_gamedb.cpp and read in place through a memory mapping.
+//
+//     GameDbHeader
+//     uint32_t seeds[bucketCount]      displacement per hash bucket
+//     uint32_t slots[slotCount]        record index, GAMEDB_EMPTY_SLOT if unused
+//     GameDbRecord records[recordCount] sorted by key
+//     char strings[stringsSize]        keys, titles and profile names
+//
+// Keys are lower case executable names or lower case hex executable hashes.
+// A key lands in slot GameDbSlot(hash, seeds[hash % bucketCount], slotCount)
+// which is unique per key (hash and displace perfect hashing), so a lookup
+// touches one seed, one slot and one record.
+// All integers are little endian.
+
+#define GAMEDB_MAGIC 0x4447534d // "MSGD"
+#define GAMEDB_VERSION 1
+#define GAMEDB_EMPTY_SLOT 0xffffffffu
+
+struct GameDbHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t bucketCount;
+    uint32_t slotCount;
+    uint32_t seedsOffset;
+    uint32_t slotsOffset;
+    uint32_t recordsOffset;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+};
+
+struct GameDbRecord {
+    uint32_t keyOffset;
+    uint32_t keyLength;
+    uint32_t titleOffset;
+    uint32_t titleLength;
+    uint32_t gameId;
+    uint32_t profileOffset;
+    uint32_t profileLength;
+};
+
+// seedless hash of a key, FNV-1a finished with the murmur3 mixer
+inline uint64_t GameDbHash(std::string_view key){
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c: key) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint32_t GameDbSlot(uint64_t hash, uint32_t seed, uint32_t slotCount){
+    uint64_t h = hash + seed * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 31;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 29;
+    return static_cast<uint32_t>(h % slotCount);
+}
+
+#endif
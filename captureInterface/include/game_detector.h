@@ -0,0 +1,77 @@
+#ifndef GAME_DETECTOR_H
+#define GAME_DETECTOR_H
+
+#include "game_rules.h"
+#include "process_cache.h"
+#include "target_scorer.h"
+#include "win_types.h"
+#include "window_events.h"
+#include "window_snapshot.h"
+#include "window_system.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Finds the capture target among the desktop's windows. The window list is
+// only scanned again when a window event says it changed, when Rescan asks
+// for it or once the last scan is older than the interval given to
+// RescanIfOlder, which covers events that never arrive. Only windows that
+// are new or changed title are matched against the game rules, matches go
+// to a TargetScorer.
+//
+// Driven by the PollFGWin task, not thread safe.
+class GameDetector {
+
+public:
+    // with a reliable event source the list is still rescanned this often in
+    // case an event got lost, without one it is polled
+    static constexpr uint64_t RESCAN_MS = 5000;
+    static constexpr uint64_t POLL_MS = 1000;
+
+    GameDetector(WindowSystem& windows, ProcessCache& processes, const GameRules& rules);
+
+    // waits for window events for up to an interval and updates, rescanning
+    // when the wait times out. true if the target changed
+    bool Poll(WindowEvents& source);
+
+    void OnEvents(const std::vector<WinEvent>& events);
+    // scans on the next Update
+    void Rescan(){ this->rescan = true; };
+    void RescanIfOlder(uint64_t intervalMs);
+    // scans if needed and rescores, true if the target changed
+    bool Update();
+
+    // nullptr when no window looks like a game
+    const WindowEntry* Target() const;
+    std::string_view TargetTitle() const;
+    float TargetScore() const;
+    // number of times the window list was scanned
+    uint64_t Scans() const { return this->scans; };
+
+private:
+    WindowSystem& windows;
+    ProcessCache& processes;
+    const GameRules& rules;
+    TargetScorer scorer;
+
+    // latest holds the current window list, older the one before it
+    WindowSnapshot snapshots[2];
+    WindowSnapshot* latest = &snapshots[0];
+    WindowSnapshot* older = &snapshots[1];
+    std::vector<uint32_t> added;
+    std::vector<uint32_t> removed;
+    std::vector<WinEvent> events;
+    // reused for every window's image path
+    std::string filePath;
+
+    bool rescan = true;
+    uint64_t lastScanMs = 0;
+    uint64_t scans = 0;
+    HWND target = nullptr;
+
+    void scan();
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef GAME_RULES_H
+#define GAME_RULES_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum GameRuleKind {
+    RULE_PATH,  // substring of the executable path
+    RULE_EXE,   // executable file name
+    RULE_CLASS  // window class name
+};
+
+struct GameRule {
+    GameRuleKind kind;
+    std::string pattern;
+    float confidence;
+    // matching an ignore rule marks the window as not a game, whatever else matched
+    bool ignore;
+};
+
+struct GameMatch {
+    const GameRule* rule = nullptr;
+    float confidence = 0.0f;
+    bool Matched() const { return rule != nullptr; };
+};
+
+// Game detection rules loaded from a data file and compiled into an
+// Aho-Corasick automaton for path patterns plus hash maps for executable and
+// window class names. Matching walks the path once and does two hash lookups
+// regardless of how many rules are loaded. Matching is case insensitive and
+// treats '/' and '\' the same.
+//
+// File format, one rule per line, '#' starts a comment:
+//     <path|exe|class> <confidence|ignore> <pattern>
+class GameRules {
+
+public:
+    static GameRules& Instance();
+
+    // parses and compiles the rules file, keeps the built in rules on failure
+    bool Load(const std::string& filename);
+    void Compile(std::vector<GameRule> rules);
+    std::size_t RuleCount() const { return this->rules.size(); };
+
+    GameMatch Match(std::string_view path, std::string_view windowClass) const;
+
+private:
+    std::vector<GameRule> rules;
+
+    // automaton over the bytes that appear in path patterns, class 0 is
+    // every other byte. delta holds the full transition table with the
+    // failure links folded in, one row of alphabetSize entries per state.
+    uint8_t byteClass[256];
+    int alphabetSize = 1;
+    std::vector<int32_t> delta;
+    // per state, the best rule ending here or at any suffix state, -1 for none
+    std::vector<int32_t> stateRule;
+    std::vector<bool> stateIgnore;
+
+    // transparent hashing so names can be looked up without building a std::string
+    struct NameHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+    };
+    using NameMap = std::unordered_map<std::string, int32_t, NameHash, std::equal_to<>>;
+
+    NameMap exeRules;
+    NameMap classRules;
+
+    void compilePaths();
+    void addName(NameMap& names, int32_t rule);
+    // returns the more confident of two rule indices, -1 meaning no rule
+    int32_t better(int32_t a, int32_t b) const;
+
+    GameRules();
+
+    // deleting the copy constructor to prevent copies
+    GameRules(const GameRules& obj) = delete;
+    void operator=(GameRules const&) = delete;
+};
+
+static GameRules& GAMERULES = GameRules::Instance();
+
+#endif
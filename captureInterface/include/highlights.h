@@ -0,0 +1,55 @@
+#ifndef HIGHLIGHTS_H
+#define HIGHLIGHTS_H
+
+#include "clip_sidecar_format.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+struct HighlightMarker {
+    // steady clock time in microseconds, the clock AudioRing::TimeOf uses
+    int64_t time;
+    uint32_t durationMs;
+    ClipMarkerKind kind;
+    // 0 to 1
+    float score;
+};
+
+// Highlight markers of the replay window, in time order. Detectors add to
+// it as they run, the save path takes the markers inside a clip with it.
+// Markers of the same kind that touch are merged, keeping the best score.
+class HighlightTimeline {
+
+public:
+    static HighlightTimeline& Instance();
+
+    void Add(const HighlightMarker& marker);
+    // markers older than this before the newest one are dropped
+    void SetRetention(int64_t micros);
+
+    std::vector<HighlightMarker> Between(int64_t from, int64_t to) const;
+    // markers inside [from, to) with times relative to from, for a sidecar
+    std::vector<ClipSidecarMarker> ForClip(int64_t from, int64_t to) const;
+    // the best scoring marker in [from, to), false if there is none
+    bool Best(int64_t from, int64_t to, HighlightMarker& out) const;
+
+private:
+    // markers closer than this count as touching
+    static constexpr int64_t MERGE_GAP = 500000;
+
+    mutable std::mutex mutex;
+    std::deque<HighlightMarker> markers;
+    int64_t retention = int64_t(5) * 60 * 1000000;
+
+    HighlightTimeline(){};
+
+    // deleting the copy constructor to prevent copies
+    HighlightTimeline(const HighlightTimeline& obj) = delete;
+    void operator=(HighlightTimeline const&) = delete;
+};
+
+static HighlightTimeline& HIGHLIGHTS = HighlightTimeline::Instance();
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef IPC_API_H
+#define IPC_API_H
+
+#include "application_data.h"
+#include "highlights.h"
+#include "ipc_protocol.h"
+
+#include <cstdint>
+#include <string_view>
+
+// Requests and pushes of the GUI's local API, on top of IpcServer. The
+// payloads are described in ipc_protocol.h.
+namespace IpcApi {
+
+    // the IpcServer handler, runs on the client's reader thread
+    IpcStatus Handle(uint16_t type, IpcReader& request, IpcWriter& response);
+
+    void PushHighlight(const HighlightMarker& marker);
+    void PushCapture(CaptureState state);
+    void PushGame(std::string_view exe);
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef IPC_PROTOCOL_H
+#define IPC_PROTOCOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Wire format of the local API between the capture interface and the GUI,
+// shared by IpcServer and client/ipc_client.h.
+//
+// Every message is a uint32_t length followed by that many bytes: an
+// IpcHeader and the payload. Requests carry an id picked by the client and
+// the response echoes it, so a client can send any number of requests
+// without waiting and match the responses up as they arrive. Responses
+// come back in request order. Pushes for subscribed topics have id 0 and
+// can arrive between responses.
+//
+// Payload fields are packed little endian integers, strings are a uint16_t
+// length and the bytes. All integers are little endian.
+
+#ifdef _WIN32
+#define IPC_DEFAULT_NAME "\\\\.\\pipe\\macroscale"
+#else
+#define IPC_DEFAULT_NAME "/tmp/macroscale.sock"
+#endif
+
+// larger messages close the connection
+#define IPC_MAX_MESSAGE (1 << 20)
+
+struct IpcHeader {
+    uint32_t id;
+    uint16_t type;
+    // IpcStatus in responses, 0 in requests and pushes
+    uint16_t status;
+};
+
+static_assert(sizeof(IpcHeader) == 8, "ipc header layout changed");
+
+enum IpcType : uint16_t {
+    // payload is echoed back
+    IPC_PING = 1,
+    // -> u32 topic mask, see IpcTopic
+    IPC_SUBSCRIBE = 2,
+    // <- u8 capture state, u64 config version, str game title, str profile,
+    //    u64 profile switches, u64 last and u64 slowest switch micros
+    IPC_STATUS = 3,
+    // -> u8 recording
+    IPC_SET_CAPTURE = 4,
+    // -> u32 limit, str game (empty for all)
+    // <- u32 count, then per clip: u64 id, i64 timestamp, u32 duration ms,
+    //    str game, str title, str path
+    IPC_LIST_CLIPS = 5,
+    // -> u32 limit, str query. <- same as IPC_LIST_CLIPS
+    IPC_SEARCH_CLIPS = 6,
+    // starts building a highlight reel. <- str output path
+    IPC_BUILD_REEL = 7,
+    // <- u32 count, then per plugin: str name, u8 enabled, u64 calls,
+    //    u64 errors, u64 overruns, i64 busy micros, u64 memory bytes
+    IPC_PLUGIN_STATS = 8,
+
+    // pushes
+    // i64 time, u32 duration ms, u32 kind, f32 score
+    IPC_PUSH_HIGHLIGHT = 100,
+    // u8 capture state
+    IPC_PUSH_CAPTURE = 101,
+    // str executable name
+    IPC_PUSH_GAME = 102,
+};
+
+enum IpcTopic : uint32_t {
+    IPC_TOPIC_HIGHLIGHTS = 1 << 0,
+    IPC_TOPIC_CAPTURE = 1 << 1,
+    IPC_TOPIC_GAMES = 1 << 2,
+};
+
+enum IpcStatus : uint16_t {
+    IPC_OK = 0,
+    IPC_UNKNOWN_TYPE = 1,
+    IPC_BAD_REQUEST = 2,
+    IPC_FAILED = 3,
+};
+
+// Appends payload fields to a string.
+class IpcWriter {
+
+public:
+    explicit IpcWriter(std::string& out): out(out) {};
+
+    template <typename T>
+    void Put(T value){
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        this->out.append(bytes, sizeof(T));
+    }
+    void PutString(std::string_view s){
+        uint16_t length = static_cast<uint16_t>(std::min<std::size_t>(s.size(), UINT16_MAX));
+        this->Put(length);
+        this->out.append(s.data(), length);
+    }
+
+private:
+    std::string& out;
+};
+
+// Reads payload fields, every read past the end fails and leaves ok false.
+class IpcReader {
+
+public:
+    IpcReader(const char* data, std::size_t size): data(data), size(size) {};
+
+    template <typename T>
+    bool Get(T& value){
+        if (!this->ok || this->size - this->pos < sizeof(T)) return this->ok = false;
+        std::memcpy(&value, this->data + this->pos, sizeof(T));
+        this->pos += sizeof(T);
+        return true;
+    }
+    bool GetString(std::string_view& s){
+        uint16_t length;
+        if (!this->Get(length) || this->size - this->pos < length) return this->ok = false;
+        s = std::string_view(this->data + this->pos, length);
+        this->pos += length;
+        return true;
+    }
+    bool Ok() const { return this->ok; };
+    std::string_view Rest() const { return std::string_view(this->data + this->pos, this->size - this->pos); };
+
+private:
+    const char* data;
+    std::size_t size;
+    std::size_t pos = 0;
+    bool ok = true;
+};
+
+// appends a complete message to out
+inline void IpcFrame(std::string& out, uint32_t id, uint16_t type, uint16_t status, std::string_view payload){
+    IpcHeader header{ .id = id, .type = type, .status = status };
+    uint32_t length = static_cast<uint32_t>(sizeof(header) + payload.size());
+    IpcWriter w(out);
+    w.Put(length);
+    w.Put(header);
+    out.append(payload.data(), payload.size());
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef IPC_SERVER_H
+#define IPC_SERVER_H
+
+#include "ipc_protocol.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// handles one request, writes the response payload and returns its status
+using IpcHandler = std::function<IpcStatus(uint16_t type, IpcReader& request, IpcWriter& response)>;
+
+// Local API server for the GUI, a named pipe on windows and a unix domain
+// socket elsewhere. See ipc_protocol.h for the wire format.
+//
+// Every client gets a reader and a writer thread. The reader handles all
+// requests that arrived together and queues their responses as one batch,
+// so pipelined requests cost one write. Pushes are queued the same way, so
+// Publish never waits for a client, a client that lets its queue grow past
+// OUTBOX_LIMIT is disconnected.
+//
+// A client that stops sending still gets the responses queued until then:
+// the writer flushes the outbox before the connection is closed. Stop, an
+// invalid message and a full outbox close it right away. The last of a
+// connection's threads to exit hands it to the acceptor, which joins it.
+class IpcServer {
+
+public:
+    static IpcServer& Instance();
+
+    // called from every client's reader thread, set it before Start
+    void SetHandler(IpcHandler handler);
+    // name is a pipe name on windows, a socket path elsewhere
+    bool Start(const std::string& name);
+    void Stop();
+
+    // queues a push for every client subscribed to topic
+    void Publish(IpcTopic topic, uint16_t type, std::string_view payload);
+    // connections that aren't closing
+    std::size_t Clients() const;
+
+private:
+    struct Stream;
+
+    struct Connection {
+        std::unique_ptr<Stream> stream;
+        std::thread reader;
+        std::thread writer;
+        std::atomic<uint32_t> topics{0};
+        // reader and writer threads still running, the last one to exit
+        // moves the connection to finished
+        std::atomic<int> threads{2};
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::string outbox;
+        // the reader saw the end of the stream, the writer closes the
+        // connection once the outbox is flushed
+        bool draining = false;
+        bool closing = false;
+
+        ~Connection();
+    };
+
+    static constexpr std::size_t OUTBOX_LIMIT = 4 * 1024 * 1024;
+
+    IpcHandler handler;
+    std::string name;
+    std::atomic<bool> running{false};
+    std::thread acceptor;
+#ifdef _WIN32
+    void* stopEvent = nullptr;
+    // set when a connection finished, wakes the acceptor
+    void* reapEvent = nullptr;
+#else
+    int listener = -1;
+    // a byte written to wake[1] wakes the acceptor to reap
+    int wake[2] = { -1, -1 };
+#endif
+
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<Connection>> connections;
+    // connections whose threads are done, waiting to be joined
+    std::vector<std::shared_ptr<Connection>> finished;
+
+    void accept();
+    void read(Connection* conn);
+    void write(Connection* conn);
+    // false if the outbox is over its limit or the connection is closing,
+    // data queued while draining is dropped
+    bool queue(Connection& conn, const std::string& data);
+    void drain(Connection& conn);
+    void close(Connection& conn);
+    // called by both threads of a connection as they exit
+    void finish(Connection* conn);
+    // joins the finished connections, every connection with all
+    void reap(bool all);
+
+    IpcServer(){};
+    ~IpcServer();
+
+    // deleting the copy constructor to prevent copies
+    IpcServer(const IpcServer& obj) = delete;
+    void operator=(IpcServer const&) = delete;
+};
+
+static IpcServer& IPCSERVER = IpcServer::Instance();
+
+#endif
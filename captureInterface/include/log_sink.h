@@ -0,0 +1,81 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+
+// Log output backed by preallocated, memory mapped segment files. Writing a
+// line is a memcpy into the mapped view, the kernel writes the pages back to
+// disk. Segments are rotated once they are full or older than maxAge and are
+// truncated to the written length when closed. Segments are named
+// <baseName>-<date>-<time>-<pid>-<index>.txt and never reuse an existing file. Closed segments, including
+// the last one, can optionally be compressed with XPRESS on a background
+// thread (windows only, `[log] compress` in config.ini).
+//
+// Write is not thread safe, the Logger serialises calls into the sink.
+class LogSink {
+
+public:
+    struct Options {
+        std::string baseName = "log";
+        std::size_t segmentSize = 4 * 1024 * 1024;
+        std::chrono::seconds maxAge = std::chrono::hours(24);
+        bool compress = false;
+    };
+
+    LogSink(){};
+    ~LogSink();
+
+    // opens the first segment, does nothing if the sink is already open
+    bool Open(const Options& options);
+    void Write(const char* data, std::size_t size);
+    // compresses the segments closed from now on
+    void SetCompress(bool compress);
+    void Close();
+    bool IsOpen(){ return this->view != nullptr; };
+    // path of the segment being written
+    const std::string& SegmentPath() const { return this->segmentPath; };
+
+private:
+    Options options;
+
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    char* view = nullptr;
+    std::size_t offset = 0;
+    std::string segmentPath;
+    std::chrono::steady_clock::time_point segmentOpened;
+    int segmentIndex = 0;
+
+    std::thread compressThread;
+    std::mutex compressMutex;
+    std::condition_variable compressCv;
+    std::queue<std::string> compressQueue;
+    bool compressStop = false;
+
+    // taken segment names tried before giving up
+    static constexpr int MAX_OPEN_ATTEMPTS = 1000;
+
+    bool openSegment();
+    // returns false if nothing was written to the segment
+    bool closeSegment();
+    void rotate();
+    void queueCompress(const std::string& path);
+    void stopCompress();
+    void compressWorker();
+
+    // deleting the copy constructor to prevent copies
+    LogSink(const LogSink& obj) = delete;
+    void operator=(LogSink const&) = delete;
+};
+
+#endif
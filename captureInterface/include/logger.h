@@ -2,69 +2,255 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include "log_sink.h"
+#include <algorithm>
+#include <chrono>
 #include <ctime>
-#include <fstream>
+#include <format>
 #include <iostream>
-#include <sstream>
+#include <mutex>
+#include <string_view>
+#include <vector>
 
 // Enum to represent log levels
 enum LogLevel { DEBUG, INFO, WARNING, ERROR, CRITICAL };
 
+// Rate limit for a single log call site. The first `burst` messages are
+// logged as normal, after that only one sample is let through every
+// `interval` along with a count of the messages that were dropped.
+// Declare one as a function local static next to the hot log call, every
+// call site needs its own. Messages still suppressed at exit are counted by
+// Logger::flushSuppressed or when the limit is destroyed.
+class LogRateLimit {
+public:
+    LogRateLimit(int burst, std::chrono::seconds interval): burst(burst), interval(interval) {};
+    ~LogRateLimit();
+
+    // returns true if the message should be logged, suppressed is set to the
+    // number of messages dropped since the last one that got through
+    bool Allow(int& suppressed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+
+        if (count < burst) {
+            count++;
+            lastSample = now;
+            suppressed = 0;
+            return true;
+        }
+
+        if (now - lastSample >= interval) {
+            lastSample = now;
+            suppressed = dropped;
+            dropped = 0;
+            return true;
+        }
+
+        dropped++;
+        return false;
+    }
+
+    // number of messages dropped since the last one that got through, resets it
+    int Flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        int n = dropped;
+        dropped = 0;
+        return n;
+    }
+
+private:
+    friend class Logger;
+
+    // format of the suppressed messages and whether the logger knows about
+    // the limit, set by the logger
+    std::string_view site;
+    bool registered = false;
+
+    std::mutex mutex;
+    int burst;
+    std::chrono::steady_clock::duration interval;
+    int count = 0;
+    int dropped = 0;
+    std::chrono::steady_clock::time_point lastSample;
+};
+
 class Logger {
 public:
-    // Constructor: Opens the log file in append mode
-    static Logger& instance(const std::string& filename)
+    // Constructor: Opens the rotating log segments named after baseName
+    static Logger& instance(const std::string& baseName)
     {
         static Logger inst;
-        inst.logFile.open(filename, std::ios::app);
-        if (!inst.logFile.is_open()) {
-            std::cerr << "Error opening log file." << std::endl;
+        std::lock_guard<std::mutex> lock(inst.writeMutex);
+        if (!inst.sink.IsOpen()) {
+            LogSink::Options options;
+            options.baseName = baseName;
+            if (!inst.sink.Open(options)) {
+                std::cerr << "Error opening log file." << std::endl;
+            }
         }
         return inst; 
     }
 
     // Destructor: Closes the log file
-    ~Logger() { logFile.close(); }
-
-    // Logs a message with a given log level
-    void log(LogLevel level, const std::string& message) {
-        // Get current timestamp
-        time_t now = time(0);
-        tm* timeinfo = localtime(&now);
-        char timestamp[20];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
+    ~Logger() { sink.Close(); }
 
-        // Create log entry
-        std::ostringstream logEntry;
-        logEntry << "[" << timestamp << "] "
-                 << levelToString(level) << ": " << message
-                 << std::endl;
+    // compresses finished log segments from now on, see LogSink
+    void compress(bool enabled) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        sink.SetCompress(enabled);
+    }
 
-        // Output to console
-        std::cout << logEntry.str();
+    // Logs a message with a given log level. The line is formatted with
+    // std::format_to_n into a thread local buffer, so nothing is allocated
+    // per line. Lines longer than the buffer are truncated.
+    template <typename... Args>
+    void log(LogLevel level, std::format_string<Args...> fmt, Args&&... args) {
+        logLine(level, 0, fmt, std::forward<Args>(args)...);
+    }
 
-        // Output to log file
-        if (logFile.is_open()) {
-            logFile << logEntry.str();
-            logFile
-                .flush(); // Ensure immediate write to file
-        }
+    template <typename... Args>
+    void info(std::format_string<Args...> fmt, Args&&... args){
+        logLine(INFO, 0, fmt, std::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    void error(std::format_string<Args...> fmt, Args&&... args){
+        logLine(ERROR, 0, fmt, std::forward<Args>(args)...);
     }
 
-    void info(const std::string& message){
-        log(INFO, message);
+    // rate limited variant for hot paths, see LogRateLimit
+    template <typename... Args>
+    void info(LogRateLimit& limit, std::format_string<Args...> fmt, Args&&... args){
+        int suppressed;
+        if (!limit.Allow(suppressed)) return dropped(limit, fmt.get());
+        logLine(INFO, suppressed, fmt, std::forward<Args>(args)...);
     }
-    void error(const std::string& message){
-        log(ERROR, message);
+    template <typename... Args>
+    void error(LogRateLimit& limit, std::format_string<Args...> fmt, Args&&... args){
+        int suppressed;
+        if (!limit.Allow(suppressed)) return dropped(limit, fmt.get());
+        logLine(ERROR, suppressed, fmt, std::forward<Args>(args)...);
     }
 
+    // logs how many messages every rate limited call site dropped since its
+    // last message got through, called once more at exit
+    void flushSuppressed() {
+        std::lock_guard<std::mutex> lock(limitsMutex);
+        for (LogRateLimit* limit: limits) flushLimit(*limit);
+    }
+
+    // called by a limit that goes away
+    void forget(LogRateLimit& limit) {
+        std::lock_guard<std::mutex> lock(limitsMutex);
+        flushLimit(limit);
+        limits.erase(std::remove(limits.begin(), limits.end(), &limit), limits.end());
+    }
 
 private:
-    Logger() = default;
+    // room for every call site, so registering one doesn't allocate
+    Logger() { limits.reserve(64); }
+
+    static constexpr std::size_t LINE_SIZE = 1024;
+
+    struct LineBuffer {
+        char data[LINE_SIZE];
+    };
 
-    std::ofstream logFile; 
+    // the timestamp text only changes once a second, so each thread keeps the
+    // last one it formatted and only converts the time again when the second
+    // rolls over
+    struct TimestampCache {
+        time_t second = -1;
+        char text[20];
+    };
 
-    std::string levelToString(LogLevel level)
+    LogSink sink;
+    std::mutex writeMutex;
+
+    // limits that dropped a message at some point
+    std::vector<LogRateLimit*> limits;
+    std::mutex limitsMutex;
+
+    void dropped(LogRateLimit& limit, std::string_view site) {
+        std::lock_guard<std::mutex> lock(limitsMutex);
+        limit.site = site;
+        if (limit.registered) return;
+        limit.registered = true;
+        limits.push_back(&limit);
+    }
+
+    void flushLimit(LogRateLimit& limit) {
+        int n = limit.Flush();
+        if (n == 0) return;
+        char* end;
+        char* out = beginLine(INFO, end);
+        out = std::min(end, std::format_to_n(out, end - out, "suppressed {} messages like \"{}\"", n, limit.site).out);
+        endLine(out, end, 0);
+    }
+
+    // only the message itself is formatted in the template, the buffer, the
+    // prefix and the suffix are shared by all of its instantiations
+    template <typename... Args>
+    void logLine(LogLevel level, int suppressed, std::format_string<Args...> fmt, Args&&... args) {
+        char* end;
+        char* out = beginLine(level, end);
+        // format_to_n reports where the untruncated output would have ended
+        out = std::min(end, std::format_to_n(out, end - out, fmt, std::forward<Args>(args)...).out);
+        endLine(out, end, suppressed);
+    }
+
+    // one buffer per thread, an inline function's statics are shared by
+    // every translation unit
+    static LineBuffer& lineBuffer() {
+        thread_local LineBuffer line;
+        return line;
+    }
+
+    // writes the prefix, end is set to the last byte the message may use
+    static char* beginLine(LogLevel level, char*& end) {
+        LineBuffer& line = lineBuffer();
+        end = line.data + sizeof(line.data) - 1; // room for the newline
+        return std::min(end, std::format_to_n(line.data, end - line.data, "[{}] {}: ", timestamp(), levelToString(level)).out);
+    }
+
+    void endLine(char* out, char* end, int suppressed) {
+        if (suppressed > 0) {
+            out = std::min(end, std::format_to_n(out, end - out, " (suppressed {} similar messages)", suppressed).out);
+        }
+        *out++ = '\n';
+
+        LineBuffer& line = lineBuffer();
+        write(line.data, out - line.data);
+    }
+
+    static std::string_view timestamp() {
+        thread_local TimestampCache cache;
+
+        time_t now = time(0);
+        if (now != cache.second) {
+            // localtime shares one static buffer between threads
+            tm timeinfo;
+#ifdef _WIN32
+            localtime_s(&timeinfo, &now);
+#else
+            localtime_r(&now, &timeinfo);
+#endif
+            strftime(cache.text, sizeof(cache.text), "%Y-%m-%d %H:%M:%S", &timeinfo);
+            cache.second = now;
+        }
+        return std::string_view(cache.text);
+    }
+
+    void write(const char* data, std::size_t size) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        // Output to console
+        std::cout.write(data, size);
+
+        // Output to log file
+        sink.Write(data, size);
+    }
+
+    static std::string_view levelToString(LogLevel level)
     {
         switch (level) {
         case DEBUG: return "DEBUG";
@@ -86,7 +272,7 @@ private:
 /*{*/
 /*    // Example usage of the logger*/
 /*    logger.log(INFO, "Program started.");*/
-/*    logger.log(DEBUG, "Debugging information.");*/
+/*    logger.log(DEBUG, "Debugging information: {}", 42);*/
 /*    logger.log(ERROR, "An error occurred.");*/
 /**/
 /*    return 0;*/
@@ -94,6 +280,12 @@ private:
 /**/
 
 // Make SLOG a reference to the singleton instance
-static Logger& SLOG = Logger::instance("log.txt");
+static Logger& SLOG = Logger::instance("log");
+
+// limits are function local statics or members, they go away before the
+// logger does
+inline LogRateLimit::~LogRateLimit() {
+    if (registered) SLOG.forget(*this);
+}
 
 #endif
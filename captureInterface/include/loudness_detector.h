@@ -0,0 +1,81 @@
+#ifndef LOUDNESS_DETECTOR_H
+#define LOUDNESS_DETECTOR_H
+
+#include "highlights.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// mean square and absolute peak of n samples, vectorised
+void AudioBlockStats(const float* samples, std::size_t n, float& meanSquare, float& peak);
+
+struct LoudnessOptions {
+    uint32_t sampleRate = 48000;
+    uint32_t channels = 2;
+    // analysis block, loudness and onsets have this resolution
+    uint32_t blockMs = 10;
+    // short-term loudness window
+    uint32_t windowMs = 400;
+    // how quickly the baseline follows the game's normal loudness
+    uint32_t baselineMs = 10000;
+    // short-term loudness this far over the baseline is a loud section
+    float loudDb = 8.0f;
+    // a loud section lasting longer ends here and its loudness becomes the
+    // baseline, the game just got louder
+    uint32_t maxLoudMs = 30000;
+    // a block this much louder than the window before it is an onset
+    float onsetDb = 15.0f;
+    // onsets quieter than this are ignored
+    float onsetPeakDb = -30.0f;
+    // gap forced between two onset markers
+    uint32_t refractoryMs = 1000;
+};
+
+// Finds loud sections and sharp transients in an audio stream. Audio is cut
+// into short blocks; the mean square of a block is its energy, the average
+// over the last windowMs the short-term loudness (plain RMS in dBFS, without
+// the K-weighting of EBU R128) and a slow moving average of that the
+// baseline. Loud sections are where short-term loudness stays loudDb over
+// the baseline, for at most maxLoudMs. Onsets are blocks that jump onsetDb
+// over the window before.
+class LoudnessDetector {
+
+public:
+    LoudnessDetector(const LoudnessOptions& options = LoudnessOptions());
+
+    // feeds interleaved frames, time is the steady clock time of the first
+    // one in microseconds. markers found are appended to out.
+    void Process(const float* samples, std::size_t frames, int64_t time, std::vector<HighlightMarker>& out);
+
+    float ShortTermDb() const { return this->shortTermDb; };
+    float BaselineDb() const { return this->baselineDb; };
+
+private:
+    LoudnessOptions options;
+    std::size_t blockSamples;
+
+    // samples of the block being filled
+    std::vector<float> pending;
+    int64_t pendingTime = 0;
+
+    // energies of the last windowMs of blocks
+    std::vector<float> window;
+    std::size_t windowPos = 0;
+    std::size_t windowFilled = 0;
+    double windowSum = 0.0;
+
+    float shortTermDb = -120.0f;
+    float baselineDb = -120.0f;
+    float baselineAlpha;
+
+    bool loud = false;
+    int64_t loudStart = 0;
+    float loudMaxExcess = 0.0f;
+    // earliest time the next onset may be at
+    int64_t nextOnset = INT64_MIN;
+
+    void block(const float* samples, int64_t time, std::vector<HighlightMarker>& out);
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read only view of a whole file, unmapped when closed or destroyed.
+class MappedFile {
+
+public:
+    MappedFile(){};
+    ~MappedFile();
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const { return this->data != nullptr; };
+    const uint8_t* Data() const { return this->data; };
+    std::size_t Size() const { return this->size; };
+
+private:
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+    const uint8_t* data = nullptr;
+    std::size_t size = 0;
+
+    // deleting the copy constructor to prevent copies
+    MappedFile(const MappedFile& obj) = delete;
+    void operator=(MappedFile const&) = delete;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include "downscale.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// mean absolute difference of two planes, 0 to 255
+float MeanAbsDiff(const uint8_t* a, const uint8_t* b, std::size_t n);
+
+struct MotionSample {
+    // milliseconds since the timeline's first sample
+    uint32_t timeMs;
+    // mean absolute difference times 256
+    uint16_t score;
+};
+
+// Motion score of every analysed frame over the replay window, kept as a
+// ring of 6 byte samples so an hour at 60 fps is about 1.3 MB. FramePipeline
+// sizes it to the active profile's replay window.
+class MotionTimeline {
+
+public:
+    static MotionTimeline& Instance();
+
+    // samples past capacity overwrite the oldest
+    void SetCapacity(std::size_t samples);
+    // time in steady clock microseconds, score as returned by MeanAbsDiff
+    void Add(int64_t time, float score);
+
+    struct Point {
+        int64_t time;
+        float score;
+    };
+    std::vector<Point> Between(int64_t from, int64_t to) const;
+    // mean and peak over [from, to), false if there are no samples
+    bool Stats(int64_t from, int64_t to, float& mean, float& peak) const;
+
+private:
+    mutable std::mutex mutex;
+    std::vector<MotionSample> samples;
+    std::size_t head = 0;
+    std::size_t count = 0;
+    int64_t base = 0;
+
+    // calls f with every sample in [from, to), oldest first
+    template <typename F> void forEach(int64_t from, int64_t to, F f) const;
+
+    MotionTimeline();
+
+    // deleting the copy constructor to prevent copies
+    MotionTimeline(const MotionTimeline& obj) = delete;
+    void operator=(MotionTimeline const&) = delete;
+};
+
+static MotionTimeline& MOTION = MotionTimeline::Instance();
+
+// called with every score MotionAnalyser adds to the timeline
+using MotionListener = std::function<void(int64_t time, float score)>;
+
+// Keeps the previous frame's luma plane, at most MAX_WIDTH x MAX_HEIGHT, and
+// scores each new frame against it. Called by FramePipeline with the frame
+// it already downscaled for the frame ring, so the full frame is only read
+// once.
+class MotionAnalyser {
+
+public:
+    explicit MotionAnalyser(MotionListener listener = nullptr): listener(std::move(listener)) {};
+
+    // returns the frame's motion score, 0 for the first frame or after the
+    // frame size changed
+    float Process(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride, int64_t time);
+
+private:
+    // the plane is about 320x180 whatever the capture size, 1/6 of a 1080p
+    // and 1/12 of a 4K capture
+    static constexpr uint32_t MAX_WIDTH = 320;
+    static constexpr uint32_t MAX_HEIGHT = 180;
+
+    std::vector<uint8_t> previous;
+    std::vector<uint8_t> current;
+    DownscaleScratch scratch;
+    MotionListener listener;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+#endif
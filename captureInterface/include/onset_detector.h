@@ -0,0 +1,74 @@
+#ifndef ONSET_DETECTOR_H
+#define ONSET_DETECTOR_H
+
+#include "fft.h"
+#include "highlights.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct OnsetOptions {
+    uint32_t sampleRate = 48000;
+    uint32_t channels = 2;
+    // power of two
+    uint32_t frameSize = 1024;
+    uint32_t hopSize = 512;
+    // flux has to be this many times the recent median
+    float threshold = 3.0f;
+    // and over this, so near silence doesn't trigger
+    float minFlux = 0.05f;
+    // length of the recent history the median is taken over
+    uint32_t medianMs = 1000;
+    // gap forced between two onsets
+    uint32_t refractoryMs = 250;
+};
+
+// Spectral flux onset detection. Every hop the mono downmix of the last
+// frameSize samples is windowed and transformed, magnitudes are log
+// compressed and the flux is the summed increase of every bin over the
+// frame before. Onsets are local peaks of the flux well above its recent
+// median, which catches gunshots and explosions that barely move the
+// overall loudness when music is playing.
+class OnsetDetector {
+
+public:
+    OnsetDetector(const OnsetOptions& options = OnsetOptions());
+
+    // feeds interleaved frames, time is the steady clock time of the first
+    // one in microseconds. markers found are appended to out. marker times
+    // come from the time of the call their samples arrived in.
+    void Process(const float* samples, std::size_t frames, int64_t time, std::vector<HighlightMarker>& out);
+
+private:
+    OnsetOptions options;
+    RealFft fft;
+    std::vector<float> hann;
+
+    // mono samples not consumed by a hop yet
+    std::vector<float> mono;
+    // where the next call's audio should start, a call that doesn't
+    // continue there starts over
+    int64_t expectedTime = INT64_MIN;
+
+    std::vector<float> frame;
+    std::vector<float> magnitudes;
+    std::vector<float> previous;
+    bool hasPrevious = false;
+
+    std::deque<float> history;
+    std::size_t historySize;
+    std::vector<float> sorted;
+
+    // the last two flux values and their times, peaks are picked one hop late
+    float flux1 = 0.0f, flux2 = 0.0f;
+    int64_t time1 = 0;
+    // earliest time the next onset may be at
+    int64_t nextOnset = INT64_MIN;
+
+    float analyse(const float* samples);
+    float median();
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef PLUGIN_HOST_H
+#define PLUGIN_HOST_H
+
+#include "logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct lua_State;
+struct lua_Debug;
+
+enum PluginEventType {
+    PLUGIN_FRAME,
+    PLUGIN_ONSET,
+    PLUGIN_GAME,
+    PLUGIN_HOTKEY,
+    PLUGIN_EVENT_COUNT
+};
+
+struct PluginEvent {
+    PluginEventType type;
+    // steady clock microseconds, Post fills in the current time when 0
+    int64_t time = 0;
+    // frame: motion score, onset: strength
+    float value = 0.0f;
+    // game: pid, hotkey: id
+    int64_t id = 0;
+    // game: executable name
+    std::string name;
+};
+
+struct PluginStats {
+    std::string name;
+    bool enabled;
+    uint64_t calls;
+    uint64_t errors;
+    // callbacks stopped for running past their budget
+    uint64_t overruns;
+    // time spent inside the plugin's callbacks
+    int64_t busyMicros;
+    int64_t maxCallMicros;
+    std::size_t memoryBytes;
+};
+
+// Runs the Lua plugins in the plugin directory, one VM per script. Plugins
+// subscribe to events from their top level chunk:
+//
+//     plugin.on("frame", function(time, motion) end)
+//     plugin.on("onset", function(time, strength) end)
+//     plugin.on("game", function(name, pid, time) end)
+//     plugin.on("hotkey", function(id, time) end)
+//
+// and can call plugin.marker(time, durationMs, score), plugin.log(...) and
+// plugin.now(). Only the base, string, table, math and utf8 libraries are
+// opened, without load, loadfile and dofile.
+//
+// Post never blocks on a plugin. Events are queued for a single plugin
+// thread and dropped when the queue is full. Every callback runs under the
+// instruction and time budget from the config, a callback past either is
+// aborted, and a plugin that overruns MAX_OVERRUNS times within the
+// config's overrun window is disabled. Occasional overruns, a slow callback
+// now and then over a long session, are only counted.
+class PluginHost {
+
+public:
+    static PluginHost& Instance();
+
+    // stops the running plugins and loads every *.lua file in directory
+    void Load(const std::string& directory);
+    void Stop();
+
+    // cheap when no plugin listens to the event type
+    void Post(const PluginEvent& event);
+
+    std::vector<PluginStats> Stats() const;
+    uint64_t Dropped() const { return this->dropped.load(std::memory_order_relaxed); };
+
+private:
+    struct Plugin {
+        std::string name;
+        lua_State* state = nullptr;
+        // registry references of the callbacks, LUA_NOREF if not subscribed
+        int callbacks[PLUGIN_EVENT_COUNT];
+        bool enabled = true;
+        std::size_t memory = 0;
+
+        // budget of the running callback
+        int64_t instructions = 0;
+        int64_t instructionBudget = 0;
+        std::chrono::steady_clock::time_point deadline;
+        bool overran = false;
+        // times of the overruns within the overrun window, oldest first
+        std::deque<std::chrono::steady_clock::time_point> recentOverruns;
+
+        // copied from the fields above after every call, under the host's mutex
+        PluginStats stats{};
+
+        LogRateLimit logLimit{ 10, std::chrono::seconds(10) };
+
+        ~Plugin();
+    };
+
+    // the hook checks the budget every this many instructions
+    static constexpr int HOOK_INTERVAL = 1000;
+    static constexpr std::size_t MEMORY_LIMIT = 64 * 1024 * 1024;
+    static constexpr std::size_t QUEUE_LIMIT = 256;
+    // overruns within the window that disable a plugin
+    static constexpr std::size_t MAX_OVERRUNS = 10;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+    bool stop = false;
+
+    std::vector<std::unique_ptr<Plugin>> plugins;
+    std::deque<PluginEvent> queue;
+    // bit per PluginEventType that any plugin subscribed to
+    std::atomic<uint32_t> subscribed{0};
+    std::atomic<uint64_t> dropped{0};
+
+    std::unique_ptr<Plugin> open(const std::string& filename);
+    // runs the function on top of the plugin's stack with nargs arguments
+    bool call(Plugin& plugin, int nargs);
+    void dispatch(const PluginEvent& event);
+    void work();
+
+    static void hook(lua_State* L, lua_Debug* ar);
+    static void* alloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize);
+    static int luaOn(lua_State* L);
+    static int luaMarker(lua_State* L);
+    static int luaLog(lua_State* L);
+    static int luaNow(lua_State* L);
+
+    PluginHost(){};
+    ~PluginHost();
+
+    // deleting the copy constructor to prevent copies
+    PluginHost(const PluginHost& obj) = delete;
+    void operator=(PluginHost const&) = delete;
+};
+
+static PluginHost& PLUGINS = PluginHost::Instance();
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include "downscale.h"
+#include "preview_format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <windef.h>
+
+// Publishes a small live preview of the capture for the GUI into a triple
+// buffered shared memory region, see preview_format.h for the layout. The
+// rate and size come from the [preview] section of the config. Frames come
+// from FramePipeline's shared downscale, so the preview is never larger than
+// the frame ring's 640x360.
+//
+// Like FrameRing the region is a named mapping by default and Open can be
+// given a file instead, for readers outside of wine.
+class PreviewBuffer {
+
+public:
+    static PreviewBuffer& Instance();
+
+    // file empty for the named mapping
+    bool Open(const std::string& file);
+    void Close();
+    bool IsOpen() const { return this->header != nullptr; };
+
+    // called by FramePipeline for every frame, from one thread, with the
+    // frame it already downscaled. source is the captured size. frames
+    // between preview intervals and frames nobody polls for are skipped
+    // before they are copied.
+    void Publish(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+        uint32_t sourceWidth, uint32_t sourceHeight, int64_t time);
+
+private:
+    // frames are only published this long after the last reader poll
+    static constexpr int64_t READER_TIMEOUT_MICROS = 2000000;
+
+    HANDLE file = NULL;
+    HANDLE mapping = NULL;
+    uint8_t* view = nullptr;
+    PreviewHeader* header = nullptr;
+
+    uint64_t frame = 0;
+    int64_t lastFrameTime = 0;
+    uint64_t lastPolls = 0;
+    int64_t lastPollTime = 0;
+    DownscaleScratch scratch;
+
+    PreviewBuffer(){};
+    ~PreviewBuffer();
+
+    // deleting the copy constructor to prevent copies
+    PreviewBuffer(const PreviewBuffer& obj) = delete;
+    void operator=(PreviewBuffer const&) = delete;
+};
+
+static PreviewBuffer& PREVIEW = PreviewBuffer::Instance();
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef PREVIEW_FORMAT_H
+#define PREVIEW_FORMAT_H
+
+#include "frame_ring_format.h"
+
+#include <cstdint>
+
+// Layout of the shared memory live preview, written by PreviewBuffer and
+// read by client/preview_client.h. Only depends on the standard library so
+// clients can build it anywhere.
+//
+//     PreviewHeader
+//     buffers[bufferCount], bufferSize bytes each, 64 byte aligned:
+//         PreviewFrameHeader
+//         uint8_t pixels[]        BGRA, height rows of stride bytes
+//
+// A triple buffer for one reader. header.state packs the index of the
+// newest frame, the index the reader holds and a fresh bit. The publisher
+// only writes the third buffer, then makes it the newest and sets fresh.
+// The reader takes the newest buffer by swapping it into its own index and
+// clearing fresh, and can use it for as long as it likes. Neither side
+// waits for the other or copies a frame. state, readerPolls and frames
+// are accessed atomically.
+
+#define PREVIEW_MAGIC 0x57565250 // "PRVW"
+#define PREVIEW_VERSION 1
+
+// mapping name on windows, shm_open name elsewhere
+#define PREVIEW_MAPPING "Local\\macroscale_preview"
+#define PREVIEW_SHM "/macroscale_preview"
+
+#define PREVIEW_BUFFERS 3
+#define PREVIEW_MAX_WIDTH 854
+#define PREVIEW_MAX_HEIGHT 480
+
+// no buffer, the state before the first frame or the first read
+#define PREVIEW_NONE 3u
+
+constexpr uint32_t PreviewState(uint32_t latest, uint32_t reading, bool fresh){
+    return latest | (reading << 2) | (fresh ? 1u << 4 : 0u);
+}
+constexpr uint32_t PreviewLatest(uint32_t state){ return state & 3u; }
+constexpr uint32_t PreviewReading(uint32_t state){ return (state >> 2) & 3u; }
+constexpr bool PreviewFresh(uint32_t state){ return (state >> 4) & 1u; }
+// the buffer the publisher writes next, neither the newest nor the reader's.
+// the reader only ever moves to the newest, so it stays the publisher's
+constexpr uint32_t PreviewTarget(uint32_t state){
+    uint32_t target = 0;
+    while (target == PreviewLatest(state) || target == PreviewReading(state)) target++;
+    return target;
+}
+
+struct PreviewHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t bufferCount;
+    uint32_t bufferSize;
+    uint32_t buffersOffset;
+    uint32_t maxWidth;
+    uint32_t maxHeight;
+
+    // see PreviewState
+    uint32_t state;
+    uint32_t reserved0;
+    // the reader bumps this when it polls, the publisher skips the downscale
+    // while it doesn't change
+    uint64_t readerPolls;
+    // frames published since the preview was opened
+    uint64_t frames;
+
+    uint32_t reserved[2];
+};
+
+struct PreviewFrameHeader {
+    // counts from 1, a reader can tell a new frame from the one it has
+    uint64_t number;
+    // publisher's steady clock in microseconds
+    int64_t time;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    // FrameFormat
+    uint32_t format;
+    // size of the captured frame before downscaling
+    uint32_t sourceWidth;
+    uint32_t sourceHeight;
+    uint32_t reserved[6];
+};
+
+static_assert(sizeof(PreviewHeader) == 64, "preview header layout changed");
+static_assert(sizeof(PreviewFrameHeader) == 64, "preview frame header layout changed");
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef PROCESS_CACHE_H
+#define PROCESS_CACHE_H
+
+#include "win_types.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// what a cache entry holds on to while it lives, owned by the ProcessSource
+struct ProcessHandle {
+    void* process = nullptr;
+    void* exitWait = nullptr;
+};
+
+// Resolves running processes for ProcessCache: OpenProcess on windows,
+// /proc elsewhere, the tests use a mock. /proc can't hold on to a process or
+// wait for it to exit, so there entries stay until they are evicted and a
+// pid reused in the meantime still resolves to the old image path.
+class ProcessSource {
+
+public:
+    static ProcessSource& Native();
+
+    virtual ~ProcessSource() = default;
+
+    // image path of pid, the source may keep the process open in handle
+    // until Close
+    virtual bool Open(DWORD pid, std::string& path, ProcessHandle& handle) = 0;
+    // calls ProcessCache::Exited with waitId once the process exits, false
+    // if that can't be arranged. runs under the cache's lock
+    virtual bool Watch(uint64_t waitId, ProcessHandle& handle) = 0;
+    virtual void Close(ProcessHandle& handle) = 0;
+};
+
+// Cache of process image paths by pid. The first lookup for a process opens
+// it once, queries its image path and keeps the handle open, which stops
+// Windows from reusing the pid while the entry lives. An exit wait on that handle drops the entry again, so a
+// lookup for a known process is a single hash lookup. Past the capacity the
+// least recently used entry is dropped, processes that don't need to stay
+// cached are resolved with Peek.
+class ProcessCache {
+
+public:
+    static ProcessCache& Instance();
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+    // a cache of its own, PROCCACHE uses ProcessSource::Native
+    explicit ProcessCache(ProcessSource& source, std::size_t capacity = DEFAULT_CAPACITY):
+        source(source), capacity(capacity) {};
+    ~ProcessCache();
+
+    // copies the image path of pid into path, false if the process can't be
+    // opened. a cached process costs no allocation once path has the capacity
+    bool ImagePath(DWORD pid, std::string& path);
+    // like ImagePath, but a process that isn't cached yet is closed again
+    // instead of being added
+    bool Peek(DWORD pid, std::string& path);
+    std::size_t Size();
+
+    // called by the source when a process it watches exits
+    void Exited(uint64_t waitId);
+
+private:
+    struct Entry {
+        uint64_t waitId;
+        uint64_t lastUse;
+        std::string path;
+        ProcessHandle handle;
+    };
+
+    ProcessSource& source;
+    std::size_t capacity;
+    std::mutex mutex;
+    // keyed by pid alone: a pid can't be reused while its handle is held here,
+    // so an entry never outlives its process, see ProcessSource for /proc
+    std::unordered_map<DWORD, Entry> entries;
+    // tells apart entries that reused a pid, the exit wait only knows the id
+    uint32_t nextWait = 0;
+    uint64_t uses = 0;
+
+    // copies the cached path of pid, false if it isn't cached. needs the lock
+    bool cached(DWORD pid, std::string& path);
+    // drops the least recently used entry, needs the lock
+    void evict();
+
+    // deleting the copy constructor to prevent copies
+    ProcessCache(const ProcessCache& obj) = delete;
+    void operator=(ProcessCache const&) = delete;
+};
+
+static ProcessCache& PROCCACHE = ProcessCache::Instance();
+
+#endif
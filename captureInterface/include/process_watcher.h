@@ -0,0 +1,55 @@
+#ifndef PROCESS_WATCHER_H
+#define PROCESS_WATCHER_H
+
+#include "game_rules.h"
+#include "process_cache.h"
+#include "win_types.h"
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+enum ProcessWatchResult {
+    PROC_STARTED,
+    PROC_TIMEOUT,
+    PROC_FAILED
+};
+
+// Reports processes as they start. Native() is a WMI subscription on
+// windows and a /proc scan elsewhere, which lets the launch detection run
+// and be tested natively. Processes running before Open aren't reported.
+class ProcessWatcher {
+
+public:
+    static ProcessWatcher& Native();
+
+    virtual ~ProcessWatcher() = default;
+
+    // called from the thread that calls Next
+    virtual bool Open() = 0;
+    // waits up to timeout for the next process start
+    virtual ProcessWatchResult Next(DWORD& pid, std::chrono::milliseconds timeout) = 0;
+    virtual void Close() = 0;
+};
+
+// Matches newly started processes against the game rules by their image
+// path alone, before they have a window. Other processes are only peeked
+// at, a game is kept in the process cache for when its window shows up.
+class LaunchDetector {
+
+public:
+    LaunchDetector(ProcessCache& processes, const GameRules& rules): processes(processes), rules(rules) {};
+
+    // true if pid is a game, Path and Match describe it until the next call
+    bool Check(DWORD pid);
+    std::string_view Path() const { return this->path; };
+    GameMatch Match() const { return this->match; };
+
+private:
+    ProcessCache& processes;
+    const GameRules& rules;
+    std::string path;
+    GameMatch match;
+};
+
+#endif
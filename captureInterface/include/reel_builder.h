@@ -0,0 +1,100 @@
+#ifndef REEL_BUILDER_H
+#define REEL_BUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct ReelOptions {
+    // moments in the reel
+    std::size_t count = 5;
+    // kept before and after each marker
+    int64_t leadMicros = 4000000;
+    int64_t tailMicros = 2000000;
+    // cut exactly at the moment instead of the keyframe before it, the part
+    // up to the next keyframe is re-encoded
+    bool precise = false;
+    std::string ffmpeg = "ffmpeg";
+};
+
+struct ReelSegment {
+    std::string path;
+    // microseconds from the start of the clip
+    int64_t start;
+    int64_t end;
+    // the stream copied part starts here, on a keyframe. [start, copyFrom)
+    // is re-encoded, which only happens for precise cuts.
+    int64_t copyFrom;
+    // last keyframe at or before start, where the segment begins when its
+    // head can't be re-encoded
+    int64_t keyframe;
+    float score;
+};
+
+// the first SPS and PPS NAL units of an annex b H.264 stream, without start
+// codes, empty when the stream has none
+struct H264ParameterSets {
+    std::string sps;
+    std::string pps;
+};
+H264ParameterSets FindParameterSets(std::string_view annexB);
+
+// Builds a highlight reel from saved clips: the best scoring marker windows
+// of their sidecars, in the order they were recorded, joined into one file.
+// Segments start on the keyframe before their moment so they can be stream
+// copied. Precise cuts start at the moment and re-encode up to the next
+// keyframe instead, which only plays back if the re-encoded head has the
+// same parameter sets as the clip. Build checks that and falls back to the
+// keyframe before when they differ. Cuts go through ffmpeg's concat demuxer,
+// which reads the copied parts straight from the clips, only precise cuts
+// write temporary files for their heads. Clips are expected to be H.264 with
+// AAC audio.
+//
+// AddClip and Plan only read sidecars, Build runs ffmpeg.
+class ReelBuilder {
+
+public:
+    ReelBuilder(ReelOptions options): options(std::move(options)) {};
+
+    // reads the clip's sidecar, false if it has none
+    bool AddClip(const std::string& videoPath);
+
+    std::vector<ReelSegment> Plan() const;
+    bool Build(const std::vector<ReelSegment>& segments, const std::string& output) const;
+
+private:
+    struct Source {
+        std::string path;
+        int64_t timestamp;
+        int64_t duration;
+        uint32_t fps;
+        std::vector<int64_t> keyframes;
+    };
+
+    // marker window of a source, overlapping windows are merged
+    struct Moment {
+        uint32_t source;
+        int64_t start;
+        int64_t end;
+        float score;
+    };
+
+    ReelOptions options;
+    std::vector<Source> sources;
+    std::vector<Moment> moments;
+
+    const Source* source(const std::string& path) const;
+    // joins neighbours of the same clip that overlap
+    static void merge(std::vector<ReelSegment>& segments);
+    bool run(const std::string& arguments) const;
+    // re-encodes [start, copyFrom) of the segment into head, false if that
+    // failed or the head's parameter sets differ from the clip's
+    bool encodeHead(const ReelSegment& segment, const std::string& head, const std::string& scratch) const;
+    // of the video's first frame, read through scratch
+    bool parameterSets(const std::string& video, const std::string& scratch, H264ParameterSets& sets) const;
+};
+
+#endif
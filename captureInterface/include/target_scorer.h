@@ -0,0 +1,60 @@
+#ifndef TARGET_SCORER_H
+#define TARGET_SCORER_H
+
+#include "win_types.h"
+#include "window_system.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+// Picks the capture target among the windows that matched a game rule.
+// Each candidate gets a score from its rule confidence, how much of its
+// monitor it covers, how long it has been in the foreground, recent input
+// while it was in the foreground and whether it looks like an owned popup or
+// tool window (launchers, overlays). Scores are only recomputed for the
+// window a change is about, and the best candidate is kept up to date
+// incrementally, only rescanning when the best one is removed or demoted.
+class TargetScorer {
+
+public:
+    explicit TargetScorer(WindowSystem& windows): windows(windows) {};
+
+    void Add(HWND hwnd, float confidence);
+    void Remove(HWND hwnd);
+    void OnForeground(HWND hwnd);
+    // measures a candidate again after it was moved or resized
+    void Moved(HWND hwnd);
+    // refreshes the time based terms of the foreground candidate
+    void Tick();
+
+    // NULL when there are no candidates
+    HWND Best() const { return this->best; };
+    float Score(HWND hwnd) const;
+
+private:
+    struct Candidate {
+        HWND hwnd;
+        float confidence;
+        // updated when added, moved and when it comes to the foreground
+        WindowShape shape;
+        uint64_t foregroundMs = 0;
+        uint64_t foregroundSince = 0;
+        uint64_t lastInput = 0;
+        float score = 0.0f;
+    };
+
+    // a new best has to beat the current one by this much, stops flip flopping
+    static constexpr float SWITCH_MARGIN = 0.1f;
+
+    WindowSystem& windows;
+    std::unordered_map<HWND, Candidate> candidates;
+    HWND foreground = NULL;
+    HWND best = NULL;
+
+    // returns the score before rescoring
+    float rescore(Candidate& c, uint64_t now);
+    void updateBest(Candidate& c, float previous);
+    void rescanBest();
+};
+
+#endif
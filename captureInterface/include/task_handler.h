@@ -15,6 +15,7 @@ class TaskHandler {
 public:
     static TaskHandler* Instance();
     void Start();
+    // ends the loop and asks the running tasks to stop
     void End();
     // use move on this function
     void AddTask(std::unique_ptr<Task> t);
@@ -28,6 +29,8 @@ private:
         std::thread tThread; 
         std::shared_ptr<std::atomic<bool>> complete;
         std::string tTitle;
+        // shared with the thread, so End can stop a task that is finishing
+        std::shared_ptr<Task> task;
     };
 
     bool running;
@@ -1,6 +1,9 @@
 #ifndef TASKS_H
 #define TASKS_H
 
+#include "app_config.h"
+#include "reel_builder.h"
+#include <atomic>
 #include <string>
 
 class Task {
@@ -11,11 +14,14 @@ public:
     Task() {};
     std::string GetName() { return name; };
     void SetName(std::string name) { this->name = name; };
+    virtual ~Task() = default;
     virtual void Execute() = 0;
+    // asks a running task to return from Execute, called from another thread
+    virtual void Stop() { this->SetRunning(false); };
     void SetRunning(bool running) { this->running = running; };
     bool GetRunning() { return this->running; };
 private:
-    int running;
+    std::atomic<bool> running{false};
 };
 
 namespace Tasks {
@@ -26,6 +32,24 @@ namespace Tasks {
             LogFGWins(); 
             void Execute() override; 
     }; 
+    class PrepareProfile: public Task {
+        public: 
+            PrepareProfile(CaptureProfile profile); 
+            void Execute() override; 
+        private:
+            CaptureProfile profile;
+    }; 
+    class BuildReel: public Task {
+        public: 
+            // options from the config, written to reels/
+            BuildReel(); 
+            BuildReel(ReelOptions options, std::string output); 
+            void Execute() override; 
+            const std::string& GetOutput() { return output; };
+        private:
+            ReelOptions options;
+            std::string output;
+    }; 
 
     // Polls 
     class PollHotkeys: public Task {
@@ -38,6 +62,34 @@ namespace Tasks {
             PollFGWin(); 
             void Execute() override; 
     }; 
+
+    // Watchers
+    class WatchWinEvents: public Task {
+        public: 
+            WatchWinEvents(); 
+            void Execute() override; 
+            // GetMessage blocks, the loop is woken with WM_QUIT
+            void Stop() override;
+        private:
+            std::atomic<unsigned long> threadId{0};
+    }; 
+    class WatchProcesses: public Task {
+        public: 
+            WatchProcesses(); 
+            void Execute() override; 
+    }; 
+    class WatchConfig: public Task {
+        public: 
+            WatchConfig(); 
+            void Execute() override; 
+    }; 
+
+    // Detectors
+    class DetectHighlights: public Task {
+        public: 
+            DetectHighlights(); 
+            void Execute() override; 
+    }; 
 }
 
 #endif
@@ -0,0 +1,111 @@
+#ifndef TEMPLATE_MATCHER_H
+#define TEMPLATE_MATCHER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// luma image with rows padded so kernels can read 8 bytes past the width
+struct LumaImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    std::vector<uint8_t> pixels;
+
+    void Resize(uint32_t width, uint32_t height);
+    uint8_t* Row(uint32_t y) { return this->pixels.data() + std::size_t(y) * this->stride; };
+    const uint8_t* Row(uint32_t y) const { return this->pixels.data() + std::size_t(y) * this->stride; };
+};
+
+// template prepared for normalised cross correlation: mean removed,
+// rows zero padded to a multiple of 8 for the dot product kernel
+struct NccTemplate {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    std::vector<int16_t> centred;
+    // sum and norm of the centred values
+    int64_t sum = 0;
+    double norm = 0.0;
+
+    void Build(const LumaImage& image);
+};
+
+struct MatchResult {
+    uint32_t x;
+    uint32_t y;
+    float score;
+};
+
+// best match of tmpl anywhere in image, score is the NCC in [-1, 1].
+// searches a 1/4 scale copy first and only refines the best coarse spots.
+MatchResult MatchTemplate(const LumaImage& image, const NccTemplate& tmpl, const NccTemplate& coarse, float threshold);
+
+// Watches configured screen regions for template images (kill feed icons,
+// victory banners, ...) and posts a TEMPLATE_MATCH event when one shows up.
+// Regions are cut out of every Nth submitted frame and matched on a worker
+// thread, a frame is skipped if the worker is still busy with the last one.
+class TemplateMatcher {
+
+public:
+    static TemplateMatcher& Instance();
+
+    // replaces the templates with the ones listed in filename, see
+    // data/templates.txt for the format
+    bool Load(const std::string& filename);
+    void SetInterval(uint32_t frames);
+    void Stop();
+
+    // called by FramePipeline with every frame, at the captured size
+    void Submit(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride, int64_t time);
+
+    std::string Name(int index) const;
+
+private:
+    struct Entry {
+        std::string name;
+        // region as fractions of the frame
+        float x, y, w, h;
+        float threshold;
+        NccTemplate full;
+        NccTemplate coarse;
+    };
+
+    // a match has to stay away this long to be reported again
+    static constexpr int64_t REARM_MICROS = 2000000;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+    bool stop = false;
+
+    std::vector<Entry> entries;
+    uint32_t interval = 6;
+    uint64_t frameCount = 0;
+
+    // job handed to the worker, one region per entry
+    bool pending = false;
+    bool busy = false;
+    int64_t jobTime = 0;
+    std::vector<LumaImage> regions;
+    // last time each template matched, a match is only reported when the
+    // template appears, not for every frame it stays on screen
+    std::vector<int64_t> lastSeen;
+
+    void work();
+
+    TemplateMatcher(){};
+    ~TemplateMatcher();
+
+    // deleting the copy constructor to prevent copies
+    TemplateMatcher(const TemplateMatcher& obj) = delete;
+    void operator=(TemplateMatcher const&) = delete;
+};
+
+static TemplateMatcher& TEMPLATES = TemplateMatcher::Instance();
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct SearchHit {
+    uint64_t id;
+    // how many of the query trigrams the document has
+    uint32_t matched;
+};
+
+// Incremental trigram index for typo tolerant substring search. Text is
+// lowercased, everything that isn't a letter or digit separates words, and
+// every 3 byte window of " word " is a trigram, so two letter queries still
+// match word starts.
+//
+// Documents get increasing internal ids as they are added, so posting lists
+// only ever grow at the end. Full blocks of 128 postings are delta + varint
+// compressed and keep their first and last id uncompressed, letting an
+// intersection skip blocks without decoding them. Removed documents are
+// tombstoned and filtered out of results, once they outnumber the live ones
+// (and COMPACT_MIN) the lists are rebuilt without them and the remaining
+// documents renumbered in the same order.
+//
+// Not thread safe, the owner serialises writes against searches. Searches
+// from several threads at once are fine.
+class TrigramIndex {
+
+public:
+    void Add(uint64_t id, std::string_view text);
+    void Remove(uint64_t id);
+    void Clear();
+
+    // documents containing every query trigram, newest first. If there are
+    // fewer than limit of those, documents sharing at least half of the
+    // query trigrams are added after them, newest first in steps of
+    // SEARCH_WINDOW documents and best matches first within a step.
+    std::vector<SearchHit> Search(std::string_view query, std::size_t limit) const;
+
+    std::size_t Size() const { return this->liveDocs; };
+    // compressed posting bytes, for stats
+    std::size_t PostingBytes() const;
+
+private:
+    static constexpr uint32_t BLOCK_SIZE = 128;
+    static constexpr std::size_t MAX_QUERY_TRIGRAMS = 64;
+    // documents looked at per step of a search
+    static constexpr uint32_t SEARCH_WINDOW = 1 << 16;
+    // tombstones kept before compacting is worth it
+    static constexpr std::size_t COMPACT_MIN = 4096;
+
+    struct Block {
+        uint32_t first;
+        uint32_t last;
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    struct PostingList {
+        std::vector<uint8_t> bytes;
+        std::vector<Block> blocks;
+        // postings after the last full block, not compressed yet
+        std::vector<uint32_t> tail;
+        uint32_t count = 0;
+    };
+
+    std::unordered_map<uint32_t, PostingList> postings;
+    std::vector<uint64_t> docIds;
+    std::vector<bool> removed;
+    std::unordered_map<uint64_t, uint32_t> docOf;
+    std::size_t liveDocs = 0;
+
+    static void trigrams(std::string_view text, bool query, std::vector<uint32_t>& out);
+    static void append(PostingList& list, uint32_t doc);
+    // first block that can hold ids >= doc
+    static std::size_t firstBlock(const std::vector<Block>& blocks, uint32_t doc);
+    static void decodeBlock(const PostingList& list, const Block& block, uint32_t* out);
+    static void intersect(const PostingList& list, std::vector<uint32_t>& docs, std::vector<uint32_t>& scratch);
+    // ids of the list in [lo, hi)
+    static void decodeRange(const PostingList& list, uint32_t lo, uint32_t hi, std::vector<uint32_t>& out);
+    void compact();
+};
+
+#endif
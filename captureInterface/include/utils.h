@@ -1,13 +1,21 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "win_types.h"
+#include "window_snapshot.h"
 #include <string>
-#include <unordered_map>
-#include <windef.h>
+#include <string_view>
 
 namespace Utils { 
-    std::string filepathHWND(HWND hwnd);
-    std::unordered_map<HWND, std::string> GetFgWins();
+    // class name into buf without allocating, returns its length
+    std::size_t classNameHWND(HWND hwnd, char* buf, std::size_t size);
+    // file name part of a path, inline so portable code can use it
+    inline std::string_view exeName(std::string_view path){
+        std::size_t sep = path.find_last_of("\\/");
+        return sep == std::string_view::npos ? path : path.substr(sep + 1);
+    }
+    // rescans visible titled windows into snapshot, reusing its storage
+    void ScanFgWins(WindowSnapshot& snapshot);
 }
 
 #endif
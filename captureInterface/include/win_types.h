@@ -0,0 +1,17 @@
+#ifndef WIN_TYPES_H
+#define WIN_TYPES_H
+
+// The windows handle and integer types used by headers that the native
+// build shares, see native/CMakeLists.txt. Elsewhere they are opaque
+// stand-ins with the same size.
+#ifdef _WIN32
+#include <windef.h>
+#else
+#include <cstdint>
+typedef void* HANDLE;
+typedef struct HWND__* HWND;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+#endif
+
+#endif
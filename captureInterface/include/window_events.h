@@ -0,0 +1,65 @@
+#ifndef WINDOW_EVENTS_H
+#define WINDOW_EVENTS_H
+
+#include "win_types.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+enum WinEventKind {
+    WIN_FOREGROUND,
+    WIN_SHOWN,
+    WIN_RENAMED,
+    WIN_DESTROYED,
+    // moved or resized
+    WIN_MOVED
+};
+
+struct WinEvent {
+    WinEventKind kind;
+    HWND hwnd;
+};
+
+// Queue of window changes fed by a window event source (the WatchWinEvents
+// task on Windows). Consumers block in Wait instead of polling the window
+// list, so game detection only runs when something actually changed, and
+// fall back to polling while the source isn't Reliable.
+class WindowEvents {
+
+public:
+    static WindowEvents& Instance();
+
+    void Push(WinEventKind kind, HWND hwnd);
+
+    // blocks until events are pending or the timeout passes. pending events
+    // are swapped into out, so reusing the same vector does not allocate.
+    // returns false on timeout.
+    bool Wait(std::vector<WinEvent>& out, std::chrono::milliseconds timeout);
+
+    // set by the event source once all of its hooks are in place. while it
+    // is false events may be missing and consumers have to poll
+    void SetReliable(bool reliable){ this->reliable = reliable; };
+    bool Reliable() const { return this->reliable; };
+
+private:
+    // events past this are dropped, consumers rescan on any wake up anyway
+    static constexpr std::size_t MAX_PENDING = 4096;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<WinEvent> pending;
+    std::atomic<bool> reliable{false};
+
+    WindowEvents(){};
+
+    // deleting the copy constructor to prevent copies
+    WindowEvents(const WindowEvents& obj) = delete;
+    void operator=(WindowEvents const&) = delete;
+};
+
+static WindowEvents& WINEVENTS = WindowEvents::Instance();
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef WINDOW_SNAPSHOT_H
+#define WINDOW_SNAPSHOT_H
+
+#include "win_types.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct WindowEntry {
+    HWND hwnd;
+    DWORD pid;
+    uint32_t titleOffset;
+    uint32_t titleLength;
+};
+
+// Flat list of visible, titled top level windows. Titles live in one
+// character arena and entries refer to them by offset. Clearing keeps the
+// capacity of both, so rescanning into the same snapshot stops allocating
+// once it has seen the largest window list.
+class WindowSnapshot {
+
+public:
+    void Clear();
+    void Add(HWND hwnd, DWORD pid, std::string_view title);
+#ifdef _WIN32
+    // converts a wide title to utf-8 straight into the arena
+    void Add(HWND hwnd, DWORD pid, const wchar_t* title, int titleLength);
+#endif
+    // sorts entries by handle, needed by Find and DiffWindows
+    void Sort();
+
+    // returns nullptr if the window isn't in the snapshot
+    const WindowEntry* Find(HWND hwnd) const;
+    std::string_view Title(const WindowEntry& entry) const;
+    const std::vector<WindowEntry>& Entries() const { return this->entries; };
+
+    // scratch space for reading wide titles before they go into the arena
+    std::vector<wchar_t> wideTitle;
+
+private:
+    std::vector<WindowEntry> entries;
+    std::vector<char> arena;
+};
+
+// compares two sorted snapshots. added holds indices into cur of windows that
+// are new or changed title, removed holds indices into prev of windows that
+// are gone. both vectors are cleared first and reused.
+void DiffWindows(const WindowSnapshot& prev, const WindowSnapshot& cur, 
+    std::vector<uint32_t>& added, std::vector<uint32_t>& removed);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef WINDOW_SYSTEM_H
+#define WINDOW_SYSTEM_H
+
+#include "win_types.h"
+#include "window_snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// how much of its monitor a window covers and whether it looks like a game
+struct WindowShape {
+    float coverage = 0.0f;
+    bool fullscreen = false;
+    // owned popups and tool windows: splash screens, launchers and overlays
+    bool auxiliary = false;
+};
+
+// What game detection asks the desktop. Native() is the win32 one (in
+// window_system.cpp, windows only), the tests drive GameDetector and
+// TargetScorer with a mock.
+class WindowSystem {
+
+public:
+    static WindowSystem& Native();
+
+    virtual ~WindowSystem() = default;
+
+    // visible, titled top level windows into snapshot, sorted by handle
+    virtual void Scan(WindowSnapshot& snapshot) = 0;
+    virtual HWND Foreground() = 0;
+    // writes the class name into buf without allocating, returns its length
+    virtual std::size_t ClassName(HWND hwnd, char* buf, std::size_t size) = 0;
+    virtual WindowShape Shape(HWND hwnd) = 0;
+    // monotonic milliseconds
+    virtual uint64_t NowMs() = 0;
+    // NowMs of the last keyboard or mouse input anywhere, 0 if unknown
+    virtual uint64_t LastInputMs() = 0;
+};
+
+#endif
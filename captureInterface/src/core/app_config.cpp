@@ -0,0 +1,346 @@
+#include "app_config.h"
+#include "logger.h"
+#include "preview_format.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+// the win32 values, hotkeys are only registered on windows but the config
+// is parsed everywhere
+enum : UINT {
+    MOD_ALT = 0x0001, MOD_CONTROL = 0x0002, MOD_SHIFT = 0x0004, MOD_WIN = 0x0008,
+    VK_PAUSE = 0x13, VK_SPACE = 0x20, VK_END = 0x23, VK_HOME = 0x24, 
+    VK_SNAPSHOT = 0x2C, VK_INSERT = 0x2D, VK_DELETE = 0x2E, VK_F1 = 0x70
+};
+#endif
+
+static std::string_view trim(std::string_view s){
+    const char* ws = " \t\r\n";
+    std::size_t start = s.find_first_not_of(ws);
+    if (start == std::string_view::npos) return {};
+    std::size_t end = s.find_last_not_of(ws);
+    return s.substr(start, end - start + 1);
+}
+
+static std::string upper(std::string_view s){
+    std::string res(s);
+    for (char& c: res) {
+        if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+    }
+    return res;
+}
+
+static bool parseInt(std::string_view value, int& out){
+    std::string s(value);
+    char* end;
+    errno = 0;
+    long v = std::strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX) return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+// out is only changed if the value is a number within [min, max]
+static bool parseInt(std::string_view value, int min, int max, int& out){
+    int v;
+    if (!parseInt(value, v) || v < min || v > max) return false;
+    out = v;
+    return true;
+}
+
+static bool parseBool(std::string_view value, bool& out){
+    std::string v = upper(value);
+    if (v == "TRUE" || v == "ON" || v == "1") out = true;
+    else if (v == "FALSE" || v == "OFF" || v == "0") out = false;
+    else return false;
+    return true;
+}
+
+// parses combinations like ALT+R or CTRL+SHIFT+F9
+static bool parseHotkey(std::string_view value, Hotkey& out){
+    Hotkey hk = { .modifiers = 0, .vk = 0 };
+    std::string v = upper(value);
+    std::string_view rest = v;
+
+    while (!rest.empty()) {
+        std::size_t plus = rest.find('+');
+        std::string_view part = trim(rest.substr(0, plus));
+        rest = plus == std::string_view::npos ? std::string_view() : rest.substr(plus + 1);
+
+        if (part == "ALT") hk.modifiers |= MOD_ALT;
+        else if (part == "CTRL") hk.modifiers |= MOD_CONTROL;
+        else if (part == "SHIFT") hk.modifiers |= MOD_SHIFT;
+        else if (part == "WIN") hk.modifiers |= MOD_WIN;
+        else if (hk.vk != 0) return false;
+        else if (part.size() == 1 && ((part[0] >= 'A' && part[0] <= 'Z') || (part[0] >= '0' && part[0] <= '9'))) {
+            hk.vk = part[0];
+        } else if (part.size() >= 2 && part[0] == 'F') {
+            int n;
+            if (!parseInt(part.substr(1), 1, 24, n)) return false;
+            hk.vk = VK_F1 + n - 1;
+        } 
+        else if (part == "SPACE") hk.vk = VK_SPACE;
+        else if (part == "HOME") hk.vk = VK_HOME;
+        else if (part == "END") hk.vk = VK_END;
+        else if (part == "INSERT") hk.vk = VK_INSERT;
+        else if (part == "DELETE") hk.vk = VK_DELETE;
+        else if (part == "PAUSE") hk.vk = VK_PAUSE;
+        else if (part == "PRINTSCREEN") hk.vk = VK_SNAPSHOT;
+        else return false;
+    }
+
+    if (hk.vk == 0) return false;
+    out = hk;
+    return true;
+}
+
+static bool parseList(std::string_view value, int* out, int count){
+    for (int i = 0; i < count; i++) {
+        std::size_t comma = value.find(',');
+        if ((comma == std::string_view::npos) != (i == count - 1)) return false;
+        if (!parseInt(trim(value.substr(0, comma)), out[i])) return false;
+        value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+    }
+    return true;
+}
+
+// keys of a [profile.<name>] section
+static bool applyProfileSetting(CaptureProfile& profile, std::string_view key, std::string_view value){
+    if (key == "fps") return parseInt(value, 1, INT_MAX, profile.fps);
+    if (key == "bitrate") return parseInt(value, 1, INT_MAX, profile.bitrateKbps);
+    if (key == "replay_seconds") return parseInt(value, 1, INT_MAX, profile.replaySeconds);
+    if (key == "resolution") {
+        std::size_t x = value.find('x');
+        if (x == std::string_view::npos) return false;
+        int width, height;
+        if (!parseInt(trim(value.substr(0, x)), 1, INT_MAX, width) || 
+            !parseInt(trim(value.substr(x + 1)), 1, INT_MAX, height)) {
+            return false;
+        }
+        profile.width = width;
+        profile.height = height;
+        return true;
+    }
+    if (key == "crop") {
+        int v[4];
+        if (!parseList(value, v, 4) || v[0] < 0 || v[1] < 0 || v[2] < 0 || v[3] < 0) return false;
+        profile.crop = CropRect{ .x = v[0], .y = v[1], .width = v[2], .height = v[3] };
+        return true;
+    }
+    return false;
+}
+
+// applies one setting, returns false if the key is unknown or the value invalid
+static bool applySetting(AppConfig& config, std::string_view key, std::string_view value){
+    if (key.starts_with("profile.")) {
+        std::string_view rest = key.substr(8);
+        std::size_t dot = rest.rfind('.');
+        if (dot == std::string_view::npos || dot == 0) return false;
+        std::string_view name = rest.substr(0, dot);
+        std::string_view setting = rest.substr(dot + 1);
+
+        for (CaptureProfile& p: config.profiles) {
+            if (p.name == name) return applyProfileSetting(p, setting, value);
+        }
+        // a new profile is only listed once a setting of it applies, an
+        // invalid line doesn't create it
+        CaptureProfile profile{ .name = std::string(name), .crop = {} };
+        if (!applyProfileSetting(profile, setting, value)) return false;
+        config.profiles.push_back(std::move(profile));
+        return true;
+    }
+    if (key.starts_with("games.")) {
+        std::string exe(key.substr(6));
+        for (char& c: exe) {
+            if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+        }
+        config.gameProfiles[exe] = value;
+        return true;
+    }
+
+    if (key == "capture.seconds") {
+        return parseInt(value, 1, INT_MAX, config.captureSeconds);
+    }
+    if (key == "capture.quality") {
+        std::string v = upper(value);
+        if (v == "LOW") config.quality = QUALITY_LOW;
+        else if (v == "MEDIUM") config.quality = QUALITY_MEDIUM;
+        else if (v == "HIGH") config.quality = QUALITY_HIGH;
+        else return false;
+        return true;
+    }
+    if (key == "capture.audio") {
+        return parseBool(value, config.audio);
+    }
+
+    if (key == "frames.enabled") {
+        return parseBool(value, config.frameRing);
+    }
+    if (key == "frames.file") {
+        config.frameRingFile = value;
+        return true;
+    }
+
+    if (key == "preview.enabled") {
+        return parseBool(value, config.preview);
+    }
+    if (key == "preview.file") {
+        config.previewFile = value;
+        return true;
+    }
+    if (key == "preview.fps") {
+        return parseInt(value, 1, 60, config.previewFps);
+    }
+    if (key == "preview.height") {
+        return parseInt(value, 90, PREVIEW_MAX_HEIGHT, config.previewHeight);
+    }
+
+    if (key == "ipc.enabled") {
+        return parseBool(value, config.ipc);
+    }
+    if (key == "ipc.name") {
+        config.ipcName = value;
+        return true;
+    }
+
+    if (key == "reel.count") {
+        return parseInt(value, 1, INT_MAX, config.reelCount);
+    }
+    if (key == "reel.precise") {
+        return parseBool(value, config.reelPrecise);
+    }
+    if (key == "reel.ffmpeg") {
+        if (value.empty()) return false;
+        config.ffmpegPath = value;
+        return true;
+    }
+
+    if (key == "log.compress") {
+        return parseBool(value, config.logCompress);
+    }
+
+    if (key == "plugins.directory") {
+        if (value.empty()) return false;
+        config.pluginDirectory = value;
+        return true;
+    }
+    if (key == "plugins.instructions") {
+        return parseInt(value, 1, INT_MAX, config.pluginInstructions);
+    }
+    if (key == "plugins.time_ms") {
+        return parseInt(value, 1, INT_MAX, config.pluginTimeMs);
+    }
+    if (key == "plugins.overrun_window_s") {
+        return parseInt(value, 1, INT_MAX, config.pluginOverrunWindowS);
+    }
+
+    static const std::pair<std::string_view, HotkeyId> hotkeys[] = {
+        { "hotkeys.quit", HOTKEY_QUIT },
+        { "hotkeys.start_capture", HOTKEY_START_CAPTURE },
+        { "hotkeys.stop_capture", HOTKEY_STOP_CAPTURE },
+        { "hotkeys.log_processes", HOTKEY_LOG_PROCESSES },
+        { "hotkeys.build_reel", HOTKEY_BUILD_REEL },
+    };
+    for (auto& [name, id]: hotkeys) {
+        if (key == name) return parseHotkey(value, config.hotkeys[id - 1]);
+    }
+
+    return false;
+}
+
+ConfigStore& ConfigStore::Instance(){
+    static ConfigStore inst;
+    return inst; 
+};
+
+ConfigStore::ConfigStore(){
+    // defaults until a file is loaded, so Current() is never null
+    this->publish(std::make_unique<AppConfig>());
+}
+
+bool ConfigStore::Load(const std::string& filename){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->filename = filename;
+    }
+    return this->Reload();
+}
+
+bool ConfigStore::Reload(){
+    auto config = std::make_unique<AppConfig>();
+    if (!this->parse(*config)) return false;
+
+    this->publish(std::move(config));
+    SLOG.info("config: published version {} from {}", this->Current()->version, this->filename);
+    return true;
+}
+
+void ConfigStore::Subscribe(DWORD threadId){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->subscribers.push_back(threadId);
+}
+
+bool ConfigStore::parse(AppConfig& config){
+    std::ifstream file(this->filename);
+    if (!file.is_open()) {
+        SLOG.error("config: unable to open {}, using defaults", this->filename);
+        return false;
+    }
+
+    std::string line;
+    std::string section;
+    int lineNo = 0;
+
+    while (std::getline(file, line)) {
+        lineNo++;
+
+        std::string_view rest = trim(line);
+        if (rest.empty() || rest[0] == '#') continue;
+
+        if (rest.front() == '[' && rest.back() == ']') {
+            section = trim(rest.substr(1, rest.size() - 2));
+            continue;
+        }
+
+        std::size_t eq = rest.find('=');
+        if (eq == std::string_view::npos) {
+            SLOG.error("config: {}:{} expected key = value", this->filename, lineNo);
+            continue;
+        }
+
+        std::string key = section.empty() ? "" : section + ".";
+        key += trim(rest.substr(0, eq));
+        std::string_view value = trim(rest.substr(eq + 1));
+
+        // a setting that doesn't apply keeps its default
+        if (!applySetting(config, key, value)) {
+            SLOG.error("config: {}:{} unknown setting or invalid value for {}", this->filename, lineNo, key);
+        }
+    }
+
+    return true;
+}
+
+void ConfigStore::publish(std::unique_ptr<AppConfig> config){
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    const AppConfig* prev = this->current.load(std::memory_order_relaxed);
+    config->version = prev == nullptr ? 1 : prev->version + 1;
+
+    // old configs stay alive, readers may still hold pointers to them
+    const AppConfig* next = config.get();
+    this->published.push_back(std::move(config));
+    this->current.store(next, std::memory_order_release);
+
+#ifdef _WIN32
+    for (DWORD threadId: this->subscribers) {
+        PostThreadMessage(threadId, WM_CONFIG_CHANGED, 0, 0);
+    }
+#endif
+}
@@ -1,5 +1,17 @@
 #include "application_data.h"
 
+#include <cstring>
+
+// longest prefix of s that fits in size bytes without splitting a utf-8
+// sequence, titles are utf-8 since the window snapshot converts them
+static std::size_t utf8Prefix(std::string_view s, std::size_t size){
+    if (s.size() <= size) return s.size();
+    // back off over continuation bytes to the start of the cut sequence
+    std::size_t n = size;
+    while (n > 0 && (static_cast<uint8_t>(s[n]) & 0xC0) == 0x80) n--;
+    return n;
+}
+
 AppData& AppData::Instance(){
     static AppData inst;
     if (inst.hasInit == false){
@@ -8,13 +20,71 @@ AppData& AppData::Instance(){
     return inst; 
 };
 
+AppState AppData::Snapshot() const {
+    uint64_t buf[STATE_WORDS];
+
+    while (true) {
+        uint64_t before = this->seq.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        // acquire keeps the second seq load from moving above the copy
+        for (std::size_t i = 0; i < STATE_WORDS; i++) {
+            buf[i] = this->words[i].load(std::memory_order_acquire);
+        }
+
+        if (this->seq.load(std::memory_order_relaxed) == before) break;
+    }
+
+    AppState state;
+    std::memcpy(&state, buf, sizeof(AppState));
+    return state;
+}
+
+template <typename F>
+void AppData::update(F change){
+    std::lock_guard<std::mutex> lock(this->writeMutex);
+
+    // only writers touch the words under the mutex, so reading them back is safe
+    uint64_t buf[STATE_WORDS];
+    for (std::size_t i = 0; i < STATE_WORDS; i++) {
+        buf[i] = this->words[i].load(std::memory_order_relaxed);
+    }
+    AppState state;
+    std::memcpy(&state, buf, sizeof(AppState));
+
+    change(state);
+    state.version++;
+    std::memcpy(buf, &state, sizeof(AppState));
+
+    uint64_t s = this->seq.load(std::memory_order_relaxed);
+    this->seq.store(s + 1, std::memory_order_relaxed);
 
-std::pair<HWND, std::string> AppData::GetCurrentGameWin(){
-    return currentGameWin;
+    // release keeps the odd seq store ahead of every word, so a reader that
+    // sees a new word also sees the write in progress
+    for (std::size_t i = 0; i < STATE_WORDS; i++) {
+        this->words[i].store(buf[i], std::memory_order_release);
+    }
+
+    this->seq.store(s + 2, std::memory_order_release);
 }
 
-void AppData::SetGameWin(HWND hwnd, std::string title){
-    currentGameWin = std::pair<HWND, std::string>(hwnd, title);
+void AppData::SetGameWin(HWND hwnd, std::string_view title){
+    this->update([&](AppState& state) {
+        state.gameWin = hwnd;
+        state.titleLength = utf8Prefix(title, sizeof(state.title));
+        std::memcpy(state.title, title.data(), state.titleLength);
+    });
 }
 
+void AppData::SetCaptureState(CaptureState captureState){
+    this->update([&](AppState& state) {
+        state.captureState = captureState;
+    });
+}
 
+void AppData::SetProfile(std::string_view profile){
+    this->update([&](AppState& state) {
+        state.profileLength = utf8Prefix(profile, sizeof(state.profile));
+        std::memcpy(state.profile, profile.data(), state.profileLength);
+    });
+}
@@ -0,0 +1,95 @@
+#include "audio_ring.h"
+
+#include <algorithm>
+
+AudioRing& AudioRing::Instance(){
+    static AudioRing inst;
+    return inst; 
+};
+
+void AudioRing::Configure(uint32_t sampleRate, uint32_t channels, uint32_t seconds){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->sampleRate = sampleRate;
+        this->channels = channels;
+        this->capacity = std::size_t(sampleRate) * seconds;
+        this->samples.assign(this->capacity * channels, 0.0f);
+        this->written = 0;
+        this->generation++;
+        this->startTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    // waiters are waiting for positions of the old generation
+    this->cv.notify_all();
+}
+
+void AudioRing::Write(const float* samples, std::size_t frames){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->capacity == 0) return;
+
+        // only the newest capacity frames can be kept
+        if (frames > this->capacity) {
+            samples += (frames - this->capacity) * this->channels;
+            this->written += frames - this->capacity;
+            frames = this->capacity;
+        }
+
+        std::size_t pos = this->written % this->capacity;
+        std::size_t first = std::min(frames, this->capacity - pos);
+        std::copy(samples, samples + first * this->channels, this->samples.begin() + pos * this->channels);
+        std::copy(samples + first * this->channels, samples + frames * this->channels, this->samples.begin());
+        this->written += frames;
+    }
+    this->cv.notify_all();
+}
+
+std::size_t AudioRing::Read(uint64_t& start, float* out, std::size_t frames) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->capacity == 0) return 0;
+
+    uint64_t oldest = this->written > this->capacity ? this->written - this->capacity : 0;
+    start = std::max(start, oldest);
+    if (start >= this->written) return 0;
+    frames = std::min<std::size_t>(frames, this->written - start);
+
+    std::size_t pos = start % this->capacity;
+    std::size_t first = std::min(frames, this->capacity - pos);
+    auto data = this->samples.begin();
+    std::copy(data + pos * this->channels, data + (pos + first) * this->channels, out);
+    std::copy(data, data + (frames - first) * this->channels, out + first * this->channels);
+    return frames;
+}
+
+bool AudioRing::Wait(uint64_t frame, std::chrono::milliseconds timeout){
+    std::unique_lock<std::mutex> lock(this->mutex);
+    uint64_t generation = this->generation;
+    return this->cv.wait_for(lock, timeout, [this, frame, generation]{
+        return this->written > frame || this->generation != generation;
+    });
+}
+
+uint64_t AudioRing::Written() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->written;
+}
+
+uint64_t AudioRing::Generation() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->generation;
+}
+
+uint32_t AudioRing::SampleRate() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->sampleRate;
+}
+
+uint32_t AudioRing::Channels() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->channels;
+}
+
+int64_t AudioRing::TimeOf(uint64_t frame) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->startTime + static_cast<int64_t>(frame * 1000000 / this->sampleRate);
+}
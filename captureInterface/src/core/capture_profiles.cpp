@@ -0,0 +1,167 @@
+#include "capture_profiles.h"
+#include "application_data.h"
+#include "game_db.h"
+#include "logger.h"
+#include "task_handler.h"
+#include "tasks.h"
+
+#include <chrono>
+
+ProfileManager& ProfileManager::Instance(){
+    static ProfileManager inst;
+    return inst; 
+};
+
+CaptureProfile ProfileManager::Resolve(std::string_view exeName){
+    const AppConfig* config = CONFIG.Current();
+
+    std::string exe(exeName);
+    for (char& c: exe) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+    }
+
+    std::string_view name = "default";
+    std::optional<GameInfo> info = GAMEDB.Lookup(exe);
+    if (info && !info->profile.empty()) name = info->profile;
+
+    auto it = config->gameProfiles.find(exe);
+    if (it != config->gameProfiles.end()) name = it->second;
+
+    const CaptureProfile* profile = config->FindProfile(name);
+    if (profile == nullptr) {
+        SLOG.error("profiles: no profile named {} for {}, using default", name, exe);
+        profile = config->FindProfile("default");
+    }
+    return *profile;
+}
+
+void ProfileManager::Prepare(std::string_view exeName){
+    CaptureProfile profile = this->Resolve(exeName);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        Resources current = this->Active();
+        if (current != nullptr && current->profile.name == profile.name) return;
+        if (this->prepared && this->prepared->profile.name == profile.name) return;
+    }
+
+    TaskHandler::Instance()->AddTask(std::make_unique<Tasks::PrepareProfile>(profile));
+}
+
+void ProfileManager::Build(const CaptureProfile& profile){
+    // allocating and touching the frame pool is the slow part, done without the lock
+    Resources resources = allocate(profile);
+
+    std::vector<Resources> release;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->prepared) release.push_back(std::move(this->prepared));
+        this->prepared = std::move(resources);
+        this->reclaim(release);
+    }
+
+    SLOG.info("profiles: prepared {} ({}x{} @ {} fps)", profile.name, profile.width, profile.height, profile.fps);
+}
+
+void ProfileManager::Activate(std::string_view exeName){
+    CaptureProfile profile = this->Resolve(exeName);
+
+    auto start = std::chrono::steady_clock::now();
+    Resources next;
+    std::vector<Resources> release;
+    bool wasPrepared = false;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        Resources current = this->Active();
+        if (current != nullptr && current->profile.name == profile.name) return;
+        if (this->prepared && this->prepared->profile.name == profile.name) {
+            next = std::move(this->prepared);
+            wasPrepared = true;
+        }
+    }
+
+    // not prepared in time, allocated here but still without the lock
+    if (!next) next = allocate(profile);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        Resources current = this->Active();
+        // another Activate got there while this one was allocating
+        if (current != nullptr && current->profile.name == profile.name) {
+            release.push_back(std::move(next));
+        } else {
+            current = this->swapActive(std::move(next));
+            if (current != nullptr) this->retired.push_back(std::move(current));
+        }
+    }
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->reclaim(release);
+    }
+    release.clear();
+
+    this->switches.fetch_add(1, std::memory_order_relaxed);
+    this->lastMicros.store(micros, std::memory_order_relaxed);
+    uint64_t max = this->maxMicros.load(std::memory_order_relaxed);
+    while (micros > max && !this->maxMicros.compare_exchange_weak(max, micros, std::memory_order_relaxed));
+
+    APPDATA.SetProfile(profile.name);
+    SLOG.info("profiles: switched to {} in {} us (prepared: {})", profile.name, micros, wasPrepared);
+}
+
+std::shared_ptr<const PipelineResources> ProfileManager::Active() const {
+    std::lock_guard<std::mutex> lock(this->activeMutex);
+    return this->active;
+}
+
+ProfileManager::Resources ProfileManager::swapActive(Resources next){
+    std::lock_guard<std::mutex> lock(this->activeMutex);
+    std::swap(this->active, next);
+    return next;
+}
+
+ProfileSwitchStats ProfileManager::Stats() const {
+    return ProfileSwitchStats{
+        .switches = this->switches.load(std::memory_order_relaxed),
+        .lastMicros = this->lastMicros.load(std::memory_order_relaxed),
+        .maxMicros = this->maxMicros.load(std::memory_order_relaxed),
+    };
+}
+
+std::size_t ProfileManager::Retired(){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->retired.size();
+}
+
+void ProfileManager::reclaim(std::vector<Resources>& release){
+    // the retired list holds the only reference once readers are done,
+    // readers only copy the active resources so the count can't go back up
+    auto unused = [](const Resources& r) { return r.use_count() == 1; };
+    for (Resources& r: this->retired) {
+        if (unused(r)) release.push_back(std::move(r));
+    }
+    std::erase(this->retired, nullptr);
+
+    // oldest first, whoever drops the last reference frees them
+    if (this->retired.size() > MAX_RETIRED) {
+        std::size_t excess = this->retired.size() - MAX_RETIRED;
+        for (std::size_t i = 0; i < excess; i++) release.push_back(std::move(this->retired[i]));
+        this->retired.erase(this->retired.begin(), this->retired.begin() + excess);
+    }
+}
+
+ProfileManager::Resources ProfileManager::allocate(const CaptureProfile& profile){
+    auto resources = std::make_shared<PipelineResources>();
+    resources->profile = profile;
+
+    // BGRA frames, value initialising the vectors touches every page
+    std::size_t frameBytes = std::size_t(profile.width) * profile.height * 4;
+    resources->framePool.resize(POOL_FRAMES);
+    for (std::vector<uint8_t>& frame: resources->framePool) {
+        frame.resize(frameBytes);
+    }
+    return resources;
+}
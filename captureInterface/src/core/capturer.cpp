@@ -13,6 +13,7 @@ Capturer& Capturer::Instance(){
 };
 
 void Capturer::Capture(){};
+void Capturer::Prepare(){};
 void Capturer::StartCapture(){};
 void Capturer::EndCapture(){};
 void Capturer::ScreenShot(){};
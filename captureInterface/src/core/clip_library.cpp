@@ -0,0 +1,517 @@
+#include "clip_library.h"
+#include "clip_sidecar.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <unordered_set>
+
+// Log records, all integers little endian:
+//
+//     uint32_t payloadSize
+//     uint32_t checksum           FNV-1a of the payload
+//     uint8_t op, uint64_t id     followed by the op's fields
+//
+// strings are a uint16_t length followed by the bytes
+
+enum ClipLogOp : uint8_t {
+    CLIPLOG_ADD = 1,
+    CLIPLOG_REMOVE = 2,
+    CLIPLOG_TAGS = 3,
+};
+
+static uint32_t checksum(const char* data, std::size_t size){
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void putInt(std::string& out, uint64_t value, int bytes){
+    for (int i = 0; i < bytes; i++) out += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+static void putString(std::string& out, std::string_view s){
+    s = s.substr(0, UINT16_MAX);
+    putInt(out, s.size(), 2);
+    out += s;
+}
+
+struct LogReader {
+    const char* data;
+    std::size_t size;
+    std::size_t pos = 0;
+    bool ok = true;
+
+    uint64_t Int(int bytes){
+        if (size - pos < static_cast<std::size_t>(bytes)) {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) value |= uint64_t(static_cast<uint8_t>(data[pos + i])) << (8 * i);
+        pos += bytes;
+        return value;
+    }
+
+    std::string String(){
+        std::size_t length = this->Int(2);
+        if (!ok || size - pos < length) {
+            ok = false;
+            return {};
+        }
+        std::string s(data + pos, length);
+        pos += length;
+        return s;
+    }
+};
+
+static std::string lower(std::string_view s){
+    std::string out(s);
+    for (char& c: out) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+    }
+    return out;
+}
+
+static std::vector<std::string> normaliseTags(std::vector<std::string> tags){
+    for (std::string& tag: tags) tag = lower(tag);
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+    tags.erase(std::remove(tags.begin(), tags.end(), std::string()), tags.end());
+    return tags;
+}
+
+static std::string frame(const std::string& payload){
+    std::string record;
+    putInt(record, payload.size(), 4);
+    putInt(record, checksum(payload.data(), payload.size()), 4);
+    return record + payload;
+}
+
+static std::string encodeAdd(const ClipRecord& clip){
+    std::string payload;
+    putInt(payload, CLIPLOG_ADD, 1);
+    putInt(payload, clip.id, 8);
+    putInt(payload, static_cast<uint64_t>(clip.timestamp), 8);
+    putInt(payload, clip.durationMs, 4);
+    putString(payload, clip.game);
+    putString(payload, clip.title);
+    putString(payload, clip.path);
+    putInt(payload, clip.tags.size(), 2);
+    for (const std::string& tag: clip.tags) putString(payload, tag);
+    return frame(payload);
+}
+
+static std::string encodeRemove(uint64_t id){
+    std::string payload;
+    putInt(payload, CLIPLOG_REMOVE, 1);
+    putInt(payload, id, 8);
+    return frame(payload);
+}
+
+static std::string encodeTags(uint64_t id, const std::vector<std::string>& tags){
+    std::string payload;
+    putInt(payload, CLIPLOG_TAGS, 1);
+    putInt(payload, id, 8);
+    putInt(payload, tags.size(), 2);
+    for (const std::string& tag: tags) putString(payload, tag);
+    return frame(payload);
+}
+
+ClipLibrary& ClipLibrary::Instance(){
+    static ClipLibrary inst;
+    return inst;
+};
+
+bool ClipLibrary::Open(const std::string& filename){
+    std::unique_lock lock(this->mutex);
+
+    std::string data;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (file.is_open()) data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::size_t valid = 0;
+    std::size_t skipped = 0;
+    if (!this->replay(data, valid, skipped)) {
+        SLOG.error("clip library: dropping {} bytes of torn or corrupt log at the end of {}", data.size() - valid, filename);
+        std::error_code ec;
+        std::filesystem::resize_file(filename, valid, ec);
+        if (ec) SLOG.error("clip library: unable to truncate {}: {}", filename, ec.message());
+    }
+
+    this->filename = filename;
+    this->log.open(filename, std::ios::binary | std::ios::app);
+    if (!this->log.is_open()) {
+        SLOG.error("clip library: unable to open {} for writing", filename);
+        return false;
+    }
+
+    SLOG.info("clip library: loaded {} clips from {}", this->byId.size(), filename);
+    lock.unlock();
+
+    // compacting drops the damaged records, they'd be skipped on every start otherwise
+    if (skipped > 0) {
+        SLOG.error("clip library: skipped {} bytes of corrupt records in {}", skipped, filename);
+        this->Compact();
+    } else if (this->garbage > 1024 && this->garbage > this->byId.size()) {
+        this->Compact();
+    }
+    return true;
+}
+
+void ClipLibrary::Close(){
+    std::unique_lock lock(this->mutex);
+    this->log.close();
+
+    this->nextId = 1;
+    this->garbage = 0;
+    this->clips.clear();
+    this->freeSlots.clear();
+    this->byId.clear();
+    this->byTime.clear();
+    this->byGame.clear();
+    this->byTag.clear();
+    this->text.Clear();
+}
+
+bool ClipLibrary::replay(const std::string& data, std::size_t& valid, std::size_t& skipped){
+    valid = 0;
+    skipped = 0;
+    while (valid < data.size()) {
+        std::size_t used = this->replayRecord(data.data() + valid, data.size() - valid);
+        if (used > 0) {
+            valid += used;
+            continue;
+        }
+
+        // a crash mid write only leaves a bad record at the end, one followed
+        // by a good record was damaged in place and is skipped
+        std::size_t next = valid + 1;
+        while (next < data.size() && (used = this->replayRecord(data.data() + next, data.size() - next)) == 0) next++;
+        if (next >= data.size()) return false;
+
+        skipped += next - valid;
+        this->garbage++;
+        valid = next + used;
+    }
+    return true;
+}
+
+std::size_t ClipLibrary::replayRecord(const char* data, std::size_t size){
+    LogReader header{ .data = data, .size = size };
+    std::size_t payloadSize = header.Int(4);
+    uint32_t sum = header.Int(4);
+    if (!header.ok || header.size - header.pos < payloadSize) return 0;
+
+    const char* payload = header.data + header.pos;
+    if (checksum(payload, payloadSize) != sum) return 0;
+
+    // the record is only applied once all of it has been read
+    LogReader r{ .data = payload, .size = payloadSize };
+    uint8_t op = r.Int(1);
+    uint64_t id = r.Int(8);
+
+    if (op == CLIPLOG_ADD) {
+        ClipRecord clip;
+        clip.id = id;
+        clip.timestamp = static_cast<int64_t>(r.Int(8));
+        clip.durationMs = r.Int(4);
+        clip.game = r.String();
+        clip.title = r.String();
+        clip.path = r.String();
+        std::size_t count = r.Int(2);
+        for (std::size_t i = 0; i < count && r.ok; i++) clip.tags.push_back(r.String());
+        if (!r.ok) return 0;
+
+        if (this->byId.count(id)) {
+            this->garbage++;
+            this->erase(this->byId[id]);
+        }
+        this->nextId = std::max(this->nextId, id + 1);
+        this->insert(std::move(clip));
+    } else if (op == CLIPLOG_REMOVE) {
+        if (!r.ok) return 0;
+        auto it = this->byId.find(id);
+        // the add and the remove are both garbage now
+        this->garbage += it == this->byId.end() ? 1 : 2;
+        if (it != this->byId.end()) this->erase(it->second);
+    } else if (op == CLIPLOG_TAGS) {
+        std::vector<std::string> tags;
+        std::size_t count = r.Int(2);
+        for (std::size_t i = 0; i < count && r.ok; i++) tags.push_back(r.String());
+        if (!r.ok) return 0;
+
+        this->garbage++;
+        auto it = this->byId.find(id);
+        if (it != this->byId.end()) this->retag(it->second, std::move(tags));
+    } else {
+        return 0;
+    }
+
+    return header.pos + payloadSize;
+}
+
+bool ClipLibrary::append(const std::string& record){
+    if (!this->log.is_open()) return false;
+    this->log.write(record.data(), record.size());
+    this->log.flush();
+    if (!this->log) {
+        SLOG.error("clip library: write to {} failed", this->filename);
+        this->log.clear();
+        return false;
+    }
+    return true;
+}
+
+uint64_t ClipLibrary::Add(ClipRecord clip){
+    std::unique_lock lock(this->mutex);
+    clip.id = this->nextId;
+    clip.tags = normaliseTags(std::move(clip.tags));
+    if (!this->append(encodeAdd(clip))) return 0;
+
+    this->nextId++;
+    this->insert(std::move(clip));
+    return this->nextId - 1;
+}
+
+bool ClipLibrary::Remove(uint64_t id){
+    std::unique_lock lock(this->mutex);
+    auto it = this->byId.find(id);
+    if (it == this->byId.end() || !this->append(encodeRemove(id))) return false;
+
+    this->garbage += 2;
+    this->erase(it->second);
+    return true;
+}
+
+bool ClipLibrary::SetTags(uint64_t id, std::vector<std::string> tags){
+    std::unique_lock lock(this->mutex);
+    auto it = this->byId.find(id);
+    tags = normaliseTags(std::move(tags));
+    if (it == this->byId.end() || !this->append(encodeTags(id, tags))) return false;
+
+    this->garbage++;
+    this->retag(it->second, std::move(tags));
+    return true;
+}
+
+std::size_t ClipLibrary::Import(const std::string& directory){
+    std::unordered_set<std::string> known;
+    {
+        std::shared_lock lock(this->mutex);
+        for (uint32_t slot: this->byTime) known.insert(this->clips[slot].path);
+    }
+
+    std::error_code ec;
+    std::size_t added = 0;
+    ClipSidecar sidecar;
+    for (const auto& entry: std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.path().extension() != ".msc") continue;
+
+        // only the sidecar is read, never the video
+        std::string sidecarPath = entry.path().string();
+        std::string videoPath = sidecarPath.substr(0, sidecarPath.size() - 4);
+        if (known.count(videoPath) || !sidecar.Open(sidecarPath)) continue;
+
+        const ClipSidecarHeader& h = sidecar.Header();
+        ClipRecord clip{ .id = 0, .timestamp = h.timestamp, .durationMs = h.durationMs,
+            .game = std::string(sidecar.Game()), .title = std::string(sidecar.Title()), .path = videoPath, .tags = {} };
+        if (this->Add(std::move(clip)) != 0) added++;
+    }
+    if (ec) SLOG.error("clip library: unable to scan {}: {}", directory, ec.message());
+
+    SLOG.info("clip library: imported {} clips from {}", added, directory);
+    return added;
+}
+
+bool ClipLibrary::Compact(){
+    std::unique_lock lock(this->mutex);
+    std::string tmp = this->filename + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        for (uint32_t slot: this->byTime) {
+            std::string record = encodeAdd(this->clips[slot]);
+            out.write(record.data(), record.size());
+        }
+        if (!out) {
+            SLOG.error("clip library: unable to write {}", tmp);
+            return false;
+        }
+    }
+
+    this->log.close();
+    std::error_code ec;
+    std::filesystem::rename(tmp, this->filename, ec);
+    if (ec) SLOG.error("clip library: unable to replace {}: {}", this->filename, ec.message());
+    else this->garbage = 0;
+
+    this->log.open(this->filename, std::ios::binary | std::ios::app);
+    return !ec && this->log.is_open();
+}
+
+void ClipLibrary::insert(ClipRecord clip){
+    uint32_t slot;
+    if (!this->freeSlots.empty()) {
+        slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+        this->clips[slot] = std::move(clip);
+    } else {
+        slot = static_cast<uint32_t>(this->clips.size());
+        this->clips.push_back(std::move(clip));
+    }
+
+    const ClipRecord& c = this->clips[slot];
+    this->byId[c.id] = slot;
+    this->insertSorted(this->byTime, slot);
+    this->insertSorted(this->byGame[lower(c.game)], slot);
+    for (const std::string& tag: c.tags) this->insertSorted(this->byTag[tag], slot);
+    this->indexText(c);
+}
+
+void ClipLibrary::erase(uint32_t slot){
+    ClipRecord& c = this->clips[slot];
+    this->eraseSorted(this->byTime, slot);
+
+    auto game = this->byGame.find(lower(c.game));
+    this->eraseSorted(game->second, slot);
+    if (game->second.empty()) this->byGame.erase(game);
+
+    for (const std::string& tag: c.tags) {
+        auto it = this->byTag.find(tag);
+        this->eraseSorted(it->second, slot);
+        if (it->second.empty()) this->byTag.erase(it);
+    }
+
+    this->byId.erase(c.id);
+    this->text.Remove(c.id);
+    c = ClipRecord{};
+    this->freeSlots.push_back(slot);
+}
+
+void ClipLibrary::retag(uint32_t slot, std::vector<std::string> tags){
+    ClipRecord& c = this->clips[slot];
+    for (const std::string& tag: c.tags) {
+        auto it = this->byTag.find(tag);
+        this->eraseSorted(it->second, slot);
+        if (it->second.empty()) this->byTag.erase(it);
+    }
+
+    c.tags = normaliseTags(std::move(tags));
+    for (const std::string& tag: c.tags) this->insertSorted(this->byTag[tag], slot);
+    this->indexText(c);
+}
+
+void ClipLibrary::indexText(const ClipRecord& clip){
+    std::string text = clip.title + ' ' + clip.game;
+    for (const std::string& tag: clip.tags) text += ' ' + tag;
+    this->text.Add(clip.id, text);
+}
+
+bool ClipLibrary::before(uint32_t a, uint32_t b) const {
+    const ClipRecord& x = this->clips[a];
+    const ClipRecord& y = this->clips[b];
+    if (x.timestamp != y.timestamp) return x.timestamp < y.timestamp;
+    return x.id < y.id;
+}
+
+void ClipLibrary::insertSorted(SlotList& list, uint32_t slot){
+    // clips are mostly saved in time order, so this is usually a push_back
+    if (list.empty() || this->before(list.back(), slot)) {
+        list.push_back(slot);
+        return;
+    }
+    auto pos = std::upper_bound(list.begin(), list.end(), slot,
+        [this](uint32_t a, uint32_t b) { return this->before(a, b); });
+    list.insert(pos, slot);
+}
+
+void ClipLibrary::eraseSorted(SlotList& list, uint32_t slot){
+    auto pos = std::lower_bound(list.begin(), list.end(), slot,
+        [this](uint32_t a, uint32_t b) { return this->before(a, b); });
+    if (pos != list.end() && *pos == slot) list.erase(pos);
+}
+
+std::vector<ClipRecord> ClipLibrary::List(const ClipFilter& filter) const {
+    std::shared_lock lock(this->mutex);
+    std::vector<ClipRecord> result;
+    std::vector<std::string> tags = normaliseTags(filter.tags);
+
+    // walk the shortest list that every result has to be in, the other
+    // conditions are checked per clip
+    const SlotList* candidates = &this->byTime;
+    const SlotList* gameList = nullptr;
+    if (!filter.game.empty()) {
+        auto it = this->byGame.find(lower(filter.game));
+        if (it == this->byGame.end()) return result;
+        candidates = gameList = &it->second;
+    }
+    for (const std::string& tag: tags) {
+        auto it = this->byTag.find(tag);
+        if (it == this->byTag.end()) return result;
+        if (it->second.size() < candidates->size()) candidates = &it->second;
+    }
+
+    // lists are time ordered, start at the last clip not after filter.to
+    auto end = std::upper_bound(candidates->begin(), candidates->end(), filter.to,
+        [this](int64_t to, uint32_t slot) { return to < this->clips[slot].timestamp; });
+
+    // the game only needs checking when walking a tag list
+    if (candidates == gameList) gameList = nullptr;
+
+    for (auto it = end; it != candidates->begin() && result.size() < filter.limit;) {
+        uint32_t slot = *--it;
+        const ClipRecord& clip = this->clips[slot];
+        if (clip.timestamp < filter.from) break;
+
+        if (this->matches(clip, gameList, slot, tags)) result.push_back(clip);
+    }
+    return result;
+}
+
+bool ClipLibrary::matches(const ClipRecord& clip, const SlotList* gameList, uint32_t slot, const std::vector<std::string>& tags) const {
+    if (gameList != nullptr && !std::binary_search(gameList->begin(), gameList->end(), slot,
+            [this](uint32_t a, uint32_t b) { return this->before(a, b); })) {
+        return false;
+    }
+    for (const std::string& tag: tags) {
+        if (!std::binary_search(clip.tags.begin(), clip.tags.end(), tag)) return false;
+    }
+    return true;
+}
+
+std::vector<ClipRecord> ClipLibrary::Search(std::string_view query, std::size_t limit) const {
+    std::shared_lock lock(this->mutex);
+    std::vector<ClipRecord> result;
+    for (const SearchHit& hit: this->text.Search(query, limit)) {
+        result.push_back(this->clips[this->byId.at(hit.id)]);
+    }
+    return result;
+}
+
+std::vector<std::string> ClipLibrary::Games() const {
+    std::shared_lock lock(this->mutex);
+    std::vector<std::string> games;
+    games.reserve(this->byGame.size());
+    for (const auto& [game, slots]: this->byGame) games.push_back(this->clips[slots.back()].game);
+    return games;
+}
+
+bool ClipLibrary::Find(uint64_t id, ClipRecord& out) const {
+    std::shared_lock lock(this->mutex);
+    auto it = this->byId.find(id);
+    if (it == this->byId.end()) return false;
+    out = this->clips[it->second];
+    return true;
+}
+
+std::size_t ClipLibrary::Size() const {
+    std::shared_lock lock(this->mutex);
+    return this->byId.size();
+}
@@ -0,0 +1,185 @@
+#include "clip_sidecar.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static uint32_t align8(std::size_t n){
+    return static_cast<uint32_t>((n + 7) & ~std::size_t(7));
+}
+
+bool ClipSidecar::Open(const std::string& filename){
+    this->Close();
+    if (!this->file.Open(filename)) return false;
+
+    if (!this->View(this->file.Data(), this->file.Size())) {
+        SLOG.error("clip sidecar: {} is not a valid version {} sidecar", filename, SIDECAR_VERSION_MAJOR);
+        this->file.Close();
+        return false;
+    }
+    return true;
+}
+
+void ClipSidecar::Close(){
+    this->header = nullptr;
+    this->base = nullptr;
+    this->file.Close();
+}
+
+bool ClipSidecar::View(const uint8_t* data, std::size_t size){
+    this->header = nullptr;
+    this->base = nullptr;
+
+    const ClipSidecarHeader* h = reinterpret_cast<const ClipSidecarHeader*>(data);
+    if (data == nullptr || size < sizeof(ClipSidecarHeader) || h->magic != SIDECAR_MAGIC ||
+        h->versionMajor != SIDECAR_VERSION_MAJOR || h->headerSize < sizeof(ClipSidecarHeader) ||
+        h->headerSize > size || h->fileSize != size) {
+        return false;
+    }
+
+    // sections must be aligned, in the file and not overlap the header
+    auto fits = [h, size](uint64_t offset, uint64_t bytes) {
+        return offset % 8 == 0 && offset >= h->headerSize && offset + bytes <= size;
+    };
+    if (!fits(h->keyframesOffset, uint64_t(h->keyframeCount) * sizeof(ClipSidecarKeyframe)) ||
+        !fits(h->markersOffset, uint64_t(h->markerCount) * sizeof(ClipSidecarMarker)) ||
+        !fits(h->stringsOffset, h->stringsSize)) {
+        return false;
+    }
+
+    auto inStrings = [h](uint64_t offset, uint64_t length) { return offset + length <= h->stringsSize; };
+    if (!inStrings(h->gameOffset, h->gameLength) || !inStrings(h->titleOffset, h->titleLength) ||
+        !inStrings(h->uploadUrlOffset, h->uploadUrlLength)) {
+        return false;
+    }
+
+    this->header = h;
+    this->base = data;
+    return true;
+}
+
+std::string_view ClipSidecar::string(uint32_t offset, uint32_t length) const {
+    return std::string_view(reinterpret_cast<const char*>(this->base + this->header->stringsOffset + offset), length);
+}
+
+std::string_view ClipSidecar::Game() const {
+    return this->string(this->header->gameOffset, this->header->gameLength);
+}
+
+std::string_view ClipSidecar::Title() const {
+    return this->string(this->header->titleOffset, this->header->titleLength);
+}
+
+std::string_view ClipSidecar::UploadUrl() const {
+    return this->string(this->header->uploadUrlOffset, this->header->uploadUrlLength);
+}
+
+std::span<const ClipSidecarKeyframe> ClipSidecar::Keyframes() const {
+    return { reinterpret_cast<const ClipSidecarKeyframe*>(this->base + this->header->keyframesOffset), this->header->keyframeCount };
+}
+
+std::span<const ClipSidecarMarker> ClipSidecar::Markers() const {
+    return { reinterpret_cast<const ClipSidecarMarker*>(this->base + this->header->markersOffset), this->header->markerCount };
+}
+
+const ClipSidecarKeyframe* ClipSidecar::KeyframeBefore(int64_t time) const {
+    std::span<const ClipSidecarKeyframe> keyframes = this->Keyframes();
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+        [](int64_t t, const ClipSidecarKeyframe& k) { return t < k.time; });
+    if (it == keyframes.begin()) return nullptr;
+    return &*(it - 1);
+}
+
+std::string ClipSidecar::PathFor(std::string_view videoPath){
+    return std::string(videoPath) + ".msc";
+}
+
+std::string ClipSidecar::Encode(const ClipMetadata& metadata){
+    ClipSidecarHeader h{};
+    h.magic = SIDECAR_MAGIC;
+    h.versionMajor = SIDECAR_VERSION_MAJOR;
+    h.versionMinor = SIDECAR_VERSION_MINOR;
+    h.headerSize = sizeof(ClipSidecarHeader);
+    h.timestamp = metadata.timestamp;
+    h.durationMs = metadata.durationMs;
+    h.fps = metadata.fps;
+    h.width = metadata.width;
+    h.height = metadata.height;
+    h.bitrateKbps = metadata.bitrateKbps;
+    h.gameId = metadata.gameId;
+    h.uploadState = metadata.uploadState;
+    h.uploadProgress = metadata.uploadProgress;
+
+    std::string strings;
+    auto addString = [&strings](const std::string& s, uint32_t& offset, uint32_t& length) {
+        offset = static_cast<uint32_t>(strings.size());
+        length = static_cast<uint32_t>(s.size());
+        strings += s;
+    };
+    addString(metadata.game, h.gameOffset, h.gameLength);
+    addString(metadata.title, h.titleOffset, h.titleLength);
+    addString(metadata.uploadUrl, h.uploadUrlOffset, h.uploadUrlLength);
+
+    std::vector<ClipSidecarKeyframe> keyframes = metadata.keyframes;
+    std::vector<ClipSidecarMarker> markers = metadata.markers;
+    std::stable_sort(keyframes.begin(), keyframes.end(),
+        [](const ClipSidecarKeyframe& a, const ClipSidecarKeyframe& b) { return a.time < b.time; });
+    std::stable_sort(markers.begin(), markers.end(),
+        [](const ClipSidecarMarker& a, const ClipSidecarMarker& b) { return a.time < b.time; });
+
+    h.keyframeCount = static_cast<uint32_t>(keyframes.size());
+    h.keyframesOffset = align8(sizeof(ClipSidecarHeader));
+    h.markerCount = static_cast<uint32_t>(markers.size());
+    h.markersOffset = align8(h.keyframesOffset + keyframes.size() * sizeof(ClipSidecarKeyframe));
+    h.stringsSize = static_cast<uint32_t>(strings.size());
+    h.stringsOffset = align8(h.markersOffset + markers.size() * sizeof(ClipSidecarMarker));
+    h.fileSize = h.stringsOffset + h.stringsSize;
+
+    std::string out(h.fileSize, '\0');
+    std::memcpy(out.data(), &h, sizeof(h));
+    if (!keyframes.empty()) std::memcpy(out.data() + h.keyframesOffset, keyframes.data(), keyframes.size() * sizeof(ClipSidecarKeyframe));
+    if (!markers.empty()) std::memcpy(out.data() + h.markersOffset, markers.data(), markers.size() * sizeof(ClipSidecarMarker));
+    std::memcpy(out.data() + h.stringsOffset, strings.data(), strings.size());
+    return out;
+}
+
+bool ClipSidecar::Write(const std::string& filename, const ClipMetadata& metadata){
+    std::string data = Encode(metadata);
+    std::string tmp = filename + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if (!out) {
+            SLOG.error("clip sidecar: unable to write {}", tmp);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, filename, ec);
+    if (ec) {
+        SLOG.error("clip sidecar: unable to replace {}: {}", filename, ec.message());
+        return false;
+    }
+    return true;
+}
+
+bool ClipSidecar::SetUploadState(const std::string& filename, ClipUploadState state, uint32_t progress){
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    ClipSidecarHeader h;
+    if (!file.read(reinterpret_cast<char*>(&h), sizeof(h)) || h.magic != SIDECAR_MAGIC ||
+        h.versionMajor != SIDECAR_VERSION_MAJOR) {
+        SLOG.error("clip sidecar: {} is not a valid version {} sidecar", filename, SIDECAR_VERSION_MAJOR);
+        return false;
+    }
+
+    // both fields are next to each other, one write updates them together
+    uint32_t fields[2] = { state, progress };
+    static_assert(offsetof(ClipSidecarHeader, uploadProgress) == offsetof(ClipSidecarHeader, uploadState) + 4);
+    file.seekp(offsetof(ClipSidecarHeader, uploadState));
+    file.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+    return static_cast<bool>(file);
+}
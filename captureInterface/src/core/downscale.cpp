@@ -0,0 +1,138 @@
+#include "downscale.h"
+
+#include <algorithm>
+#include <cstring>
+#include <emmintrin.h>
+
+uint32_t DownscaleFactor(uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight){
+    uint32_t fx = (width + maxWidth - 1) / maxWidth;
+    uint32_t fy = (height + maxHeight - 1) / maxHeight;
+    return std::clamp<uint32_t>(std::max(fx, fy), 1, 16);
+}
+
+void DownscaleBgra(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t factor, uint8_t* out, uint32_t outStride, DownscaleScratch& scratch){
+    const uint32_t outWidth = width / factor;
+    const uint32_t outHeight = height / factor;
+    // bytes of each source row that end up in a block
+    const uint32_t rowBytes = outWidth * factor * 4;
+
+    if (factor == 1) {
+        for (uint32_t y = 0; y < outHeight; y++) std::memcpy(out + std::size_t(y) * outStride, bgra + std::size_t(y) * stride, rowBytes);
+        return;
+    }
+
+    // a block sums to at most 255 * 16 * 16, which fits 16 bits
+    const __m128 scale = _mm_set1_ps(1.0f / float(factor * factor));
+    const __m128i zero = _mm_setzero_si128();
+
+    // per channel sums of the block rows
+    if (scratch.sums.size() < rowBytes) scratch.sums.resize(rowBytes);
+    uint16_t* sums = scratch.sums.data();
+
+    const uint8_t* rows[16];
+
+    for (uint32_t oy = 0; oy < outHeight; oy++) {
+        for (uint32_t r = 0; r < factor; r++) rows[r] = bgra + std::size_t(oy * factor + r) * stride;
+
+        // column sums are kept in registers across the block rows
+        uint32_t x = 0;
+        for (; x + 16 <= rowBytes; x += 16) {
+            __m128i lo = zero, hi = zero;
+            for (uint32_t r = 0; r < factor; r++) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[r] + x));
+                lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+                hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x + 8), hi);
+        }
+        for (; x < rowBytes; x++) {
+            uint16_t sum = 0;
+            for (uint32_t r = 0; r < factor; r++) sum += rows[r][x];
+            sums[x] = sum;
+        }
+
+        // one pixel is 4 channel sums, 8 bytes. two output pixels are summed
+        // side by side in one register
+        uint8_t* dst = out + std::size_t(oy) * outStride;
+        const std::size_t blockBytes = std::size_t(factor) * 4;
+        uint32_t ox = 0;
+        for (; ox + 2 <= outWidth; ox += 2) {
+            const uint16_t* a = sums + ox * blockBytes;
+            const uint16_t* b = a + blockBytes;
+            __m128i acc = zero;
+            for (uint32_t k = 0; k < factor; k++) {
+                acc = _mm_add_epi16(acc, _mm_unpacklo_epi64(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + k * 4)),
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + k * 4))));
+            }
+            // rounds to nearest
+            __m128i p0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(acc, zero)), scale));
+            __m128i p1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(acc, zero)), scale));
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), zero);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + ox * 4), packed);
+        }
+        if (ox < outWidth) {
+            const uint16_t* a = sums + ox * blockBytes;
+            __m128i acc = zero;
+            for (uint32_t k = 0; k < factor; k++) {
+                acc = _mm_add_epi16(acc, _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + k * 4)));
+            }
+            __m128i p0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(acc, zero)), scale));
+            int pixel = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(p0, zero), zero));
+            std::memcpy(dst + ox * 4, &pixel, 4);
+        }
+    }
+}
+
+// BT.601 luma weights in 1/256ths
+static const uint32_t LUMA_R = 77;
+static const uint32_t LUMA_G = 150;
+static const uint32_t LUMA_B = 29;
+
+void DownscaleLuma(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t factor, uint8_t* luma, DownscaleScratch& scratch){
+    const uint32_t outWidth = width / factor;
+    const uint32_t outHeight = height / factor;
+    const uint32_t columns = outWidth * factor;
+    const uint32_t count = factor * factor;
+    // BGRA order, two pixels per register
+    const __m128i weights = _mm_setr_epi16(LUMA_B, LUMA_G, LUMA_R, 0, LUMA_B, LUMA_G, LUMA_R, 0);
+    const __m128i zero = _mm_setzero_si128();
+
+    // weighted column sums of the block rows, at most 255 * 256 * 16 which
+    // fits 32 bits and so does a whole block
+    if (scratch.lumaSums.size() < columns) scratch.lumaSums.resize(columns);
+    uint32_t* sums = scratch.lumaSums.data();
+
+    for (uint32_t oy = 0; oy < outHeight; oy++) {
+        std::fill(sums, sums + columns, 0);
+        for (uint32_t r = 0; r < factor; r++) {
+            const uint8_t* row = bgra + std::size_t(oy * factor + r) * stride;
+            uint32_t x = 0;
+            for (; x + 4 <= columns; x += 4) {
+                // b * LUMA_B + g * LUMA_G and r * LUMA_R per pixel, then the
+                // two halves of each pixel added up
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 4 * x));
+                __m128 a = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights));
+                __m128 b = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights));
+                __m128i weighted = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+                    _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+                __m128i* acc = reinterpret_cast<__m128i*>(sums + x);
+                _mm_storeu_si128(acc, _mm_add_epi32(_mm_loadu_si128(acc), weighted));
+            }
+            for (; x < columns; x++) {
+                sums[x] += row[4 * x + 2] * LUMA_R + row[4 * x + 1] * LUMA_G + row[4 * x] * LUMA_B;
+            }
+        }
+
+        uint8_t* dst = luma + std::size_t(oy) * outWidth;
+        for (uint32_t ox = 0; ox < outWidth; ox++) {
+            const uint32_t* block = sums + std::size_t(ox) * factor;
+            uint32_t sum = 0;
+            for (uint32_t k = 0; k < factor; k++) sum += block[k];
+            dst[ox] = static_cast<uint8_t>((sum / count) >> 8);
+        }
+    }
+}
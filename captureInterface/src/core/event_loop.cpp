@@ -1,7 +1,16 @@
+#include "application_data.h"
+#include "capture_profiles.h"
+#include "capturer.h"
 #include "event_loop.h"
+#include "highlights.h"
+#include "ipc_api.h"
 #include "logger.h"
+#include "plugin_host.h"
+#include "process_cache.h"
 #include "task_handler.h"
 #include "tasks.h"
+#include "template_matcher.h"
+#include "utils.h"
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -46,21 +55,20 @@ void EventLoop::ProcessEvent(Event& e) {
     if (e.GetEventType() == EventType::HOTKEY) {
         EventData ed = e.GetEventData();
         int id = ed.hotkeyData.id;
+        PLUGINS.Post(PluginEvent{ .type = PLUGIN_HOTKEY, .id = id });
         if (id == 1) { 
-            std::ostringstream oss;
-            oss << "eventloop: quit application";
-            SLOG.info(oss.str());
+            SLOG.info("eventloop: quit application");
             // TODO: need to shutdown and clean thread handles for 
             // all systems gracefully
             exit(1); 
         } else if (id == 2) { 
-            std::ostringstream oss;
-            oss << "eventloop: start capture";
-            SLOG.info(oss.str());
+            SLOG.info("eventloop: start capture");
+            APPDATA.SetCaptureState(CAPTURE_RECORDING);
+            IpcApi::PushCapture(CAPTURE_RECORDING);
         } else if (id == 3) { 
-            std::ostringstream oss;
-            oss << "eventloop: stop capture";
-            SLOG.info(oss.str());
+            SLOG.info("eventloop: stop capture");
+            APPDATA.SetCaptureState(CAPTURE_IDLE);
+            IpcApi::PushCapture(CAPTURE_IDLE);
         } else if (id == 4) { 
             SLOG.info("eventloop: log processes");
 
@@ -68,12 +76,34 @@ void EventLoop::ProcessEvent(Event& e) {
             std::unique_ptr<Task> logTask = std::make_unique<Tasks::LogFGWins>();
             taskHandlerInst->AddTask(std::move(logTask));
 
+        } else if (id == 5) { 
+            SLOG.info("eventloop: build highlight reel");
+
+            TaskHandler* taskHandlerInst = TaskHandler::Instance();
+            taskHandlerInst->AddTask(std::make_unique<Tasks::BuildReel>());
+
         } else {
-            std::ostringstream oss;
-            oss << "unhandled hotkey id: " << id;
-            SLOG.info(oss.str());
+            SLOG.info("unhandled hotkey id: {}", id);
         }
     }
+    else if (e.GetEventType() == EventType::GAME_LAUNCH) {
+        EventData ed = e.GetEventData();
+        SLOG.info("eventloop: game launched, pid: {}, preparing capture", ed.processData.pid);
+        std::string path;
+        PROCCACHE.ImagePath(ed.processData.pid, path);
+        std::string exe(Utils::exeName(path));
+        PROFILES.Prepare(exe);
+        PLUGINS.Post(PluginEvent{ .type = PLUGIN_GAME, .id = static_cast<int64_t>(ed.processData.pid), .name = exe });
+        IpcApi::PushGame(exe);
+        CAPTURER.Prepare();
+    }
+    else if (e.GetEventType() == EventType::TEMPLATE_MATCH) {
+        TemplateMatchData match = e.GetEventData().templateMatchData;
+        SLOG.info("eventloop: template {} matched, score: {:.2f}", TEMPLATES.Name(match.index), match.score);
+        HIGHLIGHTS.Add(HighlightMarker{
+            .time = match.time, .durationMs = 1000, .kind = MARKER_TEMPLATE, .score = match.score
+        });
+    }
     else {
         SLOG.info("unable to process event");
     }
@@ -81,9 +111,8 @@ void EventLoop::ProcessEvent(Event& e) {
 
 void EventLoop::AddEvent(Event& e) {
 
-    std::ostringstream oss;
-    oss << "event loop: event push: " << e.GetEventTypeStr();
-    SLOG.info(oss.str());
+    static LogRateLimit pushLimit(20, std::chrono::seconds(5));
+    SLOG.info(pushLimit, "event loop: event push: {}", e.GetEventTypeStr());
 
     std::lock_guard<std::mutex> lock(this->eventBufMutex);
     this->eventBuf.push_back(e);
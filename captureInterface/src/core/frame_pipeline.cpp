@@ -0,0 +1,60 @@
+#include "frame_pipeline.h"
+#include "capture_profiles.h"
+#include "downscale.h"
+#include "frame_ring.h"
+#include "plugin_host.h"
+#include "preview.h"
+#include "template_matcher.h"
+
+#include <algorithm>
+#include <memory>
+
+FramePipeline& FramePipeline::Instance(){
+    static FramePipeline inst;
+    return inst;
+};
+
+FramePipeline::FramePipeline(): motion([](int64_t time, float score) {
+    PLUGINS.Post(PluginEvent{ .type = PLUGIN_FRAME, .time = time, .value = score });
+}){
+    // enough for every capture up to 16 times the ring's size
+    this->small.resize(std::size_t(FRAME_RING_MAX_WIDTH) * FRAME_RING_MAX_HEIGHT * 4);
+}
+
+void FramePipeline::sizeTimeline(){
+    std::shared_ptr<const PipelineResources> resources = PROFILES.Active();
+    if (resources == nullptr) return;
+
+    const CaptureProfile& profile = resources->profile;
+    std::size_t frames = std::size_t(std::max(1, profile.replaySeconds)) * std::max(1, profile.fps);
+    if (frames == this->replayFrames) return;
+
+    // clears the timeline, only happens when the profile changes
+    MOTION.SetCapacity(frames);
+    this->replayFrames = frames;
+}
+
+void FramePipeline::Process(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride, int64_t time){
+    this->sizeTimeline();
+
+    // templates are matched at the captured size, regions are cut from the
+    // full frame on every Nth frame only
+    TEMPLATES.Submit(bgra, width, height, stride, time);
+
+    uint32_t factor = DownscaleFactor(width, height, FRAME_RING_MAX_WIDTH, FRAME_RING_MAX_HEIGHT);
+    uint32_t smallWidth = width / factor;
+    uint32_t smallHeight = height / factor;
+    if (smallWidth == 0 || smallHeight == 0) return;
+
+    // the factor stops at 16, so wider than 10240 or taller than 5760
+    // captures come out larger than the ring. motion and the preview still
+    // work from them, the ring skips them.
+    const uint32_t smallStride = smallWidth * 4;
+    std::size_t smallSize = std::size_t(smallStride) * smallHeight;
+    if (this->small.size() < smallSize) this->small.resize(smallSize);
+    DownscaleBgra(bgra, width, height, stride, factor, this->small.data(), smallStride, this->scratch);
+
+    float score = this->motion.Process(this->small.data(), smallWidth, smallHeight, smallStride, time);
+    FRAMES.Publish(this->small.data(), smallWidth, smallHeight, smallStride, width, height, time, score);
+    PREVIEW.Publish(this->small.data(), smallWidth, smallHeight, smallStride, width, height, time);
+}
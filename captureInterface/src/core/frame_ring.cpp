@@ -0,0 +1,135 @@
+#include "frame_ring.h"
+#include "logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <windows.h>
+
+static uint32_t align64(std::size_t n){
+    return static_cast<uint32_t>((n + 63) & ~std::size_t(63));
+}
+
+FrameRing& FrameRing::Instance(){
+    static FrameRing inst;
+    return inst;
+};
+
+FrameRing::~FrameRing(){
+    this->Close();
+}
+
+bool FrameRing::Open(const std::string& file){
+    this->Close();
+
+    const uint32_t slotSize = align64(sizeof(FrameSlotHeader) + std::size_t(FRAME_RING_MAX_WIDTH) * FRAME_RING_MAX_HEIGHT * 4);
+    const uint32_t slotsOffset = align64(sizeof(FrameRingHeader));
+    const uint64_t size = slotsOffset + uint64_t(slotSize) * FRAME_RING_SLOTS;
+
+    HANDLE f = INVALID_HANDLE_VALUE;
+    if (!file.empty()) {
+        f = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (f == INVALID_HANDLE_VALUE) {
+            SLOG.error("frame ring: unable to open {}, error: {}", file, GetLastError());
+            return false;
+        }
+    }
+
+    // named only when backed by the page file, a file is found by its path
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+        static_cast<DWORD>(size), file.empty() ? FRAME_RING_MAPPING : NULL);
+    if (m == NULL) {
+        SLOG.error("frame ring: unable to create the mapping, error: {}", GetLastError());
+        if (f != INVALID_HANDLE_VALUE) CloseHandle(f);
+        return false;
+    }
+
+    void* v = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (v == nullptr) {
+        SLOG.error("frame ring: unable to map the ring, error: {}", GetLastError());
+        CloseHandle(m);
+        if (f != INVALID_HANDLE_VALUE) CloseHandle(f);
+        return false;
+    }
+
+    this->file = f == INVALID_HANDLE_VALUE ? NULL : f;
+    this->mapping = m;
+    this->view = static_cast<uint8_t*>(v);
+
+    // a file may hold a ring from an earlier run, start over. readers check
+    // the magic last, so it is cleared first and written last.
+    FrameRingHeader* h = reinterpret_cast<FrameRingHeader*>(this->view);
+    std::atomic_ref<uint32_t>(h->magic).store(0, std::memory_order_relaxed);
+    std::memset(this->view, 0, size);
+    h->version = FRAME_RING_VERSION;
+    h->headerSize = sizeof(FrameRingHeader);
+    h->slotCount = FRAME_RING_SLOTS;
+    h->slotSize = slotSize;
+    h->slotsOffset = slotsOffset;
+    h->maxWidth = FRAME_RING_MAX_WIDTH;
+    h->maxHeight = FRAME_RING_MAX_HEIGHT;
+    std::atomic_ref<uint32_t>(h->magic).store(FRAME_RING_MAGIC, std::memory_order_release);
+
+    this->header = h;
+    this->frame = 0;
+    this->lastPolls = 0;
+    this->lastPollTime = 0;
+
+    SLOG.info("frame ring: sharing frames through {}", file.empty() ? FRAME_RING_MAPPING : file);
+    return true;
+}
+
+void FrameRing::Close(){
+    if (this->view == nullptr) return;
+
+    UnmapViewOfFile(this->view);
+    CloseHandle(this->mapping);
+    if (this->file != NULL) CloseHandle(this->file);
+
+    this->view = nullptr;
+    this->header = nullptr;
+    this->mapping = NULL;
+    this->file = NULL;
+}
+
+void FrameRing::Publish(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t sourceWidth, uint32_t sourceHeight, int64_t time, float motion){
+    if (this->header == nullptr) return;
+
+    // nobody has looked at the ring for a while, skip the copy
+    uint64_t polls = std::atomic_ref<uint64_t>(this->header->readerPolls).load(std::memory_order_relaxed);
+    if (polls != this->lastPolls) {
+        this->lastPolls = polls;
+        this->lastPollTime = time;
+    }
+    if (time - this->lastPollTime > READER_TIMEOUT_MICROS) return;
+
+    if (width == 0 || height == 0 || width > this->header->maxWidth || height > this->header->maxHeight) return;
+
+    uint64_t n = ++this->frame;
+    uint8_t* base = this->view + this->header->slotsOffset + std::size_t((n - 1) % this->header->slotCount) * this->header->slotSize;
+    FrameSlotHeader* slot = reinterpret_cast<FrameSlotHeader*>(base);
+    std::atomic_ref<uint64_t> sequence(slot->sequence);
+
+    // odd while writing, readers still using the slot's old frame see the
+    // change when they check it again
+    sequence.store(2 * n - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->time = time;
+    slot->width = width;
+    slot->height = height;
+    slot->stride = width * 4;
+    slot->format = FRAME_BGRA;
+    slot->sourceWidth = sourceWidth;
+    slot->sourceHeight = sourceHeight;
+    slot->motion = motion;
+    uint8_t* pixels = base + sizeof(FrameSlotHeader);
+    for (uint32_t y = 0; y < height; y++) {
+        std::memcpy(pixels + std::size_t(y) * slot->stride, bgra + std::size_t(y) * stride, slot->stride);
+    }
+
+    sequence.store(2 * n, std::memory_order_release);
+    std::atomic_ref<uint64_t>(this->header->latest).store(n, std::memory_order_release);
+}
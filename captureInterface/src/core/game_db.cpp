@@ -0,0 +1,81 @@
+#include "game_db.h"
+#include "logger.h"
+
+GameDb& GameDb::Instance(){
+    static GameDb inst;
+    return inst; 
+};
+
+bool GameDb::Open(const std::string& filename){
+    this->header = nullptr;
+
+    if (!this->file.Open(filename)) {
+        SLOG.error("game db: unable to open {}", filename);
+        return false;
+    }
+
+    const uint8_t* base = this->file.Data();
+    const std::size_t size = this->file.Size();
+    const GameDbHeader* h = reinterpret_cast<const GameDbHeader*>(base);
+
+    // only the section bounds are checked, records are checked as they are read
+    auto fits = [size](uint64_t offset, uint64_t bytes) { 
+        return offset % 4 == 0 && offset + bytes <= size; 
+    };
+    if (size < sizeof(GameDbHeader) || h->magic != GAMEDB_MAGIC || h->version != GAMEDB_VERSION ||
+        h->bucketCount == 0 || h->slotCount == 0 ||
+        !fits(h->seedsOffset, uint64_t(h->bucketCount) * sizeof(uint32_t)) ||
+        !fits(h->slotsOffset, uint64_t(h->slotCount) * sizeof(uint32_t)) ||
+        !fits(h->recordsOffset, uint64_t(h->recordCount) * sizeof(GameDbRecord)) ||
+        uint64_t(h->stringsOffset) + h->stringsSize > size) {
+        SLOG.error("game db: {} is not a valid version {} database", filename, GAMEDB_VERSION);
+        this->file.Close();
+        return false;
+    }
+
+    this->seeds = reinterpret_cast<const uint32_t*>(base + h->seedsOffset);
+    this->slots = reinterpret_cast<const uint32_t*>(base + h->slotsOffset);
+    this->records = reinterpret_cast<const GameDbRecord*>(base + h->recordsOffset);
+    this->strings = reinterpret_cast<const char*>(base + h->stringsOffset);
+    this->header = h;
+
+    SLOG.info("game db: mapped {} games from {}", h->recordCount, filename);
+    return true;
+}
+
+std::optional<GameInfo> GameDb::Lookup(std::string_view key) const {
+    if (this->header == nullptr) return std::nullopt;
+
+    // keys are stored lower case, fold into a stack buffer
+    char buf[260];
+    if (key.empty() || key.size() > sizeof(buf)) return std::nullopt;
+    for (std::size_t i = 0; i < key.size(); i++) {
+        char c = key[i];
+        buf[i] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+    std::string_view folded(buf, key.size());
+
+    uint64_t hash = GameDbHash(folded);
+    uint32_t seed = this->seeds[hash % this->header->bucketCount];
+    uint32_t index = this->slots[GameDbSlot(hash, seed, this->header->slotCount)];
+    if (index >= this->header->recordCount) return std::nullopt;
+
+    const GameDbRecord& rec = this->records[index];
+    const uint64_t stringsSize = this->header->stringsSize;
+    if (uint64_t(rec.keyOffset) + rec.keyLength > stringsSize ||
+        uint64_t(rec.titleOffset) + rec.titleLength > stringsSize ||
+        uint64_t(rec.profileOffset) + rec.profileLength > stringsSize) {
+        return std::nullopt;
+    }
+
+    // the slot of a key that isn't in the database holds some other record
+    if (std::string_view(this->strings + rec.keyOffset, rec.keyLength) != folded) {
+        return std::nullopt;
+    }
+
+    return GameInfo{
+        .title = std::string_view(this->strings + rec.titleOffset, rec.titleLength),
+        .gameId = rec.gameId,
+        .profile = std::string_view(this->strings + rec.profileOffset, rec.profileLength),
+    };
+}
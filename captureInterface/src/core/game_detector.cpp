@@ -0,0 +1,98 @@
+#include "game_detector.h"
+#include "game_db.h"
+#include "logger.h"
+#include "utils.h"
+
+#include <optional>
+
+GameDetector::GameDetector(WindowSystem& windows, ProcessCache& processes, const GameRules& rules):
+    windows(windows), processes(processes), rules(rules), scorer(windows) {};
+
+bool GameDetector::Poll(WindowEvents& source){
+    uint64_t interval = source.Reliable() ? RESCAN_MS : POLL_MS;
+
+    // a timeout means nothing was heard for a whole interval
+    if (!source.Wait(this->events, std::chrono::milliseconds(interval))) this->rescan = true;
+    this->OnEvents(this->events);
+    this->RescanIfOlder(interval);
+    // moves aren't heard about either, the target at least is kept measured
+    if (!source.Reliable()) this->scorer.Moved(this->target);
+    return this->Update();
+}
+
+void GameDetector::OnEvents(const std::vector<WinEvent>& events){
+    for (const WinEvent& ev: events) {
+        if (ev.kind == WIN_FOREGROUND) {
+            this->scorer.OnForeground(ev.hwnd);
+        } else if (ev.kind == WIN_MOVED) {
+            this->scorer.Moved(ev.hwnd);
+        } else if (ev.kind == WIN_SHOWN || ev.kind == WIN_RENAMED ||
+            (ev.kind == WIN_DESTROYED && this->latest->Find(ev.hwnd) != nullptr)) {
+            this->rescan = true;
+        }
+    }
+}
+
+void GameDetector::RescanIfOlder(uint64_t intervalMs){
+    if (this->windows.NowMs() - this->lastScanMs >= intervalMs) this->rescan = true;
+}
+
+bool GameDetector::Update(){
+    if (this->rescan) this->scan();
+    this->scorer.Tick();
+
+    HWND best = this->scorer.Best();
+    if (best == this->target) return false;
+    this->target = best;
+    return true;
+}
+
+const WindowEntry* GameDetector::Target() const {
+    return this->target == nullptr ? nullptr : this->latest->Find(this->target);
+}
+
+std::string_view GameDetector::TargetTitle() const {
+    const WindowEntry* win = this->Target();
+    return win == nullptr ? std::string_view() : this->latest->Title(*win);
+}
+
+float GameDetector::TargetScore() const {
+    return this->scorer.Score(this->target);
+}
+
+void GameDetector::scan(){
+    this->rescan = false;
+    this->lastScanMs = this->windows.NowMs();
+    this->scans++;
+
+    std::swap(this->latest, this->older);
+    this->windows.Scan(*this->latest);
+    DiffWindows(*this->older, *this->latest, this->added, this->removed);
+
+    for (uint32_t i: this->removed) {
+        this->scorer.Remove(this->older->Entries()[i].hwnd);
+    }
+
+    // only new or retitled windows are checked against the game rules
+    char className[256];
+    for (uint32_t i: this->added) {
+        const WindowEntry& win = this->latest->Entries()[i];
+        this->processes.ImagePath(win.pid, this->filePath);
+        std::size_t classLength = this->windows.ClassName(win.hwnd, className, sizeof(className));
+        GameMatch match = this->rules.Match(this->filePath, std::string_view(className, classLength));
+        if (!match.Matched()) continue;
+
+        static LogRateLimit detectedLimit(5, std::chrono::seconds(10));
+        SLOG.info(detectedLimit, "game window detected: {} path: {} rule: {} confidence: {}", 
+            this->latest->Title(win), this->filePath, match.rule->pattern, match.confidence);
+
+        std::optional<GameInfo> info = GAMEDB.Lookup(Utils::exeName(this->filePath));
+        if (info) {
+            static LogRateLimit knownLimit(5, std::chrono::seconds(10));
+            SLOG.info(knownLimit, "known game: {} id: {} profile: {}", 
+                info->title, info->gameId, info->profile);
+        }
+
+        this->scorer.Add(win.hwnd, match.confidence);
+    }
+}
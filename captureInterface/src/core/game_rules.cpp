@@ -0,0 +1,232 @@
+#include "game_rules.h"
+#include "logger.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <queue>
+
+// paths are matched case insensitively with either separator
+static uint8_t fold(char c){
+    uint8_t b = static_cast<uint8_t>(c);
+    if (b >= 'A' && b <= 'Z') return b - 'A' + 'a';
+    if (b == '/') return '\\';
+    return b;
+}
+
+static std::string_view trim(std::string_view s){
+    const char* ws = " \t\r\n";
+    std::size_t start = s.find_first_not_of(ws);
+    if (start == std::string_view::npos) return {};
+    std::size_t end = s.find_last_not_of(ws);
+    return s.substr(start, end - start + 1);
+}
+
+// splits off the first whitespace separated token of s
+static std::string_view nextToken(std::string_view& s){
+    std::size_t split = s.find_first_of(" \t");
+    std::string_view token = s.substr(0, split);
+    s = split == std::string_view::npos ? std::string_view() : trim(s.substr(split));
+    return token;
+}
+
+GameRules& GameRules::Instance(){
+    static GameRules inst;
+    return inst;
+};
+
+GameRules::GameRules(){
+    // built in fallback, used until a rules file has been loaded
+    this->Compile({ GameRule{
+        .kind = RULE_PATH, .pattern = "steamapps", .confidence = 0.9f, .ignore = false
+    }});
+}
+
+bool GameRules::Load(const std::string& filename){
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        SLOG.error("game rules: unable to open {}", filename);
+        return false;
+    }
+
+    std::vector<GameRule> parsed;
+    std::string line;
+    int lineNo = 0;
+
+    while (std::getline(file, line)) {
+        lineNo++;
+
+        std::string_view rest = trim(line);
+        if (rest.empty() || rest[0] == '#') continue;
+
+        std::string_view kind = nextToken(rest);
+        std::string_view confidence = nextToken(rest);
+        std::string_view pattern = rest;
+
+        GameRule rule;
+        if (kind == "path") rule.kind = RULE_PATH;
+        else if (kind == "exe") rule.kind = RULE_EXE;
+        else if (kind == "class") rule.kind = RULE_CLASS;
+        else {
+            SLOG.error("game rules: {}:{} unknown rule kind '{}'", filename, lineNo, kind);
+            continue;
+        }
+
+        if (confidence == "ignore") {
+            rule.ignore = true;
+            rule.confidence = 0.0f;
+        } else {
+            std::string value(confidence);
+            char* end;
+            rule.ignore = false;
+            rule.confidence = std::strtof(value.c_str(), &end);
+            if (value.empty() || *end != '\0') {
+                SLOG.error("game rules: {}:{} invalid confidence '{}'", filename, lineNo, confidence);
+                continue;
+            }
+        }
+
+        if (pattern.empty()) {
+            SLOG.error("game rules: {}:{} missing pattern", filename, lineNo);
+            continue;
+        }
+        rule.pattern = pattern;
+
+        parsed.push_back(std::move(rule));
+    }
+
+    this->Compile(std::move(parsed));
+    SLOG.info("game rules: loaded {} rules from {}", this->rules.size(), filename);
+    return true;
+}
+
+void GameRules::Compile(std::vector<GameRule> rules){
+    this->rules = std::move(rules);
+    this->exeRules.clear();
+    this->classRules.clear();
+
+    for (int32_t i = 0; i < static_cast<int32_t>(this->rules.size()); i++) {
+        GameRule& rule = this->rules[i];
+        for (char& c: rule.pattern) c = fold(c);
+
+        if (rule.kind == RULE_EXE) this->addName(this->exeRules, i);
+        else if (rule.kind == RULE_CLASS) this->addName(this->classRules, i);
+    }
+
+    this->compilePaths();
+}
+
+void GameRules::addName(NameMap& names, int32_t rule){
+    auto [it, inserted] = names.try_emplace(this->rules[rule].pattern, rule);
+    // an ignore rule for a name always wins over a game rule for it
+    if (!inserted && !this->rules[it->second].ignore) {
+        it->second = this->rules[rule].ignore ? rule : this->better(it->second, rule);
+    }
+}
+
+int32_t GameRules::better(int32_t a, int32_t b) const {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    return this->rules[b].confidence > this->rules[a].confidence ? b : a;
+}
+
+void GameRules::compilePaths(){
+    // only bytes used by some pattern get their own symbol
+    std::fill(std::begin(this->byteClass), std::end(this->byteClass), 0);
+    this->alphabetSize = 1;
+    for (const GameRule& rule: this->rules) {
+        if (rule.kind != RULE_PATH) continue;
+        for (char c: rule.pattern) {
+            uint8_t b = static_cast<uint8_t>(c);
+            if (this->byteClass[b] == 0) this->byteClass[b] = this->alphabetSize++;
+        }
+    }
+
+    const int n = this->alphabetSize;
+    this->delta.assign(n, -1);
+    this->stateRule.assign(1, -1);
+    this->stateIgnore.assign(1, false);
+
+    // build the trie of path patterns
+    for (int32_t i = 0; i < static_cast<int32_t>(this->rules.size()); i++) {
+        const GameRule& rule = this->rules[i];
+        if (rule.kind != RULE_PATH) continue;
+
+        int32_t state = 0;
+        for (char c: rule.pattern) {
+            int32_t& next = this->delta[state * n + this->byteClass[static_cast<uint8_t>(c)]];
+            if (next < 0) {
+                next = static_cast<int32_t>(this->stateRule.size());
+                this->delta.resize(this->delta.size() + n, -1);
+                this->stateRule.push_back(-1);
+                this->stateIgnore.push_back(false);
+            }
+            state = this->delta[state * n + this->byteClass[static_cast<uint8_t>(c)]];
+        }
+
+        if (rule.ignore) this->stateIgnore[state] = true;
+        else this->stateRule[state] = this->better(this->stateRule[state], i);
+    }
+
+    // breadth first over the trie, filling in missing transitions from the
+    // failure state so matching never has to follow failure links
+    std::vector<int32_t> fail(this->stateRule.size(), 0);
+    std::queue<int32_t> queue;
+
+    for (int c = 0; c < n; c++) {
+        int32_t& next = this->delta[c];
+        if (next < 0) next = 0;
+        else queue.push(next);
+    }
+
+    while (!queue.empty()) {
+        int32_t state = queue.front();
+        queue.pop();
+
+        for (int c = 0; c < n; c++) {
+            int32_t& next = this->delta[state * n + c];
+            int32_t viaFail = this->delta[fail[state] * n + c];
+            if (next < 0) {
+                next = viaFail;
+                continue;
+            }
+
+            fail[next] = viaFail;
+            this->stateRule[next] = this->better(this->stateRule[next], this->stateRule[viaFail]);
+            this->stateIgnore[next] = this->stateIgnore[next] || this->stateIgnore[viaFail];
+            queue.push(next);
+        }
+    }
+}
+
+GameMatch GameRules::Match(std::string_view path, std::string_view windowClass) const {
+    int32_t best = -1;
+    bool ignored = false;
+
+    // single pass over the path for every path pattern
+    const int n = this->alphabetSize;
+    int32_t state = 0;
+    for (char c: path) {
+        state = this->delta[state * n + this->byteClass[fold(c)]];
+        best = this->better(best, this->stateRule[state]);
+        ignored = ignored || this->stateIgnore[state];
+    }
+
+    // names are folded into a stack buffer, names longer than it can't match
+    char buf[260];
+    auto lookup = [&](const NameMap& names, std::string_view name) {
+        if (names.empty() || name.empty() || name.size() > sizeof(buf)) return;
+        for (std::size_t i = 0; i < name.size(); i++) buf[i] = fold(name[i]);
+
+        auto it = names.find(std::string_view(buf, name.size()));
+        if (it == names.end()) return;
+        if (this->rules[it->second].ignore) ignored = true;
+        else best = this->better(best, it->second);
+    };
+
+    std::size_t sep = path.find_last_of("\\/");
+    lookup(this->exeRules, sep == std::string_view::npos ? path : path.substr(sep + 1));
+    lookup(this->classRules, windowClass);
+
+    if (ignored || best < 0) return GameMatch{};
+    return GameMatch{ .rule = &this->rules[best], .confidence = this->rules[best].confidence };
+}
@@ -0,0 +1,129 @@
+#include "ipc_api.h"
+#include "app_config.h"
+#include "capture_profiles.h"
+#include "clip_library.h"
+#include "ipc_server.h"
+#include "plugin_host.h"
+#include "task_handler.h"
+#include "tasks.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// listings are capped so a response stays well under IPC_MAX_MESSAGE
+static const uint32_t MAX_CLIPS = 500;
+
+static void writeClips(IpcWriter& response, const std::vector<ClipRecord>& clips){
+    response.Put(static_cast<uint32_t>(clips.size()));
+    for (const ClipRecord& clip: clips) {
+        response.Put(clip.id);
+        response.Put(clip.timestamp);
+        response.Put(clip.durationMs);
+        response.PutString(clip.game);
+        response.PutString(clip.title);
+        response.PutString(clip.path);
+    }
+}
+
+static IpcStatus status(IpcWriter& response){
+    AppState state = APPDATA.Snapshot();
+    response.Put(static_cast<uint8_t>(state.captureState));
+    response.Put(CONFIG.Current()->version);
+    response.PutString(state.Title());
+    response.PutString(state.Profile());
+
+    ProfileSwitchStats switches = PROFILES.Stats();
+    response.Put(switches.switches);
+    response.Put(switches.lastMicros);
+    response.Put(switches.maxMicros);
+    return IPC_OK;
+}
+
+static IpcStatus setCapture(IpcReader& request){
+    uint8_t recording;
+    if (!request.Get(recording)) return IPC_BAD_REQUEST;
+
+    CaptureState state = recording ? CAPTURE_RECORDING : CAPTURE_IDLE;
+    APPDATA.SetCaptureState(state);
+    IpcApi::PushCapture(state);
+    return IPC_OK;
+}
+
+static IpcStatus listClips(IpcReader& request, IpcWriter& response){
+    uint32_t limit;
+    std::string_view game;
+    if (!request.Get(limit) || !request.GetString(game)) return IPC_BAD_REQUEST;
+
+    ClipFilter filter;
+    filter.game = game;
+    filter.limit = std::min(limit, MAX_CLIPS);
+    writeClips(response, CLIPLIB.List(filter));
+    return IPC_OK;
+}
+
+static IpcStatus searchClips(IpcReader& request, IpcWriter& response){
+    uint32_t limit;
+    std::string_view query;
+    if (!request.Get(limit) || !request.GetString(query)) return IPC_BAD_REQUEST;
+
+    writeClips(response, CLIPLIB.Search(query, std::min(limit, MAX_CLIPS)));
+    return IPC_OK;
+}
+
+static IpcStatus buildReel(IpcWriter& response){
+    auto task = std::make_unique<Tasks::BuildReel>();
+    response.PutString(task->GetOutput());
+    TaskHandler::Instance()->AddTask(std::move(task));
+    return IPC_OK;
+}
+
+static IpcStatus pluginStats(IpcWriter& response){
+    std::vector<PluginStats> stats = PLUGINS.Stats();
+    response.Put(static_cast<uint32_t>(stats.size()));
+    for (const PluginStats& s: stats) {
+        response.PutString(s.name);
+        response.Put(static_cast<uint8_t>(s.enabled));
+        response.Put(s.calls);
+        response.Put(s.errors);
+        response.Put(s.overruns);
+        response.Put(s.busyMicros);
+        response.Put(static_cast<uint64_t>(s.memoryBytes));
+    }
+    return IPC_OK;
+}
+
+IpcStatus IpcApi::Handle(uint16_t type, IpcReader& request, IpcWriter& response){
+    switch (type) {
+        case IPC_STATUS: return status(response);
+        case IPC_SET_CAPTURE: return setCapture(request);
+        case IPC_LIST_CLIPS: return listClips(request, response);
+        case IPC_SEARCH_CLIPS: return searchClips(request, response);
+        case IPC_BUILD_REEL: return buildReel(response);
+        case IPC_PLUGIN_STATS: return pluginStats(response);
+        default: return IPC_UNKNOWN_TYPE;
+    }
+}
+
+void IpcApi::PushHighlight(const HighlightMarker& marker){
+    std::string payload;
+    IpcWriter w(payload);
+    w.Put(marker.time);
+    w.Put(marker.durationMs);
+    w.Put(static_cast<uint32_t>(marker.kind));
+    w.Put(marker.score);
+    IPCSERVER.Publish(IPC_TOPIC_HIGHLIGHTS, IPC_PUSH_HIGHLIGHT, payload);
+}
+
+void IpcApi::PushCapture(CaptureState state){
+    std::string payload;
+    IpcWriter(payload).Put(static_cast<uint8_t>(state));
+    IPCSERVER.Publish(IPC_TOPIC_CAPTURE, IPC_PUSH_CAPTURE, payload);
+}
+
+void IpcApi::PushGame(std::string_view exe){
+    std::string payload;
+    IpcWriter(payload).PutString(exe);
+    IPCSERVER.Publish(IPC_TOPIC_GAMES, IPC_PUSH_GAME, payload);
+}
@@ -0,0 +1,450 @@
+#include "ipc_server.h"
+#include "logger.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// blocking reads and writes that another thread can interrupt
+struct IpcServer::Stream {
+    std::atomic<bool> closed{false};
+#ifdef _WIN32
+    HANDLE pipe;
+    // a pipe opened for overlapped io can be read and written by two
+    // threads at once, each waits on its own event
+    HANDLE readEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    HANDLE writeEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    explicit Stream(HANDLE pipe): pipe(pipe) {};
+    ~Stream(){
+        CloseHandle(this->readEvent);
+        CloseHandle(this->writeEvent);
+        CloseHandle(this->pipe);
+    }
+
+    bool wait(OVERLAPPED& ov, BOOL started, DWORD& bytes){
+        if (!started && GetLastError() != ERROR_IO_PENDING) return false;
+        return GetOverlappedResult(this->pipe, &ov, &bytes, TRUE) && !this->closed;
+    }
+
+    // bytes read, 0 once the stream is closed
+    std::size_t Read(char* buf, std::size_t n){
+        if (this->closed) return 0;
+        OVERLAPPED ov = {};
+        ov.hEvent = this->readEvent;
+        DWORD got = 0;
+        if (!this->wait(ov, ReadFile(this->pipe, buf, static_cast<DWORD>(n), NULL, &ov), got)) return 0;
+        return got;
+    }
+
+    bool Write(const char* buf, std::size_t n){
+        while (n > 0) {
+            if (this->closed) return false;
+            OVERLAPPED ov = {};
+            ov.hEvent = this->writeEvent;
+            DWORD put = 0;
+            if (!this->wait(ov, WriteFile(this->pipe, buf, static_cast<DWORD>(n), NULL, &ov), put)) return false;
+            buf += put;
+            n -= put;
+        }
+        return true;
+    }
+
+    void Shutdown(){
+        this->closed = true;
+        CancelIoEx(this->pipe, NULL);
+        DisconnectNamedPipe(this->pipe);
+    }
+#else
+    int fd;
+
+    explicit Stream(int fd): fd(fd) {};
+    ~Stream(){ ::close(this->fd); }
+
+    std::size_t Read(char* buf, std::size_t n){
+        while (!this->closed) {
+            ssize_t got = ::read(this->fd, buf, n);
+            if (got >= 0) return static_cast<std::size_t>(got);
+            if (errno != EINTR) return 0;
+        }
+        return 0;
+    }
+
+    bool Write(const char* buf, std::size_t n){
+        while (n > 0) {
+            if (this->closed) return false;
+            ssize_t put = ::send(this->fd, buf, n, MSG_NOSIGNAL);
+            if (put < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            buf += put;
+            n -= static_cast<std::size_t>(put);
+        }
+        return true;
+    }
+
+    void Shutdown(){
+        this->closed = true;
+        ::shutdown(this->fd, SHUT_RDWR);
+    }
+#endif
+};
+
+IpcServer::Connection::~Connection(){}
+
+IpcServer& IpcServer::Instance(){
+    static IpcServer inst;
+    return inst;
+};
+
+IpcServer::~IpcServer(){
+    this->Stop();
+}
+
+void IpcServer::SetHandler(IpcHandler handler){
+    this->handler = std::move(handler);
+}
+
+bool IpcServer::Start(const std::string& name){
+    this->Stop();
+    this->name = name;
+
+#ifdef _WIN32
+    this->stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    this->reapEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+#else
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (fd < 0 || name.size() >= sizeof(addr.sun_path)) {
+        SLOG.error("ipc: unable to create a socket for {}", name);
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    std::memcpy(addr.sun_path, name.c_str(), name.size() + 1);
+    // left over from a previous run
+    ::unlink(name.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 8) != 0) {
+        SLOG.error("ipc: unable to listen on {}: {}", name, std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    // only the user running the capture interface
+    ::chmod(name.c_str(), 0600);
+    if (::pipe(this->wake) != 0) {
+        SLOG.error("ipc: unable to create a pipe: {}", std::strerror(errno));
+        ::close(fd);
+        ::unlink(name.c_str());
+        return false;
+    }
+    this->listener = fd;
+#endif
+
+    this->running = true;
+    this->acceptor = std::thread(&IpcServer::accept, this);
+    SLOG.info("ipc: listening on {}", name);
+    return true;
+}
+
+void IpcServer::Stop(){
+    if (!this->running.exchange(false)) return;
+
+#ifdef _WIN32
+    SetEvent(this->stopEvent);
+#else
+    // wakes up accept
+    ::shutdown(this->listener, SHUT_RDWR);
+    char b = 0;
+    ssize_t unused = ::write(this->wake[1], &b, 1);
+    (void)unused;
+#endif
+    if (this->acceptor.joinable()) this->acceptor.join();
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (auto& conn: this->connections) this->close(*conn);
+    }
+    this->reap(true);
+
+    // the connection threads wake the acceptor until they are joined
+#ifdef _WIN32
+    CloseHandle(this->stopEvent);
+    CloseHandle(this->reapEvent);
+    this->stopEvent = nullptr;
+    this->reapEvent = nullptr;
+#else
+    ::close(this->listener);
+    ::close(this->wake[0]);
+    ::close(this->wake[1]);
+    ::unlink(this->name.c_str());
+    this->listener = -1;
+    this->wake[0] = this->wake[1] = -1;
+#endif
+}
+
+void IpcServer::accept(){
+    while (this->running) {
+        std::unique_ptr<Stream> stream;
+
+#ifdef _WIN32
+        HANDLE pipe = CreateNamedPipeA(this->name.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, NULL);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            SLOG.error("ipc: unable to create pipe {}, error: {}", this->name, GetLastError());
+            return;
+        }
+
+        HANDLE connected = CreateEventA(NULL, TRUE, FALSE, NULL);
+        OVERLAPPED ov = {};
+        ov.hEvent = connected;
+        bool ok = ConnectNamedPipe(pipe, &ov) || GetLastError() == ERROR_PIPE_CONNECTED;
+        if (!ok && GetLastError() == ERROR_IO_PENDING) {
+            HANDLE events[3] = { connected, this->stopEvent, this->reapEvent };
+            DWORD res;
+            while ((res = WaitForMultipleObjects(3, events, FALSE, INFINITE)) == WAIT_OBJECT_0 + 2) this->reap(false);
+            DWORD unused;
+            ok = res == WAIT_OBJECT_0 && GetOverlappedResult(pipe, &ov, &unused, FALSE);
+            if (!ok) {
+                CancelIoEx(pipe, &ov);
+                GetOverlappedResult(pipe, &ov, &unused, TRUE);
+            }
+        }
+        CloseHandle(connected);
+        if (!ok) {
+            CloseHandle(pipe);
+            continue;
+        }
+        stream = std::make_unique<Stream>(pipe);
+#else
+        pollfd fds[2] = { { this->listener, POLLIN, 0 }, { this->wake[0], POLLIN, 0 } };
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents != 0) {
+            char buf[64];
+            ssize_t unused = ::read(this->wake[0], buf, sizeof(buf));
+            (void)unused;
+            this->reap(false);
+        }
+        if (fds[0].revents == 0) continue;
+
+        int fd = ::accept(this->listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            // the listener was shut down
+            break;
+        }
+        stream = std::make_unique<Stream>(fd);
+#endif
+
+        auto conn = std::make_shared<Connection>();
+        conn->stream = std::move(stream);
+
+        // listed before the reader runs, a push published right after the
+        // client's subscribe response would miss it otherwise
+        std::lock_guard<std::mutex> lock(this->mutex);
+        // the threads get a plain pointer, reap joins them before the
+        // connection can go away
+        conn->reader = std::thread(&IpcServer::read, this, conn.get());
+        conn->writer = std::thread(&IpcServer::write, this, conn.get());
+        this->connections.push_back(std::move(conn));
+        SLOG.info("ipc: client connected, {} clients", this->connections.size());
+    }
+}
+
+void IpcServer::read(Connection* conn){
+    std::string in;
+    std::string out;
+    std::string payload;
+    std::vector<char> chunk(64 * 1024);
+
+    // the client stopped sending, or the stream was closed or failed. either
+    // way the writer finishes what is queued or notices the stream is gone.
+    bool eof = false;
+
+    while (true) {
+        std::size_t n = conn->stream->Read(chunk.data(), chunk.size());
+        if (n == 0) {
+            eof = true;
+            break;
+        }
+        in.append(chunk.data(), n);
+
+        // every complete request in the buffer, answered in one batch
+        std::size_t pos = 0;
+        bool bad = false;
+        out.clear();
+        while (in.size() - pos >= sizeof(uint32_t)) {
+            uint32_t length;
+            std::memcpy(&length, in.data() + pos, sizeof(length));
+            if (length < sizeof(IpcHeader) || length > IPC_MAX_MESSAGE) {
+                bad = true;
+                break;
+            }
+            if (in.size() - pos - sizeof(uint32_t) < length) break;
+
+            IpcHeader header;
+            const char* body = in.data() + pos + sizeof(uint32_t);
+            std::memcpy(&header, body, sizeof(header));
+            IpcReader request(body + sizeof(header), length - sizeof(header));
+            payload.clear();
+            IpcWriter response(payload);
+
+            IpcStatus status = IPC_OK;
+            if (header.type == IPC_PING) {
+                payload.assign(request.Rest());
+            } else if (header.type == IPC_SUBSCRIBE) {
+                uint32_t topics;
+                if (request.Get(topics)) conn->topics = topics;
+                else status = IPC_BAD_REQUEST;
+            } else if (this->handler) {
+                status = this->handler(header.type, request, response);
+            } else {
+                status = IPC_UNKNOWN_TYPE;
+            }
+
+            IpcFrame(out, header.id, header.type, status, payload);
+            pos += sizeof(uint32_t) + length;
+        }
+        in.erase(0, pos);
+
+        if (!out.empty() && !this->queue(*conn, out)) break;
+        if (bad) {
+            static LogRateLimit badLimit(5, std::chrono::seconds(60));
+            SLOG.error(badLimit, "ipc: invalid message length, closing the connection");
+            break;
+        }
+    }
+
+    if (eof) this->drain(*conn);
+    else this->close(*conn);
+    this->finish(conn);
+}
+
+void IpcServer::write(Connection* conn){
+    std::string batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(conn->mutex);
+            conn->cv.wait(lock, [conn]{ return conn->closing || conn->draining || !conn->outbox.empty(); });
+            if (conn->closing) break;
+            // draining and everything is written
+            if (conn->outbox.empty()) break;
+            std::swap(batch, conn->outbox);
+        }
+        if (!conn->stream->Write(batch.data(), batch.size())) break;
+        batch.clear();
+    }
+
+    this->close(*conn);
+    this->finish(conn);
+}
+
+bool IpcServer::queue(Connection& conn, const std::string& data){
+    {
+        std::lock_guard<std::mutex> lock(conn.mutex);
+        if (conn.closing) return false;
+        // pushes for a client that is going away
+        if (conn.draining) return true;
+        if (conn.outbox.size() + data.size() > OUTBOX_LIMIT) return false;
+        conn.outbox += data;
+    }
+    conn.cv.notify_one();
+    return true;
+}
+
+void IpcServer::drain(Connection& conn){
+    {
+        std::lock_guard<std::mutex> lock(conn.mutex);
+        if (conn.closing || conn.draining) return;
+        conn.draining = true;
+    }
+    conn.cv.notify_one();
+}
+
+void IpcServer::close(Connection& conn){
+    {
+        std::lock_guard<std::mutex> lock(conn.mutex);
+        if (conn.closing) return;
+        conn.closing = true;
+    }
+    conn.cv.notify_one();
+    conn.stream->Shutdown();
+}
+
+void IpcServer::finish(Connection* conn){
+    if (--conn->threads > 0) return;
+
+    // a thread can't join itself, the acceptor joins the connection. Stop
+    // may have taken it already
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (auto it = this->connections.begin(); it != this->connections.end(); ++it) {
+            if (it->get() != conn) continue;
+            this->finished.push_back(std::move(*it));
+            this->connections.erase(it);
+            break;
+        }
+    }
+#ifdef _WIN32
+    SetEvent(this->reapEvent);
+#else
+    char b = 0;
+    ssize_t unused = ::write(this->wake[1], &b, 1);
+    (void)unused;
+#endif
+}
+
+void IpcServer::reap(bool all){
+    std::vector<std::shared_ptr<Connection>> done;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        done.swap(this->finished);
+        if (all) {
+            for (auto& conn: this->connections) done.push_back(std::move(conn));
+            this->connections.clear();
+        }
+    }
+
+    for (auto& conn: done) {
+        if (conn->reader.joinable()) conn->reader.join();
+        if (conn->writer.joinable()) conn->writer.join();
+    }
+}
+
+void IpcServer::Publish(IpcTopic topic, uint16_t type, std::string_view payload){
+    std::string message;
+    IpcFrame(message, 0, type, IPC_OK, payload);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto& conn: this->connections) {
+        if ((conn->topics.load(std::memory_order_relaxed) & topic) == 0) continue;
+        if (!this->queue(*conn, message)) {
+            SLOG.error("ipc: client isn't reading its messages, closing the connection");
+            this->close(*conn);
+        }
+    }
+}
+
+std::size_t IpcServer::Clients() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::size_t open = 0;
+    for (auto& conn: this->connections) {
+        std::lock_guard<std::mutex> connLock(conn->mutex);
+        if (!conn->closing) open++;
+    }
+    return open;
+}
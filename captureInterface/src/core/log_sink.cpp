@@ -0,0 +1,270 @@
+#include "log_sink.h"
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <compressapi.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+LogSink::~LogSink(){
+    this->Close();
+}
+
+bool LogSink::Open(const Options& options){
+    if (this->IsOpen()) return true;
+
+    this->options = options;
+    this->options.compress = false;
+    this->SetCompress(options.compress);
+
+    return this->openSegment();
+}
+
+void LogSink::Write(const char* data, std::size_t size){
+    if (!this->IsOpen()) return;
+
+    bool full = this->offset + size > this->options.segmentSize;
+    bool expired = std::chrono::steady_clock::now() - this->segmentOpened >= this->options.maxAge;
+    if ((full || expired) && this->offset > 0) {
+        this->rotate();
+        if (!this->IsOpen()) return;
+    }
+
+    // a single write larger than a whole segment gets cut off
+    if (size > this->options.segmentSize - this->offset) {
+        size = this->options.segmentSize - this->offset;
+    }
+
+    std::memcpy(this->view + this->offset, data, size);
+    this->offset += size;
+}
+
+void LogSink::SetCompress(bool compress){
+    if (compress == this->options.compress) return;
+#ifndef _WIN32
+    if (compress) {
+        std::cerr << "Log compression is only available on windows" << std::endl;
+        return;
+    }
+#endif
+
+    this->options.compress = compress;
+    if (compress) {
+        this->compressStop = false;
+        this->compressThread = std::thread(&LogSink::compressWorker, this);
+    } else {
+        this->stopCompress();
+    }
+}
+
+void LogSink::Close(){
+    // the last segment is compressed as well, stopping the worker waits for it
+    if (this->closeSegment() && this->options.compress) this->queueCompress(this->segmentPath);
+    this->stopCompress();
+}
+
+bool LogSink::openSegment(){
+    time_t now = time(0);
+    tm timeinfo;
+#ifdef _WIN32
+    localtime_s(&timeinfo, &now);
+#else
+    localtime_r(&now, &timeinfo);
+#endif
+    char stamp[20];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &timeinfo);
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    long pid = static_cast<long>(getpid());
+#endif
+    const std::string prefix = this->options.baseName + "-" + stamp + "-" + std::to_string(pid) + "-";
+
+    // never opens an existing segment, another process or an earlier sink
+    // in this one may still have it mapped. taken names move on to the next index.
+    for (int attempt = 0;; attempt++) {
+        this->segmentPath = prefix + std::to_string(this->segmentIndex++) + ".txt";
+#ifdef _WIN32
+        HANDLE f = CreateFileA(this->segmentPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (f != INVALID_HANDLE_VALUE) {
+            this->file = f;
+            break;
+        }
+        bool taken = GetLastError() == ERROR_FILE_EXISTS;
+#else
+        int f = ::open(this->segmentPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (f >= 0) {
+            this->fd = f;
+            break;
+        }
+        bool taken = errno == EEXIST;
+#endif
+        if (!taken || attempt >= MAX_OPEN_ATTEMPTS) {
+            std::cerr << "Error opening log segment " << this->segmentPath << std::endl;
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    HANDLE f = this->file;
+
+    // mapping a view larger than the file grows the file to the full segment size
+    ULARGE_INTEGER size;
+    size.QuadPart = this->options.segmentSize;
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+    if (m == NULL) {
+        std::cerr << "Error mapping log segment " << this->segmentPath << std::endl;
+        CloseHandle(f);
+        this->file = nullptr;
+        return false;
+    }
+
+    char* v = static_cast<char*>(MapViewOfFile(m, FILE_MAP_WRITE, 0, 0, this->options.segmentSize));
+    if (v == nullptr) {
+        std::cerr << "Error mapping log segment " << this->segmentPath << std::endl;
+        CloseHandle(m);
+        CloseHandle(f);
+        this->file = nullptr;
+        return false;
+    }
+
+    this->mapping = m;
+#else
+    int f = this->fd;
+
+    // grown to the full segment size up front like on windows, the tail is
+    // sparse until it is written
+    void* m = MAP_FAILED;
+    if (ftruncate(f, static_cast<off_t>(this->options.segmentSize)) == 0) {
+        m = mmap(nullptr, this->options.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+    }
+    if (m == MAP_FAILED) {
+        std::cerr << "Error mapping log segment " << this->segmentPath << std::endl;
+        ::close(f);
+        this->fd = -1;
+        return false;
+    }
+    char* v = static_cast<char*>(m);
+#endif
+    this->view = v;
+    this->offset = 0;
+    this->segmentOpened = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool LogSink::closeSegment(){
+    if (!this->IsOpen()) return false;
+
+#ifdef _WIN32
+    UnmapViewOfFile(this->view);
+    CloseHandle(this->mapping);
+
+    // drop the unused preallocated tail
+    LARGE_INTEGER end;
+    end.QuadPart = this->offset;
+    SetFilePointerEx(this->file, end, NULL, FILE_BEGIN);
+    SetEndOfFile(this->file);
+    CloseHandle(this->file);
+
+    this->mapping = nullptr;
+    this->file = nullptr;
+#else
+    munmap(this->view, this->options.segmentSize);
+    // drop the unused preallocated tail
+    if (ftruncate(this->fd, static_cast<off_t>(this->offset)) != 0) {
+        std::cerr << "Error truncating log segment " << this->segmentPath << std::endl;
+    }
+    ::close(this->fd);
+    this->fd = -1;
+#endif
+
+    this->view = nullptr;
+    return this->offset > 0;
+}
+
+void LogSink::rotate(){
+    if (this->closeSegment() && this->options.compress) this->queueCompress(this->segmentPath);
+    this->openSegment();
+}
+
+void LogSink::queueCompress(const std::string& path){
+    {
+        std::lock_guard<std::mutex> lock(this->compressMutex);
+        this->compressQueue.push(path);
+    }
+    this->compressCv.notify_one();
+}
+
+void LogSink::stopCompress(){
+    if (!this->compressThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(this->compressMutex);
+        this->compressStop = true;
+    }
+    this->compressCv.notify_one();
+    // the worker finishes the queue first
+    this->compressThread.join();
+}
+
+void LogSink::compressWorker(){
+#ifdef _WIN32
+    COMPRESSOR_HANDLE compressor;
+    if (!CreateCompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, NULL, &compressor)) {
+        std::cerr << "Error creating log compressor" << std::endl;
+        return;
+    }
+
+    std::vector<char> in;
+    std::vector<char> out;
+
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(this->compressMutex);
+            this->compressCv.wait(lock, [this]{ 
+                return this->compressStop || !this->compressQueue.empty(); 
+            });
+            if (this->compressQueue.empty()) break;
+            path = std::move(this->compressQueue.front());
+            this->compressQueue.pop();
+        }
+
+        std::ifstream src(path, std::ios::binary | std::ios::ate);
+        if (!src.is_open()) continue;
+        in.resize(src.tellg());
+        src.seekg(0);
+        src.read(in.data(), in.size());
+        src.close();
+
+        // the first call only reports the buffer size needed
+        SIZE_T needed = 0;
+        Compress(compressor, in.data(), in.size(), NULL, 0, &needed);
+        out.resize(needed);
+        SIZE_T written = 0;
+        if (!Compress(compressor, in.data(), in.size(), out.data(), out.size(), &written)) {
+            std::cerr << "Error compressing log segment " << path << std::endl;
+            continue;
+        }
+
+        std::ofstream dst(path + ".xpress", std::ios::binary | std::ios::trunc);
+        dst.write(out.data(), written);
+        dst.close();
+        if (dst.good()) {
+            DeleteFileA(path.c_str());
+        }
+    }
+
+    CloseCompressor(compressor);
+#endif
+}
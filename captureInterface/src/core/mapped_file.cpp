@@ -0,0 +1,86 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile(){
+    this->Close();
+}
+
+bool MappedFile::Open(const std::string& filename){
+    this->Close();
+
+#ifdef _WIN32
+    HANDLE f = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, 
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    // empty files can't be mapped
+    if (!GetFileSizeEx(f, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(f);
+        return false;
+    }
+
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m == NULL) {
+        CloseHandle(f);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+
+    this->file = f;
+    this->mapping = m;
+    this->data = static_cast<const uint8_t*>(view);
+    this->size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    // empty files can't be mapped
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+
+    this->data = static_cast<const uint8_t*>(view);
+    this->size = static_cast<std::size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::Close(){
+    if (this->data == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(this->data);
+    CloseHandle(this->mapping);
+    CloseHandle(this->file);
+
+    this->mapping = nullptr;
+    this->file = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(this->data), this->size);
+#endif
+
+    this->data = nullptr;
+    this->size = 0;
+}
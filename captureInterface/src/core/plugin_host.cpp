@@ -0,0 +1,353 @@
+#include "plugin_host.h"
+#include "app_config.h"
+#include "highlights.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <lua.hpp>
+
+static const char* EVENT_NAMES[] = { "frame", "onset", "game", "hotkey", nullptr };
+
+static int64_t nowMicros(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PluginHost& PluginHost::Instance(){
+    static PluginHost inst;
+    return inst;
+};
+
+PluginHost::~PluginHost(){
+    this->Stop();
+}
+
+PluginHost::Plugin::~Plugin(){
+    if (this->state != nullptr) lua_close(this->state);
+}
+
+// the plugin of a state lives in its extra space
+static void setPlugin(lua_State* L, void* plugin){
+    *static_cast<void**>(lua_getextraspace(L)) = plugin;
+}
+
+template <typename T>
+static T* getPlugin(lua_State* L){
+    return *static_cast<T**>(lua_getextraspace(L));
+}
+
+void* PluginHost::alloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize){
+    Plugin* plugin = static_cast<Plugin*>(ud);
+    // osize is the object type when ptr is null
+    std::size_t old = ptr != nullptr ? osize : 0;
+
+    if (nsize == 0) {
+        std::free(ptr);
+        plugin->memory -= old;
+        return nullptr;
+    }
+    // lua raises a memory error when this fails
+    if (nsize > old && plugin->memory + nsize - old > MEMORY_LIMIT) return nullptr;
+
+    void* res = std::realloc(ptr, nsize);
+    if (res != nullptr) plugin->memory = plugin->memory - old + nsize;
+    return res;
+}
+
+void PluginHost::hook(lua_State* L, lua_Debug* ar){
+    (void)ar;
+    Plugin* plugin = getPlugin<Plugin>(L);
+    plugin->instructions += HOOK_INTERVAL;
+
+    if (plugin->overran || plugin->instructions > plugin->instructionBudget ||
+        std::chrono::steady_clock::now() > plugin->deadline) {
+        plugin->overran = true;
+        // check every instruction from now on, so a script catching the
+        // error with pcall is stopped again right away
+        lua_sethook(L, &PluginHost::hook, LUA_MASKCOUNT, 1);
+        luaL_error(L, "callback ran past its budget");
+    }
+}
+
+int PluginHost::luaOn(lua_State* L){
+    Plugin* plugin = getPlugin<Plugin>(L);
+    int type = luaL_checkoption(L, 1, nullptr, EVENT_NAMES);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+
+    lua_settop(L, 2);
+    luaL_unref(L, LUA_REGISTRYINDEX, plugin->callbacks[type]);
+    plugin->callbacks[type] = luaL_ref(L, LUA_REGISTRYINDEX);
+    PLUGINS.subscribed.fetch_or(1u << type, std::memory_order_relaxed);
+    return 0;
+}
+
+int PluginHost::luaMarker(lua_State* L){
+    lua_Integer time = luaL_checkinteger(L, 1);
+    lua_Integer durationMs = luaL_checkinteger(L, 2);
+    lua_Number score = luaL_checknumber(L, 3);
+
+    HIGHLIGHTS.Add(HighlightMarker{
+        .time = time,
+        .durationMs = static_cast<uint32_t>(std::clamp<lua_Integer>(durationMs, 0, 60000)),
+        .kind = MARKER_PLUGIN,
+        .score = static_cast<float>(std::clamp<lua_Number>(score, 0.0, 1.0)),
+    });
+    return 0;
+}
+
+// also replaces print
+int PluginHost::luaLog(lua_State* L){
+    Plugin* plugin = getPlugin<Plugin>(L);
+    int n = lua_gettop(L);
+
+    luaL_Buffer b;
+    luaL_buffinit(L, &b);
+    for (int i = 1; i <= n; i++) {
+        if (i > 1) luaL_addchar(&b, ' ');
+        luaL_tolstring(L, i, nullptr);
+        luaL_addvalue(&b);
+    }
+    luaL_pushresult(&b);
+
+    SLOG.info(plugin->logLimit, "plugin {}: {}", plugin->name, lua_tostring(L, -1));
+    return 0;
+}
+
+int PluginHost::luaNow(lua_State* L){
+    lua_pushinteger(L, nowMicros());
+    return 1;
+}
+
+bool PluginHost::call(Plugin& plugin, int nargs){
+    const AppConfig* config = CONFIG.Current();
+    auto start = std::chrono::steady_clock::now();
+
+    plugin.instructions = 0;
+    plugin.instructionBudget = config->pluginInstructions;
+    plugin.deadline = start + std::chrono::milliseconds(config->pluginTimeMs);
+    plugin.overran = false;
+    lua_sethook(plugin.state, &PluginHost::hook, LUA_MASKCOUNT, HOOK_INTERVAL);
+
+    int status = lua_pcall(plugin.state, nargs, 0, 0);
+    int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (status != LUA_OK) {
+        static LogRateLimit errorLimit(10, std::chrono::seconds(10));
+        const char* message = lua_tostring(plugin.state, -1);
+        SLOG.error(errorLimit, "plugin {}: {}", plugin.name, message != nullptr ? message : "error object is not a string");
+    }
+    lua_settop(plugin.state, 0);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    PluginStats& stats = plugin.stats;
+    stats.calls++;
+    stats.busyMicros += micros;
+    stats.maxCallMicros = std::max(stats.maxCallMicros, micros);
+    stats.memoryBytes = plugin.memory;
+    if (plugin.overran) stats.overruns++;
+    else if (status != LUA_OK) stats.errors++;
+
+    if (plugin.overran) {
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::seconds window(config->pluginOverrunWindowS);
+        std::deque<std::chrono::steady_clock::time_point>& recent = plugin.recentOverruns;
+        while (!recent.empty() && now - recent.front() > window) recent.pop_front();
+        recent.push_back(now);
+
+        if (recent.size() >= MAX_OVERRUNS && plugin.enabled) {
+            plugin.enabled = false;
+            SLOG.error("plugin {}: disabled after {} budget overruns within {} s", plugin.name, recent.size(), window.count());
+        }
+    }
+    stats.enabled = plugin.enabled;
+    return status == LUA_OK;
+}
+
+std::unique_ptr<PluginHost::Plugin> PluginHost::open(const std::string& filename){
+    auto plugin = std::make_unique<Plugin>();
+    plugin->name = std::filesystem::path(filename).stem().string();
+    std::fill(std::begin(plugin->callbacks), std::end(plugin->callbacks), LUA_NOREF);
+    plugin->stats = PluginStats{
+        .name = plugin->name,
+        .enabled = true,
+        .calls = 0,
+        .errors = 0,
+        .overruns = 0,
+        .busyMicros = 0,
+        .maxCallMicros = 0,
+        .memoryBytes = 0,
+    };
+
+    lua_State* L = lua_newstate(&PluginHost::alloc, plugin.get());
+    if (L == nullptr) return nullptr;
+    plugin->state = L;
+    setPlugin(L, plugin.get());
+
+    // no io, os, package or debug
+    static const luaL_Reg libs[] = {
+        { LUA_GNAME, luaopen_base },
+        { LUA_TABLIBNAME, luaopen_table },
+        { LUA_STRLIBNAME, luaopen_string },
+        { LUA_MATHLIBNAME, luaopen_math },
+        { LUA_UTF8LIBNAME, luaopen_utf8 },
+    };
+    for (const luaL_Reg& lib: libs) {
+        luaL_requiref(L, lib.name, lib.func, 1);
+        lua_pop(L, 1);
+    }
+    for (const char* name: { "load", "loadfile", "dofile" }) {
+        lua_pushnil(L);
+        lua_setglobal(L, name);
+    }
+    lua_pushcfunction(L, &PluginHost::luaLog);
+    lua_setglobal(L, "print");
+
+    static const luaL_Reg api[] = {
+        { "on", &PluginHost::luaOn },
+        { "marker", &PluginHost::luaMarker },
+        { "log", &PluginHost::luaLog },
+        { "now", &PluginHost::luaNow },
+        { nullptr, nullptr },
+    };
+    luaL_newlib(L, api);
+    lua_pushstring(L, plugin->name.c_str());
+    lua_setfield(L, -2, "name");
+    lua_setglobal(L, "plugin");
+
+    // text only, precompiled chunks can crash the VM
+    if (luaL_loadfilex(L, filename.c_str(), "t") != LUA_OK) {
+        SLOG.error("plugins: unable to load {}: {}", filename, lua_tostring(L, -1));
+        return nullptr;
+    }
+    // the top level chunk runs under the same budget as a callback
+    if (!this->call(*plugin, 0)) return nullptr;
+    return plugin;
+}
+
+void PluginHost::Load(const std::string& directory){
+    this->Stop();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->plugins.clear();
+        this->queue.clear();
+        this->stop = false;
+    }
+    this->subscribed.store(0, std::memory_order_relaxed);
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(directory, ec)) {
+        SLOG.info("plugins: no plugin directory {}", directory);
+        return;
+    }
+
+    std::vector<std::string> files;
+    for (const auto& entry: std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".lua") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::unique_ptr<Plugin>> loaded;
+    uint32_t mask = 0;
+    for (const std::string& file: files) {
+        std::unique_ptr<Plugin> plugin = this->open(file);
+        if (!plugin) continue;
+        for (int type = 0; type < PLUGIN_EVENT_COUNT; type++) {
+            if (plugin->callbacks[type] != LUA_NOREF) mask |= 1u << type;
+        }
+        loaded.push_back(std::move(plugin));
+    }
+    // plugins that failed to load may have subscribed before failing
+    this->subscribed.store(mask, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->plugins = std::move(loaded);
+    }
+    SLOG.info("plugins: loaded {} of {} plugins from {}", this->plugins.size(), files.size(), directory);
+    if (!this->plugins.empty()) this->worker = std::thread(&PluginHost::work, this);
+}
+
+void PluginHost::Stop(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->cv.notify_all();
+    if (this->worker.joinable()) this->worker.join();
+}
+
+void PluginHost::Post(const PluginEvent& event){
+    if ((this->subscribed.load(std::memory_order_relaxed) & (1u << event.type)) == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->stop) return;
+        if (this->queue.size() >= QUEUE_LIMIT) {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        this->queue.push_back(event);
+        if (event.time == 0) this->queue.back().time = nowMicros();
+    }
+    this->cv.notify_one();
+}
+
+std::vector<PluginStats> PluginHost::Stats() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<PluginStats> res;
+    res.reserve(this->plugins.size());
+    for (const auto& plugin: this->plugins) res.push_back(plugin->stats);
+    return res;
+}
+
+void PluginHost::dispatch(const PluginEvent& event){
+    for (const auto& plugin: this->plugins) {
+        int ref = plugin->callbacks[event.type];
+        if (!plugin->enabled || ref == LUA_NOREF) continue;
+
+        lua_State* L = plugin->state;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+        int nargs = 0;
+        switch (event.type) {
+            case PLUGIN_FRAME:
+            case PLUGIN_ONSET:
+                lua_pushinteger(L, event.time);
+                lua_pushnumber(L, event.value);
+                nargs = 2;
+                break;
+            case PLUGIN_GAME:
+                lua_pushlstring(L, event.name.data(), event.name.size());
+                lua_pushinteger(L, event.id);
+                lua_pushinteger(L, event.time);
+                nargs = 3;
+                break;
+            case PLUGIN_HOTKEY:
+                lua_pushinteger(L, event.id);
+                lua_pushinteger(L, event.time);
+                nargs = 2;
+                break;
+            default:
+                break;
+        }
+        this->call(*plugin, nargs);
+    }
+}
+
+void PluginHost::work(){
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (true) {
+        this->cv.wait(lock, [this]{ return !this->queue.empty() || this->stop; });
+        if (this->stop) break;
+        PluginEvent event = std::move(this->queue.front());
+        this->queue.pop_front();
+        lock.unlock();
+
+        // only this thread touches the plugins' states, Load joins it first
+        this->dispatch(event);
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,144 @@
+#include "preview.h"
+#include "app_config.h"
+#include "downscale.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <windows.h>
+
+static uint32_t align64(std::size_t n){
+    return static_cast<uint32_t>((n + 63) & ~std::size_t(63));
+}
+
+PreviewBuffer& PreviewBuffer::Instance(){
+    static PreviewBuffer inst;
+    return inst;
+};
+
+PreviewBuffer::~PreviewBuffer(){
+    this->Close();
+}
+
+bool PreviewBuffer::Open(const std::string& file){
+    this->Close();
+
+    const uint32_t bufferSize = align64(sizeof(PreviewFrameHeader) + std::size_t(PREVIEW_MAX_WIDTH) * PREVIEW_MAX_HEIGHT * 4);
+    const uint32_t buffersOffset = align64(sizeof(PreviewHeader));
+    const uint64_t size = buffersOffset + uint64_t(bufferSize) * PREVIEW_BUFFERS;
+
+    HANDLE f = INVALID_HANDLE_VALUE;
+    if (!file.empty()) {
+        f = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (f == INVALID_HANDLE_VALUE) {
+            SLOG.error("preview: unable to open {}, error: {}", file, GetLastError());
+            return false;
+        }
+    }
+
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+        static_cast<DWORD>(size), file.empty() ? PREVIEW_MAPPING : NULL);
+    if (m == NULL) {
+        SLOG.error("preview: unable to create the mapping, error: {}", GetLastError());
+        if (f != INVALID_HANDLE_VALUE) CloseHandle(f);
+        return false;
+    }
+
+    void* v = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (v == nullptr) {
+        SLOG.error("preview: unable to map the buffers, error: {}", GetLastError());
+        CloseHandle(m);
+        if (f != INVALID_HANDLE_VALUE) CloseHandle(f);
+        return false;
+    }
+
+    this->file = f == INVALID_HANDLE_VALUE ? NULL : f;
+    this->mapping = m;
+    this->view = static_cast<uint8_t*>(v);
+
+    // same as the frame ring, the magic is cleared first and written last
+    PreviewHeader* h = reinterpret_cast<PreviewHeader*>(this->view);
+    std::atomic_ref<uint32_t>(h->magic).store(0, std::memory_order_relaxed);
+    std::memset(this->view, 0, size);
+    h->version = PREVIEW_VERSION;
+    h->headerSize = sizeof(PreviewHeader);
+    h->bufferCount = PREVIEW_BUFFERS;
+    h->bufferSize = bufferSize;
+    h->buffersOffset = buffersOffset;
+    h->maxWidth = PREVIEW_MAX_WIDTH;
+    h->maxHeight = PREVIEW_MAX_HEIGHT;
+    h->state = PreviewState(PREVIEW_NONE, PREVIEW_NONE, false);
+    std::atomic_ref<uint32_t>(h->magic).store(PREVIEW_MAGIC, std::memory_order_release);
+
+    this->header = h;
+    this->frame = 0;
+    this->lastFrameTime = 0;
+    this->lastPolls = 0;
+    this->lastPollTime = 0;
+
+    SLOG.info("preview: sharing the preview through {}", file.empty() ? PREVIEW_MAPPING : file);
+    return true;
+}
+
+void PreviewBuffer::Close(){
+    if (this->view == nullptr) return;
+
+    UnmapViewOfFile(this->view);
+    CloseHandle(this->mapping);
+    if (this->file != NULL) CloseHandle(this->file);
+
+    this->view = nullptr;
+    this->header = nullptr;
+    this->mapping = NULL;
+    this->file = NULL;
+}
+
+void PreviewBuffer::Publish(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t sourceWidth, uint32_t sourceHeight, int64_t time){
+    if (this->header == nullptr) return;
+
+    const AppConfig* config = CONFIG.Current();
+    // the config checks the range, but a zero here would divide by zero
+    int64_t interval = 1000000 / std::max(1, config->previewFps);
+    if (this->frame > 0 && time - this->lastFrameTime < interval) return;
+
+    // the gui isn't showing the preview, skip the copy
+    uint64_t polls = std::atomic_ref<uint64_t>(this->header->readerPolls).load(std::memory_order_relaxed);
+    if (polls != this->lastPolls) {
+        this->lastPolls = polls;
+        this->lastPollTime = time;
+    }
+    if (time - this->lastPollTime > READER_TIMEOUT_MICROS) return;
+
+    // usually 1 and a copy, a smaller preview height shrinks the shared frame further
+    uint32_t maxHeight = std::min<uint32_t>(std::max(1, config->previewHeight), this->header->maxHeight);
+    uint32_t factor = DownscaleFactor(width, height, this->header->maxWidth, maxHeight);
+    uint32_t outWidth = width / factor;
+    uint32_t outHeight = height / factor;
+    if (outWidth == 0 || outHeight == 0) return;
+
+    // stays ours while we write it, see PreviewTarget
+    std::atomic_ref<uint32_t> state(this->header->state);
+    uint32_t current = state.load(std::memory_order_acquire);
+    uint32_t target = PreviewTarget(current);
+
+    uint8_t* base = this->view + this->header->buffersOffset + std::size_t(target) * this->header->bufferSize;
+    PreviewFrameHeader* f = reinterpret_cast<PreviewFrameHeader*>(base);
+    f->number = ++this->frame;
+    f->time = time;
+    f->width = outWidth;
+    f->height = outHeight;
+    f->stride = outWidth * 4;
+    f->format = FRAME_BGRA;
+    f->sourceWidth = sourceWidth;
+    f->sourceHeight = sourceHeight;
+    DownscaleBgra(bgra, width, height, stride, factor, base + sizeof(PreviewFrameHeader), f->stride, this->scratch);
+
+    // keeps whichever buffer the reader took meanwhile
+    while (!state.compare_exchange_weak(current, PreviewState(target, PreviewReading(current), true),
+        std::memory_order_release, std::memory_order_relaxed)) {}
+    std::atomic_ref<uint64_t>(this->header->frames).store(this->frame, std::memory_order_relaxed);
+    this->lastFrameTime = time;
+}
@@ -0,0 +1,182 @@
+#include "process_cache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static void CALLBACK onProcessExit(void* context, BOOLEAN){
+    PROCCACHE.Exited(reinterpret_cast<uint64_t>(context));
+}
+
+class Win32ProcessSource: public ProcessSource {
+
+public:
+    bool Open(DWORD pid, std::string& path, ProcessHandle& handle) override {
+        HANDLE hProc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+        if (hProc == NULL) return false;
+
+        wchar_t wide[MAX_PATH];
+        DWORD size = MAX_PATH;
+        if (!QueryFullProcessImageNameW(hProc, 0, wide, &size)) {
+            CloseHandle(hProc);
+            return false;
+        }
+
+        int len = WideCharToMultiByte(CP_UTF8, 0, wide, size, NULL, 0, NULL, NULL);
+        path.resize(len);
+        WideCharToMultiByte(CP_UTF8, 0, wide, size, path.data(), len, NULL, NULL);
+        handle.process = hProc;
+        return true;
+    }
+
+    bool Watch(uint64_t waitId, ProcessHandle& handle) override {
+        // the wait only carries the id, so it never points at a dropped entry
+        HANDLE wait = NULL;
+        if (!RegisterWaitForSingleObject(&wait, handle.process, onProcessExit, 
+                reinterpret_cast<void*>(waitId), INFINITE, WT_EXECUTEONLYONCE)) {
+            return false;
+        }
+        handle.exitWait = wait;
+        return true;
+    }
+
+    void Close(ProcessHandle& handle) override {
+        // non blocking unregister, this runs on the wait callback itself
+        if (handle.exitWait != nullptr) UnregisterWait(handle.exitWait);
+        CloseHandle(handle.process);
+        handle = ProcessHandle();
+    }
+};
+#else
+class ProcSource: public ProcessSource {
+
+public:
+    bool Open(DWORD pid, std::string& path, ProcessHandle&) override {
+        char name[64];
+        char target[4096];
+        std::snprintf(name, sizeof(name), "/proc/%u/exe", pid);
+        ssize_t length = readlink(name, target, sizeof(target));
+        if (length <= 0) return false;
+
+        path.assign(target, static_cast<std::size_t>(length));
+        return true;
+    }
+
+    // nothing to wait on, entries stay until they are evicted
+    bool Watch(uint64_t, ProcessHandle&) override {
+        return true;
+    }
+
+    void Close(ProcessHandle&) override {}
+};
+#endif
+
+ProcessSource& ProcessSource::Native(){
+#ifdef _WIN32
+    static Win32ProcessSource inst;
+#else
+    static ProcSource inst;
+#endif
+    return inst;
+}
+
+ProcessCache& ProcessCache::Instance(){
+    static ProcessCache inst(ProcessSource::Native());
+    return inst; 
+};
+
+ProcessCache::~ProcessCache(){
+    for (auto& [pid, entry]: this->entries) this->source.Close(entry.handle);
+}
+
+bool ProcessCache::cached(DWORD pid, std::string& path){
+    auto it = this->entries.find(pid);
+    if (it == this->entries.end()) return false;
+    it->second.lastUse = ++this->uses;
+    path.assign(it->second.path);
+    return true;
+}
+
+bool ProcessCache::ImagePath(DWORD pid, std::string& path){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->cached(pid, path)) return true;
+    }
+
+    ProcessHandle handle;
+    if (!this->source.Open(pid, path, handle)) {
+        path.clear();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // another thread may have resolved the same process in the meantime
+    if (this->cached(pid, path)) {
+        this->source.Close(handle);
+        return true;
+    }
+    if (this->entries.size() >= this->capacity) this->evict();
+
+    auto it = this->entries.try_emplace(pid).first;
+    Entry& entry = it->second;
+    entry.waitId = (static_cast<uint64_t>(pid) << 32) | this->nextWait++;
+    entry.lastUse = ++this->uses;
+    entry.path = path;
+    entry.handle = handle;
+
+    // the wait can fire right away, it blocks on the lock until the entry is in
+    if (!this->source.Watch(entry.waitId, entry.handle)) {
+        this->source.Close(entry.handle);
+        this->entries.erase(it);
+    }
+
+    return true;
+}
+
+bool ProcessCache::Peek(DWORD pid, std::string& path){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->cached(pid, path)) return true;
+    }
+
+    ProcessHandle handle;
+    if (!this->source.Open(pid, path, handle)) {
+        path.clear();
+        return false;
+    }
+    this->source.Close(handle);
+    return true;
+}
+
+void ProcessCache::evict(){
+    // only runs once the cache is full, a walk over a few hundred entries
+    // is cheaper than keeping a recency list up to date on every hit
+    auto oldest = this->entries.begin();
+    for (auto it = this->entries.begin(); it != this->entries.end(); ++it) {
+        if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+    }
+    if (oldest == this->entries.end()) return;
+
+    this->source.Close(oldest->second.handle);
+    this->entries.erase(oldest);
+}
+
+std::size_t ProcessCache::Size(){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->entries.size();
+}
+
+void ProcessCache::Exited(uint64_t waitId){
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->entries.find(static_cast<DWORD>(waitId >> 32));
+    if (it == this->entries.end() || it->second.waitId != waitId) return;
+
+    this->source.Close(it->second.handle);
+    this->entries.erase(it);
+}
@@ -0,0 +1,238 @@
+#include "process_watcher.h"
+#include "logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <wbemidl.h>
+#else
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <iterator>
+#include <thread>
+#include <vector>
+#endif
+
+bool LaunchDetector::Check(DWORD pid){
+    this->match = GameMatch{};
+
+    // most launches aren't games, those aren't kept in the cache
+    if (!this->processes.Peek(pid, this->path)) return false;
+    this->match = this->rules.Match(this->path, "");
+    if (!this->match.Matched()) return false;
+
+    // warms the cache for when the game's window shows up
+    this->processes.ImagePath(pid, this->path);
+    return true;
+}
+
+#ifdef _WIN32
+// event driven process start trace, only available to elevated processes
+static const wchar_t* START_TRACE_QUERY = 
+    L"SELECT ProcessID FROM Win32_ProcessStartTrace";
+// fallback for unelevated processes, WMI checks for new processes every second
+static const wchar_t* INSTANCE_QUERY = 
+    L"SELECT * FROM __InstanceCreationEvent WITHIN 1 WHERE TargetInstance ISA 'Win32_Process'";
+
+static bool readPid(IWbemClassObject* obj, const wchar_t* name, DWORD& pid){
+    VARIANT v;
+    VariantInit(&v);
+    bool ok = SUCCEEDED(obj->Get(name, 0, &v, NULL, NULL)) && 
+        SUCCEEDED(VariantChangeType(&v, &v, 0, VT_UI4));
+    if (ok) pid = v.ulVal;
+    VariantClear(&v);
+    return ok;
+}
+
+// pulls the pid out of either query's event object
+static bool eventPid(IWbemClassObject* event, bool startTrace, DWORD& pid){
+    if (startTrace) return readPid(event, L"ProcessID", pid);
+
+    VARIANT v;
+    VariantInit(&v);
+    bool ok = false;
+    if (SUCCEEDED(event->Get(L"TargetInstance", 0, &v, NULL, NULL)) && v.vt == VT_UNKNOWN) {
+        IWbemClassObject* target = NULL;
+        if (SUCCEEDED(v.punkVal->QueryInterface(IID_IWbemClassObject, (void**)&target))) {
+            ok = readPid(target, L"ProcessId", pid);
+            target->Release();
+        }
+    }
+    VariantClear(&v);
+    return ok;
+}
+
+static HRESULT subscribe(IWbemServices* services, const wchar_t* wql, IEnumWbemClassObject** events){
+    BSTR lang = SysAllocString(L"WQL");
+    BSTR query = SysAllocString(wql);
+    HRESULT hr = services->ExecNotificationQuery(lang, query, 
+        WBEM_FLAG_RETURN_IMMEDIATELY | WBEM_FLAG_FORWARD_ONLY, NULL, events);
+    SysFreeString(query);
+    SysFreeString(lang);
+    return hr;
+}
+
+class WmiProcessWatcher: public ProcessWatcher {
+
+public:
+    bool Open() override {
+        HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+        if (FAILED(hr)) {
+            SLOG.error("process watcher: CoInitializeEx failed: {:#x}", static_cast<unsigned long>(hr));
+            return false;
+        }
+        this->comInit = true;
+        this->startTrace = true;
+
+        hr = CoCreateInstance(CLSID_WbemLocator, NULL, CLSCTX_INPROC_SERVER, 
+            IID_IWbemLocator, (void**)&this->locator);
+        if (SUCCEEDED(hr)) {
+            BSTR ns = SysAllocString(L"ROOT\\CIMV2");
+            hr = this->locator->ConnectServer(ns, NULL, NULL, NULL, 0, NULL, NULL, &this->services);
+            SysFreeString(ns);
+        }
+        if (SUCCEEDED(hr)) {
+            hr = CoSetProxyBlanket(this->services, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, NULL, 
+                RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
+        }
+        if (SUCCEEDED(hr)) {
+            hr = subscribe(this->services, START_TRACE_QUERY, &this->events);
+            if (FAILED(hr)) {
+                this->startTrace = false;
+                hr = subscribe(this->services, INSTANCE_QUERY, &this->events);
+            }
+        }
+
+        if (FAILED(hr)) {
+            SLOG.error("process watcher: unable to subscribe to process starts: {:#x}", 
+                static_cast<unsigned long>(hr));
+            this->events = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    ProcessWatchResult Next(DWORD& pid, std::chrono::milliseconds timeout) override {
+        if (this->events == NULL) return PROC_FAILED;
+
+        IWbemClassObject* event = NULL;
+        ULONG returned = 0;
+        HRESULT hr = this->events->Next(static_cast<long>(timeout.count()), 1, &event, &returned);
+
+        // semisynchronous queries report access denied on the first Next
+        if (FAILED(hr) && this->startTrace) {
+            this->events->Release();
+            this->events = NULL;
+            this->startTrace = false;
+            SLOG.info("process watcher: start trace unavailable, falling back to process creation events");
+            if (FAILED(subscribe(this->services, INSTANCE_QUERY, &this->events))) {
+                this->events = NULL;
+                return PROC_FAILED;
+            }
+            return PROC_TIMEOUT;
+        }
+        if (FAILED(hr)) {
+            SLOG.error("process watcher: event query failed: {:#x}", static_cast<unsigned long>(hr));
+            return PROC_FAILED;
+        }
+        if (returned == 0) return PROC_TIMEOUT;
+
+        bool hasPid = eventPid(event, this->startTrace, pid);
+        event->Release();
+        return hasPid ? PROC_STARTED : PROC_TIMEOUT;
+    }
+
+    void Close() override {
+        if (this->events != NULL) this->events->Release();
+        if (this->services != NULL) this->services->Release();
+        if (this->locator != NULL) this->locator->Release();
+        this->events = NULL;
+        this->services = NULL;
+        this->locator = NULL;
+        if (this->comInit) CoUninitialize();
+        this->comInit = false;
+    }
+
+private:
+    IWbemLocator* locator = NULL;
+    IWbemServices* services = NULL;
+    IEnumWbemClassObject* events = NULL;
+    bool startTrace = true;
+    bool comInit = false;
+};
+#else
+// Diffs the pids in /proc every SCAN_INTERVAL. Processes that start and exit
+// between two scans are missed, games don't.
+class ProcScanWatcher: public ProcessWatcher {
+
+public:
+    static constexpr std::chrono::milliseconds SCAN_INTERVAL{250};
+
+    bool Open() override {
+        this->started.clear();
+        this->reported = 0;
+        this->nextScan = std::chrono::steady_clock::now() + SCAN_INTERVAL;
+        return this->scan(this->known);
+    }
+
+    ProcessWatchResult Next(DWORD& pid, std::chrono::milliseconds timeout) override {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        while (this->reported == this->started.size()) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) return PROC_TIMEOUT;
+            if (now < this->nextScan) {
+                std::this_thread::sleep_for(std::min(this->nextScan, deadline) - now);
+                continue;
+            }
+            this->nextScan = now + SCAN_INTERVAL;
+
+            if (!this->scan(this->current)) return PROC_FAILED;
+            this->started.clear();
+            this->reported = 0;
+            std::set_difference(this->current.begin(), this->current.end(), 
+                this->known.begin(), this->known.end(), std::back_inserter(this->started));
+            std::swap(this->known, this->current);
+        }
+
+        pid = this->started[this->reported++];
+        return PROC_STARTED;
+    }
+
+    void Close() override {}
+
+private:
+    // sorted pids of the last scan and the one before it
+    std::vector<DWORD> known;
+    std::vector<DWORD> current;
+    // in the last scan but not the one before, the first reported are done
+    std::vector<DWORD> started;
+    std::size_t reported = 0;
+    std::chrono::steady_clock::time_point nextScan;
+
+    bool scan(std::vector<DWORD>& pids){
+        DIR* dir = opendir("/proc");
+        if (dir == nullptr) return false;
+
+        pids.clear();
+        while (dirent* entry = readdir(dir)) {
+            char* end;
+            unsigned long pid = std::strtoul(entry->d_name, &end, 10);
+            if (*end == '\0' && end != entry->d_name) pids.push_back(static_cast<DWORD>(pid));
+        }
+        closedir(dir);
+
+        std::sort(pids.begin(), pids.end());
+        return true;
+    }
+};
+#endif
+
+ProcessWatcher& ProcessWatcher::Native(){
+#ifdef _WIN32
+    static WmiProcessWatcher inst;
+#else
+    static ProcScanWatcher inst;
+#endif
+    return inst;
+}
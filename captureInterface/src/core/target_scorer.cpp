@@ -0,0 +1,133 @@
+#include "target_scorer.h"
+
+#include <algorithm>
+
+// input seen within this window counts as the user playing
+static const uint64_t INPUT_RECENT_MS = 30000;
+// foreground time stops adding to the score after this
+static const uint64_t FOREGROUND_FULL_MS = 60000;
+
+void TargetScorer::Add(HWND hwnd, float confidence){
+    auto [it, inserted] = this->candidates.try_emplace(hwnd);
+    Candidate& c = it->second;
+    if (inserted) c.hwnd = hwnd;
+    c.confidence = confidence;
+
+    uint64_t now = this->windows.NowMs();
+    if (hwnd == this->windows.Foreground()) {
+        this->foreground = hwnd;
+        if (c.foregroundSince == 0) c.foregroundSince = now;
+    }
+
+    c.shape = this->windows.Shape(c.hwnd);
+    this->updateBest(c, this->rescore(c, now));
+}
+
+void TargetScorer::Remove(HWND hwnd){
+    if (this->candidates.erase(hwnd) == 0) return;
+    if (this->foreground == hwnd) this->foreground = NULL;
+    if (this->best == hwnd) this->rescanBest();
+}
+
+void TargetScorer::OnForeground(HWND hwnd){
+    if (hwnd == this->foreground) return;
+    uint64_t now = this->windows.NowMs();
+
+    // bank the time the previous foreground candidate spent on top
+    auto prev = this->candidates.find(this->foreground);
+    if (prev != this->candidates.end()) {
+        Candidate& c = prev->second;
+        c.foregroundMs += now - c.foregroundSince;
+        c.foregroundSince = 0;
+        this->updateBest(c, this->rescore(c, now));
+    }
+
+    this->foreground = hwnd;
+
+    auto next = this->candidates.find(hwnd);
+    if (next != this->candidates.end()) {
+        Candidate& c = next->second;
+        c.foregroundSince = now;
+        c.shape = this->windows.Shape(c.hwnd);
+        this->updateBest(c, this->rescore(c, now));
+    }
+}
+
+void TargetScorer::Moved(HWND hwnd){
+    auto it = this->candidates.find(hwnd);
+    if (it == this->candidates.end()) return;
+
+    Candidate& c = it->second;
+    c.shape = this->windows.Shape(c.hwnd);
+    this->updateBest(c, this->rescore(c, this->windows.NowMs()));
+}
+
+void TargetScorer::Tick(){
+    auto it = this->candidates.find(this->foreground);
+    if (it == this->candidates.end()) return;
+
+    uint64_t now = this->windows.NowMs();
+    Candidate& c = it->second;
+
+    // input is system wide, credit it to whatever candidate is on top
+    c.lastInput = std::max(c.lastInput, this->windows.LastInputMs());
+
+    this->updateBest(c, this->rescore(c, now));
+}
+
+float TargetScorer::Score(HWND hwnd) const {
+    auto it = this->candidates.find(hwnd);
+    return it == this->candidates.end() ? 0.0f : it->second.score;
+}
+
+float TargetScorer::rescore(Candidate& c, uint64_t now){
+    float previous = c.score;
+
+    uint64_t fgMs = c.foregroundMs;
+    if (c.foregroundSince != 0) fgMs += now - c.foregroundSince;
+    float fgTerm = float(std::min(fgMs, FOREGROUND_FULL_MS)) / FOREGROUND_FULL_MS;
+
+    bool recentInput = c.lastInput != 0 && now - c.lastInput < INPUT_RECENT_MS;
+
+    c.score = 0.35f * c.confidence
+        + 0.25f * (c.shape.fullscreen ? 1.0f : c.shape.coverage)
+        + 0.20f * fgTerm
+        + 0.10f * (c.hwnd == this->foreground ? 1.0f : 0.0f)
+        + 0.10f * (recentInput ? 1.0f : 0.0f)
+        - 0.30f * (c.shape.auxiliary ? 1.0f : 0.0f);
+    return previous;
+}
+
+void TargetScorer::updateBest(Candidate& c, float previous){
+    if (this->best == NULL) {
+        this->best = c.hwnd;
+        return;
+    }
+    if (c.hwnd == this->best) {
+        // the best only needs replacing if it lost ground
+        if (c.score < previous) this->rescanBest();
+        return;
+    }
+
+    if (c.score > this->candidates.at(this->best).score + SWITCH_MARGIN) {
+        this->best = c.hwnd;
+    }
+}
+
+void TargetScorer::rescanBest(){
+    HWND top = NULL;
+    float topScore = 0.0f;
+    for (auto& [hwnd, c]: this->candidates) {
+        if (top == NULL || c.score > topScore) {
+            top = hwnd;
+            topScore = c.score;
+        }
+    }
+
+    // keep the current best unless something clearly beats it
+    auto current = this->candidates.find(this->best);
+    if (current != this->candidates.end() && current->second.score + SWITCH_MARGIN >= topScore) {
+        return;
+    }
+    this->best = top;
+}
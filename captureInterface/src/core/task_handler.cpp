@@ -44,15 +44,14 @@ void TaskHandler::Start(){
 
 void TaskHandler::runTask(std::unique_ptr<Task> t) {
 
-    std::ostringstream oss;
-    oss << "task handler: executing " << t->GetName();
-    SLOG.info(oss.str());
+    SLOG.info("task handler: executing {}", t->GetName());
 
     auto handle = std::make_unique<TaskThreadHandle>();
     handle->tTitle = t->GetName();
     handle->complete = std::make_shared<std::atomic<bool>>(false);
+    handle->task = std::move(t);
 
-    std::thread tThread([task = std::move(t), complete = handle->complete]() {
+    std::thread tThread([task = handle->task, complete = handle->complete]() {
         task->Execute();
         complete->store(true); 
     });
@@ -70,9 +69,7 @@ void TaskHandler::cleanHandles() {
 
     for (auto it = taskHandles.begin(); it != taskHandles.end();){
         if ((*it)->complete->load()) { 
-            std::ostringstream oss;
-            oss << "task handler: completed " << (*it)->tTitle;
-            SLOG.info(oss.str());
+            SLOG.info("task handler: completed {}", (*it)->tTitle);
 
             if ((*it)->tThread.joinable()) {
                 (*it)->tThread.join(); 
@@ -84,10 +81,7 @@ void TaskHandler::cleanHandles() {
 }
 
 void TaskHandler::AddTask(std::unique_ptr<Task> t){
-    std::ostringstream oss;
-    oss << "adding task: " << t->GetName();
-
-    SLOG.info(oss.str());
+    SLOG.info("adding task: {}", t->GetName());
 
     {
         std::lock_guard<std::mutex> lock(this->tasksBufMutex);
@@ -95,4 +89,11 @@ void TaskHandler::AddTask(std::unique_ptr<Task> t){
     }
 }
 
-void TaskHandler::End(){ this->running = false; }
+void TaskHandler::End(){ 
+    this->running = false; 
+
+    std::lock_guard<std::mutex> lock(taskHandlesMutex);
+    for (auto& handle: taskHandles) {
+        if (!handle->complete->load()) handle->task->Stop();
+    }
+}
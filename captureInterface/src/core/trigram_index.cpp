@@ -0,0 +1,336 @@
+#include "trigram_index.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+static char normalise(char c){
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) return c;
+    // utf-8 sequences are kept as is
+    if (static_cast<uint8_t>(c) >= 0x80) return c;
+    return ' ';
+}
+
+void TrigramIndex::trigrams(std::string_view text, bool query, std::vector<uint32_t>& out){
+    out.clear();
+    uint32_t window = static_cast<uint8_t>(' ');
+    int length = 1;
+    char prev = ' ';
+
+    for (std::size_t i = 0; i <= text.size(); i++) {
+        char c = i < text.size() ? normalise(text[i]) : ' ';
+        // runs of separators count as one
+        if (c == ' ' && prev == ' ') continue;
+        prev = c;
+
+        window = ((window << 8) | static_cast<uint8_t>(c)) & 0xffffff;
+        if (++length < 3) continue;
+
+        // trigrams across two words would make word order matter, and the
+        // last word of a query may still be being typed so its end isn't
+        // known
+        if (((window >> 8) & 0xff) == ' ') continue;
+        if (query && c == ' ') continue;
+        out.push_back(window);
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void TrigramIndex::append(PostingList& list, uint32_t doc){
+    list.tail.push_back(doc);
+    list.count++;
+    if (list.tail.size() < BLOCK_SIZE) return;
+
+    Block block{ .first = list.tail.front(), .last = list.tail.back(),
+        .offset = static_cast<uint32_t>(list.bytes.size()), .count = BLOCK_SIZE };
+    for (uint32_t i = 1; i < BLOCK_SIZE; i++) {
+        uint32_t delta = list.tail[i] - list.tail[i - 1];
+        while (delta >= 0x80) {
+            list.bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+            delta >>= 7;
+        }
+        list.bytes.push_back(static_cast<uint8_t>(delta));
+    }
+    list.blocks.push_back(block);
+    list.tail.clear();
+}
+
+void TrigramIndex::decodeBlock(const PostingList& list, const Block& block, uint32_t* out){
+    const uint8_t* p = list.bytes.data() + block.offset;
+    uint32_t doc = block.first;
+    out[0] = doc;
+    for (uint32_t i = 1; i < block.count; i++) {
+        uint32_t delta = 0;
+        int shift = 0;
+        uint8_t b;
+        do {
+            b = *p++;
+            delta |= uint32_t(b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        doc += delta;
+        out[i] = doc;
+    }
+}
+
+std::size_t TrigramIndex::firstBlock(const std::vector<Block>& blocks, uint32_t doc){
+    return std::lower_bound(blocks.begin(), blocks.end(), doc,
+        [](const Block& b, uint32_t d) { return b.last < d; }) - blocks.begin();
+}
+
+void TrigramIndex::decodeRange(const PostingList& list, uint32_t lo, uint32_t hi, std::vector<uint32_t>& out){
+    out.clear();
+    uint32_t block[BLOCK_SIZE];
+
+    auto copyRun = [&](const uint32_t* ids, std::size_t count) {
+        const uint32_t* begin = std::lower_bound(ids, ids + count, lo);
+        const uint32_t* end = std::lower_bound(begin, ids + count, hi);
+        out.insert(out.end(), begin, end);
+    };
+
+    for (std::size_t i = firstBlock(list.blocks, lo); i < list.blocks.size(); i++) {
+        const Block& b = list.blocks[i];
+        if (b.first >= hi) return;
+        decodeBlock(list, b, block);
+        copyRun(block, b.count);
+    }
+    copyRun(list.tail.data(), list.tail.size());
+}
+
+// sorted set intersection, 4x4 ids per step: every id of a is compared with
+// every rotation of b. writes the common ids to out and returns their count.
+static std::size_t intersectSorted(const uint32_t* a, std::size_t na, const uint32_t* b, std::size_t nb, uint32_t* out){
+    std::size_t i = 0, j = 0, n = 0;
+
+    while (i + 4 <= na && j + 4 <= nb) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        for (int k = 0; k < 4; k++) {
+            if (mask & (1 << k)) out[n++] = a[i + k];
+        }
+
+        uint32_t lastA = a[i + 3];
+        uint32_t lastB = b[j + 3];
+        if (lastA <= lastB) i += 4;
+        if (lastB <= lastA) j += 4;
+    }
+
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) i++;
+        else if (b[j] < a[i]) j++;
+        else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+
+void TrigramIndex::intersect(const PostingList& list, std::vector<uint32_t>& docs, std::vector<uint32_t>& scratch){
+    uint32_t block[BLOCK_SIZE];
+    std::size_t kept = 0;
+    std::size_t d = 0;
+
+    auto intersectRun = [&](const uint32_t* ids, std::size_t count) {
+        // docs in [d, end) fall inside this run of ids
+        std::size_t end = std::upper_bound(docs.begin() + d, docs.end(), ids[count - 1]) - docs.begin();
+        if (end == d) return;
+        scratch.resize(std::max(scratch.size(), end - d));
+        std::size_t n = intersectSorted(docs.data() + d, end - d, ids, count, scratch.data());
+        // kept <= d, so the results can be moved down in place
+        std::copy(scratch.begin(), scratch.begin() + n, docs.begin() + kept);
+        kept += n;
+        d = end;
+    };
+
+    if (docs.empty()) return;
+    for (std::size_t i = firstBlock(list.blocks, docs.front()); i < list.blocks.size(); i++) {
+        const Block& b = list.blocks[i];
+        if (d == docs.size() || b.first > docs.back()) break;
+        // skip blocks entirely before the next candidate without decoding
+        if (b.last < docs[d]) continue;
+        // and candidates entirely before this block
+        d = std::lower_bound(docs.begin() + d, docs.end(), b.first) - docs.begin();
+        if (d == docs.size() || docs[d] > b.last) continue;
+
+        decodeBlock(list, b, block);
+        intersectRun(block, b.count);
+    }
+    if (d < docs.size() && !list.tail.empty()) {
+        d = std::lower_bound(docs.begin() + d, docs.end(), list.tail.front()) - docs.begin();
+        if (d < docs.size()) intersectRun(list.tail.data(), list.tail.size());
+    }
+
+    docs.resize(kept);
+}
+
+void TrigramIndex::Add(uint64_t id, std::string_view text){
+    if (this->docOf.count(id)) this->Remove(id);
+
+    uint32_t doc = static_cast<uint32_t>(this->docIds.size());
+    this->docIds.push_back(id);
+    this->removed.push_back(false);
+    this->docOf[id] = doc;
+    this->liveDocs++;
+
+    std::vector<uint32_t> grams;
+    trigrams(text, false, grams);
+    for (uint32_t gram: grams) append(this->postings[gram], doc);
+}
+
+void TrigramIndex::Remove(uint64_t id){
+    auto it = this->docOf.find(id);
+    if (it == this->docOf.end()) return;
+    this->removed[it->second] = true;
+    this->docOf.erase(it);
+    this->liveDocs--;
+
+    std::size_t tombstones = this->docIds.size() - this->liveDocs;
+    if (tombstones > COMPACT_MIN && tombstones > this->liveDocs) this->compact();
+}
+
+void TrigramIndex::compact(){
+    // live documents keep their order, so every list stays sorted
+    std::vector<uint32_t> remap(this->docIds.size(), UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t doc = 0; doc < this->docIds.size(); doc++) {
+        if (this->removed[doc]) continue;
+        remap[doc] = next;
+        this->docIds[next] = this->docIds[doc];
+        this->docOf[this->docIds[next]] = next;
+        next++;
+    }
+    this->docIds.resize(next);
+    this->docIds.shrink_to_fit();
+    this->removed.assign(next, false);
+
+    std::vector<uint32_t> docs;
+    for (auto it = this->postings.begin(); it != this->postings.end();) {
+        decodeRange(it->second, 0, UINT32_MAX, docs);
+        PostingList list;
+        for (uint32_t doc: docs) {
+            if (remap[doc] != UINT32_MAX) append(list, remap[doc]);
+        }
+        if (list.count == 0) {
+            it = this->postings.erase(it);
+        } else {
+            it->second = std::move(list);
+            ++it;
+        }
+    }
+}
+
+void TrigramIndex::Clear(){
+    this->postings.clear();
+    this->docIds.clear();
+    this->removed.clear();
+    this->docOf.clear();
+    this->liveDocs = 0;
+}
+
+std::size_t TrigramIndex::PostingBytes() const {
+    std::size_t bytes = 0;
+    for (const auto& [gram, list]: this->postings) {
+        bytes += list.bytes.size() + list.blocks.size() * sizeof(Block) + list.tail.size() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+std::vector<SearchHit> TrigramIndex::Search(std::string_view query, std::size_t limit) const {
+    std::vector<SearchHit> hits;
+    if (limit == 0) return hits;
+
+    std::vector<uint32_t> grams;
+    trigrams(query, true, grams);
+    // keeps the per document hit counts below fit in a byte
+    if (grams.size() > MAX_QUERY_TRIGRAMS) grams.resize(MAX_QUERY_TRIGRAMS);
+
+    std::vector<const PostingList*> lists;
+    for (uint32_t gram: grams) {
+        auto it = this->postings.find(gram);
+        if (it != this->postings.end()) lists.push_back(&it->second);
+    }
+    if (lists.empty()) return hits;
+    std::sort(lists.begin(), lists.end(),
+        [](const PostingList* a, const PostingList* b) { return a->count < b->count; });
+
+    // results are newest first, so documents are visited in windows going
+    // back from the newest and the search stops once enough were found
+    const uint32_t docCount = static_cast<uint32_t>(this->docIds.size());
+    std::vector<uint32_t> docs, scratch;
+
+    // exact: every trigram, starting from the rarest
+    if (lists.size() == grams.size()) {
+        for (uint32_t hi = docCount; hi > 0 && hits.size() < limit;) {
+            uint32_t lo = hi > SEARCH_WINDOW ? hi - SEARCH_WINDOW : 0;
+            decodeRange(*lists[0], lo, hi, docs);
+            for (std::size_t i = 1; i < lists.size() && !docs.empty(); i++) intersect(*lists[i], docs, scratch);
+
+            for (auto it = docs.rbegin(); it != docs.rend() && hits.size() < limit; ++it) {
+                if (this->removed[*it]) continue;
+                hits.push_back(SearchHit{ .id = this->docIds[*it], .matched = static_cast<uint32_t>(grams.size()) });
+            }
+            hi = lo;
+        }
+        if (hits.size() == limit || grams.size() < 2) return hits;
+    }
+
+    // fuzzy: one mistyped character breaks at most three trigrams, so half
+    // of them still matching is a good bar. a document reaching it has to be
+    // in at least one of the rarest lists.size() - threshold + 1 lists, the
+    // other lists only add to the counts of those candidates.
+    const uint32_t threshold = static_cast<uint32_t>((grams.size() + 1) / 2);
+    if (lists.size() < threshold) return hits;
+    const std::size_t seedLists = lists.size() - threshold + 1;
+    const uint32_t full = static_cast<uint32_t>(grams.size());
+
+    thread_local std::vector<uint8_t> counts;
+    std::vector<std::pair<uint32_t, uint32_t>> fuzzy;
+    std::vector<uint32_t> candidates;
+
+    for (uint32_t hi = docCount; hi > 0 && hits.size() + fuzzy.size() < limit;) {
+        uint32_t lo = hi > SEARCH_WINDOW ? hi - SEARCH_WINDOW : 0;
+        counts.assign(hi - lo, 0);
+        candidates.clear();
+
+        for (std::size_t i = 0; i < seedLists; i++) {
+            decodeRange(*lists[i], lo, hi, docs);
+            for (uint32_t doc: docs) {
+                if (counts[doc - lo]++ == 0) candidates.push_back(doc);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for (std::size_t i = seedLists; i < lists.size() && !candidates.empty(); i++) {
+            docs = candidates;
+            intersect(*lists[i], docs, scratch);
+            for (uint32_t doc: docs) counts[doc - lo]++;
+        }
+
+        std::size_t windowStart = fuzzy.size();
+        for (uint32_t doc: candidates) {
+            uint32_t count = counts[doc - lo];
+            // exact hits are already in the result
+            if (count < threshold || count == full || this->removed[doc]) continue;
+            fuzzy.emplace_back(count, doc);
+        }
+        // within the window, more matched trigrams first, then newer
+        std::sort(fuzzy.begin() + windowStart, fuzzy.end(), std::greater<>());
+        hi = lo;
+    }
+
+    for (std::size_t i = 0; i < fuzzy.size() && hits.size() < limit; i++) {
+        hits.push_back(SearchHit{ .id = this->docIds[fuzzy[i].second], .matched = fuzzy[i].first });
+    }
+    return hits;
+}
@@ -0,0 +1,27 @@
+#include "window_events.h"
+
+WindowEvents& WindowEvents::Instance(){
+    static WindowEvents inst;
+    return inst; 
+};
+
+void WindowEvents::Push(WinEventKind kind, HWND hwnd){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->pending.size() >= MAX_PENDING) return;
+        this->pending.push_back(WinEvent{ .kind = kind, .hwnd = hwnd });
+    }
+    this->cv.notify_one();
+}
+
+bool WindowEvents::Wait(std::vector<WinEvent>& out, std::chrono::milliseconds timeout){
+    out.clear();
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (!this->cv.wait_for(lock, timeout, [this]{ return !this->pending.empty(); })) {
+        return false;
+    }
+
+    std::swap(out, this->pending);
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "window_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+void WindowSnapshot::Clear(){
+    this->entries.clear();
+    this->arena.clear();
+}
+
+void WindowSnapshot::Add(HWND hwnd, DWORD pid, std::string_view title){
+    if (title.empty()) return;
+
+    std::size_t offset = this->arena.size();
+    this->arena.resize(offset + title.size());
+    std::memcpy(this->arena.data() + offset, title.data(), title.size());
+
+    this->entries.push_back(WindowEntry{
+        .hwnd = hwnd,
+        .pid = pid,
+        .titleOffset = static_cast<uint32_t>(offset),
+        .titleLength = static_cast<uint32_t>(title.size()),
+    });
+}
+
+#ifdef _WIN32
+void WindowSnapshot::Add(HWND hwnd, DWORD pid, const wchar_t* title, int titleLength){
+    int len = WideCharToMultiByte(CP_UTF8, 0, title, titleLength, NULL, 0, NULL, NULL);
+    if (len <= 0) return;
+
+    // grows only past the largest title set seen so far
+    std::size_t offset = this->arena.size();
+    this->arena.resize(offset + len);
+    WideCharToMultiByte(CP_UTF8, 0, title, titleLength, this->arena.data() + offset, len, NULL, NULL);
+
+    this->entries.push_back(WindowEntry{
+        .hwnd = hwnd,
+        .pid = pid,
+        .titleOffset = static_cast<uint32_t>(offset),
+        .titleLength = static_cast<uint32_t>(len),
+    });
+}
+#endif
+
+static bool byHandle(const WindowEntry& a, const WindowEntry& b){
+    return a.hwnd < b.hwnd;
+}
+
+void WindowSnapshot::Sort(){
+    std::sort(this->entries.begin(), this->entries.end(), byHandle);
+}
+
+const WindowEntry* WindowSnapshot::Find(HWND hwnd) const {
+    WindowEntry key = { .hwnd = hwnd, .pid = 0, .titleOffset = 0, .titleLength = 0 };
+    auto it = std::lower_bound(this->entries.begin(), this->entries.end(), key, byHandle);
+    if (it == this->entries.end() || it->hwnd != hwnd) return nullptr;
+    return &*it;
+}
+
+std::string_view WindowSnapshot::Title(const WindowEntry& entry) const {
+    return std::string_view(this->arena.data() + entry.titleOffset, entry.titleLength);
+}
+
+void DiffWindows(const WindowSnapshot& prev, const WindowSnapshot& cur, 
+        std::vector<uint32_t>& added, std::vector<uint32_t>& removed){
+    added.clear();
+    removed.clear();
+
+    const std::vector<WindowEntry>& a = prev.Entries();
+    const std::vector<WindowEntry>& b = cur.Entries();
+    std::size_t i = 0, j = 0;
+
+    // merge walk over both handle sorted lists
+    while (i < a.size() || j < b.size()) {
+        if (j == b.size() || (i < a.size() && a[i].hwnd < b[j].hwnd)) {
+            removed.push_back(i++);
+        } else if (i == a.size() || b[j].hwnd < a[i].hwnd) {
+            added.push_back(j++);
+        } else {
+            if (prev.Title(a[i]) != cur.Title(b[j])) added.push_back(j);
+            i++;
+            j++;
+        }
+    }
+}
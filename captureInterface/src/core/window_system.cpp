@@ -0,0 +1,62 @@
+#include "window_system.h"
+#include "utils.h"
+
+#include <windows.h>
+
+class Win32WindowSystem: public WindowSystem {
+
+public:
+    void Scan(WindowSnapshot& snapshot) override {
+        Utils::ScanFgWins(snapshot);
+    }
+
+    HWND Foreground() override {
+        return GetForegroundWindow();
+    }
+
+    std::size_t ClassName(HWND hwnd, char* buf, std::size_t size) override {
+        return Utils::classNameHWND(hwnd, buf, size);
+    }
+
+    WindowShape Shape(HWND hwnd) override {
+        WindowShape shape;
+
+        RECT win;
+        MONITORINFO monitor = { .cbSize = sizeof(MONITORINFO) };
+        HMONITOR hmon = MonitorFromWindow(hwnd, MONITOR_DEFAULTTONULL);
+        if (hmon != NULL && GetWindowRect(hwnd, &win) && GetMonitorInfo(hmon, &monitor)) {
+            RECT& m = monitor.rcMonitor;
+            RECT overlap;
+            if (IntersectRect(&overlap, &win, &m)) {
+                float area = float(overlap.right - overlap.left) * float(overlap.bottom - overlap.top);
+                float monitorArea = float(m.right - m.left) * float(m.bottom - m.top);
+                shape.coverage = monitorArea > 0 ? area / monitorArea : 0.0f;
+            }
+            shape.fullscreen = win.left <= m.left && win.top <= m.top && 
+                win.right >= m.right && win.bottom >= m.bottom;
+        }
+
+        LONG_PTR exStyle = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
+        shape.auxiliary = GetWindow(hwnd, GW_OWNER) != NULL || (exStyle & WS_EX_TOOLWINDOW) != 0;
+        return shape;
+    }
+
+    uint64_t NowMs() override {
+        return GetTickCount64();
+    }
+
+    uint64_t LastInputMs() override {
+        LASTINPUTINFO input = { .cbSize = sizeof(LASTINPUTINFO) };
+        if (!GetLastInputInfo(&input)) return 0;
+
+        // the tick in LASTINPUTINFO is the 32 bit GetTickCount
+        uint64_t now = GetTickCount64();
+        uint64_t since = static_cast<uint32_t>(now) - input.dwTime;
+        return since < now ? now - since : 0;
+    }
+};
+
+WindowSystem& WindowSystem::Native(){
+    static Win32WindowSystem inst;
+    return inst;
+}
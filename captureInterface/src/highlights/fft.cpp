@@ -0,0 +1,136 @@
+#include "fft.h"
+
+#include <cassert>
+#include <cmath>
+#include <emmintrin.h>
+
+static const double PI = 3.14159265358979323846;
+
+RealFft::RealFft(std::size_t size): size(size), half(size / 2) {
+    // the radix-4 pass needs a half size of at least 4
+    assert(size >= 8 && (size & (size - 1)) == 0);
+    unsigned bits = 0;
+    while ((std::size_t(1) << bits) < this->half) bits++;
+
+    this->bitReverse.resize(this->half);
+    for (unsigned i = 0; i < this->half; i++) {
+        unsigned r = 0;
+        for (unsigned b = 0; b < bits; b++) {
+            if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+        }
+        this->bitReverse[i] = r;
+    }
+
+    // passes after the radix-4 one start at len 8
+    for (std::size_t len = 8; len <= this->half; len *= 2) {
+        for (std::size_t k = 0; k < len / 2; k++) {
+            double angle = -2.0 * PI * double(k) / double(len);
+            this->twiddleRe.push_back(static_cast<float>(std::cos(angle)));
+            this->twiddleIm.push_back(static_cast<float>(std::sin(angle)));
+        }
+    }
+
+    for (std::size_t k = 0; k <= this->half; k++) {
+        double angle = -2.0 * PI * double(k) / double(size);
+        this->splitRe.push_back(static_cast<float>(std::cos(angle)));
+        this->splitIm.push_back(static_cast<float>(std::sin(angle)));
+    }
+
+    this->workRe.resize(this->half);
+    this->workIm.resize(this->half);
+    this->outRe.resize(this->half + 1);
+    this->outIm.resize(this->half + 1);
+}
+
+void RealFft::complexFft(){
+    float* re = this->workRe.data();
+    float* im = this->workIm.data();
+    const std::size_t n = this->half;
+
+    // lengths 2 and 4 together as radix-4 butterflies, -i is the only
+    // twiddle that isn't 1
+    for (std::size_t s = 0; s < n; s += 4) {
+        float a0r = re[s] + re[s + 1], a0i = im[s] + im[s + 1];
+        float a1r = re[s] - re[s + 1], a1i = im[s] - im[s + 1];
+        float a2r = re[s + 2] + re[s + 3], a2i = im[s + 2] + im[s + 3];
+        float a3r = re[s + 2] - re[s + 3], a3i = im[s + 2] - im[s + 3];
+
+        re[s] = a0r + a2r;
+        im[s] = a0i + a2i;
+        re[s + 2] = a0r - a2r;
+        im[s + 2] = a0i - a2i;
+        // a3 * -i is (a3i, -a3r)
+        re[s + 1] = a1r + a3i;
+        im[s + 1] = a1i - a3r;
+        re[s + 3] = a1r - a3i;
+        im[s + 3] = a1i + a3r;
+    }
+
+    // radix-2 passes, four butterflies per step
+    const float* twRe = this->twiddleRe.data();
+    const float* twIm = this->twiddleIm.data();
+    for (std::size_t len = 8; len <= n; len *= 2) {
+        const std::size_t halfLen = len / 2;
+        for (std::size_t s = 0; s < n; s += len) {
+            for (std::size_t k = 0; k < halfLen; k += 4) {
+                __m128 wr = _mm_loadu_ps(twRe + k);
+                __m128 wi = _mm_loadu_ps(twIm + k);
+                __m128 ur = _mm_loadu_ps(re + s + k);
+                __m128 ui = _mm_loadu_ps(im + s + k);
+                __m128 vr = _mm_loadu_ps(re + s + k + halfLen);
+                __m128 vi = _mm_loadu_ps(im + s + k + halfLen);
+
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(vr, wr), _mm_mul_ps(vi, wi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(vr, wi), _mm_mul_ps(vi, wr));
+
+                _mm_storeu_ps(re + s + k, _mm_add_ps(ur, tr));
+                _mm_storeu_ps(im + s + k, _mm_add_ps(ui, ti));
+                _mm_storeu_ps(re + s + k + halfLen, _mm_sub_ps(ur, tr));
+                _mm_storeu_ps(im + s + k + halfLen, _mm_sub_ps(ui, ti));
+            }
+        }
+        twRe += halfLen;
+        twIm += halfLen;
+    }
+}
+
+void RealFft::Forward(const float* in, float* re, float* im){
+    const std::size_t n = this->half;
+
+    // even samples are the real parts, odd ones the imaginary parts
+    for (std::size_t i = 0; i < n; i++) {
+        unsigned r = this->bitReverse[i];
+        this->workRe[r] = in[2 * i];
+        this->workIm[r] = in[2 * i + 1];
+    }
+    this->complexFft();
+
+    // X[k] = E[k] + w^k O[k], with E and O recovered from Z[k] and Z[n-k]
+    for (std::size_t k = 0; k <= n; k++) {
+        float zr = this->workRe[k % n], zi = this->workIm[k % n];
+        float cr = this->workRe[(n - k) % n], ci = -this->workIm[(n - k) % n];
+
+        float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        // (z - conj) / 2i
+        float orr = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+
+        float wr = this->splitRe[k], wi = this->splitIm[k];
+        re[k] = er + orr * wr - oi * wi;
+        im[k] = ei + orr * wi + oi * wr;
+    }
+}
+
+void RealFft::Magnitudes(const float* in, float* out){
+    this->Forward(in, this->outRe.data(), this->outIm.data());
+
+    const std::size_t bins = this->half + 1;
+    std::size_t k = 0;
+    for (; k + 4 <= bins; k += 4) {
+        __m128 r = _mm_loadu_ps(this->outRe.data() + k);
+        __m128 i = _mm_loadu_ps(this->outIm.data() + k);
+        _mm_storeu_ps(out + k, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(i, i))));
+    }
+    for (; k < bins; k++) {
+        out[k] = std::sqrt(this->outRe[k] * this->outRe[k] + this->outIm[k] * this->outIm[k]);
+    }
+}
@@ -0,0 +1,91 @@
+#include "highlights.h"
+#include "ipc_api.h"
+
+#include <algorithm>
+#include <iterator>
+
+static int64_t endOf(const HighlightMarker& m){
+    return m.time + int64_t(m.durationMs) * 1000;
+}
+
+HighlightTimeline& HighlightTimeline::Instance(){
+    static HighlightTimeline inst;
+    return inst; 
+};
+
+void HighlightTimeline::SetRetention(int64_t micros){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->retention = micros;
+}
+
+void HighlightTimeline::Add(const HighlightMarker& marker){
+    IpcApi::PushHighlight(marker);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // detectors run behind real time by different amounts, so a marker can
+    // land a little before the newest ones
+    auto pos = std::upper_bound(this->markers.begin(), this->markers.end(), marker.time,
+        [](int64_t t, const HighlightMarker& m) { return t < m.time; });
+
+    // merge into the closest earlier marker of the same kind if they touch
+    auto merged = this->markers.end();
+    for (auto it = pos; it != this->markers.begin();) {
+        --it;
+        if (endOf(*it) + MERGE_GAP < marker.time) break;
+        if (it->kind != marker.kind) continue;
+
+        int64_t end = std::max(endOf(*it), endOf(marker));
+        it->durationMs = static_cast<uint32_t>((end - it->time) / 1000);
+        it->score = std::max(it->score, marker.score);
+        merged = it;
+        break;
+    }
+    if (merged == this->markers.end()) merged = this->markers.insert(pos, marker);
+
+    // and swallow later ones it now touches
+    for (auto it = std::next(merged); it != this->markers.end() && it->time <= endOf(*merged) + MERGE_GAP;) {
+        if (it->kind != merged->kind) {
+            ++it;
+            continue;
+        }
+        int64_t end = std::max(endOf(*merged), endOf(*it));
+        merged->durationMs = static_cast<uint32_t>((end - merged->time) / 1000);
+        merged->score = std::max(merged->score, it->score);
+        it = this->markers.erase(it);
+    }
+
+    int64_t newest = this->markers.back().time;
+    while (!this->markers.empty() && this->markers.front().time < newest - this->retention) {
+        this->markers.pop_front();
+    }
+}
+
+std::vector<HighlightMarker> HighlightTimeline::Between(int64_t from, int64_t to) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<HighlightMarker> result;
+    for (const HighlightMarker& m: this->markers) {
+        if (m.time >= to) break;
+        if (m.time >= from) result.push_back(m);
+    }
+    return result;
+}
+
+std::vector<ClipSidecarMarker> HighlightTimeline::ForClip(int64_t from, int64_t to) const {
+    std::vector<ClipSidecarMarker> result;
+    for (const HighlightMarker& m: this->Between(from, to)) {
+        result.push_back(ClipSidecarMarker{
+            .time = m.time - from, .durationMs = m.durationMs, .kind = m.kind, .score = m.score, .reserved = 0
+        });
+    }
+    return result;
+}
+
+bool HighlightTimeline::Best(int64_t from, int64_t to, HighlightMarker& out) const {
+    bool found = false;
+    for (const HighlightMarker& m: this->Between(from, to)) {
+        if (!found || m.score > out.score) out = m;
+        found = true;
+    }
+    return found;
+}
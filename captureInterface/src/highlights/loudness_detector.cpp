@@ -0,0 +1,141 @@
+#include "loudness_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+static const float SILENCE_DB = -120.0f;
+
+static float toDb(double energy){
+    if (energy <= 1e-12) return SILENCE_DB;
+    return static_cast<float>(10.0 * std::log10(energy));
+}
+
+void AudioBlockStats(const float* samples, std::size_t n, float& meanSquare, float& peak){
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+    __m128 max0 = _mm_setzero_ps(), max1 = _mm_setzero_ps();
+
+    // two accumulators of each kind hide the add latency
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_loadu_ps(samples + i);
+        __m128 b = _mm_loadu_ps(samples + i + 4);
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(a, a));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(b, b));
+        max0 = _mm_max_ps(max0, _mm_and_ps(a, absMask));
+        max1 = _mm_max_ps(max1, _mm_and_ps(b, absMask));
+    }
+
+    float sums[4], maxes[4];
+    _mm_storeu_ps(sums, _mm_add_ps(sum0, sum1));
+    _mm_storeu_ps(maxes, _mm_max_ps(max0, max1));
+    double sum = double(sums[0]) + sums[1] + sums[2] + sums[3];
+    float max = std::max(std::max(maxes[0], maxes[1]), std::max(maxes[2], maxes[3]));
+
+    for (; i < n; i++) {
+        sum += double(samples[i]) * samples[i];
+        max = std::max(max, std::fabs(samples[i]));
+    }
+
+    meanSquare = n == 0 ? 0.0f : static_cast<float>(sum / n);
+    peak = max;
+}
+
+LoudnessDetector::LoudnessDetector(const LoudnessOptions& options): options(options) {
+    std::size_t blockFrames = std::max<std::size_t>(1, std::size_t(options.sampleRate) * options.blockMs / 1000);
+    this->blockSamples = blockFrames * options.channels;
+    this->pending.reserve(this->blockSamples);
+    this->window.assign(std::max<uint32_t>(1, options.windowMs / options.blockMs), 0.0f);
+    this->baselineAlpha = float(options.blockMs) / std::max(options.blockMs, options.baselineMs);
+}
+
+void LoudnessDetector::Process(const float* samples, std::size_t frames, int64_t time, std::vector<HighlightMarker>& out){
+    const std::size_t n = frames * this->options.channels;
+    auto timeAt = [&](std::size_t sample) {
+        return time + int64_t(sample / this->options.channels) * 1000000 / this->options.sampleRate;
+    };
+    std::size_t i = 0;
+
+    // finish a block started by the previous call
+    if (!this->pending.empty()) {
+        std::size_t take = std::min(n, this->blockSamples - this->pending.size());
+        this->pending.insert(this->pending.end(), samples, samples + take);
+        i = take;
+        if (this->pending.size() < this->blockSamples) return;
+        this->block(this->pending.data(), this->pendingTime, out);
+        this->pending.clear();
+    }
+
+    // whole blocks straight from the caller's buffer
+    for (; i + this->blockSamples <= n; i += this->blockSamples) {
+        this->block(samples + i, timeAt(i), out);
+    }
+
+    if (i < n) {
+        this->pendingTime = timeAt(i);
+        this->pending.insert(this->pending.end(), samples + i, samples + n);
+    }
+}
+
+void LoudnessDetector::block(const float* samples, int64_t time, std::vector<HighlightMarker>& out){
+    float energy, peak;
+    AudioBlockStats(samples, this->blockSamples, energy, peak);
+
+    // the window before this block, for onsets
+    float windowDb = this->windowFilled == 0 ? SILENCE_DB : toDb(this->windowSum / this->windowFilled);
+    float blockDb = toDb(energy);
+
+    this->windowSum += energy - this->window[this->windowPos];
+    this->window[this->windowPos] = energy;
+    this->windowPos = (this->windowPos + 1) % this->window.size();
+    this->windowFilled = std::min(this->windowFilled + 1, this->window.size());
+    // keeps float error from building up in the running sum
+    if (this->windowPos == 0) {
+        this->windowSum = 0.0;
+        for (float e: this->window) this->windowSum += e;
+    }
+    this->shortTermDb = toDb(this->windowSum / this->windowFilled);
+
+    if (this->baselineDb <= SILENCE_DB) this->baselineDb = this->shortTermDb;
+
+    float excess = this->shortTermDb - this->baselineDb;
+    if (!this->loud && excess >= this->options.loudDb) {
+        this->loud = true;
+        this->loudStart = time - int64_t(this->options.windowMs) * 1000;
+        this->loudMaxExcess = excess;
+    } else if (this->loud) {
+        this->loudMaxExcess = std::max(this->loudMaxExcess, excess);
+        // a few dB of hysteresis so a section doesn't flicker on and off
+        bool quiet = excess < this->options.loudDb - 3.0f;
+        bool tooLong = time - this->loudStart >= int64_t(this->options.maxLoudMs) * 1000;
+        if (quiet || tooLong) {
+            this->loud = false;
+            // the baseline was held while loud, it would never catch up
+            if (!quiet) this->baselineDb = this->shortTermDb;
+            out.push_back(HighlightMarker{
+                .time = this->loudStart,
+                .durationMs = static_cast<uint32_t>((time - this->loudStart) / 1000),
+                .kind = MARKER_AUDIO,
+                .score = std::min(1.0f, this->loudMaxExcess / 24.0f),
+            });
+        }
+    }
+
+    // the baseline stops following while a section is loud, so a long loud
+    // section doesn't become the new normal
+    if (!this->loud) this->baselineDb += this->baselineAlpha * (this->shortTermDb - this->baselineDb);
+
+    // the first window's worth of blocks has nothing to compare against
+    float jump = blockDb - windowDb;
+    if (this->windowFilled == this->window.size() && jump >= this->options.onsetDb && toDb(double(peak) * peak) >= this->options.onsetPeakDb &&
+        time >= this->nextOnset) {
+        this->nextOnset = time + int64_t(this->options.refractoryMs) * 1000;
+        out.push_back(HighlightMarker{
+            .time = time,
+            .durationMs = this->options.blockMs,
+            .kind = MARKER_AUDIO,
+            .score = std::min(1.0f, jump / 40.0f),
+        });
+    }
+}
@@ -0,0 +1,118 @@
+#include "motion.h"
+#include "downscale.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+float MeanAbsDiff(const uint8_t* a, const uint8_t* b, std::size_t n){
+    if (n == 0) return 0.0f;
+
+    __m128i acc = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        // two 64 bit lanes of summed absolute differences
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    uint64_t total = lanes[0] + lanes[1];
+    for (; i < n; i++) total += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+
+    return static_cast<float>(double(total) / double(n));
+}
+
+MotionTimeline& MotionTimeline::Instance(){
+    static MotionTimeline inst;
+    return inst; 
+};
+
+MotionTimeline::MotionTimeline(){
+    // 10 minutes at 60 fps
+    this->samples.resize(60 * 60 * 10);
+}
+
+void MotionTimeline::SetCapacity(std::size_t samples){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->samples.assign(std::max<std::size_t>(1, samples), MotionSample{});
+    this->head = 0;
+    this->count = 0;
+}
+
+void MotionTimeline::Add(int64_t time, float score){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->count == 0) this->base = time;
+
+    int64_t ms = std::max<int64_t>(0, (time - this->base) / 1000);
+    MotionSample sample{
+        .timeMs = static_cast<uint32_t>(std::min<int64_t>(ms, UINT32_MAX)),
+        .score = static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, score * 256.0f))),
+    };
+
+    std::size_t capacity = this->samples.size();
+    this->samples[(this->head + this->count) % capacity] = sample;
+    if (this->count < capacity) this->count++;
+    else this->head = (this->head + 1) % capacity;
+}
+
+template <typename F>
+void MotionTimeline::forEach(int64_t from, int64_t to, F f) const {
+    const std::size_t capacity = this->samples.size();
+    auto at = [&](std::size_t i) -> const MotionSample& { return this->samples[(this->head + i) % capacity]; };
+    auto timeOf = [&](const MotionSample& s) { return this->base + int64_t(s.timeMs) * 1000; };
+
+    // samples are in time order, binary search the start
+    std::size_t lo = 0, hi = this->count;
+    while (lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        if (timeOf(at(mid)) < from) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (std::size_t i = lo; i < this->count; i++) {
+        const MotionSample& s = at(i);
+        int64_t t = timeOf(s);
+        if (t >= to) break;
+        f(t, s.score / 256.0f);
+    }
+}
+
+std::vector<MotionTimeline::Point> MotionTimeline::Between(int64_t from, int64_t to) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<Point> result;
+    this->forEach(from, to, [&](int64_t t, float score) { result.push_back(Point{ .time = t, .score = score }); });
+    return result;
+}
+
+bool MotionTimeline::Stats(int64_t from, int64_t to, float& mean, float& peak) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    double sum = 0.0;
+    std::size_t n = 0;
+    peak = 0.0f;
+    this->forEach(from, to, [&](int64_t, float score) {
+        sum += score;
+        peak = std::max(peak, score);
+        n++;
+    });
+    mean = n == 0 ? 0.0f : static_cast<float>(sum / n);
+    return n > 0;
+}
+
+float MotionAnalyser::Process(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride, int64_t time){
+    uint32_t factor = DownscaleFactor(width, height, MAX_WIDTH, MAX_HEIGHT);
+    std::size_t planeSize = std::size_t(width / factor) * (height / factor);
+    bool sameSize = width == this->width && height == this->height;
+    this->current.resize(planeSize);
+    DownscaleLuma(bgra, width, height, stride, factor, this->current.data(), this->scratch);
+
+    float score = sameSize ? MeanAbsDiff(this->previous.data(), this->current.data(), planeSize) : 0.0f;
+    std::swap(this->previous, this->current);
+    this->width = width;
+    this->height = height;
+
+    MOTION.Add(time, score);
+    if (this->listener) this->listener(time, score);
+    return score;
+}
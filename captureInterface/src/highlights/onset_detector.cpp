@@ -0,0 +1,110 @@
+#include "onset_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+static const double PI = 3.14159265358979323846;
+// log compression, makes quiet and loud bins count more alike
+static const float COMPRESSION = 100.0f;
+
+OnsetDetector::OnsetDetector(const OnsetOptions& options): options(options), fft(options.frameSize) {
+    const std::size_t n = options.frameSize;
+    this->hann.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        this->hann[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * double(i) / double(n)));
+    }
+
+    this->frame.resize(n);
+    this->magnitudes.resize(this->fft.Bins());
+    this->previous.resize(this->fft.Bins());
+    this->mono.reserve(n * 2);
+
+    std::size_t hopsPerSecond = std::max<std::size_t>(1, options.sampleRate / options.hopSize);
+    this->historySize = std::max<std::size_t>(3, hopsPerSecond * options.medianMs / 1000);
+}
+
+void OnsetDetector::Process(const float* samples, std::size_t frames, int64_t time, std::vector<HighlightMarker>& out){
+    const uint32_t channels = this->options.channels;
+    const std::size_t frameSize = this->options.frameSize;
+    const std::size_t hop = this->options.hopSize;
+    const uint32_t rate = this->options.sampleRate;
+
+    // audio was skipped or the stream restarted, the samples left over and
+    // the last spectrum don't belong in front of this
+    if (this->expectedTime == INT64_MIN || std::llabs(time - this->expectedTime) > int64_t(hop) * 1000000 / rate) {
+        this->mono.clear();
+        this->hasPrevious = false;
+        this->flux1 = this->flux2 = 0.0f;
+    }
+    this->expectedTime = time + int64_t(frames) * 1000000 / rate;
+
+    // game audio is analysed as one channel
+    const float scale = 1.0f / channels;
+    for (std::size_t f = 0; f < frames; f++) {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < channels; c++) sum += samples[f * channels + c];
+        this->mono.push_back(sum * scale);
+    }
+    // index of this call's first sample, the ones before it are left over
+    const int64_t first = int64_t(this->mono.size()) - int64_t(frames);
+
+    std::size_t consumed = 0;
+    while (this->mono.size() - consumed >= frameSize) {
+        // a frame's time is its centre
+        int64_t frameTime = time + (int64_t(consumed + frameSize / 2) - first) * 1000000 / rate;
+        float flux = this->analyse(this->mono.data() + consumed);
+        consumed += hop;
+
+        if (!this->hasPrevious) {
+            this->hasPrevious = true;
+            continue;
+        }
+
+        // flux1 is a peak if it beats both neighbours and the recent median
+        float threshold = std::max(this->options.minFlux, this->options.threshold * this->median());
+        if (this->flux1 > this->flux2 && this->flux1 >= flux && this->flux1 > threshold &&
+            this->time1 >= this->nextOnset) {
+            this->nextOnset = this->time1 + int64_t(this->options.refractoryMs) * 1000;
+            out.push_back(HighlightMarker{
+                .time = this->time1,
+                .durationMs = this->options.frameSize * 1000 / this->options.sampleRate,
+                .kind = MARKER_AUDIO,
+                // approaches 1 as the peak gets far over the threshold
+                .score = this->flux1 / (this->flux1 + threshold * 4.0f),
+            });
+        }
+
+        this->history.push_back(flux);
+        if (this->history.size() > this->historySize) this->history.pop_front();
+        this->flux2 = this->flux1;
+        this->flux1 = flux;
+        this->time1 = frameTime;
+    }
+
+    this->mono.erase(this->mono.begin(), this->mono.begin() + consumed);
+}
+
+float OnsetDetector::analyse(const float* samples){
+    const std::size_t n = this->options.frameSize;
+    for (std::size_t i = 0; i < n; i++) this->frame[i] = samples[i] * this->hann[i];
+    this->fft.Magnitudes(this->frame.data(), this->magnitudes.data());
+
+    // magnitudes normalised so a full scale sine peaks around 1
+    const float norm = 4.0f / n;
+    float flux = 0.0f;
+    for (std::size_t k = 0; k < this->magnitudes.size(); k++) {
+        float m = std::log1p(COMPRESSION * this->magnitudes[k] * norm);
+        flux += std::max(0.0f, m - this->previous[k]);
+        this->previous[k] = m;
+    }
+    return flux / this->magnitudes.size();
+}
+
+float OnsetDetector::median(){
+    if (this->history.empty()) return 0.0f;
+    this->sorted.assign(this->history.begin(), this->history.end());
+    auto mid = this->sorted.begin() + this->sorted.size() / 2;
+    std::nth_element(this->sorted.begin(), mid, this->sorted.end());
+    return *mid;
+}
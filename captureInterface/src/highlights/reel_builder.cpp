@@ -0,0 +1,145 @@
+#include "reel_builder.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <windows.h>
+
+static std::string seconds(int64_t micros){
+    return std::format("{:.6f}", double(micros) / 1000000.0);
+}
+
+// quoted for a windows command line, paths can't contain quotes
+static std::string quote(const std::string& s){
+    return "\"" + s + "\"";
+}
+
+// quoted for an ffmpeg concat list
+static std::string concatQuote(const std::string& s){
+    std::string res = "'";
+    for (char c: s) {
+        if (c == '\'') res += "'\\''";
+        else res += c;
+    }
+    return res + "'";
+}
+
+bool ReelBuilder::run(const std::string& arguments) const {
+    std::string commandLine = quote(this->options.ffmpeg) + " -hide_banner -loglevel error -nostdin -y " + arguments;
+
+    STARTUPINFOA si = { .cb = sizeof(STARTUPINFOA) };
+    PROCESS_INFORMATION pi;
+    if (!CreateProcessA(NULL, commandLine.data(), NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
+        SLOG.error("reel: unable to start {}, error: {}", this->options.ffmpeg, GetLastError());
+        return false;
+    }
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    DWORD code = 1;
+    GetExitCodeProcess(pi.hProcess, &code);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+
+    if (code != 0) SLOG.error("reel: ffmpeg exited with {}: {}", code, arguments);
+    return code == 0;
+}
+
+bool ReelBuilder::parameterSets(const std::string& video, const std::string& scratch, H264ParameterSets& sets) const {
+    // the bitstream filter puts the parameter sets in front of the first keyframe
+    if (!this->run("-i " + quote(video) + " -map 0:v:0 -c copy -bsf:v h264_mp4toannexb -frames:v 1 -f h264 " + quote(scratch))) return false;
+
+    std::ifstream in(scratch, std::ios::binary);
+    std::string annexB((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::error_code ec;
+    std::filesystem::remove(scratch, ec);
+
+    sets = FindParameterSets(annexB);
+    return !sets.sps.empty() && !sets.pps.empty();
+}
+
+bool ReelBuilder::encodeHead(const ReelSegment& segment, const std::string& head, const std::string& scratch) const {
+    const Source* source = this->source(segment.path);
+    std::string args = "-ss " + seconds(segment.start) + " -i " + quote(segment.path) + " -t " + seconds(segment.copyFrom - segment.start) +
+        " -map 0:v:0 -map 0:a:0? -c:v libx264 -preset veryfast -crf 18 -pix_fmt yuv420p -c:a aac -b:a 192k";
+    if (source != nullptr && source->fps > 0) args += " -r " + std::to_string(source->fps);
+    if (!this->run(args + " " + quote(head))) return false;
+
+    // the output takes the parameter sets of its first part, a head encoded
+    // with other ones would be decoded with the clip's and come out garbled
+    H264ParameterSets clip, encoded;
+    if (!this->parameterSets(segment.path, scratch, clip) || !this->parameterSets(head, scratch, encoded)) return false;
+    return clip.sps == encoded.sps && clip.pps == encoded.pps;
+}
+
+bool ReelBuilder::Build(const std::vector<ReelSegment>& segments, const std::string& output) const {
+    if (segments.empty()) {
+        SLOG.info("reel: no highlight markers to build {} from", output);
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::path parts = std::filesystem::absolute(output + ".parts");
+    std::filesystem::create_directories(parts, ec);
+    if (std::filesystem::path(output).has_parent_path()) {
+        std::filesystem::create_directories(std::filesystem::path(output).parent_path(), ec);
+    }
+
+    // precise heads are re-encoded first, a head that can't be mixed with
+    // the clip falls back to the keyframe before
+    struct Part {
+        ReelSegment segment;
+        std::string head;
+    };
+    std::vector<Part> cuts;
+    for (std::size_t i = 0; i < segments.size(); i++) {
+        ReelSegment s = segments[i];
+        std::string head;
+        if (s.copyFrom > s.start) {
+            head = (parts / std::format("head{}.mp4", i)).string();
+            if (!this->encodeHead(s, head, (parts / "probe.h264").string())) {
+                SLOG.info("reel: re-encoded head of {} doesn't match the clip, cutting at the keyframe before", s.path);
+                head.clear();
+                s.start = s.keyframe;
+                s.copyFrom = s.keyframe;
+            }
+        }
+
+        // the keyframe before can reach back into the part before
+        if (!cuts.empty() && cuts.back().segment.path == s.path && s.start <= cuts.back().segment.end) {
+            cuts.back().segment.end = std::max(cuts.back().segment.end, s.end);
+            continue;
+        }
+        cuts.push_back(Part{ .segment = std::move(s), .head = std::move(head) });
+    }
+
+    // copied parts are read from the clips through inpoint/outpoint, only
+    // re-encoded heads are written out first
+    std::string list = "ffconcat version 1.0\n";
+    for (const Part& part: cuts) {
+        const ReelSegment& s = part.segment;
+        if (!part.head.empty()) list += "file " + concatQuote(part.head) + "\n";
+        if (s.copyFrom < s.end) {
+            list += "file " + concatQuote(s.path) + "\n";
+            list += "inpoint " + seconds(s.copyFrom) + "\n";
+            list += "outpoint " + seconds(s.end) + "\n";
+        }
+    }
+
+    std::string listFile = (parts / "segments.txt").string();
+    bool ok;
+    {
+        std::ofstream out(listFile, std::ios::trunc);
+        out << list;
+        ok = static_cast<bool>(out);
+    }
+    // the concat demuxer converts every part to annex b with its own
+    // parameter sets, which only works out when they are the same
+    ok = ok && this->run("-f concat -safe 0 -i " + quote(listFile) + " -map 0 -c copy -movflags +faststart " + quote(output));
+
+    std::filesystem::remove_all(parts, ec);
+    if (ok) SLOG.info("reel: wrote {} moments to {}", segments.size(), output);
+    return ok;
+}
@@ -0,0 +1,132 @@
+#include "reel_builder.h"
+#include "clip_sidecar.h"
+
+#include <algorithm>
+#include <filesystem>
+
+bool ReelBuilder::AddClip(const std::string& videoPath){
+    ClipSidecar sidecar;
+    if (!sidecar.Open(ClipSidecar::PathFor(videoPath))) return false;
+
+    const ClipSidecarHeader& h = sidecar.Header();
+    Source source{
+        .path = std::filesystem::absolute(videoPath).string(),
+        .timestamp = h.timestamp,
+        .duration = int64_t(h.durationMs) * 1000,
+        .fps = h.fps,
+        .keyframes = {},
+    };
+    for (const ClipSidecarKeyframe& k: sidecar.Keyframes()) source.keyframes.push_back(k.time);
+
+    uint32_t index = static_cast<uint32_t>(this->sources.size());
+    std::vector<Moment> windows;
+    for (const ClipSidecarMarker& m: sidecar.Markers()) {
+        int64_t start = std::max<int64_t>(0, m.time - this->options.leadMicros);
+        int64_t end = std::min(source.duration, m.time + int64_t(m.durationMs) * 1000 + this->options.tailMicros);
+        if (end > start) windows.push_back(Moment{ .source = index, .start = start, .end = end, .score = m.score });
+    }
+
+    // markers are sorted by time but windows of different lengths aren't
+    std::sort(windows.begin(), windows.end(), [](const Moment& a, const Moment& b) { return a.start < b.start; });
+    for (const Moment& w: windows) {
+        if (!this->moments.empty() && this->moments.back().source == index && w.start <= this->moments.back().end) {
+            Moment& last = this->moments.back();
+            last.end = std::max(last.end, w.end);
+            last.score = std::max(last.score, w.score);
+        } else {
+            this->moments.push_back(w);
+        }
+    }
+
+    this->sources.push_back(std::move(source));
+    return true;
+}
+
+std::vector<ReelSegment> ReelBuilder::Plan() const {
+    std::vector<Moment> best = this->moments;
+    std::size_t count = std::min(this->options.count, best.size());
+    std::partial_sort(best.begin(), best.begin() + count, best.end(),
+        [](const Moment& a, const Moment& b) { return a.score > b.score; });
+    best.resize(count);
+
+    // the reel plays the moments in the order they happened
+    std::sort(best.begin(), best.end(), [this](const Moment& a, const Moment& b) {
+        const Source& sa = this->sources[a.source];
+        const Source& sb = this->sources[b.source];
+        if (sa.timestamp != sb.timestamp) return sa.timestamp < sb.timestamp;
+        if (a.source != b.source) return a.source < b.source;
+        return a.start < b.start;
+    });
+
+    std::vector<ReelSegment> segments;
+    for (const Moment& m: best) {
+        const std::vector<int64_t>& keyframes = this->sources[m.source].keyframes;
+
+        // last keyframe at or before the start and the first one after it.
+        // without keyframes ffmpeg is left to find them.
+        int64_t before = m.start, next = m.start;
+        auto after = std::upper_bound(keyframes.begin(), keyframes.end(), m.start);
+        if (!keyframes.empty()) {
+            before = after == keyframes.begin() ? 0 : *(after - 1);
+            next = before == m.start ? m.start : after == keyframes.end() ? m.end : std::min(*after, m.end);
+        }
+
+        ReelSegment segment{ .path = this->sources[m.source].path, .start = m.start, .end = m.end,
+            .copyFrom = m.start, .keyframe = before, .score = m.score };
+        if (this->options.precise) {
+            segment.copyFrom = next;
+        } else {
+            // widen to the keyframe, stream copy can only start there
+            segment.start = before;
+            segment.copyFrom = before;
+        }
+        segments.push_back(std::move(segment));
+    }
+
+    // snapping can make neighbours of the same clip overlap
+    merge(segments);
+    return segments;
+}
+
+void ReelBuilder::merge(std::vector<ReelSegment>& segments){
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < segments.size(); i++) {
+        if (kept > 0 && segments[kept - 1].path == segments[i].path && segments[i].start <= segments[kept - 1].end) {
+            ReelSegment& last = segments[kept - 1];
+            last.end = std::max(last.end, segments[i].end);
+            last.score = std::max(last.score, segments[i].score);
+            continue;
+        }
+        if (kept != i) segments[kept] = std::move(segments[i]);
+        kept++;
+    }
+    segments.resize(kept);
+}
+
+const ReelBuilder::Source* ReelBuilder::source(const std::string& path) const {
+    for (const Source& s: this->sources) {
+        if (s.path == path) return &s;
+    }
+    return nullptr;
+}
+
+// NAL units are preceded by 00 00 01 or 00 00 00 01
+H264ParameterSets FindParameterSets(std::string_view annexB){
+    H264ParameterSets sets;
+    std::size_t pos = annexB.find(std::string_view("\0\0\1", 3));
+    while (pos != std::string_view::npos && (sets.sps.empty() || sets.pps.empty())) {
+        std::size_t begin = pos + 3;
+        std::size_t next = annexB.find(std::string_view("\0\0\1", 3), begin);
+        std::size_t end = next == std::string_view::npos ? annexB.size() : next;
+        // the zero of a four byte start code belongs to the next one
+        if (next != std::string_view::npos && end > begin && annexB[end - 1] == '\0') end--;
+
+        if (end > begin) {
+            int type = annexB[begin] & 0x1f;
+            if (type == 7 && sets.sps.empty()) sets.sps = std::string(annexB.substr(begin, end - begin));
+            if (type == 8 && sets.pps.empty()) sets.pps = std::string(annexB.substr(begin, end - begin));
+        }
+        pos = next;
+    }
+    return sets;
+}
@@ -0,0 +1,370 @@
+#include "template_matcher.h"
+#include "event_loop.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+// coarse spots down to this fraction of the threshold are still refined,
+// downscaling blurs fine detail and lowers the best coarse score a lot when
+// the template isn't aligned to the 4 pixel grid
+static const float COARSE_FLOOR = 0.5f;
+static const int COARSE_CANDIDATES = 4;
+static const int SCALE = 4;
+
+void LumaImage::Resize(uint32_t width, uint32_t height){
+    this->width = width;
+    this->height = height;
+    this->stride = width + 16;
+    this->pixels.assign(std::size_t(this->stride) * height, 0);
+}
+
+void NccTemplate::Build(const LumaImage& image){
+    this->width = image.width;
+    this->height = image.height;
+    this->stride = (image.width + 7) & ~7u;
+    this->centred.assign(std::size_t(this->stride) * this->height, 0);
+
+    const double n = double(this->width) * this->height;
+    double total = 0.0;
+    for (uint32_t y = 0; y < this->height; y++) {
+        for (uint32_t x = 0; x < this->width; x++) total += image.Row(y)[x];
+    }
+    int mean = static_cast<int>(std::lround(total / n));
+
+    this->sum = 0;
+    int64_t squares = 0;
+    for (uint32_t y = 0; y < this->height; y++) {
+        for (uint32_t x = 0; x < this->width; x++) {
+            int16_t v = static_cast<int16_t>(image.Row(y)[x] - mean);
+            this->centred[std::size_t(y) * this->stride + x] = v;
+            this->sum += v;
+            squares += int64_t(v) * v;
+        }
+    }
+    this->norm = std::sqrt(std::max(0.0, double(squares) - double(this->sum) * double(this->sum) / n));
+}
+
+// box filter by SCALE in both directions
+static void downscale(const LumaImage& in, LumaImage& out){
+    out.Resize(in.width / SCALE, in.height / SCALE);
+    for (uint32_t y = 0; y < out.height; y++) {
+        for (uint32_t x = 0; x < out.width; x++) {
+            uint32_t sum = 0;
+            for (int dy = 0; dy < SCALE; dy++) {
+                const uint8_t* row = in.Row(y * SCALE + dy) + x * SCALE;
+                for (int dx = 0; dx < SCALE; dx++) sum += row[dx];
+            }
+            out.Row(y)[x] = static_cast<uint8_t>(sum / (SCALE * SCALE));
+        }
+    }
+}
+
+// summed area tables of the pixels and their squares
+struct Integral {
+    uint32_t width;
+    std::vector<uint32_t> sum;
+    std::vector<uint64_t> squares;
+
+    void Build(const LumaImage& image){
+        this->width = image.width + 1;
+        this->sum.assign(std::size_t(this->width) * (image.height + 1), 0);
+        this->squares.assign(this->sum.size(), 0);
+        for (uint32_t y = 0; y < image.height; y++) {
+            uint32_t rowSum = 0;
+            uint64_t rowSquares = 0;
+            for (uint32_t x = 0; x < image.width; x++) {
+                uint32_t v = image.Row(y)[x];
+                rowSum += v;
+                rowSquares += v * v;
+                std::size_t i = std::size_t(y + 1) * this->width + x + 1;
+                this->sum[i] = this->sum[i - this->width] + rowSum;
+                this->squares[i] = this->squares[i - this->width] + rowSquares;
+            }
+        }
+    }
+
+    template <typename T>
+    static T box(const std::vector<T>& table, uint32_t width, uint32_t x, uint32_t y, uint32_t w, uint32_t h){
+        std::size_t top = std::size_t(y) * width, bottom = std::size_t(y + h) * width;
+        return table[bottom + x + w] - table[bottom + x] - table[top + x + w] + table[top + x];
+    }
+};
+
+// sum of image * template over the window at (x, y), 8 pixels per step.
+// rows are summed in 32 bits and added up in 64.
+static int64_t dot(const LumaImage& image, const NccTemplate& tmpl, uint32_t x, uint32_t y){
+    const __m128i zero = _mm_setzero_si128();
+    int64_t total = 0;
+
+    for (uint32_t ty = 0; ty < tmpl.height; ty++) {
+        const uint8_t* row = image.Row(y + ty) + x;
+        const int16_t* t = tmpl.centred.data() + std::size_t(ty) * tmpl.stride;
+        __m128i acc = zero;
+        for (uint32_t tx = 0; tx < tmpl.stride; tx += 8) {
+            // padding past the template width is zero, so reading past the
+            // window doesn't change the sum
+            __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + tx)), zero);
+            __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + tx));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(pixels, weights));
+        }
+        int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        total += int64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+    return total;
+}
+
+static float ncc(const LumaImage& image, const Integral& ii, const NccTemplate& tmpl, uint32_t x, uint32_t y){
+    if (tmpl.norm <= 0.0) return 0.0f;
+    const double n = double(tmpl.width) * tmpl.height;
+    double s = Integral::box(ii.sum, ii.width, x, y, tmpl.width, tmpl.height);
+    double q = double(Integral::box(ii.squares, ii.width, x, y, tmpl.width, tmpl.height));
+
+    double variance = q - s * s / n;
+    // flat windows can't match anything
+    if (variance < 1.0) return 0.0f;
+
+    double numerator = double(dot(image, tmpl, x, y)) - s * double(tmpl.sum) / n;
+    return static_cast<float>(numerator / (std::sqrt(variance) * tmpl.norm));
+}
+
+MatchResult MatchTemplate(const LumaImage& image, const NccTemplate& tmpl, const NccTemplate& coarse, float threshold){
+    MatchResult best{ .x = 0, .y = 0, .score = -1.0f };
+    if (tmpl.width == 0 || tmpl.width > image.width || tmpl.height > image.height) return best;
+
+    Integral ii;
+    ii.Build(image);
+
+    auto refine = [&](uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+        x1 = std::min(x1, image.width - tmpl.width);
+        y1 = std::min(y1, image.height - tmpl.height);
+        for (uint32_t y = y0; y <= y1; y++) {
+            for (uint32_t x = x0; x <= x1; x++) {
+                float score = ncc(image, ii, tmpl, x, y);
+                if (score > best.score) best = MatchResult{ .x = x, .y = y, .score = score };
+            }
+        }
+    };
+
+    // small templates don't survive downscaling, search them directly
+    if (coarse.width < 4 || coarse.height < 4) {
+        refine(0, 0, image.width - tmpl.width, image.height - tmpl.height);
+        return best;
+    }
+
+    LumaImage small;
+    downscale(image, small);
+    if (coarse.width > small.width || coarse.height > small.height) return best;
+
+    Integral smallIi;
+    smallIi.Build(small);
+
+    // best few coarse spots, kept sorted by score
+    MatchResult candidates[COARSE_CANDIDATES];
+    int found = 0;
+    for (uint32_t y = 0; y + coarse.height <= small.height; y++) {
+        for (uint32_t x = 0; x + coarse.width <= small.width; x++) {
+            float score = ncc(small, smallIi, coarse, x, y);
+            if (score < threshold * COARSE_FLOOR) continue;
+            if (found == COARSE_CANDIDATES && score <= candidates[found - 1].score) continue;
+
+            int i = found < COARSE_CANDIDATES ? found++ : found - 1;
+            while (i > 0 && candidates[i - 1].score < score) {
+                candidates[i] = candidates[i - 1];
+                i--;
+            }
+            candidates[i] = MatchResult{ .x = x, .y = y, .score = score };
+        }
+    }
+
+    // each coarse pixel covers SCALE full ones, search a little around it
+    for (int i = 0; i < found; i++) {
+        uint32_t cx = candidates[i].x * SCALE, cy = candidates[i].y * SCALE;
+        refine(cx > SCALE ? cx - SCALE : 0, cy > SCALE ? cy - SCALE : 0, cx + SCALE, cy + SCALE);
+    }
+    return best;
+}
+
+// binary PGM (P5) with 8 bit samples
+static bool loadPgm(const std::string& filename, LumaImage& out){
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::string magic;
+    uint32_t values[3];
+    file >> magic;
+    if (magic != "P5") return false;
+    for (uint32_t& v: values) {
+        // skip comments between header fields
+        while (file >> std::ws && file.peek() == '#') file.ignore(4096, '\n');
+        if (!(file >> v)) return false;
+    }
+    file.get();
+
+    if (values[0] == 0 || values[1] == 0 || values[2] > 255 || values[0] > 4096 || values[1] > 4096) return false;
+    out.Resize(values[0], values[1]);
+    for (uint32_t y = 0; y < out.height; y++) {
+        if (!file.read(reinterpret_cast<char*>(out.Row(y)), out.width)) return false;
+    }
+    return true;
+}
+
+TemplateMatcher& TemplateMatcher::Instance(){
+    static TemplateMatcher inst;
+    return inst;
+};
+
+TemplateMatcher::~TemplateMatcher(){
+    this->Stop();
+}
+
+bool TemplateMatcher::Load(const std::string& filename){
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        SLOG.error("templates: unable to open {}", filename);
+        return false;
+    }
+
+    // template images are relative to the list
+    std::filesystem::path dir = std::filesystem::path(filename).parent_path();
+    std::vector<Entry> loaded;
+    std::string line;
+    int lineNo = 0;
+
+    while (std::getline(file, line)) {
+        lineNo++;
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        std::istringstream fields(line);
+        Entry entry;
+        std::string image;
+        if (!(fields >> entry.name >> entry.threshold >> entry.x >> entry.y >> entry.w >> entry.h >> image) ||
+            entry.x < 0.0f || entry.y < 0.0f || entry.w <= 0.0f || entry.h <= 0.0f ||
+            entry.x + entry.w > 1.0f || entry.y + entry.h > 1.0f) {
+            SLOG.error("templates: {}:{} invalid template line", filename, lineNo);
+            continue;
+        }
+
+        LumaImage pixels;
+        if (!loadPgm((dir / image).string(), pixels)) {
+            SLOG.error("templates: {}:{} unable to load {}", filename, lineNo, image);
+            continue;
+        }
+
+        LumaImage small;
+        downscale(pixels, small);
+        entry.full.Build(pixels);
+        entry.coarse.Build(small);
+        loaded.push_back(std::move(entry));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        // the worker reads the entries while matching
+        this->cv.wait(lock, [this]{ return !this->busy; });
+        this->entries = std::move(loaded);
+        this->regions.assign(this->entries.size(), LumaImage());
+        this->lastSeen.assign(this->entries.size(), INT64_MIN / 2);
+        this->pending = false;
+        this->stop = false;
+    }
+    if (!this->worker.joinable()) this->worker = std::thread(&TemplateMatcher::work, this);
+
+    SLOG.info("templates: loaded {} templates from {}", this->entries.size(), filename);
+    return true;
+}
+
+void TemplateMatcher::SetInterval(uint32_t frames){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->interval = std::max<uint32_t>(1, frames);
+}
+
+void TemplateMatcher::Stop(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->cv.notify_all();
+    if (this->worker.joinable()) this->worker.join();
+}
+
+std::string TemplateMatcher::Name(int index) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (index < 0 || index >= static_cast<int>(this->entries.size())) return {};
+    return this->entries[index].name;
+}
+
+void TemplateMatcher::Submit(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t stride, int64_t time){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->entries.empty() || ++this->frameCount % this->interval != 0) return;
+        // still matching an earlier frame, skip this one
+        if (this->busy || this->pending) return;
+        // keeps Load from swapping the entries while the regions are cut
+        this->busy = true;
+    }
+
+    // the worker is idle, so the region buffers are free to fill
+    for (std::size_t i = 0; i < this->entries.size(); i++) {
+        const Entry& e = this->entries[i];
+        uint32_t x0 = static_cast<uint32_t>(e.x * width), y0 = static_cast<uint32_t>(e.y * height);
+        uint32_t w = std::min(width - x0, static_cast<uint32_t>(e.w * width));
+        uint32_t h = std::min(height - y0, static_cast<uint32_t>(e.h * height));
+
+        LumaImage& region = this->regions[i];
+        region.Resize(w, h);
+        for (uint32_t y = 0; y < h; y++) {
+            const uint8_t* src = bgra + std::size_t(y0 + y) * stride + std::size_t(x0) * 4;
+            uint8_t* dst = region.Row(y);
+            for (uint32_t x = 0; x < w; x++) {
+                dst[x] = static_cast<uint8_t>((src[4 * x + 2] * 77 + src[4 * x + 1] * 150 + src[4 * x] * 29) >> 8);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->jobTime = time;
+        this->pending = true;
+    }
+    this->cv.notify_all();
+}
+
+void TemplateMatcher::work(){
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (true) {
+        this->cv.wait(lock, [this]{ return this->pending || this->stop; });
+        if (this->stop) break;
+        this->pending = false;
+        this->busy = true;
+        int64_t time = this->jobTime;
+        lock.unlock();
+
+        for (std::size_t i = 0; i < this->entries.size(); i++) {
+            const Entry& e = this->entries[i];
+            MatchResult match = MatchTemplate(this->regions[i], e.full, e.coarse, e.threshold);
+            if (match.score < e.threshold) continue;
+
+            // an icon stays on screen for a while, report it when it appears
+            bool appeared = time - this->lastSeen[i] > REARM_MICROS;
+            this->lastSeen[i] = time;
+            if (!appeared) continue;
+
+            EventData data;
+            data.templateMatchData = TemplateMatchData{ .index = static_cast<int>(i), .score = match.score, .time = time };
+            Event ev(EventType::TEMPLATE_MATCH, data);
+            EventLoop::Instance()->AddEvent(ev);
+        }
+
+        lock.lock();
+        this->busy = false;
+        this->cv.notify_all();
+    }
+}
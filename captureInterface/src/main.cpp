@@ -2,10 +2,20 @@
 #include <minwindef.h>
 #include <sysinfoapi.h>
 #include <thread>
+#include "app_config.h"
+#include "clip_library.h"
 #include "event_loop.h"
+#include "frame_ring.h"
+#include "game_db.h"
+#include "game_rules.h"
+#include "ipc_api.h"
+#include "ipc_server.h"
 #include "logger.h"
+#include "plugin_host.h"
+#include "preview.h"
 #include "task_handler.h"
 #include "tasks.h"
+#include "template_matcher.h"
 #include "capturer.h"
 
 
@@ -38,6 +48,21 @@ int main() {
 
     CheckWinVer();
 
+    CONFIG.Load("config.ini");
+    SLOG.compress(CONFIG.Current()->logCompress);
+    GAMERULES.Load("game_rules.txt");
+    GAMEDB.Open("games.db");
+    CLIPLIB.Open("clips.log");
+    TEMPLATES.Load("templates.txt");
+    PLUGINS.Load(CONFIG.Current()->pluginDirectory);
+    if (CONFIG.Current()->frameRing) FRAMES.Open(CONFIG.Current()->frameRingFile);
+    if (CONFIG.Current()->preview) PREVIEW.Open(CONFIG.Current()->previewFile);
+    if (CONFIG.Current()->ipc) {
+        const std::string& ipcName = CONFIG.Current()->ipcName;
+        IPCSERVER.SetHandler(IpcApi::Handle);
+        IPCSERVER.Start(ipcName.empty() ? IPC_DEFAULT_NAME : ipcName);
+    }
+
     /*bool capturerStatus = CAPTURER.Init();*/
     /*if (capturerStatus) {*/
     /*    SLOG.error("capture is not supported on this device!");*/
@@ -57,14 +82,23 @@ int main() {
     // create initial tasks
     std::unique_ptr<Task> poll_hotkeys_task = std::make_unique<Tasks::PollHotkeys>();
     std::unique_ptr<Task> poll_fgwin_task = std::make_unique<Tasks::PollFGWin>();
+    std::unique_ptr<Task> watch_winevents_task = std::make_unique<Tasks::WatchWinEvents>();
+    std::unique_ptr<Task> watch_processes_task = std::make_unique<Tasks::WatchProcesses>();
+    std::unique_ptr<Task> watch_config_task = std::make_unique<Tasks::WatchConfig>();
+    std::unique_ptr<Task> detect_highlights_task = std::make_unique<Tasks::DetectHighlights>();
 
     // add tasks to task handler
     taskHandlerInst->AddTask(std::move(poll_hotkeys_task));
     taskHandlerInst->AddTask(std::move(poll_fgwin_task));
+    taskHandlerInst->AddTask(std::move(watch_winevents_task));
+    taskHandlerInst->AddTask(std::move(watch_processes_task));
+    taskHandlerInst->AddTask(std::move(watch_config_task));
+    taskHandlerInst->AddTask(std::move(detect_highlights_task));
 
     event_thread.join();
     task_thread.join();
 
+    SLOG.flushSuppressed();
     SLOG.info("exiting program");
     return 0;
 }
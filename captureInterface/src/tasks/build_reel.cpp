@@ -0,0 +1,64 @@
+#include "clip_library.h"
+#include "logger.h"
+#include "reel_builder.h"
+#include "tasks.h"
+#include <ctime>
+#include <filesystem>
+#include <format>
+#include <mutex>
+
+// clips the reel picks its moments from, newest first
+static const std::size_t REEL_CLIPS = 20;
+
+static ReelOptions configuredOptions(){
+    const AppConfig* config = CONFIG.Current();
+    return ReelOptions{
+        .count = static_cast<std::size_t>(config->reelCount),
+        .precise = config->reelPrecise,
+        .ffmpeg = config->ffmpegPath,
+    };
+}
+
+// reel_<time>.mp4, with a suffix for the second and later reel of the same
+// second. a build only writes its file when it finishes, so names handed out
+// moments ago are remembered rather than looked for on disk.
+static std::string newReelPath(){
+    static std::mutex mutex;
+    static std::time_t lastTime = 0;
+    static int lastCount = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::time_t now = std::time(nullptr);
+    int n = now == lastTime ? lastCount + 1 : 1;
+    auto path = [now](int n) {
+        return n == 1 ? std::format("reels/reel_{}.mp4", now) : std::format("reels/reel_{}_{}.mp4", now, n);
+    };
+    // reels left by an earlier run
+    while (std::filesystem::exists(path(n))) n++;
+
+    lastTime = now;
+    lastCount = n;
+    return path(n);
+}
+
+Tasks::BuildReel::BuildReel(): BuildReel(configuredOptions(), newReelPath()) {}
+
+Tasks::BuildReel::BuildReel(ReelOptions options, std::string output): options(std::move(options)), output(std::move(output)) { 
+    this->SetName("BuildReel"); 
+}
+
+void Tasks::BuildReel::Execute(){
+    this->SetRunning(true);
+
+    ReelBuilder builder(this->options);
+    std::size_t clips = 0;
+    for (const ClipRecord& clip: CLIPLIB.List(ClipFilter{ .limit = REEL_CLIPS })) {
+        if (builder.AddClip(clip.path)) clips++;
+    }
+
+    std::vector<ReelSegment> segments = builder.Plan();
+    SLOG.info("reel: {} moments from {} clips", segments.size(), clips);
+    builder.Build(segments, this->output);
+
+    this->SetRunning(false);
+}
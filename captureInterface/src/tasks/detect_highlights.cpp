@@ -0,0 +1,70 @@
+#include "audio_ring.h"
+#include "highlights.h"
+#include "logger.h"
+#include "loudness_detector.h"
+#include "onset_detector.h"
+#include "plugin_host.h"
+#include "tasks.h"
+
+#include <memory>
+#include <vector>
+
+// audio is analysed in chunks of this many milliseconds
+static const uint32_t CHUNK_MS = 50;
+
+Tasks::DetectHighlights::DetectHighlights() { 
+    this->SetName("DetectHighlights"); 
+}
+
+void Tasks::DetectHighlights::Execute(){
+    this->SetRunning(true);
+
+    std::unique_ptr<LoudnessDetector> loudness;
+    std::unique_ptr<OnsetDetector> onsets;
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+    std::vector<float> chunk;
+    std::vector<HighlightMarker> markers;
+    uint64_t generation = 0;
+    uint64_t next = 0;
+
+    while(this->GetRunning()){
+        // the ring is reconfigured when the audio device changes, which
+        // starts the frame positions over even if the format stays the same
+        if (!loudness || AUDIORING.Generation() != generation) {
+            generation = AUDIORING.Generation();
+            sampleRate = AUDIORING.SampleRate();
+            channels = AUDIORING.Channels();
+            loudness = std::make_unique<LoudnessDetector>(LoudnessOptions{ .sampleRate = sampleRate, .channels = channels });
+            onsets = std::make_unique<OnsetDetector>(OnsetOptions{ .sampleRate = sampleRate, .channels = channels });
+            chunk.resize(std::size_t(sampleRate) * CHUNK_MS / 1000 * channels);
+            next = AUDIORING.Written();
+        }
+
+        std::size_t chunkFrames = chunk.size() / channels;
+        // time out so the running flag is checked every now and then
+        if (!AUDIORING.Wait(next + chunkFrames - 1, std::chrono::seconds(1))) continue;
+        if (AUDIORING.Generation() != generation) continue;
+
+        uint64_t start = next;
+        std::size_t frames = AUDIORING.Read(start, chunk.data(), chunkFrames);
+        if (start != next) {
+            static LogRateLimit behindLimit(1, std::chrono::seconds(60));
+            SLOG.error(behindLimit, "highlights: audio analysis fell behind, skipped {} frames", start - next);
+        }
+        next = start + frames;
+
+        markers.clear();
+        int64_t time = AUDIORING.TimeOf(start);
+        loudness->Process(chunk.data(), frames, time, markers);
+        onsets->Process(chunk.data(), frames, time, markers);
+        for (const HighlightMarker& m: markers) {
+            HIGHLIGHTS.Add(m);
+            PLUGINS.Post(PluginEvent{ .type = PLUGIN_ONSET, .time = m.time, .value = m.score });
+            static LogRateLimit markerLimit(5, std::chrono::seconds(10));
+            SLOG.info(markerLimit, "highlights: audio marker at {} score: {:.2f}", m.time, m.score);
+        }
+    }
+
+    this->SetRunning(false);
+}
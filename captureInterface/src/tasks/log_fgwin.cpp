@@ -5,7 +5,6 @@
 #include "utils.h"
 
 #include <string>
-#include <unordered_map>
 #include <windows.h>
 
 Tasks::LogFGWins::LogFGWins() { 
@@ -15,16 +14,19 @@ Tasks::LogFGWins::LogFGWins() {
 void Tasks::LogFGWins::Execute(){
     this->SetRunning(true); 
 
-    std::unordered_map<HWND, std::string> fgWins = Utils::GetFgWins();
+    WindowSnapshot fgWins;
+    Utils::ScanFgWins(fgWins);
     std::string titles = "[";
 
-    for (auto &el: fgWins){
-        titles += "{ " + el.second + " }, ";
+    for (const WindowEntry &el: fgWins.Entries()){
+        titles += "{ ";
+        titles += fgWins.Title(el);
+        titles += " }, ";
     }
 
     titles += "]";
 
-    SLOG.info(titles);
+    SLOG.info("{}", titles);
 
     this->SetRunning(false); 
 }
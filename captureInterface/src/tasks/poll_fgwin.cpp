@@ -1,11 +1,15 @@
 #include "application_data.h"
-#include "event_loop.h"
+#include "capture_profiles.h"
+#include "game_detector.h"
+#include "game_rules.h"
 #include "logger.h"
+#include "process_cache.h"
 #include "tasks.h"
 #include "utils.h"
+#include "window_events.h"
+#include "window_system.h"
 
-#include <thread>
-#include <unordered_map>
+#include <string>
 #include <windows.h>
 
 Tasks::PollFGWin::PollFGWin() { 
@@ -15,32 +19,24 @@ Tasks::PollFGWin::PollFGWin() {
 void Tasks::PollFGWin::Execute(){
     this->SetRunning(true);
 
-    EventLoop* evInst = EventLoop::Instance(); 
+    // polls the window list while WatchWinEvents is missing a hook
+    GameDetector detector(WindowSystem::Native(), PROCCACHE, GAMERULES);
+    std::string path;
 
     while(this->GetRunning()){
-        std::unordered_map<HWND, std::string> fgWins = Utils::GetFgWins();
-
-        // skip processing if current game window hwnd is alive 
-        if (IsWindow(APPDATA.GetCurrentGameWin().first)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            continue;
+        if (!detector.Poll(WINEVENTS)) continue;
+
+        const WindowEntry* win = detector.Target();
+        if (win != nullptr) {
+            SLOG.info("capture target: {} score: {}", detector.TargetTitle(), detector.TargetScore());
+            APPDATA.SetGameWin(win->hwnd, detector.TargetTitle());
+            PROCCACHE.ImagePath(win->pid, path);
+            PROFILES.Activate(Utils::exeName(path));
+        } else {
+            // the game closed, nothing to capture until another one shows up
+            SLOG.info("capture target: none");
+            APPDATA.SetGameWin(NULL, "");
         }
-        
-        // TODO: move into util for checking if hwnd is game
-        for (auto &win: fgWins){
-            std::string filePath = Utils::filepathHWND(win.first);
-            std::size_t found = filePath.find("steamapps");
-
-            if (found != std::string::npos){
-                std::ostringstream oss;
-                oss << "game window detected: " << win.second << " path: " << filePath;
-                SLOG.info(oss.str());
-                APPDATA.SetGameWin(win.first, win.second);
-            }
-
-        }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
 
     this->SetRunning(false);
@@ -1,13 +1,31 @@
+#include "app_config.h"
 #include "event_data.h"
 #include "event_loop.h"
 #include "logger.h"
 #include "tasks.h"
 
-#include <sstream>
-#include <strstream>
 #include <thread>
 #include <windows.h>
 
+static const char* HOTKEY_NAMES[HOTKEY_COUNT] = {
+    "quit", "start capture", "stop capture", "log processes", "build reel"
+};
+
+static void registerHotkeys(const AppConfig* config){
+    for (int id = HOTKEY_QUIT; id <= HOTKEY_COUNT; id++) {
+        const Hotkey& hk = config->GetHotkey(static_cast<HotkeyId>(id));
+        bool status = RegisterHotKey(NULL, id, hk.modifiers, hk.vk); 
+        SLOG.info("registered {} hotkey: modifiers {:#x} key {:#x}: {}", 
+            HOTKEY_NAMES[id - 1], hk.modifiers, hk.vk, status);
+    }
+}
+
+static void unregisterHotkeys(){
+    for (int id = HOTKEY_QUIT; id <= HOTKEY_COUNT; id++) {
+        UnregisterHotKey(NULL, id);
+    }
+}
+
 Tasks::PollHotkeys::PollHotkeys() { 
     this->SetName("PollHotKeys"); 
 }
@@ -15,36 +33,10 @@ Tasks::PollHotkeys::PollHotkeys() {
 void Tasks::PollHotkeys::Execute(){
     this->SetRunning(true);
 
-    // register hotkeys
-    bool status;
-
-    status = RegisterHotKey(NULL, 1, MOD_ALT, 'Q'); 
-    {
-        std::ostringstream oss;
-        oss << "registered quit hotkey: ALT + Q: " << status;
-        SLOG.info(oss.str());
-    }
-
-    status = RegisterHotKey(NULL, 2, MOD_ALT, 'R'); 
-    {
-        std::ostringstream oss;
-        oss << "registered start capture hotkey: ALT + R: " << status;
-        SLOG.info(oss.str());
-    }
-
-    status = RegisterHotKey(NULL, 3, MOD_ALT, 'E'); 
-    {
-        std::ostringstream oss;
-        oss << "registered stop capture hotkey: ALT + E: " << status;
-        SLOG.info(oss.str());
-    }
-
-    status = RegisterHotKey(NULL, 4, MOD_ALT, 'W'); 
-    {
-        std::ostringstream oss;
-        oss << "registered log processes hotkey: ALT + W: " << status;
-        SLOG.info(oss.str());
-    }
+    // hotkeys belong to the thread that registers them, so re-registering
+    // after a config change has to happen here
+    CONFIG.Subscribe(GetCurrentThreadId());
+    registerHotkeys(CONFIG.Current());
 
     EventLoop* evInst = EventLoop::Instance(); 
 
@@ -59,10 +51,15 @@ void Tasks::PollHotkeys::Execute(){
                 };
                 Event e(EventType::HOTKEY, data);
                 evInst->AddEvent(e);
+            } else if (msg.message == WM_CONFIG_CHANGED) {
+                unregisterHotkeys();
+                registerHotkeys(CONFIG.Current());
             }
         } 
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
 
+    unregisterHotkeys();
+
     this->SetRunning(false);
 }
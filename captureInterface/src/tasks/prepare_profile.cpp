@@ -0,0 +1,12 @@
+#include "capture_profiles.h"
+#include "tasks.h"
+
+Tasks::PrepareProfile::PrepareProfile(CaptureProfile profile): profile(std::move(profile)) { 
+    this->SetName("PrepareProfile"); 
+}
+
+void Tasks::PrepareProfile::Execute(){
+    this->SetRunning(true);
+    PROFILES.Build(this->profile);
+    this->SetRunning(false);
+}
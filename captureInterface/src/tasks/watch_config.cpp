@@ -0,0 +1,67 @@
+#include "app_config.h"
+#include "logger.h"
+#include "tasks.h"
+
+#include <thread>
+#include <windows.h>
+
+// editors often write a file in several steps, wait for them to finish
+static const DWORD SETTLE_MS = 200;
+
+static bool lastWriteTime(const std::string& filename, FILETIME& out){
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &data)) return false;
+    out = data.ftLastWriteTime;
+    return true;
+}
+
+Tasks::WatchConfig::WatchConfig() { 
+    this->SetName("WatchConfig"); 
+}
+
+void Tasks::WatchConfig::Execute(){
+    this->SetRunning(true);
+
+    const std::string filename = CONFIG.Filename();
+
+    // watch the directory holding the file, the file itself can be replaced
+    char fullPath[MAX_PATH];
+    char* namePart = NULL;
+    if (GetFullPathNameA(filename.c_str(), MAX_PATH, fullPath, &namePart) == 0 || namePart == NULL) {
+        SLOG.error("config watcher: unable to resolve {}", filename);
+        this->SetRunning(false);
+        return;
+    }
+    std::string dir(fullPath, namePart - fullPath);
+
+    HANDLE change = FindFirstChangeNotificationA(dir.c_str(), FALSE, 
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (change == INVALID_HANDLE_VALUE) {
+        SLOG.error("config watcher: unable to watch {}", dir);
+        this->SetRunning(false);
+        return;
+    }
+
+    FILETIME seen = {};
+    lastWriteTime(filename, seen);
+    SLOG.info("config watcher: watching {}", fullPath);
+
+    while(this->GetRunning()){
+        // time out so the running flag is checked every now and then
+        if (WaitForSingleObject(change, 1000) != WAIT_OBJECT_0) continue;
+
+        Sleep(SETTLE_MS);
+        FindNextChangeNotification(change);
+
+        // something else in the directory changed
+        FILETIME written;
+        if (!lastWriteTime(filename, written) || CompareFileTime(&written, &seen) == 0) continue;
+        seen = written;
+
+        if (CONFIG.Reload()) SLOG.compress(CONFIG.Current()->logCompress);
+    }
+
+    FindCloseChangeNotification(change);
+
+    this->SetRunning(false);
+}
@@ -0,0 +1,43 @@
+#include "event_data.h"
+#include "event_loop.h"
+#include "game_rules.h"
+#include "logger.h"
+#include "process_cache.h"
+#include "process_watcher.h"
+#include "tasks.h"
+
+Tasks::WatchProcesses::WatchProcesses() { 
+    this->SetName("WatchProcesses"); 
+}
+
+void Tasks::WatchProcesses::Execute(){
+    this->SetRunning(true);
+
+    ProcessWatcher& watcher = ProcessWatcher::Native();
+    LaunchDetector detector(PROCCACHE, GAMERULES);
+    bool opened = watcher.Open();
+
+    EventLoop* evInst = EventLoop::Instance(); 
+
+    while(opened && this->GetRunning()){
+        // time out so the running flag is checked every now and then
+        DWORD pid;
+        ProcessWatchResult res = watcher.Next(pid, std::chrono::milliseconds(1000));
+        if (res == PROC_FAILED) break;
+        if (res == PROC_TIMEOUT || !detector.Check(pid)) continue;
+
+        SLOG.info("game launch detected: pid: {} path: {} confidence: {}", 
+            pid, detector.Path(), detector.Match().confidence);
+
+        EventData data; 
+        data.processData = ProcessData {
+            .pid = pid
+        };
+        Event e(EventType::GAME_LAUNCH, data);
+        evInst->AddEvent(e);
+    }
+
+    watcher.Close();
+
+    this->SetRunning(false);
+}
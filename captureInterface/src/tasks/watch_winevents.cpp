@@ -0,0 +1,96 @@
+#include "logger.h"
+#include "tasks.h"
+#include "window_events.h"
+
+#include <thread>
+#include <windows.h>
+
+static void CALLBACK WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, 
+        LONG idObject, LONG idChild, DWORD eventThread, DWORD eventTime) {
+    // only care about whole windows, not the objects inside them
+    if (hwnd == NULL || idObject != OBJID_WINDOW || idChild != CHILDID_SELF) {
+        return;
+    }
+
+    switch (event) {
+        case EVENT_SYSTEM_FOREGROUND:
+            WINEVENTS.Push(WIN_FOREGROUND, hwnd);
+            break;
+        case EVENT_OBJECT_SHOW:
+            if (GetAncestor(hwnd, GA_ROOT) == hwnd) WINEVENTS.Push(WIN_SHOWN, hwnd);
+            break;
+        case EVENT_OBJECT_NAMECHANGE:
+            if (GetAncestor(hwnd, GA_ROOT) == hwnd && IsWindowVisible(hwnd)) {
+                WINEVENTS.Push(WIN_RENAMED, hwnd);
+            }
+            break;
+        case EVENT_OBJECT_LOCATIONCHANGE:
+            // fires for every step of a drag, PollFGWin only rescores candidates
+            if (GetAncestor(hwnd, GA_ROOT) == hwnd) WINEVENTS.Push(WIN_MOVED, hwnd);
+            break;
+        case EVENT_OBJECT_DESTROY:
+            // the window is already gone so it can't be checked for being top level
+            WINEVENTS.Push(WIN_DESTROYED, hwnd);
+            break;
+    }
+}
+
+Tasks::WatchWinEvents::WatchWinEvents() { 
+    this->SetName("WatchWinEvents"); 
+}
+
+void Tasks::WatchWinEvents::Stop(){
+    this->SetRunning(false);
+    // 0 until the message queue exists, Execute checks running after that
+    DWORD id = this->threadId.load();
+    if (id != 0) PostThreadMessage(id, WM_QUIT, 0, 0);
+}
+
+void Tasks::WatchWinEvents::Execute(){
+    this->SetRunning(true);
+
+    // creates the thread's message queue, so a WM_QUIT from Stop can't be lost
+    MSG msg;
+    PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+    this->threadId = GetCurrentThreadId();
+
+    // out of context hooks are delivered through this thread's message queue
+    DWORD flags = WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS;
+    HWINEVENTHOOK fgHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, 
+        NULL, WinEventProc, 0, 0, flags);
+    HWINEVENTHOOK lifeHook = SetWinEventHook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_SHOW, 
+        NULL, WinEventProc, 0, 0, flags);
+    HWINEVENTHOOK nameHook = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE, 
+        NULL, WinEventProc, 0, 0, flags);
+    HWINEVENTHOOK moveHook = SetWinEventHook(EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE, 
+        NULL, WinEventProc, 0, 0, flags);
+
+    // PollFGWin polls the window list while any hook is missing
+    bool hooked = fgHook != NULL && lifeHook != NULL && nameHook != NULL && moveHook != NULL;
+    if (hooked) {
+        SLOG.info("registered window event hooks");
+    } else {
+        SLOG.error("unable to register window event hooks: {} {} {} {}, error: {}, polling windows instead", 
+            fgHook != NULL, lifeHook != NULL, nameHook != NULL, moveHook != NULL, GetLastError());
+    }
+    WINEVENTS.SetReliable(hooked);
+
+    while(this->GetRunning()){
+        // 0 for WM_QUIT, -1 on an error
+        BOOL res;
+        while ((res = GetMessage(&msg, NULL, 0, 0)) > 0) {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+        if (res == 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    WINEVENTS.SetReliable(false);
+    if (fgHook != NULL) UnhookWinEvent(fgHook);
+    if (lifeHook != NULL) UnhookWinEvent(lifeHook);
+    if (nameHook != NULL) UnhookWinEvent(nameHook);
+    if (moveHook != NULL) UnhookWinEvent(moveHook);
+
+    this->SetRunning(false);
+}
@@ -1,28 +1,9 @@
 #include "utils.h"
-#include <string>
 #include <windows.h>
 
-std::string Utils::filepathHWND(HWND hwnd){
-    int lgth = GetWindowTextLength(hwnd) + 1;
-    wchar_t* title = new wchar_t[lgth];
-    GetWindowTextW(hwnd, title, lgth);
-
-    DWORD id;
-    GetWindowThreadProcessId(hwnd, &id); 
-
-    wchar_t* path = new wchar_t[MAX_PATH];
-    DWORD size = MAX_PATH;
-    HANDLE hProc = OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, id);
-    QueryFullProcessImageNameW(hProc, 0, path, &size);
-    CloseHandle(hProc);
-
-    std::wstring wsPath(path);
-    std::string res(wsPath.begin(), wsPath.end());
-
-    delete[] title;
-    delete[] path;
-
-    return res;
+std::size_t Utils::classNameHWND(HWND hwnd, char* buf, std::size_t size){
+    int lgth = GetClassNameA(hwnd, buf, static_cast<int>(size));
+    return lgth > 0 ? static_cast<std::size_t>(lgth) : 0;
 }
 
 
@@ -32,23 +13,30 @@ BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
         return TRUE;
     }
 
-	char class_name[80];
-	char title[80];
-	GetClassName(hwnd,class_name, sizeof(class_name));
-	GetWindowText(hwnd,title,sizeof(title));
+    WindowSnapshot* snapshot = reinterpret_cast<WindowSnapshot*>(lParam);
 
-    std::unordered_map<HWND, std::string>* titles = 
-        reinterpret_cast<std::unordered_map<HWND, std::string>*>(lParam);
+    int lgth = GetWindowTextLengthW(hwnd);
+    if (lgth <= 0) {
+        return TRUE;
+    }
+
+    std::vector<wchar_t>& title = snapshot->wideTitle;
+    if (title.size() < static_cast<std::size_t>(lgth) + 1) {
+        title.resize(lgth + 1);
+    }
+    int copied = GetWindowTextW(hwnd, title.data(), title.size());
 
-    if (strlen(title) > 0){
-        titles->insert({hwnd, title});
+    if (copied > 0){
+        DWORD pid;
+        GetWindowThreadProcessId(hwnd, &pid);
+        snapshot->Add(hwnd, pid, title.data(), copied);
     }
 
 	return TRUE;
 }
 
-std::unordered_map<HWND, std::string> Utils::GetFgWins(){
-    std::unordered_map<HWND, std::string> fgWins;
-    EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&fgWins));
-    return fgWins;
+void Utils::ScanFgWins(WindowSnapshot& snapshot){
+    snapshot.Clear();
+    EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&snapshot));
+    snapshot.Sort();
 }
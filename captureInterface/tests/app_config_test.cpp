@@ -0,0 +1,75 @@
+#include "test.h"
+#include "app_config.h"
+
+#include <fstream>
+#include <string>
+
+static void writeConfig(const char* filename, const char* text){
+    std::ofstream f(filename, std::ios::trunc);
+    f << text;
+}
+
+TEST(app_config, applies_valid_settings){
+    writeConfig("valid.ini",
+        "[capture]\nseconds = 45\nquality = low\n"
+        "[preview]\nfps = 30\nheight = 240\n"
+        "[reel]\ncount = 3\n"
+        "[hotkeys]\nquit = CTRL+SHIFT+F9\n"
+        "[profile.fast]\nfps = 144\nresolution = 1280 x 720\n"
+        "[games]\nGame.EXE = fast\n");
+    REQUIRE(CONFIG.Load("valid.ini"));
+
+    const AppConfig* c = CONFIG.Current();
+    CHECK(c->captureSeconds == 45);
+    CHECK(c->quality == QUALITY_LOW);
+    CHECK(c->previewFps == 30);
+    CHECK(c->previewHeight == 240);
+    CHECK(c->reelCount == 3);
+    CHECK(c->GetHotkey(HOTKEY_QUIT).modifiers == (0x0002 | 0x0004));
+    CHECK(c->GetHotkey(HOTKEY_QUIT).vk == 0x78);
+    const CaptureProfile* fast = c->FindProfile("fast");
+    REQUIRE(fast != nullptr);
+    CHECK(fast->fps == 144);
+    CHECK(fast->width == 1280 && fast->height == 720);
+    CHECK(c->gameProfiles.at("game.exe") == "fast");
+}
+
+TEST(app_config, invalid_values_keep_their_defaults){
+    writeConfig("invalid.ini",
+        "[capture]\nseconds = -5\n"
+        "[preview]\nfps = 0\nheight = 4000\n"
+        "[reel]\ncount = 0\n"
+        "[plugins]\ninstructions = 0\ntime_ms = 99999999999\noverrun_window_s = 0\n"
+        "[hotkeys]\nquit = ALT+F25\n"
+        "[profile.default]\nresolution = 1920x0\nfps = abc\nbitrate = 0\n"
+        "[profile.typo]\nfsp = 30\nfps = abc\n");
+    REQUIRE(CONFIG.Load("invalid.ini"));
+
+    const AppConfig* c = CONFIG.Current();
+    AppConfig defaults;
+    CHECK(c->captureSeconds == defaults.captureSeconds);
+    CHECK(c->previewFps == defaults.previewFps);
+    CHECK(c->previewHeight == defaults.previewHeight);
+    CHECK(c->reelCount == defaults.reelCount);
+    CHECK(c->pluginInstructions == defaults.pluginInstructions);
+    CHECK(c->pluginTimeMs == defaults.pluginTimeMs);
+    CHECK(c->pluginOverrunWindowS == defaults.pluginOverrunWindowS);
+    CHECK(c->GetHotkey(HOTKEY_QUIT).vk == defaults.GetHotkey(HOTKEY_QUIT).vk);
+    const CaptureProfile* profile = c->FindProfile("default");
+    REQUIRE(profile != nullptr);
+    CHECK(profile->width == 1920 && profile->height == 1080);
+    CHECK(profile->fps == 60);
+    CHECK(profile->bitrateKbps == 12000);
+    // only invalid lines, the profile isn't created
+    CHECK(c->FindProfile("typo") == nullptr);
+}
+
+TEST(app_config, an_unreadable_file_keeps_the_current_config){
+    writeConfig("current.ini", "[reel]\ncount = 7\n");
+    REQUIRE(CONFIG.Load("current.ini"));
+    uint64_t version = CONFIG.Current()->version;
+
+    CHECK(!CONFIG.Load("missing.ini"));
+    CHECK(CONFIG.Current()->version == version);
+    CHECK(CONFIG.Current()->reelCount == 7);
+}
@@ -0,0 +1,91 @@
+#include "test.h"
+#include "application_data.h"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(application_data, cuts_long_titles_between_code_points){
+    // 255 bytes then a 2 byte sequence straddling the end of the buffer
+    std::string title(255, 'a');
+    title += "\xC3\xA9";
+    APPDATA.SetGameWin(nullptr, title);
+    CHECK(APPDATA.Snapshot().Title() == std::string(255, 'a'));
+
+    // a 4 byte sequence cut after its first byte
+    title.assign(253, 'b');
+    title += "\xF0\x9F\x8E\xAE";
+    APPDATA.SetGameWin(nullptr, title);
+    CHECK(APPDATA.Snapshot().Title() == std::string(253, 'b'));
+
+    // one that ends exactly at the buffer is kept
+    title.assign(252, 'c');
+    title += "\xF0\x9F\x8E\xAE";
+    APPDATA.SetGameWin(nullptr, title);
+    CHECK(APPDATA.Snapshot().Title().size() == 256);
+
+    std::string profile(63, 'p');
+    profile += "\xE2\x82\xAC";
+    APPDATA.SetProfile(profile);
+    CHECK(APPDATA.Snapshot().Profile() == std::string(63, 'p'));
+
+    APPDATA.SetGameWin(nullptr, "short");
+    CHECK(APPDATA.Snapshot().Title() == "short");
+}
+
+// Writers keep every field derived from one counter, readers check that no
+// snapshot mixes two writes. Meant to run under -fsanitize=thread as well,
+// see MACROSCALE_SANITIZE in native/CMakeLists.txt.
+TEST(application_data, snapshots_are_never_torn){
+    const int writers = 2;
+    const int readers = 4;
+    const int writes = 20000;
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> reads{0};
+    // writers wait for the readers, under ctest -j they could finish first
+    std::atomic<int> ready{0};
+
+    // what the writers would write for value 0, for readers that start first
+    APPDATA.SetGameWin(reinterpret_cast<HWND>(uintptr_t(1)), "a");
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; w++) {
+        threads.emplace_back([&, w]{
+            char title[256];
+            while (ready.load() < readers) std::this_thread::yield();
+            for (int i = 0; i < writes; i++) {
+                uint32_t value = static_cast<uint32_t>(w * writes + i);
+                // length, contents and window all follow from value
+                std::size_t length = 1 + value % 200;
+                std::memset(title, 'a' + value % 26, length);
+                APPDATA.SetGameWin(reinterpret_cast<HWND>(uintptr_t(value) + 1), std::string_view(title, length));
+            }
+        });
+    }
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&]{
+            uint64_t lastVersion = 0;
+            ready.fetch_add(1);
+            while (!done.load(std::memory_order_relaxed)) {
+                AppState s = APPDATA.Snapshot();
+                reads.fetch_add(1, std::memory_order_relaxed);
+                uint32_t value = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(s.gameWin) - 1);
+                bool ok = s.version >= lastVersion && s.titleLength == 1 + value % 200;
+                for (uint32_t i = 0; ok && i < s.titleLength; i++) ok = s.title[i] == char('a' + value % 26);
+                if (!ok) torn.fetch_add(1, std::memory_order_relaxed);
+                lastVersion = s.version;
+            }
+        });
+    }
+
+    for (int w = 0; w < writers; w++) threads[w].join();
+    done = true;
+    for (int r = 0; r < readers; r++) threads[writers + r].join();
+
+    CHECK(torn == 0);
+    CHECK(reads > 0);
+}
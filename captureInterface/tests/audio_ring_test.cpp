@@ -0,0 +1,59 @@
+#include "test.h"
+#include "audio_ring.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static std::vector<float> ramp(std::size_t frames, float from){
+    std::vector<float> samples(frames * 2);
+    for (std::size_t i = 0; i < frames; i++) samples[2 * i] = samples[2 * i + 1] = from + float(i);
+    return samples;
+}
+
+TEST(audio_ring, reads_by_absolute_position){
+    AUDIORING.Configure(100, 2, 1);
+    std::vector<float> in = ramp(250, 0.0f);
+    AUDIORING.Write(in.data(), 250);
+    CHECK(AUDIORING.Written() == 250);
+
+    // only the last 100 frames are held, an older start is moved up
+    std::vector<float> out(2 * 60);
+    uint64_t start = 10;
+    CHECK(AUDIORING.Read(start, out.data(), 60) == 60);
+    CHECK(start == 150);
+    CHECK(out[0] == 150.0f && out[119] == 209.0f);
+
+    start = 240;
+    CHECK(AUDIORING.Read(start, out.data(), 60) == 10);
+    CHECK(out[0] == 240.0f);
+}
+
+TEST(audio_ring, configure_starts_a_new_generation){
+    AUDIORING.Configure(100, 2, 1);
+    uint64_t generation = AUDIORING.Generation();
+    std::vector<float> in = ramp(80, 0.0f);
+    AUDIORING.Write(in.data(), 80);
+
+    // same format, the positions still start over
+    AUDIORING.Configure(100, 2, 1);
+    CHECK(AUDIORING.Generation() == generation + 1);
+    CHECK(AUDIORING.Written() == 0);
+}
+
+TEST(audio_ring, configure_wakes_waiters){
+    AUDIORING.Configure(100, 2, 1);
+    std::vector<float> in = ramp(80, 0.0f);
+    AUDIORING.Write(in.data(), 80);
+
+    // waiting for a position of this generation that will never come
+    bool woken = false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread waiter([&woken]{ woken = AUDIORING.Wait(1000, std::chrono::seconds(10)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    AUDIORING.Configure(100, 2, 1);
+    waiter.join();
+
+    CHECK(woken);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
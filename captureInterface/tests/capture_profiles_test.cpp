@@ -0,0 +1,105 @@
+#include "test.h"
+#include "capture_profiles.h"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+// small profiles so allocating them is cheap, a.exe and b.exe use one each
+static void loadProfiles(){
+    std::ofstream f("profiles.ini", std::ios::trunc);
+    f << "[profile.default]\nresolution = 64x32\n"
+         "[profile.small]\nresolution = 32x16\n"
+         "[profile.tiny]\nresolution = 16x8\n"
+         "[games]\na.exe = small\nb.exe = tiny\n";
+    f.close();
+    CONFIG.Load("profiles.ini");
+}
+
+TEST(capture_profiles, resolves_game_profiles){
+    loadProfiles();
+    CHECK(PROFILES.Resolve("A.EXE").name == "small");
+    CHECK(PROFILES.Resolve("b.exe").name == "tiny");
+    CHECK(PROFILES.Resolve("other.exe").name == "default");
+}
+
+TEST(capture_profiles, activates_prepared_and_unprepared_profiles){
+    loadProfiles();
+    uint64_t switches = PROFILES.Stats().switches;
+
+    PROFILES.Build(PROFILES.Resolve("a.exe"));
+    PROFILES.Activate("a.exe");
+    REQUIRE(PROFILES.Active() != nullptr);
+    CHECK(PROFILES.Active()->profile.name == "small");
+    CHECK(PROFILES.Active()->framePool.size() == 4);
+    CHECK(PROFILES.Active()->framePool[0].size() == 32 * 16 * 4);
+
+    // nothing prepared for b.exe, allocated on the spot
+    PROFILES.Activate("b.exe");
+    CHECK(PROFILES.Active()->profile.name == "tiny");
+    // already active
+    PROFILES.Activate("b.exe");
+    CHECK(PROFILES.Stats().switches == switches + 2);
+}
+
+TEST(capture_profiles, resources_outlive_the_readers_holding_them){
+    loadProfiles();
+    PROFILES.Activate("a.exe");
+    std::shared_ptr<const PipelineResources> held = PROFILES.Active();
+    REQUIRE(held != nullptr);
+
+    // a Build right after the switch used to free what a reader still held
+    PROFILES.Activate("b.exe");
+    PROFILES.Build(PROFILES.Resolve("a.exe"));
+    PROFILES.Build(PROFILES.Resolve("b.exe"));
+    CHECK(held->profile.name == "small");
+    CHECK(held->framePool[3].size() == 32 * 16 * 4);
+    CHECK(PROFILES.Retired() == 1);
+
+    // once the reader lets go the next Build frees it
+    held.reset();
+    PROFILES.Build(PROFILES.Resolve("a.exe"));
+    CHECK(PROFILES.Retired() == 0);
+}
+
+TEST(capture_profiles, keeps_the_retired_list_bounded){
+    loadProfiles();
+    std::vector<std::shared_ptr<const PipelineResources>> held;
+    for (int i = 0; i < 20; i++) {
+        PROFILES.Activate(i % 2 ? "a.exe" : "b.exe");
+        held.push_back(PROFILES.Active());
+    }
+    CHECK(PROFILES.Retired() <= 4);
+    // the readers' references are still good
+    for (auto& r: held) CHECK(r->framePool.size() == 4);
+    held.clear();
+    PROFILES.Build(PROFILES.Resolve("a.exe"));
+    CHECK(PROFILES.Retired() == 0);
+}
+
+// a capture thread reading the active frame pool while profiles switch,
+// meant to run under the address and thread sanitizers as well
+TEST(capture_profiles, switches_under_a_reader){
+    loadProfiles();
+    PROFILES.Activate("a.exe");
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> bad{0};
+
+    std::thread reader([&]{
+        while (!done.load(std::memory_order_relaxed)) {
+            std::shared_ptr<const PipelineResources> r = PROFILES.Active();
+            std::size_t expected = std::size_t(r->profile.width) * r->profile.height * 4;
+            for (const std::vector<uint8_t>& frame: r->framePool) {
+                if (frame.size() != expected || frame[expected - 1] != 0) bad++;
+            }
+        }
+    });
+    for (int i = 0; i < 500; i++) {
+        if (i % 3 == 0) PROFILES.Build(PROFILES.Resolve(i % 2 ? "a.exe" : "b.exe"));
+        PROFILES.Activate(i % 2 ? "b.exe" : "a.exe");
+    }
+    done = true;
+    reader.join();
+    CHECK(bad == 0);
+    CHECK(PROFILES.Retired() <= 4);
+}
@@ -0,0 +1,162 @@
+#include "test.h"
+#include "clip_library.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+static const char* LOG = "clips_test.log";
+
+static ClipRecord clip(int64_t timestamp, const char* game, const char* title){
+    return ClipRecord{ .id = 0, .timestamp = timestamp, .durationMs = 30000,
+        .game = game, .title = title, .path = std::string(title) + ".mp4", .tags = {} };
+}
+
+// a fresh log with three clips, ends holds the size of the log after each
+static void writeLog(std::size_t ends[3]){
+    CLIPLIB.Close();
+    std::filesystem::remove(LOG);
+    REQUIRE(CLIPLIB.Open(LOG));
+    const char* titles[3] = { "first", "second", "third" };
+    for (int i = 0; i < 3; i++) {
+        CHECK(CLIPLIB.Add(clip(1000 + i, "Quake", titles[i])) == uint64_t(i + 1));
+        ends[i] = std::filesystem::file_size(LOG);
+    }
+    CLIPLIB.Close();
+}
+
+static void patch(std::size_t offset, const std::string& bytes){
+    std::fstream f(LOG, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(offset);
+    f.write(bytes.data(), bytes.size());
+}
+
+TEST(clip_library, replays_adds_removes_and_tags){
+    std::size_t ends[3];
+    writeLog(ends);
+    REQUIRE(CLIPLIB.Open(LOG));
+    CHECK(CLIPLIB.Remove(2));
+    CHECK(CLIPLIB.SetTags(3, {"Frag", "ace", "frag"}));
+    CLIPLIB.Close();
+
+    REQUIRE(CLIPLIB.Open(LOG));
+    CHECK(CLIPLIB.Size() == 2);
+    ClipRecord c;
+    CHECK(!CLIPLIB.Find(2, c));
+    REQUIRE(CLIPLIB.Find(3, c));
+    CHECK((c.tags == std::vector<std::string>{"ace", "frag"}));
+    CHECK(CLIPLIB.List(ClipFilter{ .game = {}, .tags = {"ace"} }).size() == 1);
+    // ids keep counting after the last one in the log
+    CHECK(CLIPLIB.Add(clip(2000, "Quake", "fourth")) == 4);
+    CLIPLIB.Close();
+}
+
+TEST(clip_library, truncates_a_torn_record_at_the_end){
+    std::size_t ends[3];
+    writeLog(ends);
+    std::filesystem::resize_file(LOG, ends[2] - 5);
+
+    REQUIRE(CLIPLIB.Open(LOG));
+    CHECK(CLIPLIB.Size() == 2);
+    CHECK(std::filesystem::file_size(LOG) == ends[1]);
+    CHECK(CLIPLIB.Add(clip(3000, "Quake", "again")) == 3);
+    CLIPLIB.Close();
+
+    REQUIRE(CLIPLIB.Open(LOG));
+    CHECK(CLIPLIB.Size() == 3);
+    CLIPLIB.Close();
+}
+
+TEST(clip_library, truncates_a_corrupt_record_at_the_end){
+    std::size_t ends[3];
+    writeLog(ends);
+    patch(ends[2] - 1, "#");
+
+    REQUIRE(CLIPLIB.Open(LOG));
+    CHECK(CLIPLIB.Size() == 2);
+    CHECK(std::filesystem::file_size(LOG) == ends[1]);
+    CLIPLIB.Close();
+}
+
+TEST(clip_library, skips_a_corrupt_record_followed_by_good_ones){
+    std::size_t ends[3];
+    writeLog(ends);
+    // a byte of the second clip's title
+    patch(ends[1] - 20, "#");
+
+    REQUIRE(CLIPLIB.Open(LOG));
+    ClipRecord c;
+    CHECK(CLIPLIB.Size() == 2);
+    CHECK(CLIPLIB.Find(1, c));
+    CHECK(!CLIPLIB.Find(2, c));
+    REQUIRE(CLIPLIB.Find(3, c));
+    CHECK(c.title == "third");
+    // compacted, the damaged record is gone from the log
+    CHECK(std::filesystem::file_size(LOG) == ends[0] + ends[2] - ends[1]);
+    CLIPLIB.Close();
+
+    REQUIRE(CLIPLIB.Open(LOG));
+    CHECK(CLIPLIB.Size() == 2);
+    CLIPLIB.Close();
+}
+
+TEST(clip_library, skips_a_record_with_a_corrupt_size){
+    std::size_t ends[3];
+    writeLog(ends);
+    // claims to run past the end of the log, the third record still follows
+    patch(ends[0], std::string("\xff\xff\xff\x0f", 4));
+
+    REQUIRE(CLIPLIB.Open(LOG));
+    ClipRecord c;
+    CHECK(CLIPLIB.Size() == 2);
+    CHECK(CLIPLIB.Find(1, c));
+    CHECK(CLIPLIB.Find(3, c));
+    CLIPLIB.Close();
+}
+
+BENCH(clip_library_replay){
+    // clips left after the removes
+    const int CLIPS = 100000;
+    const int ADDED = CLIPS + CLIPS / 10;
+    const char* games[4] = { "Quake", "Doom", "Halo", "Portal" };
+    CLIPLIB.Close();
+    std::filesystem::remove(LOG);
+    CLIPLIB.Open(LOG);
+    for (int i = 0; i < ADDED; i++) {
+        ClipRecord c = clip(1000000 + i, games[i % 4], "clip");
+        c.title += std::to_string(i);
+        if (i % 10 == 0) c.tags = {"frag"};
+        CLIPLIB.Add(std::move(c));
+    }
+    // one in eleven removed, leaves garbage below the compaction threshold
+    for (int i = 2; i <= ADDED; i += 11) CLIPLIB.Remove(i);
+    CLIPLIB.Close();
+
+    BenchTimer timer;
+    CLIPLIB.Open(LOG);
+    double seconds = timer.Seconds();
+    BenchReport("replayed clips", CLIPLIB.Size(), "");
+    BenchReport("replay", seconds * 1000.0, "ms");
+    BenchReport("replay rate", (ADDED + ADDED - CLIPS) / seconds, "records/s");
+    CHECK(CLIPLIB.Size() == CLIPS);
+
+    // quake and halo have tagged clips, doom has none so the whole tag
+    // list is walked
+    const int QUERIES = 1000;
+    BenchTimer query;
+    std::size_t found = 0;
+    for (int i = 0; i < QUERIES; i++) {
+        found += CLIPLIB.List(ClipFilter{ .game = games[(i % 2) * 2], .to = 1000000 + ADDED - i * 50, .tags = {"frag"}, .limit = 20 }).size();
+    }
+    BenchReport("game and tag listing, 20 clips", query.Seconds() / QUERIES * 1e6, "us");
+    CHECK(found == QUERIES * 20);
+
+    BenchTimer empty;
+    for (int i = 0; i < QUERIES; i++) {
+        found += CLIPLIB.List(ClipFilter{ .game = "Doom", .tags = {"frag"}, .limit = 20 }).size();
+    }
+    BenchReport("game and tag listing, no match", empty.Seconds() / QUERIES * 1e6, "us");
+
+    CLIPLIB.Close();
+    std::filesystem::remove(LOG);
+}
@@ -0,0 +1,241 @@
+#include "test.h"
+#include "clip_sidecar.h"
+
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+static ClipMetadata metadata(){
+    ClipMetadata m;
+    m.timestamp = 1760000000;
+    m.durationMs = 30000;
+    m.fps = 60;
+    m.width = 1920;
+    m.height = 1080;
+    m.bitrateKbps = 12000;
+    m.gameId = 42;
+    m.uploadState = UPLOAD_PENDING;
+    m.uploadProgress = 0;
+    m.game = "Quake";
+    m.title = "Rocket jump \xc3\xa9";
+    m.uploadUrl = "https://example.com/clip";
+    // out of order, Encode sorts them
+    m.keyframes = { {2000000, 9000}, {0, 100}, {1000000, 4000} };
+    m.markers = { {1500000, 500, MARKER_AUDIO, 0.8f, 0}, {200000, 0, MARKER_MANUAL, 1.0f, 0} };
+    return m;
+}
+
+// sidecars are viewed in place and need 8 byte alignment
+struct Aligned {
+    std::vector<uint64_t> words;
+    std::size_t size;
+
+    explicit Aligned(const std::string& bytes): words((bytes.size() + 7) / 8), size(bytes.size()) {
+        if (!bytes.empty()) std::memcpy(words.data(), bytes.data(), bytes.size());
+    }
+    const uint8_t* Data() const { return reinterpret_cast<const uint8_t*>(this->words.data()); };
+};
+
+static void checkMetadata(const ClipSidecar& sidecar){
+    const ClipSidecarHeader& h = sidecar.Header();
+    CHECK(h.timestamp == 1760000000);
+    CHECK(h.durationMs == 30000);
+    CHECK(h.fps == 60);
+    CHECK(h.width == 1920 && h.height == 1080);
+    CHECK(h.bitrateKbps == 12000);
+    CHECK(h.gameId == 42);
+    CHECK(sidecar.Game() == "Quake");
+    CHECK(sidecar.Title() == "Rocket jump \xc3\xa9");
+    CHECK(sidecar.UploadUrl() == "https://example.com/clip");
+
+    REQUIRE(sidecar.Keyframes().size() == 3);
+    CHECK(sidecar.Keyframes()[0].time == 0);
+    CHECK(sidecar.Keyframes()[1].fileOffset == 4000);
+    CHECK(sidecar.Keyframes()[2].time == 2000000);
+    REQUIRE(sidecar.Markers().size() == 2);
+    CHECK(sidecar.Markers()[0].kind == MARKER_MANUAL);
+    CHECK(sidecar.Markers()[1].durationMs == 500);
+    CHECK(sidecar.Markers()[1].score == 0.8f);
+}
+
+TEST(clip_sidecar, round_trips_in_memory){
+    std::string bytes = ClipSidecar::Encode(metadata());
+    Aligned buf(bytes);
+    ClipSidecar sidecar;
+    REQUIRE(sidecar.View(buf.Data(), buf.size));
+    CHECK(sidecar.Header().uploadState == UPLOAD_PENDING);
+    checkMetadata(sidecar);
+
+    CHECK(sidecar.KeyframeBefore(-1) == nullptr);
+    CHECK(sidecar.KeyframeBefore(0)->fileOffset == 100);
+    CHECK(sidecar.KeyframeBefore(1999999)->fileOffset == 4000);
+    CHECK(sidecar.KeyframeBefore(5000000)->fileOffset == 9000);
+}
+
+TEST(clip_sidecar, round_trips_through_a_file){
+    std::string path = ClipSidecar::PathFor("clip_test.mp4");
+    CHECK(path == "clip_test.mp4.msc");
+    REQUIRE(ClipSidecar::Write(path, metadata()));
+    CHECK(!std::filesystem::exists(path + ".tmp"));
+
+    ClipSidecar sidecar;
+    REQUIRE(sidecar.Open(path));
+    checkMetadata(sidecar);
+    sidecar.Close();
+
+    // updated in place, the rest stays as it was
+    REQUIRE(ClipSidecar::SetUploadState(path, UPLOAD_RUNNING, 500));
+    REQUIRE(sidecar.Open(path));
+    CHECK(sidecar.Header().uploadState == UPLOAD_RUNNING);
+    CHECK(sidecar.Header().uploadProgress == 500);
+    checkMetadata(sidecar);
+    sidecar.Close();
+    std::filesystem::remove(path);
+}
+
+TEST(clip_sidecar, round_trips_empty_sections){
+    ClipSidecar sidecar;
+    Aligned buf(ClipSidecar::Encode(ClipMetadata{}));
+    REQUIRE(sidecar.View(buf.Data(), buf.size));
+    CHECK(sidecar.Game().empty() && sidecar.Title().empty() && sidecar.UploadUrl().empty());
+    CHECK(sidecar.Keyframes().empty() && sidecar.Markers().empty());
+    CHECK(sidecar.KeyframeBefore(0) == nullptr);
+}
+
+TEST(clip_sidecar, reads_newer_minor_versions){
+    // a longer header from a newer writer, the sections move back by 8 bytes
+    std::string bytes = ClipSidecar::Encode(metadata());
+    ClipSidecarHeader h;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    bytes.insert(sizeof(h), 8, '\x7f');
+    h.versionMinor++;
+    h.headerSize += 8;
+    h.fileSize += 8;
+    h.keyframesOffset += 8;
+    h.markersOffset += 8;
+    h.stringsOffset += 8;
+    std::memcpy(bytes.data(), &h, sizeof(h));
+
+    Aligned buf(bytes);
+    ClipSidecar sidecar;
+    REQUIRE(sidecar.View(buf.Data(), buf.size));
+    checkMetadata(sidecar);
+
+    // but not a different major version
+    h.versionMajor++;
+    std::memcpy(buf.words.data(), &h, sizeof(h));
+    CHECK(!sidecar.View(buf.Data(), buf.size));
+    CHECK(!sidecar.IsOpen());
+}
+
+TEST(clip_sidecar, rejects_truncated_files){
+    std::string bytes = ClipSidecar::Encode(metadata());
+    ClipSidecar sidecar;
+    for (std::size_t size = 0; size < bytes.size(); size++) {
+        Aligned buf(bytes.substr(0, size));
+        CHECK(!sidecar.View(buf.Data(), buf.size));
+    }
+    CHECK(!sidecar.View(nullptr, 0));
+}
+
+// whatever View accepts, every accessor stays inside the buffer
+static void checkBounds(const ClipSidecar& sidecar, const Aligned& buf){
+    const uint8_t* begin = buf.Data();
+    const uint8_t* end = begin + buf.size;
+    auto inside = [begin, end](const void* p, std::size_t bytes) {
+        const uint8_t* b = static_cast<const uint8_t*>(p);
+        return bytes == 0 || (b >= begin && b <= end && bytes <= std::size_t(end - b));
+    };
+
+    for (std::string_view s: { sidecar.Game(), sidecar.Title(), sidecar.UploadUrl() }) {
+        CHECK(inside(s.data(), s.size()));
+    }
+    std::span<const ClipSidecarKeyframe> keyframes = sidecar.Keyframes();
+    std::span<const ClipSidecarMarker> markers = sidecar.Markers();
+    CHECK(inside(keyframes.data(), keyframes.size_bytes()));
+    CHECK(inside(markers.data(), markers.size_bytes()));
+    CHECK(reinterpret_cast<uintptr_t>(keyframes.data()) % 8 == 0);
+    CHECK(reinterpret_cast<uintptr_t>(markers.data()) % 8 == 0);
+
+    // touched as well, for the sanitizers
+    uint64_t sum = 0;
+    for (const ClipSidecarKeyframe& k: keyframes) sum += k.fileOffset;
+    for (const ClipSidecarMarker& m: markers) sum += m.kind;
+    for (std::string_view s: { sidecar.Game(), sidecar.Title(), sidecar.UploadUrl() }) {
+        for (char c: s) sum += static_cast<uint8_t>(c);
+    }
+    sidecar.KeyframeBefore(int64_t(sum));
+}
+
+TEST(clip_sidecar, survives_mutated_input){
+    std::mt19937 rng(5);
+    const std::string valid = ClipSidecar::Encode(metadata());
+    // offsets and lengths that sit right at the edges
+    const uint32_t edges[] = { 0, 1, 7, 8, 104, 112, uint32_t(valid.size()), uint32_t(valid.size()) - 1,
+        0x7fffffff, 0x80000000, 0xfffffff8, 0xffffffff };
+
+    ClipSidecar sidecar;
+    std::size_t accepted = 0;
+    for (int i = 0; i < 50000; i++) {
+        std::string bytes = valid;
+        int mutations = 1 + rng() % 4;
+        for (int m = 0; m < mutations; m++) {
+            switch (rng() % 4) {
+                case 0:
+                    bytes[rng() % bytes.size()] ^= static_cast<char>(1 << (rng() % 8));
+                    break;
+                case 1: {
+                    // a 4 byte header field, most of the header is offsets and lengths
+                    if (bytes.size() < sizeof(ClipSidecarHeader)) break;
+                    uint32_t value = edges[rng() % std::size(edges)];
+                    std::memcpy(bytes.data() + 4 * (rng() % (sizeof(ClipSidecarHeader) / 4)), &value, 4);
+                    break;
+                }
+                case 2:
+                    bytes.resize(rng() % (bytes.size() + 1));
+                    break;
+                default:
+                    bytes.append(rng() % 32, static_cast<char>(rng()));
+                    break;
+            }
+            if (bytes.empty()) break;
+        }
+
+        // the size field has to match, otherwise nearly everything is rejected early
+        if (bytes.size() >= sizeof(ClipSidecarHeader) && rng() % 2) {
+            uint32_t size = static_cast<uint32_t>(bytes.size());
+            std::memcpy(bytes.data() + offsetof(ClipSidecarHeader, fileSize), &size, 4);
+        }
+
+        Aligned buf(bytes);
+        if (!sidecar.View(buf.Data(), buf.size)) continue;
+        accepted++;
+        checkBounds(sidecar, buf);
+    }
+    // the mutations leave plenty of sidecars that pass the checks
+    CHECK(accepted > 1000);
+}
+
+TEST(clip_sidecar, survives_random_input){
+    std::mt19937 rng(9);
+    ClipSidecar sidecar;
+    for (int i = 0; i < 20000; i++) {
+        std::string bytes(rng() % 512, '\0');
+        for (char& c: bytes) c = static_cast<char>(rng());
+        if (bytes.size() >= sizeof(ClipSidecarHeader)) {
+            // past the magic and version checks so the section checks run
+            ClipSidecarHeader h;
+            std::memcpy(&h, bytes.data(), sizeof(h));
+            h.magic = SIDECAR_MAGIC;
+            h.versionMajor = SIDECAR_VERSION_MAJOR;
+            h.headerSize = sizeof(ClipSidecarHeader) + 8 * (rng() % 3);
+            h.fileSize = static_cast<uint32_t>(bytes.size());
+            std::memcpy(bytes.data(), &h, sizeof(h));
+        }
+
+        Aligned buf(bytes);
+        if (sidecar.View(buf.Data(), buf.size)) checkBounds(sidecar, buf);
+    }
+}
@@ -0,0 +1,104 @@
+#include "test.h"
+#include "downscale.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// a BGRA frame with a few bytes of row padding
+struct Frame {
+    uint32_t width, height, stride;
+    std::vector<uint8_t> pixels;
+
+    Frame(uint32_t width, uint32_t height, std::mt19937& rng): width(width), height(height), stride(width * 4 + 12) {
+        this->pixels.resize(std::size_t(this->stride) * height);
+        for (uint8_t& b: this->pixels) b = static_cast<uint8_t>(rng());
+    }
+    const uint8_t* At(uint32_t x, uint32_t y) const { return this->pixels.data() + std::size_t(y) * this->stride + x * 4; };
+};
+
+TEST(downscale, factor_fits_the_bounds){
+    CHECK(DownscaleFactor(1920, 1080, 640, 360) == 3);
+    CHECK(DownscaleFactor(2560, 1440, 640, 360) == 4);
+    CHECK(DownscaleFactor(640, 360, 640, 360) == 1);
+    CHECK(DownscaleFactor(641, 100, 640, 360) == 2);
+    CHECK(DownscaleFactor(100000, 100, 640, 360) == 16);
+}
+
+TEST(downscale, bgra_averages_blocks){
+    std::mt19937 rng(1);
+    for (uint32_t factor = 1; factor <= 16; factor++) {
+        Frame frame(factor * 7 + 3, factor * 5 + 1, rng);
+        DownscaleScratch scratch;
+        uint32_t outWidth = frame.width / factor, outHeight = frame.height / factor;
+        std::vector<uint8_t> out(std::size_t(outWidth) * outHeight * 4);
+        DownscaleBgra(frame.pixels.data(), frame.width, frame.height, frame.stride, factor, out.data(), outWidth * 4, scratch);
+
+        int worst = 0;
+        for (uint32_t oy = 0; oy < outHeight; oy++) {
+            for (uint32_t ox = 0; ox < outWidth; ox++) {
+                for (int c = 0; c < 4; c++) {
+                    uint32_t sum = 0;
+                    for (uint32_t y = 0; y < factor; y++) {
+                        for (uint32_t x = 0; x < factor; x++) sum += frame.At(ox * factor + x, oy * factor + y)[c];
+                    }
+                    int expected = static_cast<int>((sum + factor * factor / 2) / (factor * factor));
+                    worst = std::max(worst, std::abs(expected - out[(std::size_t(oy) * outWidth + ox) * 4 + c]));
+                }
+            }
+        }
+        // the float rounding may land on the other side of a half
+        CHECK(worst <= 1);
+    }
+}
+
+TEST(downscale, luma_averages_blocks){
+    std::mt19937 rng(2);
+    for (uint32_t factor = 1; factor <= 16; factor++) {
+        Frame frame(factor * 9 + 5, factor * 4 + 3, rng);
+        DownscaleScratch scratch;
+        uint32_t outWidth = frame.width / factor, outHeight = frame.height / factor;
+        std::vector<uint8_t> luma(std::size_t(outWidth) * outHeight);
+        DownscaleLuma(frame.pixels.data(), frame.width, frame.height, frame.stride, factor, luma.data(), scratch);
+
+        for (uint32_t oy = 0; oy < outHeight; oy++) {
+            for (uint32_t ox = 0; ox < outWidth; ox++) {
+                uint32_t sum = 0;
+                for (uint32_t y = 0; y < factor; y++) {
+                    for (uint32_t x = 0; x < factor; x++) {
+                        const uint8_t* p = frame.At(ox * factor + x, oy * factor + y);
+                        sum += p[2] * 77 + p[1] * 150 + p[0] * 29;
+                    }
+                }
+                CHECK(luma[std::size_t(oy) * outWidth + ox] == (sum / (factor * factor)) >> 8);
+            }
+        }
+    }
+}
+
+TEST(downscale, white_stays_white){
+    std::vector<uint8_t> white(64 * 64 * 4, 255);
+    std::vector<uint8_t> luma(8 * 8);
+    DownscaleScratch scratch;
+    DownscaleLuma(white.data(), 64, 64, 64 * 4, 8, luma.data(), scratch);
+    for (uint8_t v: luma) CHECK(v == 255);
+}
+
+BENCH(downscale){
+    // what FramePipeline does with a 1080p frame: one pass over the full
+    // frame for the ring, the motion luma from its result
+    std::mt19937 rng(3);
+    Frame frame(1920, 1080, rng);
+    std::vector<uint8_t> small(640 * 360 * 4), luma(320 * 180);
+    DownscaleScratch scratch;
+
+    const int RUNS = 200;
+    BenchTimer ring;
+    for (int i = 0; i < RUNS; i++) DownscaleBgra(frame.pixels.data(), 1920, 1080, frame.stride, 3, small.data(), 640 * 4, scratch);
+    BenchReport("1080p to 640x360 bgra", ring.Seconds() / RUNS * 1e3, "ms");
+
+    BenchTimer motion;
+    for (int i = 0; i < RUNS; i++) DownscaleLuma(small.data(), 640, 360, 640 * 4, 2, luma.data(), scratch);
+    BenchReport("640x360 to 320x180 luma", motion.Seconds() / RUNS * 1e3, "ms");
+}
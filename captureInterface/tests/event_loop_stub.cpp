@@ -0,0 +1,14 @@
+#include "event_loop.h"
+
+// the template matcher posts its matches to the event loop, which would
+// bring the tasks and the windows code along. the tests match templates
+// directly and drop the events.
+EventLoop* EventLoop::instancePtr = NULL;
+std::mutex EventLoop::instMutex;
+
+EventLoop* EventLoop::Instance(){
+    static EventLoop inst;
+    return &inst;
+}
+
+void EventLoop::AddEvent(Event&){}
@@ -0,0 +1,105 @@
+#include "test.h"
+#include "fft.h"
+
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+
+// the textbook O(n^2) transform in double precision, with a table of the
+// n roots of unity
+static std::vector<std::complex<double>> naiveDft(const std::vector<float>& in){
+    const std::size_t n = in.size();
+    std::vector<std::complex<double>> roots(n);
+    for (std::size_t i = 0; i < n; i++) roots[i] = std::polar(1.0, -2.0 * PI * double(i) / double(n));
+
+    std::vector<std::complex<double>> out(n / 2 + 1);
+    for (std::size_t k = 0; k <= n / 2; k++) {
+        std::complex<double> sum = 0.0;
+        for (std::size_t t = 0; t < n; t++) sum += double(in[t]) * roots[(k * t) % n];
+        out[k] = sum;
+    }
+    return out;
+}
+
+static std::vector<float> randomSignal(std::size_t n, std::mt19937& rng){
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<float> in(n);
+    for (float& x: in) x = uniform(rng);
+    return in;
+}
+
+TEST(fft, matches_the_dft){
+    std::mt19937 rng(2);
+    for (std::size_t n = 8; n <= 4096; n *= 2) {
+        std::vector<float> in = randomSignal(n, rng);
+        RealFft fft(n);
+        REQUIRE(fft.Bins() == n / 2 + 1);
+        std::vector<float> re(fft.Bins()), im(fft.Bins()), mag(fft.Bins());
+        fft.Forward(in.data(), re.data(), im.data());
+        fft.Magnitudes(in.data(), mag.data());
+
+        std::vector<std::complex<double>> expected = naiveDft(in);
+        // float rounding grows with log n, the spectrum's scale with sqrt n
+        double tolerance = 2e-6 * std::sqrt(double(n)) * std::log2(double(n));
+        double worst = 0.0;
+        for (std::size_t k = 0; k < fft.Bins(); k++) {
+            double error = std::abs(std::complex<double>(re[k], im[k]) - expected[k]);
+            worst = std::max(worst, error);
+            CHECK(std::fabs(mag[k] - std::abs(expected[k])) <= tolerance);
+        }
+        CHECK(worst <= tolerance);
+    }
+}
+
+TEST(fft, finds_a_sine_in_its_bin){
+    const std::size_t n = 1024;
+    std::vector<float> in(n);
+    for (std::size_t t = 0; t < n; t++) in[t] = float(std::sin(2.0 * PI * 37.0 * double(t) / double(n)));
+    RealFft fft(n);
+    std::vector<float> mag(fft.Bins());
+    fft.Magnitudes(in.data(), mag.data());
+
+    CHECK(std::fabs(mag[37] - n / 2.0f) < 0.01f);
+    for (std::size_t k = 0; k < fft.Bins(); k++) {
+        if (k != 37) CHECK(mag[k] < 0.01f);
+    }
+}
+
+TEST(fft, reuses_its_scratch_space){
+    std::mt19937 rng(4);
+    RealFft fft(256);
+    std::vector<float> a = randomSignal(256, rng), b = randomSignal(256, rng);
+    std::vector<float> first(fft.Bins()), other(fft.Bins()), again(fft.Bins());
+    fft.Magnitudes(a.data(), first.data());
+    fft.Magnitudes(b.data(), other.data());
+    fft.Magnitudes(a.data(), again.data());
+    CHECK(first == again);
+}
+
+BENCH(fft){
+    std::mt19937 rng(6);
+    for (std::size_t n: { 256, 1024, 4096 }) {
+        std::vector<float> in = randomSignal(n, rng);
+        RealFft fft(n);
+        std::vector<float> mag(fft.Bins());
+
+        const int RUNS = 20000;
+        BenchTimer timer;
+        for (int i = 0; i < RUNS; i++) {
+            in[i % n] += 1e-3f;
+            fft.Magnitudes(in.data(), mag.data());
+        }
+        double micros = timer.Seconds() / RUNS * 1e6;
+        std::string what = "real fft " + std::to_string(n) + " magnitudes";
+        BenchReport(what.c_str(), micros, "us");
+
+        const int DFTS = n <= 1024 ? 20 : 2;
+        BenchTimer naive;
+        for (int i = 0; i < DFTS; i++) naiveDft(in);
+        what = "naive dft " + std::to_string(n);
+        BenchReport(what.c_str(), naive.Seconds() / DFTS * 1e6, "us");
+    }
+}
@@ -0,0 +1,138 @@
+#include "test.h"
+#include "frame_client.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// a ring laid out by hand the way frame_ring_format.h describes it
+class RingFile {
+
+public:
+    std::string path;
+    std::vector<uint8_t> data;
+
+    explicit RingFile(const char* name): path((std::filesystem::temp_directory_path() / name).string()) {
+
+        uint32_t slotSize = (sizeof(FrameSlotHeader) + FRAME_RING_MAX_WIDTH * FRAME_RING_MAX_HEIGHT * 4 + 63) & ~63u;
+        this->data.assign(64 + std::size_t(slotSize) * FRAME_RING_SLOTS, 0);
+        FrameRingHeader* h = this->header();
+        h->magic = FRAME_RING_MAGIC;
+        h->version = FRAME_RING_VERSION;
+        h->headerSize = sizeof(FrameRingHeader);
+        h->slotCount = FRAME_RING_SLOTS;
+        h->slotSize = slotSize;
+        h->slotsOffset = 64;
+        h->maxWidth = FRAME_RING_MAX_WIDTH;
+        h->maxHeight = FRAME_RING_MAX_HEIGHT;
+    }
+    ~RingFile(){ std::filesystem::remove(this->path); }
+
+    FrameRingHeader* header(){ return reinterpret_cast<FrameRingHeader*>(this->data.data()); }
+
+    void Write(uint64_t n, uint8_t value){
+        FrameRingHeader* h = this->header();
+        uint8_t* base = this->data.data() + h->slotsOffset + (n - 1) % h->slotCount * h->slotSize;
+        FrameSlotHeader* slot = reinterpret_cast<FrameSlotHeader*>(base);
+        slot->sequence = 2 * n;
+        slot->time = static_cast<int64_t>(n) * 1000;
+        slot->width = 64;
+        slot->height = 36;
+        slot->stride = 64 * 4;
+        slot->motion = 0.5f;
+        std::memset(base + sizeof(FrameSlotHeader), value, 64 * 4 * 36);
+        h->latest = n;
+    }
+
+    void Save(){
+        std::ofstream(this->path, std::ios::binary).write(reinterpret_cast<const char*>(this->data.data()), this->data.size());
+    }
+
+    FrameRingHeader Load(){
+        FrameRingHeader h;
+        std::ifstream(this->path, std::ios::binary).read(reinterpret_cast<char*>(&h), sizeof(h));
+        return h;
+    }
+};
+
+TEST(frame_client, reads_the_newest_frame){
+    RingFile ring("macroscale_frame_client");
+    for (uint64_t n = 1; n <= 3; n++) ring.Write(n, static_cast<uint8_t>(n));
+    ring.Save();
+
+    FrameRingReader reader;
+    REQUIRE(reader.Open(ring.path));
+
+    FrameView frame;
+    REQUIRE(reader.Next(0, frame));
+    CHECK(frame.number == 3);
+    CHECK(frame.width == 64 && frame.height == 36 && frame.stride == 256);
+    CHECK(frame.time == 3000);
+    CHECK(frame.pixels[0] == 3 && frame.pixels[256 * 36 - 1] == 3);
+    CHECK(reader.StillValid(frame));
+    // nothing newer
+    CHECK(!reader.Next(3, frame));
+}
+
+TEST(frame_client, rejects_overwritten_and_unwritten_frames){
+    RingFile ring("macroscale_frame_client");
+    for (uint64_t n = 1; n <= FRAME_RING_SLOTS + 2; n++) ring.Write(n, 1);
+    ring.Save();
+
+    FrameRingReader reader;
+    REQUIRE(reader.Open(ring.path));
+
+    FrameView frame;
+    // slots 1 and 2 hold frames FRAME_RING_SLOTS + 1 and + 2 now
+    CHECK(!reader.Acquire(1, frame));
+    CHECK(!reader.Acquire(2, frame));
+    CHECK(reader.Acquire(3, frame));
+    CHECK(!reader.Acquire(FRAME_RING_SLOTS + 3, frame));
+    CHECK(!reader.Acquire(0, frame));
+}
+
+TEST(frame_client, notices_a_slot_being_reused){
+    RingFile ring("macroscale_frame_client");
+    ring.Write(1, 1);
+    ring.Save();
+
+    FrameRingReader reader;
+    REQUIRE(reader.Open(ring.path));
+    FrameView frame;
+    REQUIRE(reader.Acquire(1, frame));
+
+    // the publisher starts on frame FRAME_RING_SLOTS + 1 in the same slot
+    FrameSlotHeader* slot = const_cast<FrameSlotHeader*>(reinterpret_cast<const FrameSlotHeader*>(frame.pixels) - 1);
+    std::atomic_ref<uint64_t>(slot->sequence).store(2 * (FRAME_RING_SLOTS + 1) - 1);
+    CHECK(!reader.StillValid(frame));
+}
+
+TEST(frame_client, counts_polls){
+    RingFile ring("macroscale_frame_client_polls");
+    ring.Save();
+
+    FrameRingReader reader;
+    REQUIRE(reader.Open(ring.path));
+    FrameView frame;
+    CHECK(reader.Latest() == 0);
+    CHECK(!reader.Next(0, frame));
+    // the publisher sees the polls in the shared header
+    CHECK(ring.Load().readerPolls == 2);
+}
+
+TEST(frame_client, rejects_other_files){
+    RingFile ring("macroscale_frame_client_magic");
+    ring.header()->magic = 0;
+    ring.Save();
+    FrameRingReader reader;
+    CHECK(!reader.Open(ring.path));
+
+    RingFile small("macroscale_frame_client_small");
+    small.header()->slotSize = 64;
+    small.Save();
+    CHECK(!reader.Open(small.path));
+
+    CHECK(!reader.Open("/nonexistent/ring"));
+}
@@ -0,0 +1,77 @@
+#include "test.h"
+#include "game_db.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// GAMES_DB is generated from GAMES_CSV, data/games.csv, by the build
+TEST(game_db, looks_up_the_generated_database){
+    REQUIRE(GAMEDB.Open(GAMES_DB));
+
+    std::optional<GameInfo> cs2 = GAMEDB.Lookup("CS2.exe");
+    REQUIRE(cs2.has_value());
+    CHECK(cs2->title == "Counter-Strike 2");
+    CHECK(cs2->gameId == 730);
+    CHECK(cs2->profile == "competitive");
+
+    CHECK(!GAMEDB.Lookup("explorer.exe").has_value());
+    CHECK(!GAMEDB.Lookup("").has_value());
+}
+
+TEST(game_db, rejects_files_that_are_not_a_database){
+    {
+        std::ofstream f("not_a_games.db", std::ios::binary | std::ios::trunc);
+        f << "key,title,game_id,profile\n";
+    }
+    CHECK(!GAMEDB.Open("not_a_games.db"));
+    CHECK(!GAMEDB.IsOpen());
+    CHECK(!GAMEDB.Lookup("cs2.exe").has_value());
+}
+
+// what the game detector pays per window: a lookup of every known game
+// under a few spellings and of executables that aren't games, and opening
+// the database at startup
+BENCH(game_db_lookup){
+    // nothing is parsed, an open is the mapping and the header check. the
+    // first one also pays for the logger's first line
+    BenchTimer first;
+    REQUIRE(GAMEDB.Open(GAMES_DB));
+    BenchReport("first open", first.Seconds() * 1e6, "us");
+    const int OPENS = 10;
+    BenchTimer open;
+    for (int i = 0; i < OPENS; i++) REQUIRE(GAMEDB.Open(GAMES_DB));
+    BenchReport("open and map", open.Seconds() / OPENS * 1e6, "us");
+
+    std::vector<std::string> hits, misses;
+    std::ifstream csv(GAMES_CSV);
+    std::string line;
+    std::getline(csv, line);
+    while (std::getline(csv, line)) {
+        std::string key = line.substr(0, line.find(','));
+        if (key.size() >= 2 && key.front() == '"') key = key.substr(1, key.size() - 2);
+        std::string upper = key;
+        for (char& c: upper) c = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+        hits.push_back(key);
+        hits.push_back(upper);
+    }
+    for (int i = 0; i < 1000; i++) misses.push_back("process" + std::to_string(i) + ".exe");
+    REQUIRE(!hits.empty());
+
+    const int ROUNDS = 2000;
+    std::size_t found = 0;
+    BenchTimer hit;
+    for (int round = 0; round < ROUNDS; round++) {
+        for (const std::string& key: hits) found += GAMEDB.Lookup(key).has_value();
+    }
+    BenchReport("hit", hit.Seconds() / (double(ROUNDS) * hits.size()) * 1e9, "ns");
+    CHECK(found == ROUNDS * hits.size());
+
+    found = 0;
+    BenchTimer miss;
+    for (int round = 0; round < ROUNDS / 10; round++) {
+        for (const std::string& key: misses) found += GAMEDB.Lookup(key).has_value();
+    }
+    BenchReport("miss", miss.Seconds() / (double(ROUNDS / 10) * misses.size()) * 1e9, "ns");
+    CHECK(found == 0);
+}
@@ -0,0 +1,252 @@
+#include "test.h"
+#include "game_detector.h"
+#include "mock_desktop.h"
+
+// a desktop with two ordinary windows, games live in C:\Games
+class Desktop {
+
+public:
+    MockWindowSystem windows;
+    MockProcessSource processes;
+    ProcessCache cache{processes};
+    GameDetector detector{windows, cache, GAMERULES};
+
+    Desktop(){
+        GAMERULES.Compile({
+            GameRule{ RULE_PATH, "\\games\\", 0.9f, false },
+            GameRule{ RULE_CLASS, "UnrealWindow", 0.8f, false },
+        });
+        this->processes.paths[10] = "C:\\Windows\\explorer.exe";
+        this->processes.paths[11] = "C:\\Program Files\\Editor\\editor.exe";
+        this->processes.paths[20] = "C:\\Games\\Quake\\quake.exe";
+        this->processes.paths[21] = "C:\\Program Files\\Shooter\\shooter.exe";
+        this->windows.Open(1, 10, "Explorer");
+        this->windows.Open(2, 11, "notes.txt - Editor");
+    }
+};
+
+TEST(game_detector, finds_a_game_after_a_shown_event){
+    Desktop d;
+    CHECK(!d.detector.Update());
+    CHECK(d.detector.Target() == nullptr);
+    CHECK(d.windows.scans == 1);
+
+    // nothing is scanned until an event says so
+    d.windows.Open(3, 20, "Quake");
+    CHECK(!d.detector.Update());
+    CHECK(d.windows.scans == 1);
+
+    d.detector.OnEvents({ WinEvent{ WIN_SHOWN, MockWindowSystem::Handle(3) } });
+    CHECK(d.detector.Update());
+    REQUIRE(d.detector.Target() != nullptr);
+    CHECK(d.detector.Target()->hwnd == MockWindowSystem::Handle(3));
+    CHECK(d.detector.TargetTitle() == "Quake");
+    CHECK(d.windows.scans == 2);
+}
+
+TEST(game_detector, matches_window_classes){
+    Desktop d;
+    d.windows.Open(3, 21, "Shooter", "UnrealWindow");
+    CHECK(d.detector.Update());
+    REQUIRE(d.detector.Target() != nullptr);
+    CHECK(d.detector.TargetTitle() == "Shooter");
+}
+
+TEST(game_detector, rescans_once_the_interval_passes){
+    Desktop d;
+    d.detector.Update();
+
+    // the event for this window got lost
+    d.windows.Open(3, 20, "Quake");
+    d.windows.now += GameDetector::RESCAN_MS - 1;
+    d.detector.RescanIfOlder(GameDetector::RESCAN_MS);
+    CHECK(!d.detector.Update());
+
+    d.windows.now += 1;
+    d.detector.RescanIfOlder(GameDetector::RESCAN_MS);
+    CHECK(d.detector.Update());
+    CHECK(d.detector.TargetTitle() == "Quake");
+}
+
+TEST(game_detector, polls_while_events_are_unreliable){
+    Desktop d;
+    d.detector.Update();
+    d.windows.Open(3, 20, "Quake");
+    // an unrelated event each time, so Poll doesn't wait
+    WINEVENTS.SetReliable(true);
+    d.windows.now += GameDetector::POLL_MS;
+    WINEVENTS.Push(WIN_FOREGROUND, MockWindowSystem::Handle(1));
+    CHECK(!d.detector.Poll(WINEVENTS));
+    CHECK(d.windows.scans == 1);
+
+    // a hook is missing
+    WINEVENTS.SetReliable(false);
+    WINEVENTS.Push(WIN_FOREGROUND, MockWindowSystem::Handle(1));
+    CHECK(d.detector.Poll(WINEVENTS));
+    CHECK(d.windows.scans == 2);
+    CHECK(d.detector.TargetTitle() == "Quake");
+}
+
+TEST(game_detector, rescans_when_the_wait_times_out){
+    Desktop d;
+    d.detector.Update();
+    d.windows.Open(3, 20, "Quake");
+
+    // takes POLL_MS of real time, the mock clock stands still so only the
+    // timeout can cause the scan
+    WINEVENTS.SetReliable(false);
+    CHECK(d.detector.Poll(WINEVENTS));
+    CHECK(d.windows.scans == 2);
+    CHECK(d.detector.TargetTitle() == "Quake");
+}
+
+TEST(game_detector, only_rematches_changed_windows){
+    Desktop d;
+    d.detector.Update();
+    int opens = d.processes.opens;
+
+    d.windows.Find(MockWindowSystem::Handle(2))->title = "other.txt - Editor";
+    d.detector.OnEvents({ WinEvent{ WIN_RENAMED, MockWindowSystem::Handle(2) } });
+    d.detector.Update();
+    // the renamed window's process was cached, the other one not looked at
+    CHECK(d.processes.opens == opens);
+    CHECK(d.windows.scans == 2);
+}
+
+TEST(game_detector, drops_the_target_when_its_window_closes){
+    Desktop d;
+    d.windows.Open(3, 20, "Quake");
+    CHECK(d.detector.Update());
+    REQUIRE(d.detector.Target() != nullptr);
+
+    d.windows.Close(3);
+    d.detector.OnEvents({ WinEvent{ WIN_DESTROYED, MockWindowSystem::Handle(3) } });
+    // the change to no target is reported like any other
+    CHECK(d.detector.Update());
+    CHECK(d.detector.Target() == nullptr);
+    CHECK(d.detector.TargetTitle().empty());
+}
+
+TEST(game_detector, rescores_a_candidate_when_it_moves){
+    Desktop d;
+    d.windows.Open(3, 20, "Quake");
+    d.detector.Update();
+    d.windows.Open(4, 21, "Shooter", "UnrealWindow");
+    d.detector.OnEvents({ WinEvent{ WIN_SHOWN, MockWindowSystem::Handle(4) } });
+    d.detector.Update();
+    CHECK(d.detector.TargetTitle() == "Quake");
+
+    // going fullscreen is worth more than the better rule match
+    d.windows.Find(MockWindowSystem::Handle(4))->shape = WindowShape{ 1.0f, true, false };
+    d.detector.OnEvents({ WinEvent{ WIN_MOVED, MockWindowSystem::Handle(4) } });
+    CHECK(d.detector.Update());
+    CHECK(d.detector.TargetTitle() == "Shooter");
+    CHECK(d.windows.scans == 2);
+
+    // moves of windows that aren't candidates are ignored
+    d.detector.OnEvents({ WinEvent{ WIN_MOVED, MockWindowSystem::Handle(1) } });
+    CHECK(!d.detector.Update());
+}
+
+// every window retitled, so every one is matched against the rules again
+static void retitleAll(MockWindowSystem& desktop, GameDetector& detector, std::vector<WinEvent>& events, int round){
+    events.clear();
+    for (MockWindowSystem::Window& w: desktop.windows) {
+        w.title.back() = round % 2 ? 'a' : 'b';
+        events.push_back(WinEvent{ WIN_RENAMED, w.hwnd });
+    }
+    detector.OnEvents(events);
+    detector.Update();
+}
+
+TEST(game_detector, rescans_known_windows_without_allocating){
+    Desktop d;
+    d.windows.Open(3, 20, "Quake ");
+    d.windows.Open(4, 21, "Shooter ", "UnrealWindow");
+    std::vector<WinEvent> events;
+    events.reserve(16);
+
+    // the first rounds fill the process cache and size the buffers
+    for (int round = 0; round < 2; round++) retitleAll(d.windows, d.detector, events, round);
+    int opens = d.processes.opens;
+
+    uint64_t before = TestAllocations();
+    for (int round = 0; round < 10; round++) retitleAll(d.windows, d.detector, events, round);
+    CHECK(TestAllocations() - before == 0);
+    CHECK(d.processes.opens == opens);
+    CHECK(d.windows.scans == 12);
+    CHECK(d.detector.TargetTitle() == "Quakea");
+}
+
+// allocations and time of a rescan that matches 300 retitled windows of 100
+// processes against the rules, with a cold and a warm process cache
+BENCH(game_detection_rescan){
+    const int windows = 300;
+    MockWindowSystem desktop;
+    MockProcessSource processes;
+    ProcessCache cache(processes);
+    GameDetector detector(desktop, cache, GAMERULES);
+    for (int i = 0; i < windows; i++) {
+        processes.paths[100 + i / 3] = "C:\\Program Files\\App" + std::to_string(i / 3) + "\\app.exe";
+        desktop.Open(1000 + i, 100 + i / 3, "Window " + std::to_string(i) + " ");
+    }
+    std::vector<WinEvent> events;
+    events.reserve(windows);
+
+    uint64_t before = TestAllocations();
+    BenchTimer cold;
+    retitleAll(desktop, detector, events, 0);
+    double coldSeconds = cold.Seconds();
+    BenchReport("cold rescan", coldSeconds * 1e6, "us");
+    BenchReport("cold allocations", double(TestAllocations() - before), "");
+
+    const int rounds = 1000;
+    retitleAll(desktop, detector, events, 1);
+    before = TestAllocations();
+    BenchTimer warm;
+    for (int round = 0; round < rounds; round++) retitleAll(desktop, detector, events, round);
+    BenchReport("warm rescan", warm.Seconds() * 1e6 / rounds, "us");
+    BenchReport("warm allocations per rescan", double(TestAllocations() - before) / rounds, "");
+}
+
+// window scans per simulated minute, polling every 50 ms like PollFGWin did
+// against the event driven detector with its safety rescans, on a desktop
+// of 300 windows with a few changes during the minute
+BENCH(game_detection_minute){
+    const int windows = 300;
+    const int changes = 6;
+    const int tickMs = 50;
+    const int ticks = 60000 / tickMs;
+
+    for (int mode = 0; mode < 2; mode++) {
+        bool polling = mode == 0;
+        MockWindowSystem desktop;
+        MockProcessSource processes;
+        ProcessCache cache(processes);
+        GameDetector detector(desktop, cache, GAMERULES);
+        for (int i = 0; i < windows; i++) {
+            processes.paths[100 + i / 3] = "C:\\Program Files\\App" + std::to_string(i / 3) + "\\app.exe";
+            desktop.Open(1000 + i, 100 + i / 3, "Window " + std::to_string(i));
+        }
+        detector.Update();
+
+        uint64_t scans = desktop.scans;
+        BenchTimer timer;
+        for (int tick = 0; tick < ticks; tick++) {
+            desktop.now += tickMs;
+            if (tick % (ticks / changes) == 0) {
+                HWND hwnd = MockWindowSystem::Handle(1000 + tick / (ticks / changes));
+                desktop.Find(hwnd)->title += " *";
+                if (!polling) detector.OnEvents({ WinEvent{ WIN_RENAMED, hwnd } });
+            }
+            if (polling) detector.Rescan();
+            else detector.RescanIfOlder(GameDetector::RESCAN_MS);
+            detector.Update();
+        }
+        double seconds = timer.Seconds();
+
+        std::printf("    %s\n", polling ? "polling every 50 ms (before)" : "window events (after)");
+        BenchReport("scans per minute", double(desktop.scans - scans), "");
+        BenchReport("detection time per minute", seconds * 1e6, "us");
+    }
+}
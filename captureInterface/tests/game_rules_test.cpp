@@ -0,0 +1,137 @@
+#include "test.h"
+#include "game_rules.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string folded(std::string_view s){
+    std::string out(s);
+    for (char& c: out) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+        if (c == '/') c = '\\';
+    }
+    return out;
+}
+
+// what the automaton and the name maps stand in for, every rule in turn.
+// patterns have to be folded already
+static GameMatch naiveMatch(const std::vector<GameRule>& rules, std::string_view path, std::string_view windowClass){
+    std::string p = folded(path);
+    std::size_t sep = p.find_last_of('\\');
+    std::string exe = sep == std::string::npos ? p : p.substr(sep + 1);
+    std::string cls = folded(windowClass);
+
+    const GameRule* best = nullptr;
+    for (const GameRule& rule: rules) {
+        const std::string& pattern = rule.pattern;
+        bool hit = rule.kind == RULE_PATH ? p.find(pattern) != std::string::npos :
+            rule.kind == RULE_EXE ? exe == pattern : !cls.empty() && cls == pattern;
+        if (!hit) continue;
+        if (rule.ignore) return GameMatch{};
+        if (best == nullptr || rule.confidence > best->confidence) best = &rule;
+    }
+    return best == nullptr ? GameMatch{} : GameMatch{ .rule = best, .confidence = best->confidence };
+}
+
+static std::vector<GameRule> foldedRules(std::vector<GameRule> rules){
+    for (GameRule& rule: rules) rule.pattern = folded(rule.pattern);
+    return rules;
+}
+
+// count rules in equal parts path, exe and class, one in fifty an ignore
+// rule, all with distinct confidences so the best match is unambiguous
+static std::vector<GameRule> makeRules(int count, std::mt19937& rng){
+    std::vector<GameRule> rules;
+    rules.reserve(count);
+    for (int i = 0; i < count; i++) {
+        std::string name = "Game" + std::to_string(rng() % (count * 4));
+        float confidence = 0.1f + 0.8f * float(i) / float(count);
+        bool ignore = i % 50 == 49;
+        if (i % 3 == 0) rules.push_back(GameRule{ RULE_PATH, "\\" + name + "\\", confidence, ignore });
+        else if (i % 3 == 1) rules.push_back(GameRule{ RULE_EXE, name + ".exe", confidence, ignore });
+        else rules.push_back(GameRule{ RULE_CLASS, name + "Window", confidence, ignore });
+    }
+    return rules;
+}
+
+// paths and classes that hit the rules about half of the time
+static void makeQueries(int count, int rules, std::mt19937& rng, std::vector<std::string>& paths, std::vector<std::string>& classes){
+    for (int i = 0; i < count; i++) {
+        std::string name = "game" + std::to_string(rng() % (rules * 4));
+        paths.push_back("C:/Program Files (x86)/Steam/steamapps/common/" + name + "/Binaries/Win64/" + name + ".EXE");
+        classes.push_back(i % 2 ? name + "window" : "UnityWndClass");
+    }
+}
+
+TEST(game_rules, matches_paths_names_and_classes){
+    GAMERULES.Compile({
+        GameRule{ RULE_PATH, "\\SteamApps\\", 0.6f, false },
+        GameRule{ RULE_EXE, "quake.exe", 0.9f, false },
+        GameRule{ RULE_CLASS, "UnrealWindow", 0.8f, false },
+        GameRule{ RULE_EXE, "steamwebhelper.exe", 0.0f, true },
+    });
+
+    GameMatch m = GAMERULES.Match("D:/steamapps/common/Quake/QUAKE.EXE", "");
+    CHECK(m.Matched());
+    CHECK(m.confidence == 0.9f);
+    CHECK(GAMERULES.Match("D:\\SteamApps\\common\\x\\x.exe", "").confidence == 0.6f);
+    CHECK(GAMERULES.Match("C:\\x\\shooter.exe", "UnrealWindow").confidence == 0.8f);
+    // an ignore rule beats everything else
+    CHECK(!GAMERULES.Match("D:\\steamapps\\steamwebhelper.exe", "UnrealWindow").Matched());
+    CHECK(!GAMERULES.Match("C:\\Windows\\explorer.exe", "CabinetWClass").Matched());
+    CHECK(!GAMERULES.Match("", "").Matched());
+}
+
+TEST(game_rules, agrees_with_checking_every_rule){
+    std::mt19937 rng(81);
+    std::vector<GameRule> rules = makeRules(3000, rng);
+    GAMERULES.Compile(rules);
+    rules = foldedRules(rules);
+
+    std::vector<std::string> paths, classes;
+    makeQueries(5000, 3000, rng, paths, classes);
+    int matched = 0;
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        GameMatch fast = GAMERULES.Match(paths[i], classes[i]);
+        GameMatch slow = naiveMatch(rules, paths[i], classes[i]);
+        CHECK(fast.Matched() == slow.Matched());
+        CHECK(fast.confidence == slow.confidence);
+        matched += fast.Matched();
+    }
+    // both outcomes are covered
+    CHECK(matched > 500 && matched < 4500);
+}
+
+// matches per second against 10k rules, the compiled rules against checking
+// every rule in turn
+BENCH(game_rules_10k){
+    const int count = 10000;
+    std::mt19937 rng(10000);
+    std::vector<GameRule> rules = makeRules(count, rng);
+    std::vector<std::string> paths, classes;
+    makeQueries(2000, count, rng, paths, classes);
+
+    BenchTimer compile;
+    GAMERULES.Compile(rules);
+    BenchReport("compile", compile.Seconds() * 1e3, "ms");
+
+    uint64_t allocations = TestAllocations();
+    int rounds = 50;
+    int hits = 0;
+    BenchTimer fast;
+    for (int r = 0; r < rounds; r++) {
+        for (std::size_t i = 0; i < paths.size(); i++) hits += GAMERULES.Match(paths[i], classes[i]).Matched();
+    }
+    double fastRate = rounds * paths.size() / fast.Seconds();
+    BenchReport("compiled matches", fastRate, "/s");
+    BenchReport("allocations per match", double(TestAllocations() - allocations) / (rounds * paths.size()), "");
+
+    rules = foldedRules(rules);
+    BenchTimer slow;
+    for (std::size_t i = 0; i < 200; i++) hits += naiveMatch(rules, paths[i], classes[i]).Matched();
+    double slowRate = 200 / slow.Seconds();
+    BenchReport("linear scan matches", slowRate, "/s");
+    BenchReport("speedup", fastRate / slowRate, "x");
+    if (hits == 0) std::printf("    no matches\n");
+}
@@ -0,0 +1,201 @@
+#include "test.h"
+#include "ipc_client.h"
+#include "ipc_server.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char* SOCKET_PATH = "ipc_server_test.sock";
+
+static int connectClient(){
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, SOCKET_PATH);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const std::string& data){
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        ssize_t put = ::send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+        if (put <= 0) return false;
+        pos += static_cast<std::size_t>(put);
+    }
+    return true;
+}
+
+// everything until the server closes the connection
+static std::string readAll(int fd){
+    std::string in;
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t got = ::read(fd, chunk, sizeof(chunk));
+        if (got <= 0) break;
+        in.append(chunk, static_cast<std::size_t>(got));
+    }
+    return in;
+}
+
+struct Message {
+    IpcHeader header;
+    std::string payload;
+};
+
+static std::vector<Message> parse(const std::string& in){
+    std::vector<Message> messages;
+    std::size_t pos = 0;
+    while (in.size() - pos >= sizeof(uint32_t) + sizeof(IpcHeader)) {
+        uint32_t length;
+        std::memcpy(&length, in.data() + pos, sizeof(length));
+        if (in.size() - pos - sizeof(uint32_t) < length) break;
+        Message m;
+        std::memcpy(&m.header, in.data() + pos + sizeof(uint32_t), sizeof(IpcHeader));
+        m.payload = in.substr(pos + sizeof(uint32_t) + sizeof(IpcHeader), length - sizeof(IpcHeader));
+        messages.push_back(std::move(m));
+        pos += sizeof(uint32_t) + length;
+    }
+    return messages;
+}
+
+TEST(ipc_server, answers_requests_sent_before_the_client_stopped_sending){
+    REQUIRE(IPCSERVER.Start(SOCKET_PATH));
+    int fd = connectClient();
+    REQUIRE(fd >= 0);
+
+    // more than the socket buffers hold, most of it is still queued when
+    // the server sees the end of the stream
+    const int REQUESTS = 16;
+    std::string out;
+    for (int i = 0; i < REQUESTS; i++) IpcFrame(out, i + 1, IPC_PING, 0, std::string(200000, char('a' + i)));
+    REQUIRE(sendAll(fd, out));
+    ::shutdown(fd, SHUT_WR);
+
+    std::vector<Message> responses = parse(readAll(fd));
+    ::close(fd);
+    IPCSERVER.Stop();
+
+    REQUIRE(responses.size() == REQUESTS);
+    for (int i = 0; i < REQUESTS; i++) {
+        CHECK(responses[i].header.id == uint32_t(i + 1));
+        CHECK(responses[i].header.status == IPC_OK);
+        CHECK(responses[i].payload == std::string(200000, char('a' + i)));
+    }
+}
+
+// a ping answered means the server has listed the connection
+static bool ping(int fd){
+    std::string out;
+    IpcFrame(out, 1, IPC_PING, 0, "ping");
+    char buf[sizeof(uint32_t) + sizeof(IpcHeader) + 4];
+    return sendAll(fd, out) && ::recv(fd, buf, sizeof(buf), MSG_WAITALL) == sizeof(buf);
+}
+
+TEST(ipc_server, drained_clients_are_let_go){
+    REQUIRE(IPCSERVER.Start(SOCKET_PATH));
+    for (int i = 0; i < 4; i++) {
+        int fd = connectClient();
+        REQUIRE(fd >= 0);
+        std::string out;
+        IpcFrame(out, 1, IPC_PING, 0, "ping");
+        REQUIRE(sendAll(fd, out));
+        ::shutdown(fd, SHUT_WR);
+        CHECK(parse(readAll(fd)).size() == 1);
+        ::close(fd);
+        // closed before the client saw the end of the stream, the threads
+        // are joined once they exit without waiting for another client
+        CHECK(IPCSERVER.Clients() == 0);
+    }
+
+    int fd = connectClient();
+    REQUIRE(fd >= 0);
+    REQUIRE(ping(fd));
+    CHECK(IPCSERVER.Clients() == 1);
+    ::close(fd);
+    IPCSERVER.Stop();
+}
+
+TEST(ipc_server, stop_closes_idle_clients){
+    REQUIRE(IPCSERVER.Start(SOCKET_PATH));
+    int fd = connectClient();
+    REQUIRE(fd >= 0);
+    REQUIRE(ping(fd));
+    REQUIRE(IPCSERVER.Clients() == 1);
+
+    IPCSERVER.Stop();
+    CHECK(readAll(fd).empty());
+    CHECK(IPCSERVER.Clients() == 0);
+    ::close(fd);
+}
+
+TEST(ipc_server, pushes_reach_subscribers){
+    REQUIRE(IPCSERVER.Start(SOCKET_PATH));
+    int fd = connectClient();
+    REQUIRE(fd >= 0);
+
+    std::string out, payload;
+    IpcWriter(payload).Put(uint32_t(IPC_TOPIC_GAMES));
+    IpcFrame(out, 1, IPC_SUBSCRIBE, 0, payload);
+    REQUIRE(sendAll(fd, out));
+    // the subscription is in place once its response arrives
+    char buf[sizeof(uint32_t) + sizeof(IpcHeader)];
+    REQUIRE(::read(fd, buf, sizeof(buf)) == sizeof(buf));
+
+    IPCSERVER.Publish(IPC_TOPIC_HIGHLIGHTS, IPC_PUSH_HIGHLIGHT, "not subscribed");
+    IPCSERVER.Publish(IPC_TOPIC_GAMES, IPC_PUSH_GAME, "game");
+    ::shutdown(fd, SHUT_WR);
+    std::vector<Message> pushes = parse(readAll(fd));
+    ::close(fd);
+    IPCSERVER.Stop();
+
+    REQUIRE(pushes.size() == 1);
+    CHECK(pushes[0].header.type == IPC_PUSH_GAME);
+    CHECK(pushes[0].payload == "game");
+}
+
+// round trips through IpcClient against the server in this process: one
+// ping at a time, then pings pipelined in batches of 64
+BENCH(ipc_round_trip){
+    REQUIRE(IPCSERVER.Start(SOCKET_PATH));
+    IpcClient client;
+    REQUIRE(client.Connect(SOCKET_PATH));
+    std::string payload(64, 'x');
+    IpcMessage msg;
+
+    const int SERIAL = 20000;
+    std::vector<double> latencies;
+    latencies.reserve(SERIAL);
+    for (int i = 0; i < SERIAL; i++) {
+        BenchTimer timer;
+        REQUIRE(client.Call(IPC_PING, payload, msg));
+        latencies.push_back(timer.Seconds() * 1e6);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    BenchReport("serial round trip p50", latencies[SERIAL / 2], "us");
+    BenchReport("serial round trip p99", latencies[SERIAL * 99 / 100], "us");
+
+    const int BATCH = 64;
+    const int BATCHES = 2000;
+    int received = 0;
+    BenchTimer pipelined;
+    for (int b = 0; b < BATCHES; b++) {
+        for (int i = 0; i < BATCH; i++) client.Queue(IPC_PING, payload);
+        REQUIRE(client.Flush());
+        for (int i = 0; i < BATCH; i++) received += client.Receive(msg) && msg.payload.size() == payload.size();
+    }
+    double seconds = pipelined.Seconds();
+    CHECK(received == BATCH * BATCHES);
+    BenchReport("pipelined, batches of 64", received / seconds, "pings/s");
+
+    client.Close();
+    IPCSERVER.Stop();
+}
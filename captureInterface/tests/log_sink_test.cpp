@@ -0,0 +1,118 @@
+#include "test.h"
+#include "log_sink.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class TempDir {
+
+public:
+    fs::path path;
+
+    explicit TempDir(const char* name): path(fs::temp_directory_path() / name) {
+        fs::remove_all(this->path);
+        fs::create_directories(this->path);
+    }
+    ~TempDir(){ fs::remove_all(this->path); }
+
+    // segment contents in the order they were written
+    std::vector<std::string> Segments() const {
+        std::vector<std::pair<int, std::string>> found;
+        for (const auto& entry: fs::directory_iterator(this->path)) {
+            std::string name = entry.path().stem().string();
+            int index = std::stoi(name.substr(name.rfind('-') + 1));
+            std::ifstream in(entry.path(), std::ios::binary);
+            found.emplace_back(index, std::string(std::istreambuf_iterator<char>(in), {}));
+        }
+        std::sort(found.begin(), found.end());
+        std::vector<std::string> out;
+        for (auto& f: found) out.push_back(std::move(f.second));
+        return out;
+    }
+};
+
+TEST(log_sink, rotates_full_segments){
+    TempDir dir("macroscale_log_sink_rotate");
+    LogSink sink;
+    LogSink::Options options;
+    options.baseName = (dir.path / "log").string();
+    options.segmentSize = 64;
+    REQUIRE(sink.Open(options));
+
+    std::string written;
+    for (int i = 0; i < 10; i++) {
+        std::string line = "line " + std::to_string(i) + " of the log.\n";
+        sink.Write(line.data(), line.size());
+        written += line;
+    }
+    sink.Close();
+
+    std::vector<std::string> segments = dir.Segments();
+    CHECK(segments.size() == 4);
+    std::string joined;
+    for (const std::string& segment: segments) {
+        // lines never straddle two segments and the preallocated tail is gone
+        CHECK(!segment.empty() && segment.size() <= 64 && segment.back() == '\n');
+        joined += segment;
+    }
+    CHECK(joined == written);
+}
+
+TEST(log_sink, truncates_the_last_segment){
+    TempDir dir("macroscale_log_sink_close");
+    {
+        LogSink sink;
+        LogSink::Options options;
+        options.baseName = (dir.path / "log").string();
+        REQUIRE(sink.Open(options));
+        sink.Write("hello\n", 6);
+    }
+    std::vector<std::string> segments = dir.Segments();
+    REQUIRE(segments.size() == 1);
+    CHECK(segments[0] == "hello\n");
+}
+
+TEST(log_sink, cuts_off_writes_larger_than_a_segment){
+    TempDir dir("macroscale_log_sink_large");
+    LogSink sink;
+    LogSink::Options options;
+    options.baseName = (dir.path / "log").string();
+    options.segmentSize = 64;
+    REQUIRE(sink.Open(options));
+
+    std::string large(100, 'x');
+    sink.Write(large.data(), large.size());
+    sink.Write("after\n", 6);
+    sink.Close();
+
+    std::vector<std::string> segments = dir.Segments();
+    REQUIRE(segments.size() == 2);
+    CHECK(segments[0] == std::string(64, 'x'));
+    CHECK(segments[1] == "after\n");
+}
+
+TEST(log_sink, never_reuses_an_existing_segment){
+    TempDir dir("macroscale_log_sink_exclusive");
+    LogSink::Options options;
+    options.baseName = (dir.path / "log").string();
+    LogSink first;
+    LogSink second;
+    REQUIRE(first.Open(options));
+    first.Write("first\n", 6);
+    // the second sink starts on the same name and has to move past it
+    REQUIRE(second.Open(options));
+    second.Write("second\n", 7);
+    second.Close();
+    first.Close();
+
+    std::vector<std::string> segments = dir.Segments();
+    REQUIRE(segments.size() == 2);
+    CHECK(segments[0] == "first\n");
+    CHECK(segments[1] == "second\n");
+}
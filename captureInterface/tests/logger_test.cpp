@@ -0,0 +1,103 @@
+#include "test.h"
+#include "logger.h"
+
+#include <iostream>
+#include <sstream>
+
+// the console would dominate the timings, the sink still gets every line
+class ConsoleOff {
+
+public:
+    ConsoleOff(){ std::cout.setstate(std::ios::badbit); }
+    ~ConsoleOff(){ std::cout.clear(); }
+};
+
+// what the logger prints while it exists
+class ConsoleCapture {
+
+public:
+    std::ostringstream text;
+
+    ConsoleCapture(): old(std::cout.rdbuf(text.rdbuf())) {};
+    ~ConsoleCapture(){ std::cout.rdbuf(this->old); }
+
+private:
+    std::streambuf* old;
+};
+
+static int count(const std::string& text, const std::string& what){
+    int n = 0;
+    for (std::size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) n++;
+    return n;
+}
+
+TEST(logger, flushes_suppressed_counts){
+    // whatever earlier suites left behind when they all run together
+    SLOG.flushSuppressed();
+    ConsoleCapture console;
+    static LogRateLimit limit(1, std::chrono::seconds(60));
+    for (int i = 0; i < 5; i++) SLOG.info(limit, "window {} detected", i);
+
+    CHECK(count(console.text.str(), "window 0 detected") == 1);
+    SLOG.flushSuppressed();
+    CHECK(count(console.text.str(), "suppressed 4 messages like \"window {} detected\"") == 1);
+
+    // nothing new to report
+    SLOG.flushSuppressed();
+    CHECK(count(console.text.str(), "suppressed") == 1);
+}
+
+TEST(logger, flushes_when_a_limit_goes_away){
+    SLOG.flushSuppressed();
+    ConsoleCapture console;
+    {
+        LogRateLimit limit(2, std::chrono::seconds(60));
+        for (int i = 0; i < 10; i++) SLOG.error(limit, "plugin error {}", i);
+    }
+    CHECK(count(console.text.str(), "suppressed 8 messages like \"plugin error {}\"") == 1);
+    // and the logger no longer knows about it
+    SLOG.flushSuppressed();
+    CHECK(count(console.text.str(), "suppressed") == 1);
+}
+
+TEST(logger, logs_without_allocating){
+    ConsoleOff quiet;
+    std::string name = "capture";
+    // the first line per thread sets up the buffers
+    SLOG.info("warm up {}", 1);
+
+    static LogRateLimit limit(2, std::chrono::seconds(60));
+    uint64_t before = TestAllocations();
+    for (int i = 0; i < 1000; i++) {
+        SLOG.info("frame {} of {} took {:.2f} ms", i, name, 16.6);
+        SLOG.error(limit, "dropped frame {}", i);
+    }
+    CHECK(TestAllocations() == before);
+}
+
+TEST(logger, truncates_long_lines_without_allocating){
+    ConsoleOff quiet;
+    std::string long_text(4096, 'x');
+    SLOG.info("warm up {}", 1);
+
+    uint64_t before = TestAllocations();
+    SLOG.info("{} {}", long_text, long_text);
+    CHECK(TestAllocations() == before);
+}
+
+BENCH(logger_lines){
+    ConsoleOff quiet;
+    const int count = 1000000;
+    SLOG.info("warm up {}", 1);
+
+    uint64_t before = TestAllocations();
+    BenchTimer timer;
+    for (int i = 0; i < count; i++) {
+        SLOG.info("frame {} encoded in {:.2f} ms, {} bytes", i, 4.2, 65536);
+    }
+    double seconds = timer.Seconds();
+
+    BenchReport("lines", count / seconds, "lines/s");
+    BenchReport("time per line", seconds / count * 1e9, "ns");
+    BenchReport("allocations per line", double(TestAllocations() - before) / count, "");
+}
@@ -0,0 +1,160 @@
+#include "test.h"
+#include "loudness_detector.h"
+
+#include <cmath>
+#include <ctime>
+#include <random>
+#include <vector>
+
+static const uint32_t RATE = 48000;
+static const int64_t SECOND = 1000000;
+
+// stereo noise with the amplitude of each section, seconds long
+struct Section {
+    double seconds;
+    float amplitude;
+};
+
+static std::vector<float> noise(std::initializer_list<Section> sections){
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<float> samples;
+    for (const Section& s: sections) {
+        std::size_t frames = std::size_t(s.seconds * RATE);
+        for (std::size_t i = 0; i < frames * 2; i++) samples.push_back(s.amplitude * uniform(rng));
+    }
+    return samples;
+}
+
+// onsets are one block long, loud sections longer
+static bool isSection(const HighlightMarker& m){
+    return m.durationMs > LoudnessOptions().blockMs;
+}
+
+static std::vector<HighlightMarker> sections(const std::vector<HighlightMarker>& markers){
+    std::vector<HighlightMarker> out;
+    for (const HighlightMarker& m: markers) {
+        if (isSection(m)) out.push_back(m);
+    }
+    return out;
+}
+
+TEST(loudness_detector, finds_a_loud_burst_and_its_onset){
+    // 20 dB louder for 2 seconds
+    std::vector<float> audio = noise({ {10, 0.01f}, {2, 0.1f}, {10, 0.01f} });
+    LoudnessDetector detector;
+    std::vector<HighlightMarker> markers;
+    detector.Process(audio.data(), audio.size() / 2, 0, markers);
+
+    std::vector<HighlightMarker> loud = sections(markers);
+    REQUIRE(loud.size() == 1);
+    // starts a window before it was noticed, ends once the window is quiet again
+    CHECK(loud[0].time >= 10 * SECOND - SECOND / 2 && loud[0].time <= 10 * SECOND);
+    int64_t end = loud[0].time + int64_t(loud[0].durationMs) * 1000;
+    CHECK(end >= 12 * SECOND && end <= 12 * SECOND + SECOND / 2);
+    CHECK(loud[0].score > 0.5f);
+
+    REQUIRE(markers.size() == 2);
+    const HighlightMarker& onset = isSection(markers[0]) ? markers[1] : markers[0];
+    CHECK(std::llabs(onset.time - 10 * SECOND) <= 10000);
+}
+
+TEST(loudness_detector, quiet_and_silent_audio_have_no_markers){
+    std::vector<float> audio = noise({ {10, 0.01f}, {5, 0.0f}, {10, 0.012f} });
+    LoudnessDetector detector;
+    std::vector<HighlightMarker> markers;
+    detector.Process(audio.data(), audio.size() / 2, 0, markers);
+    CHECK(sections(markers).empty());
+}
+
+TEST(loudness_detector, a_lasting_step_becomes_the_baseline){
+    // 14 dB louder for good, the baseline is held while loud and would
+    // never catch up without the cap
+    std::vector<float> audio = noise({ {5, 0.01f}, {120, 0.05f} });
+    LoudnessDetector detector;
+    std::vector<HighlightMarker> markers;
+    detector.Process(audio.data(), audio.size() / 2, 0, markers);
+
+    std::vector<HighlightMarker> loud = sections(markers);
+    REQUIRE(loud.size() == 1);
+    CHECK(loud[0].durationMs >= LoudnessOptions().maxLoudMs);
+    CHECK(loud[0].durationMs < LoudnessOptions().maxLoudMs + 100);
+    CHECK(std::fabs(detector.ShortTermDb() - detector.BaselineDb()) < 1.0f);
+
+    // and louder than that is loud again
+    std::vector<float> more = noise({ {2, 0.5f}, {5, 0.05f} });
+    markers.clear();
+    detector.Process(more.data(), more.size() / 2, 125 * SECOND, markers);
+    CHECK(sections(markers).size() == 1);
+}
+
+TEST(loudness_detector, chunking_does_not_change_the_markers){
+    std::vector<float> audio = noise({ {5, 0.01f}, {1, 0.2f}, {3, 0.01f}, {0.5, 0.3f}, {3, 0.01f} });
+    LoudnessDetector whole;
+    std::vector<HighlightMarker> expected;
+    whole.Process(audio.data(), audio.size() / 2, 0, expected);
+    REQUIRE(sections(expected).size() == 2);
+
+    // odd chunk sizes, blocks straddle the calls
+    std::mt19937 rng(3);
+    LoudnessDetector chunked;
+    std::vector<HighlightMarker> markers;
+    std::size_t frames = audio.size() / 2;
+    for (std::size_t pos = 0; pos < frames;) {
+        std::size_t n = std::min<std::size_t>(frames - pos, 1 + rng() % 3000);
+        chunked.Process(audio.data() + pos * 2, n, int64_t(pos) * SECOND / RATE, markers);
+        pos += n;
+    }
+
+    REQUIRE(markers.size() == expected.size());
+    for (std::size_t i = 0; i < markers.size(); i++) {
+        // timestamps are rounded per call
+        CHECK(std::llabs(markers[i].time - expected[i].time) <= 2);
+        CHECK(markers[i].score == expected[i].score);
+    }
+}
+
+TEST(loudness_detector, block_stats_match_a_plain_loop){
+    std::vector<float> audio = noise({ {0.01, 0.5f} });
+    for (std::size_t n: { 0, 1, 7, 8, 9, 480, 961 }) {
+        float meanSquare, peak;
+        AudioBlockStats(audio.data(), n, meanSquare, peak);
+        double sum = 0.0;
+        float max = 0.0f;
+        for (std::size_t i = 0; i < n; i++) {
+            sum += double(audio[i]) * audio[i];
+            max = std::max(max, std::fabs(audio[i]));
+        }
+        CHECK(std::fabs(meanSquare - float(n == 0 ? 0.0 : sum / n)) < 1e-6f);
+        CHECK(peak == max);
+    }
+}
+
+// the capture thread feeds 10 ms periods, the detector is meant to stay under
+// 1% of a core
+BENCH(loudness_detection){
+    std::vector<float> audio = noise({ {20, 0.01f}, {2, 0.1f}, {20, 0.01f}, {0.5, 0.3f}, {17.5, 0.01f} });
+    std::size_t frames = audio.size() / 2;
+    const std::size_t PERIOD = RATE / 100;
+    const int RUNS = 10;
+
+    std::size_t found = 0;
+    std::clock_t start = std::clock();
+    for (int run = 0; run < RUNS; run++) {
+        LoudnessDetector detector;
+        std::vector<HighlightMarker> markers;
+        for (std::size_t pos = 0; pos < frames; pos += PERIOD) {
+            std::size_t n = std::min(PERIOD, frames - pos);
+            detector.Process(audio.data() + pos * 2, n, int64_t(pos) * SECOND / RATE, markers);
+        }
+        found = sections(markers).size();
+    }
+    double cpuSeconds = double(std::clock() - start) / CLOCKS_PER_SEC;
+    double audioSeconds = double(frames) / RATE * RUNS;
+
+    double micros = cpuSeconds / audioSeconds * 1e6;
+    BenchReport("cpu per second of 48 kHz stereo", micros, "us");
+    // 1% of a core is 10 ms per second
+    BenchReport("under the 1% budget by", 10000.0 / micros, "x");
+    CHECK(found == 2);
+}
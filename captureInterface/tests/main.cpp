@@ -0,0 +1,92 @@
+#include "test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static int failures = 0;
+static thread_local uint64_t allocations = 0;
+
+// counts allocations for TestAllocations. the array and nothrow variants
+// are replaced too, the sanitizers would otherwise hand out memory that
+// our delete frees with free()
+void* operator new(std::size_t size){
+    allocations++;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size){
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocations++;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+uint64_t TestAllocations(){
+    return allocations;
+}
+
+std::vector<TestCase>& TestCases(){
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+void TestFail(const char* file, int line, const char* expr){
+    std::printf("    %s:%d: CHECK(%s) failed\n", file, line, expr);
+    failures++;
+}
+
+// macroscaleTests [suite]
+// macroscaleTests --bench [name]
+int main(int argc, char** argv){
+    bool bench = argc > 1 && std::strcmp(argv[1], "--bench") == 0;
+    const char* filter = argc > (bench ? 2 : 1) ? argv[bench ? 2 : 1] : nullptr;
+
+    int ran = 0;
+    int failed = 0;
+    for (const TestCase& test: TestCases()) {
+        if (test.bench != bench) continue;
+        if (filter != nullptr && std::strcmp(filter, bench ? test.name : test.suite) != 0) continue;
+
+        std::printf("%s.%s\n", test.suite, test.name);
+        std::fflush(stdout);
+        int before = failures;
+        test.run();
+        ran++;
+        if (failures != before) failed++;
+    }
+
+    std::printf("%d %s, %d failed\n", ran, bench ? "benchmarks" : "tests", failed);
+    return ran == 0 || failed > 0 ? 1 : 0;
+}
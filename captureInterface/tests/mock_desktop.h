@@ -0,0 +1,111 @@
+#ifndef MOCK_DESKTOP_H
+#define MOCK_DESKTOP_H
+
+#include "process_cache.h"
+#include "window_system.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A desktop for GameDetector and TargetScorer tests: windows are added and
+// closed by hand and time only moves when the test says so.
+class MockWindowSystem: public WindowSystem {
+
+public:
+    struct Window {
+        HWND hwnd;
+        DWORD pid;
+        std::string title;
+        std::string className;
+        WindowShape shape;
+    };
+
+    std::vector<Window> windows;
+    HWND foreground = nullptr;
+    uint64_t now = 1000;
+    uint64_t lastInput = 0;
+    uint64_t scans = 0;
+
+    static HWND Handle(uintptr_t id){ return reinterpret_cast<HWND>(id); }
+
+    Window& Open(uintptr_t id, DWORD pid, std::string title, std::string className = "Window"){
+        this->windows.push_back({ Handle(id), pid, std::move(title), std::move(className), WindowShape() });
+        return this->windows.back();
+    }
+
+    void Close(uintptr_t id){
+        this->windows.erase(std::remove_if(this->windows.begin(), this->windows.end(),
+            [&](const Window& w){ return w.hwnd == Handle(id); }), this->windows.end());
+    }
+
+    Window* Find(HWND hwnd){
+        for (Window& w: this->windows) if (w.hwnd == hwnd) return &w;
+        return nullptr;
+    }
+
+    void Scan(WindowSnapshot& snapshot) override {
+        this->scans++;
+        snapshot.Clear();
+        for (const Window& w: this->windows) snapshot.Add(w.hwnd, w.pid, w.title);
+        snapshot.Sort();
+    }
+
+    HWND Foreground() override { return this->foreground; }
+
+    // like GetClassNameA, cut off to fit with room for the terminator
+    std::size_t ClassName(HWND hwnd, char* buf, std::size_t size) override {
+        Window* w = this->Find(hwnd);
+        if (w == nullptr || size == 0) return 0;
+        std::size_t n = std::min(w->className.size(), size - 1);
+        std::memcpy(buf, w->className.data(), n);
+        buf[n] = '\0';
+        return n;
+    }
+
+    WindowShape Shape(HWND hwnd) override {
+        Window* w = this->Find(hwnd);
+        return w == nullptr ? WindowShape() : w->shape;
+    }
+
+    uint64_t NowMs() override { return this->now; }
+    uint64_t LastInputMs() override { return this->lastInput; }
+};
+
+// processes by pid, Exit stands in for the exit wait firing
+class MockProcessSource: public ProcessSource {
+
+public:
+    std::unordered_map<DWORD, std::string> paths;
+    std::unordered_map<DWORD, uint64_t> waits;
+    int opens = 0;
+    int closes = 0;
+
+    bool Open(DWORD pid, std::string& path, ProcessHandle&) override {
+        this->opens++;
+        auto it = this->paths.find(pid);
+        if (it == this->paths.end()) return false;
+        path.assign(it->second);
+        return true;
+    }
+
+    bool Watch(uint64_t waitId, ProcessHandle&) override {
+        this->waits[static_cast<DWORD>(waitId >> 32)] = waitId;
+        return true;
+    }
+
+    void Close(ProcessHandle&) override {
+        this->closes++;
+    }
+
+    void Exit(ProcessCache& cache, DWORD pid){
+        this->paths.erase(pid);
+        auto it = this->waits.find(pid);
+        if (it != this->waits.end()) cache.Exited(it->second);
+    }
+};
+
+#endif
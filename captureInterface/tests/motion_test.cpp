@@ -0,0 +1,68 @@
+#include "test.h"
+#include "motion.h"
+
+#include <vector>
+
+struct Scores {
+    std::vector<int64_t> times;
+    std::vector<float> values;
+};
+
+// a flat BGRA frame without row padding
+static std::vector<uint8_t> flat(uint32_t width, uint32_t height, uint8_t value){
+    return std::vector<uint8_t>(std::size_t(width) * height * 4, value);
+}
+
+TEST(motion, scores_against_the_previous_frame){
+    Scores scores;
+    MotionAnalyser analyser([&](int64_t time, float score) {
+        scores.times.push_back(time);
+        scores.values.push_back(score);
+    });
+    std::vector<uint8_t> black = flat(640, 360, 0), white = flat(640, 360, 255);
+
+    CHECK(analyser.Process(black.data(), 640, 360, 640 * 4, 1000) == 0.0f);
+    CHECK(analyser.Process(black.data(), 640, 360, 640 * 4, 2000) == 0.0f);
+    CHECK(analyser.Process(white.data(), 640, 360, 640 * 4, 3000) == 255.0f);
+
+    // every score reaches the listener
+    REQUIRE(scores.values.size() == 3);
+    CHECK(scores.times[2] == 3000);
+    CHECK(scores.values[2] == 255.0f);
+}
+
+TEST(motion, size_change_starts_over){
+    MotionAnalyser analyser;
+    std::vector<uint8_t> black = flat(640, 360, 0), white = flat(320, 180, 255);
+    analyser.Process(black.data(), 640, 360, 640 * 4, 1000);
+    CHECK(analyser.Process(white.data(), 320, 180, 320 * 4, 2000) == 0.0f);
+}
+
+TEST(motion, adds_scores_to_the_timeline){
+    MOTION.SetCapacity(16);
+    MotionAnalyser analyser;
+    std::vector<uint8_t> black = flat(64, 36, 0), white = flat(64, 36, 255);
+    for (int i = 0; i < 4; i++) {
+        const std::vector<uint8_t>& frame = i % 2 == 0 ? black : white;
+        analyser.Process(frame.data(), 64, 36, 64 * 4, 1000000 + i * 1000);
+    }
+
+    std::vector<MotionTimeline::Point> points = MOTION.Between(0, INT64_MAX);
+    REQUIRE(points.size() == 4);
+    CHECK(points[0].score == 0.0f);
+    CHECK(points[3].score == 255.0f);
+    CHECK(points[3].time == 1003000);
+}
+
+TEST(motion, warm_frames_dont_allocate){
+    MOTION.SetCapacity(16);
+    MotionAnalyser analyser;
+    std::vector<uint8_t> frame = flat(640, 360, 7);
+    // the two planes are allocated by the first two frames
+    analyser.Process(frame.data(), 640, 360, 640 * 4, 1000);
+    analyser.Process(frame.data(), 640, 360, 640 * 4, 1001);
+
+    uint64_t before = TestAllocations();
+    for (int i = 0; i < 10; i++) analyser.Process(frame.data(), 640, 360, 640 * 4, 2000 + i);
+    CHECK(TestAllocations() - before == 0);
+}
@@ -0,0 +1,97 @@
+#include "test.h"
+#include "onset_detector.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static const uint32_t RATE = 48000;
+static const int64_t SECOND = 1000000;
+// a frame's centre lands within half a frame and a hop of the click
+static const int64_t TOLERANCE = 25000;
+
+// quiet stereo noise with 5 ms decaying clicks at the given seconds
+static std::vector<float> clicks(double seconds, std::initializer_list<double> at){
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::size_t frames = std::size_t(seconds * RATE);
+    std::vector<float> samples(frames * 2);
+    for (float& s: samples) s = 0.001f * uniform(rng);
+    for (double t: at) {
+        std::size_t start = std::size_t(t * RATE);
+        for (std::size_t i = 0; i < RATE / 200 && start + i < frames; i++) {
+            float v = 0.5f * std::exp(-float(i) / 60.0f) * uniform(rng);
+            samples[2 * (start + i)] += v;
+            samples[2 * (start + i) + 1] += v;
+        }
+    }
+    return samples;
+}
+
+// fed in 50 ms calls, time of each call from timeOf(first frame)
+template <typename TimeOf>
+static std::vector<HighlightMarker> detect(const std::vector<float>& audio, TimeOf timeOf){
+    OnsetDetector detector;
+    std::vector<HighlightMarker> markers;
+    const std::size_t chunk = RATE / 20;
+    std::size_t frames = audio.size() / 2;
+    for (std::size_t pos = 0; pos < frames; pos += chunk) {
+        std::size_t n = std::min(chunk, frames - pos);
+        detector.Process(audio.data() + 2 * pos, n, timeOf(pos), markers);
+    }
+    return markers;
+}
+
+static int64_t frameTime(std::size_t frame){
+    return int64_t(frame) * SECOND / RATE;
+}
+
+TEST(onset_detector, finds_clicks_in_quiet_audio){
+    std::vector<float> audio = clicks(5.0, { 1.0, 2.5, 4.0 });
+    const int64_t base = 1000 * SECOND;
+    std::vector<HighlightMarker> markers = detect(audio, [base](std::size_t f) { return base + frameTime(f); });
+
+    REQUIRE(markers.size() == 3);
+    const double expected[3] = { 1.0, 2.5, 4.0 };
+    for (int i = 0; i < 3; i++) {
+        CHECK(std::llabs(markers[i].time - base - int64_t(expected[i] * SECOND)) <= TOLERANCE);
+        CHECK(markers[i].kind == MARKER_AUDIO);
+        CHECK(markers[i].score > 0.5f);
+    }
+}
+
+TEST(onset_detector, times_follow_the_callers_clock){
+    // the audio clock runs 0.5% fast against the steady clock, each call
+    // says when its audio really started
+    std::vector<float> audio = clicks(60.0, { 10.0, 59.0 });
+    std::vector<HighlightMarker> markers = detect(audio, [](std::size_t f) { return frameTime(f) * 1005 / 1000; });
+
+    REQUIRE(markers.size() == 2);
+    CHECK(std::llabs(markers[0].time - 10 * SECOND * 1005 / 1000) <= TOLERANCE);
+    // counting samples alone would be 295 ms off by now
+    CHECK(std::llabs(markers[1].time - 59 * SECOND * 1005 / 1000) <= TOLERANCE);
+}
+
+TEST(onset_detector, starts_over_after_a_gap){
+    // analysis fell behind and skipped 10 s after the first 3 s
+    std::vector<float> audio = clicks(6.0, { 1.0, 4.0 });
+    std::vector<HighlightMarker> markers = detect(audio, [](std::size_t f) {
+        int64_t t = frameTime(f);
+        return t < 3 * SECOND ? t : t + 10 * SECOND;
+    });
+
+    REQUIRE(markers.size() == 2);
+    CHECK(std::llabs(markers[0].time - 1 * SECOND) <= TOLERANCE);
+    CHECK(std::llabs(markers[1].time - 14 * SECOND) <= TOLERANCE);
+}
+
+BENCH(onset_detection){
+    std::vector<float> audio = clicks(60.0, { 10.0, 20.0, 30.0, 40.0, 50.0 });
+    BenchTimer timer;
+    std::vector<HighlightMarker> markers = detect(audio, frameTime);
+    double seconds = timer.Seconds();
+    BenchReport("one minute of 48 kHz stereo", seconds * 1000.0, "ms");
+    BenchReport("faster than real time", 60.0 / seconds, "x");
+    CHECK(markers.size() == 5);
+}
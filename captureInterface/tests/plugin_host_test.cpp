@@ -0,0 +1,175 @@
+#include "test.h"
+#include "app_config.h"
+#include "plugin_host.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static void loadConfig(int instructions, int timeMs, int overrunWindowS){
+    std::ofstream f("plugins.ini", std::ios::trunc);
+    f << "[plugins]\ninstructions = " << instructions << "\ntime_ms = " << timeMs
+      << "\noverrun_window_s = " << overrunWindowS << "\n";
+    f.close();
+    CONFIG.Load("plugins.ini");
+}
+
+// replaces the plugin directory with these scripts and loads them, the
+// stats come back in the order of their names
+static void loadPlugins(const std::vector<std::pair<const char*, const char*>>& scripts){
+    std::filesystem::remove_all("plugins");
+    std::filesystem::create_directory("plugins");
+    for (const auto& [name, script]: scripts) {
+        std::ofstream f(std::string("plugins/") + name + ".lua", std::ios::trunc);
+        f << script;
+    }
+    PLUGINS.Load("plugins");
+}
+
+static PluginStats stats(std::size_t index){
+    std::vector<PluginStats> all = PLUGINS.Stats();
+    return index < all.size() ? all[index] : PluginStats{};
+}
+
+// the worker runs the callbacks, waits until the plugin made that many calls,
+// its top level chunk included
+static bool waitForCalls(std::size_t index, uint64_t calls){
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (stats(index).calls < calls) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static void postHotkey(){
+    PLUGINS.Post(PluginEvent{ .type = PLUGIN_HOTKEY, .time = 0, .value = 0.0f, .id = 1, .name = {} });
+}
+
+TEST(plugin_host, stops_an_infinite_loop){
+    loadConfig(1000000, 5, 60);
+    loadPlugins({ { "loop", "plugin.on('hotkey', function() while true do end end)\n" } });
+    REQUIRE(stats(0).calls == 1);
+
+    postHotkey();
+    REQUIRE(waitForCalls(0, 2));
+    PluginStats s = stats(0);
+    CHECK(s.overruns == 1);
+    CHECK(s.errors == 0);
+    CHECK(s.enabled);
+
+    // an overrun is only counted, the next event runs the callback again
+    postHotkey();
+    REQUIRE(waitForCalls(0, 3));
+    CHECK(stats(0).overruns == 2);
+    PLUGINS.Stop();
+}
+
+TEST(plugin_host, pcall_does_not_swallow_an_overrun){
+    loadConfig(1000000, 5, 60);
+    loadPlugins({ { "catch",
+        "plugin.on('hotkey', function()\n"
+        "    while true do pcall(function() while true do end end) end\n"
+        "end)\n" } });
+
+    postHotkey();
+    REQUIRE(waitForCalls(0, 2));
+    PluginStats s = stats(0);
+    CHECK(s.overruns == 1);
+    CHECK(s.enabled);
+    PLUGINS.Stop();
+}
+
+TEST(plugin_host, allocations_stop_at_the_memory_cap){
+    // only the memory cap stops this one
+    loadConfig(2000000000, 60000, 60);
+    loadPlugins({ { "hoard",
+        "local hoard = {}\n"
+        "plugin.on('hotkey', function()\n"
+        "    for i = 1, 100000000 do hoard[i] = string.rep('x', 1024) .. i end\n"
+        "end)\n"
+        "plugin.on('onset', function() hoard = {} collectgarbage() end)\n" } });
+
+    postHotkey();
+    REQUIRE(waitForCalls(0, 2));
+    PluginStats s = stats(0);
+    CHECK(s.errors == 1);
+    CHECK(s.overruns == 0);
+    CHECK(s.memoryBytes > 32 * 1024 * 1024);
+    CHECK(s.memoryBytes <= 64 * 1024 * 1024);
+
+    // the state survives the memory error and gets its memory back
+    PLUGINS.Post(PluginEvent{ .type = PLUGIN_ONSET, .time = 0, .value = 1.0f, .id = 0, .name = {} });
+    REQUIRE(waitForCalls(0, 3));
+    s = stats(0);
+    CHECK(s.errors == 1);
+    CHECK(s.memoryBytes < 1024 * 1024);
+    PLUGINS.Stop();
+}
+
+TEST(plugin_host, post_does_not_wait_for_a_stuck_plugin){
+    loadConfig(2000000000, 500, 60);
+    loadPlugins({ { "stuck",
+        "plugin.on('hotkey', function() while true do end end)\n"
+        "plugin.on('onset', function() end)\n" } });
+    uint64_t dropped = PLUGINS.Dropped();
+
+    postHotkey();
+    // the worker is in the callback for the next 500 ms
+    const int POSTS = 1000;
+    int64_t slowest = 0;
+    for (int i = 0; i < POSTS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        PLUGINS.Post(PluginEvent{ .type = PLUGIN_ONSET, .time = 0, .value = 0.5f, .id = 0, .name = {} });
+        int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        slowest = std::max(slowest, micros);
+    }
+    // a lock and a push, far below the stuck callback even under sanitizers
+    CHECK(slowest < 50000);
+    // the queue holds 256 events, the hotkey may still be one of them
+    CHECK(PLUGINS.Dropped() - dropped >= POSTS - 256);
+    CHECK(stats(0).calls == 1);
+
+    // the queued onsets run once the callback is stopped
+    REQUIRE(waitForCalls(0, 2 + 255));
+    CHECK(stats(0).overruns == 1);
+    PLUGINS.Stop();
+}
+
+TEST(plugin_host, disables_plugins_overrunning_within_the_window){
+    // the first hook past 1000 instructions stops the callback
+    loadConfig(1000, 1000, 1);
+    loadPlugins({
+        { "a_loop", "plugin.on('hotkey', function() while true do end end)\n" },
+        { "b_count", "local n = 0\nplugin.on('hotkey', function() n = n + 1 end)\n" },
+    });
+
+    for (int i = 0; i < 9; i++) postHotkey();
+    REQUIRE(waitForCalls(1, 1 + 9));
+    CHECK(stats(0).overruns == 9);
+    CHECK(stats(0).enabled);
+
+    // the first nine overruns leave the window
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    for (int i = 0; i < 9; i++) postHotkey();
+    REQUIRE(waitForCalls(1, 1 + 18));
+    CHECK(stats(0).overruns == 18);
+    CHECK(stats(0).enabled);
+
+    // ten within a second
+    postHotkey();
+    REQUIRE(waitForCalls(1, 1 + 19));
+    CHECK(stats(0).overruns == 19);
+    CHECK(!stats(0).enabled);
+
+    // the other plugin keeps running
+    postHotkey();
+    REQUIRE(waitForCalls(1, 1 + 20));
+    CHECK(stats(0).calls == 1 + 19);
+    CHECK(stats(1).enabled);
+    PLUGINS.Stop();
+}
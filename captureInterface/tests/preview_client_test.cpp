@@ -0,0 +1,195 @@
+#include "test.h"
+#include "preview_client.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// a preview laid out by hand the way preview_format.h describes it, shared
+// with the reader through a mapped file. Publish does what PreviewBuffer
+// does with the state word.
+class PreviewFile {
+
+public:
+    std::string path;
+    uint8_t* base = nullptr;
+    std::size_t size = 0;
+
+    explicit PreviewFile(const char* name): path((std::filesystem::current_path() / name).string()) {
+        const uint32_t bufferSize = (sizeof(PreviewFrameHeader) + PREVIEW_MAX_WIDTH * PREVIEW_MAX_HEIGHT * 4 + 63) & ~63u;
+        this->size = 64 + std::size_t(bufferSize) * PREVIEW_BUFFERS;
+        int fd = ::open(this->path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0 && ftruncate(fd, this->size) == 0) {
+            void* v = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (v != MAP_FAILED) this->base = static_cast<uint8_t*>(v);
+        }
+        if (fd >= 0) ::close(fd);
+        if (this->base == nullptr) return;
+
+        PreviewHeader* h = this->Header();
+        h->magic = PREVIEW_MAGIC;
+        h->version = PREVIEW_VERSION;
+        h->headerSize = sizeof(PreviewHeader);
+        h->bufferCount = PREVIEW_BUFFERS;
+        h->bufferSize = bufferSize;
+        h->buffersOffset = 64;
+        h->maxWidth = PREVIEW_MAX_WIDTH;
+        h->maxHeight = PREVIEW_MAX_HEIGHT;
+        h->state = PreviewState(PREVIEW_NONE, PREVIEW_NONE, false);
+    }
+    ~PreviewFile(){
+        if (this->base != nullptr) munmap(this->base, this->size);
+        std::filesystem::remove(this->path);
+    }
+
+    PreviewHeader* Header(){ return reinterpret_cast<PreviewHeader*>(this->base); }
+    uint32_t State(){ return std::atomic_ref<uint32_t>(this->Header()->state).load(); }
+
+    // frame n, every pixel byte set to n, returns the buffer it went to
+    uint32_t Publish(uint64_t n){
+        PreviewHeader* h = this->Header();
+        std::atomic_ref<uint32_t> state(h->state);
+        uint32_t current = state.load(std::memory_order_acquire);
+        uint32_t target = PreviewTarget(current);
+
+        uint8_t* b = this->base + h->buffersOffset + std::size_t(target) * h->bufferSize;
+        PreviewFrameHeader* f = reinterpret_cast<PreviewFrameHeader*>(b);
+        f->number = n;
+        f->time = static_cast<int64_t>(n) * 1000;
+        f->width = 64;
+        f->height = 36;
+        f->stride = 64 * 4;
+        f->format = FRAME_BGRA;
+        f->sourceWidth = 1920;
+        f->sourceHeight = 1080;
+        std::memset(b + sizeof(PreviewFrameHeader), static_cast<uint8_t>(n), 64 * 4 * 36);
+
+        while (!state.compare_exchange_weak(current, PreviewState(target, PreviewReading(current), true),
+            std::memory_order_release, std::memory_order_relaxed)) {}
+        return target;
+    }
+};
+
+// every pixel byte of the frame is the frame number's low byte
+static bool intact(const PreviewView& view){
+    for (std::size_t i = 0; i < std::size_t(view.stride) * view.height; i++) {
+        if (view.pixels[i] != static_cast<uint8_t>(view.number)) return false;
+    }
+    return true;
+}
+
+TEST(preview_client, nothing_before_the_first_frame){
+    PreviewFile file("preview_client_none");
+    REQUIRE(file.base != nullptr);
+    PreviewReader reader;
+    REQUIRE(reader.Open(file.path));
+
+    PreviewView view;
+    CHECK(!reader.Acquire(view));
+    CHECK(!reader.Acquire(view));
+    // the publisher still sees the polls
+    CHECK(file.Header()->readerPolls == 2);
+    CHECK(file.State() == PreviewState(PREVIEW_NONE, PREVIEW_NONE, false));
+}
+
+TEST(preview_client, swaps_in_fresh_frames){
+    PreviewFile file("preview_client_fresh");
+    REQUIRE(file.base != nullptr);
+    PreviewReader reader;
+    REQUIRE(reader.Open(file.path));
+
+    uint32_t first = file.Publish(1);
+    CHECK(file.State() == PreviewState(first, PREVIEW_NONE, true));
+
+    PreviewView view;
+    REQUIRE(reader.Acquire(view));
+    CHECK(view.number == 1 && view.width == 64 && view.height == 36 && view.sourceWidth == 1920);
+    CHECK(intact(view));
+    // the reader holds the newest buffer and the fresh bit is gone
+    CHECK(file.State() == PreviewState(first, first, false));
+
+    // nothing newer, the same frame again
+    REQUIRE(reader.Acquire(view));
+    CHECK(view.number == 1);
+
+    uint32_t second = file.Publish(2);
+    CHECK(second != first);
+    REQUIRE(reader.Acquire(view));
+    CHECK(view.number == 2 && intact(view));
+    CHECK(file.State() == PreviewState(second, second, false));
+}
+
+TEST(preview_client, a_held_frame_survives_later_publishes){
+    PreviewFile file("preview_client_held");
+    REQUIRE(file.base != nullptr);
+    PreviewReader reader;
+    REQUIRE(reader.Open(file.path));
+
+    file.Publish(1);
+    PreviewView held;
+    REQUIRE(reader.Acquire(held));
+    uint32_t reading = PreviewReading(file.State());
+
+    // the publisher keeps writing the other two buffers
+    for (uint64_t n = 2; n <= 8; n++) {
+        CHECK(file.Publish(n) != reading);
+        CHECK(PreviewReading(file.State()) == reading);
+        CHECK(held.number == 1 && intact(held));
+    }
+
+    PreviewView view;
+    REQUIRE(reader.Acquire(view));
+    CHECK(view.number == 8 && intact(view));
+}
+
+TEST(preview_client, rejects_a_frame_larger_than_its_buffer){
+    PreviewFile file("preview_client_large");
+    REQUIRE(file.base != nullptr);
+    PreviewReader reader;
+    REQUIRE(reader.Open(file.path));
+
+    uint32_t target = file.Publish(1);
+    PreviewFrameHeader* f = reinterpret_cast<PreviewFrameHeader*>(
+        file.base + file.Header()->buffersOffset + std::size_t(target) * file.Header()->bufferSize);
+    f->width = PREVIEW_MAX_WIDTH + 1;
+    PreviewView view;
+    CHECK(!reader.Acquire(view));
+}
+
+// a publisher thread against a reader that holds every frame for a while,
+// the held frame must never change underneath it. meant to run under
+// MACROSCALE_SANITIZE=thread as well.
+TEST(preview_client, frames_are_never_torn){
+    PreviewFile file("preview_client_stress");
+    REQUIRE(file.base != nullptr);
+    PreviewReader reader;
+    REQUIRE(reader.Open(file.path));
+
+    std::atomic<bool> done{false};
+    std::thread publisher([&]{
+        for (uint64_t n = 1; n <= 20000; n++) file.Publish(n);
+        done = true;
+    });
+
+    uint64_t torn = 0, last = 0;
+    PreviewView view;
+    while (!done.load()) {
+        if (!reader.Acquire(view)) continue;
+        if (view.number < last) torn++;
+        last = view.number;
+        // checked twice, before and after the publisher moved on
+        if (!intact(view)) torn++;
+        std::this_thread::yield();
+        if (!intact(view)) torn++;
+    }
+    publisher.join();
+    CHECK(torn == 0);
+
+    // the publisher may have been done before the reader got going
+    REQUIRE(reader.Acquire(view));
+    CHECK(view.number == 20000 && intact(view));
+}
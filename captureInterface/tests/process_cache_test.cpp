@@ -0,0 +1,137 @@
+#include "test.h"
+#include "mock_desktop.h"
+#include "process_cache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+TEST(process_cache, opens_a_process_once_until_it_exits){
+    MockProcessSource source;
+    ProcessCache cache(source);
+    source.paths[7] = "C:\\Games\\game.exe";
+
+    std::string path;
+    CHECK(cache.ImagePath(7, path));
+    CHECK(path == "C:\\Games\\game.exe");
+    CHECK(cache.ImagePath(7, path));
+    CHECK(source.opens == 1);
+    CHECK(cache.Size() == 1);
+
+    source.Exit(cache, 7);
+    CHECK(cache.Size() == 0);
+    CHECK(source.closes == 1);
+    CHECK(!cache.ImagePath(7, path));
+    CHECK(path.empty());
+}
+
+TEST(process_cache, peek_leaves_the_cache_alone){
+    MockProcessSource source;
+    ProcessCache cache(source);
+    source.paths[7] = "C:\\Windows\\notepad.exe";
+    source.paths[8] = "C:\\Games\\game.exe";
+
+    std::string path;
+    CHECK(cache.Peek(7, path));
+    CHECK(path == "C:\\Windows\\notepad.exe");
+    CHECK(cache.Size() == 0);
+    CHECK(source.closes == 1);
+
+    // a cached process is answered from the cache
+    cache.ImagePath(8, path);
+    int opens = source.opens;
+    CHECK(cache.Peek(8, path));
+    CHECK(path == "C:\\Games\\game.exe");
+    CHECK(source.opens == opens);
+}
+
+TEST(process_cache, drops_the_least_recently_used_past_its_capacity){
+    MockProcessSource source;
+    ProcessCache cache(source, 3);
+    for (DWORD pid = 1; pid <= 4; pid++) source.paths[pid] = "app" + std::to_string(pid) + ".exe";
+
+    std::string path;
+    cache.ImagePath(1, path);
+    cache.ImagePath(2, path);
+    cache.ImagePath(3, path);
+    // 1 is used again, so 2 goes
+    cache.ImagePath(1, path);
+    cache.ImagePath(4, path);
+    CHECK(cache.Size() == 3);
+    CHECK(source.closes == 1);
+
+    int opens = source.opens;
+    cache.ImagePath(1, path);
+    cache.ImagePath(3, path);
+    cache.ImagePath(4, path);
+    CHECK(source.opens == opens);
+    cache.ImagePath(2, path);
+    CHECK(source.opens == opens + 1);
+    CHECK(path == "app2.exe");
+}
+
+TEST(process_cache, a_dropped_entry_ignores_its_old_exit_wait){
+    MockProcessSource source;
+    ProcessCache cache(source, 1);
+    source.paths[1] = "one.exe";
+    source.paths[2] = "two.exe";
+
+    std::string path;
+    cache.ImagePath(1, path);
+    uint64_t oldWait = source.waits[1];
+    cache.ImagePath(2, path);
+    cache.ImagePath(1, path);
+    // the wait of the evicted entry fires late
+    cache.Exited(oldWait);
+    CHECK(cache.Size() == 1);
+    CHECK(cache.ImagePath(1, path));
+    CHECK(source.opens == 3);
+}
+
+// a window scan over a desktop of 500 windows from the processes running
+// here: the image path of every window opened through the native source
+// each time (before) and resolved through ImagePath (after)
+BENCH(process_cache_window_scan){
+    std::vector<DWORD> pids;
+    std::string path;
+    ProcessHandle handle;
+    for (const auto& entry: std::filesystem::directory_iterator("/proc")) {
+        const std::string name = entry.path().filename().string();
+        if (name.find_first_not_of("0123456789") != std::string::npos) continue;
+        DWORD pid = static_cast<DWORD>(std::stoul(name));
+        if (ProcessSource::Native().Open(pid, path, handle)) pids.push_back(pid);
+        ProcessSource::Native().Close(handle);
+        if (pids.size() == 50) break;
+    }
+    REQUIRE(!pids.empty());
+
+    const int windows = 500;
+    const int scans = 200;
+    std::vector<DWORD> table(windows);
+    for (int i = 0; i < windows; i++) table[i] = pids[i % pids.size()];
+
+    BenchTimer open;
+    for (int scan = 0; scan < scans; scan++) {
+        for (DWORD pid: table) {
+            ProcessSource::Native().Open(pid, path, handle);
+            ProcessSource::Native().Close(handle);
+        }
+    }
+    double openSeconds = open.Seconds();
+
+    ProcessCache cache(ProcessSource::Native());
+    for (DWORD pid: table) cache.ImagePath(pid, path);
+    uint64_t before = TestAllocations();
+    BenchTimer cached;
+    for (int scan = 0; scan < scans; scan++) {
+        for (DWORD pid: table) cache.ImagePath(pid, path);
+    }
+    double cachedSeconds = cached.Seconds();
+
+    std::printf("    %zu processes\n", pids.size());
+    BenchReport("open every window (before)", openSeconds / scans * 1e6, "us/scan");
+    BenchReport("ImagePath every window (after)", cachedSeconds / scans * 1e6, "us/scan");
+    BenchReport("speedup", openSeconds / cachedSeconds, "x");
+    BenchReport("allocations in warm scans", double(TestAllocations() - before), "");
+}
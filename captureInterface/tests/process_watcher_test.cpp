@@ -0,0 +1,97 @@
+#include "test.h"
+#include "process_watcher.h"
+
+#include <csignal>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// a child that runs sleep for a few seconds, killed and reaped at the end
+class Child {
+
+public:
+    pid_t pid = -1;
+
+    Child(){
+        this->pid = fork();
+        if (this->pid == 0) {
+            execl("/bin/sleep", "sleep", "5", (char*)nullptr);
+            _exit(127);
+        }
+    }
+
+    ~Child(){
+        if (this->pid <= 0) return;
+        kill(this->pid, SIGKILL);
+        waitpid(this->pid, nullptr, 0);
+    }
+};
+
+// next start reported for pid, skipping whatever else the machine starts
+static bool waitFor(ProcessWatcher& watcher, DWORD pid){
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (std::chrono::steady_clock::now() < deadline) {
+        DWORD started;
+        ProcessWatchResult res = watcher.Next(started, std::chrono::milliseconds(500));
+        if (res == PROC_FAILED) return false;
+        if (res == PROC_STARTED && started == pid) return true;
+    }
+    return false;
+}
+
+TEST(process_watcher, reports_a_started_process){
+    ProcessWatcher& watcher = ProcessWatcher::Native();
+    REQUIRE(watcher.Open());
+
+    Child child;
+    REQUIRE(child.pid > 0);
+    CHECK(waitFor(watcher, static_cast<DWORD>(child.pid)));
+
+    // only once
+    DWORD pid;
+    while (watcher.Next(pid, std::chrono::milliseconds(300)) == PROC_STARTED) {
+        CHECK(pid != static_cast<DWORD>(child.pid));
+    }
+    watcher.Close();
+}
+
+TEST(process_watcher, processes_running_before_open_are_not_reported){
+    Child child;
+    REQUIRE(child.pid > 0);
+    // the child has exec'd sleep before the watcher looks
+    usleep(50000);
+
+    ProcessWatcher& watcher = ProcessWatcher::Native();
+    REQUIRE(watcher.Open());
+    CHECK(!waitFor(watcher, static_cast<DWORD>(child.pid)));
+    watcher.Close();
+}
+
+TEST(process_watcher, detects_a_launched_game_before_its_window){
+    GAMERULES.Compile({ GameRule{ RULE_EXE, "sleep", 0.9f, false } });
+    ProcessCache cache(ProcessSource::Native());
+    LaunchDetector detector(cache, GAMERULES);
+
+    ProcessWatcher& watcher = ProcessWatcher::Native();
+    REQUIRE(watcher.Open());
+    Child child;
+    REQUIRE(child.pid > 0);
+    REQUIRE(waitFor(watcher, static_cast<DWORD>(child.pid)));
+    watcher.Close();
+
+    // exec may not have happened yet when the pid is first seen
+    bool game = false;
+    for (int i = 0; i < 50 && !game; i++) {
+        game = detector.Check(static_cast<DWORD>(child.pid));
+        if (!game) usleep(10000);
+    }
+    CHECK(game);
+    CHECK(detector.Path().ends_with("/sleep"));
+    CHECK(detector.Match().confidence == 0.9f);
+    // kept for its window
+    CHECK(cache.Size() == 1);
+
+    // this process isn't a game and isn't kept
+    CHECK(!detector.Check(static_cast<DWORD>(getpid())));
+    CHECK(cache.Size() == 1);
+}
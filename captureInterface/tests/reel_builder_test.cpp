@@ -0,0 +1,105 @@
+#include "test.h"
+#include "clip_sidecar.h"
+#include "reel_builder.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const int64_t SECOND = 1000000;
+
+// writes the sidecar of a minute long clip with a keyframe every 2 seconds,
+// the video itself is never read when planning
+static std::string writeClip(const std::string& name, int64_t timestamp, std::vector<ClipSidecarMarker> markers){
+    ClipMetadata m;
+    m.timestamp = timestamp;
+    m.durationMs = 60000;
+    m.fps = 60;
+    for (int64_t t = 0; t < 60 * SECOND; t += 2 * SECOND) m.keyframes.push_back(ClipSidecarKeyframe{ t, uint64_t(t / 1000) });
+    m.markers = std::move(markers);
+
+    std::string video = (fs::current_path() / name).string();
+    CHECK(ClipSidecar::Write(ClipSidecar::PathFor(video), m));
+    return video;
+}
+
+static ClipSidecarMarker marker(int64_t time, float score){
+    return ClipSidecarMarker{ .time = time, .durationMs = 0, .kind = MARKER_AUDIO, .score = score, .reserved = 0 };
+}
+
+// the best three moments of two clips, the older clip's first
+static ReelBuilder twoClips(bool precise){
+    std::string a = writeClip("reel_a.mp4", 200, {
+        marker(10500000, 0.9f), marker(11 * SECOND, 0.5f), marker(40300000, 0.2f), marker(50 * SECOND, 0.8f),
+    });
+    std::string b = writeClip("reel_b.mp4", 100, { marker(1 * SECOND, 0.7f) });
+
+    ReelBuilder builder(ReelOptions{ .count = 3, .precise = precise });
+    CHECK(builder.AddClip(a));
+    CHECK(builder.AddClip(b));
+    return builder;
+}
+
+TEST(reel_builder, plans_keyframe_cuts){
+    std::vector<ReelSegment> segments = twoClips(false).Plan();
+    REQUIRE(segments.size() == 3);
+
+    CHECK(fs::path(segments[0].path).filename() == "reel_b.mp4");
+    CHECK(segments[0].start == 0 && segments[0].end == 3 * SECOND);
+    // the two close markers are one moment, widened to the keyframe before
+    CHECK(fs::path(segments[1].path).filename() == "reel_a.mp4");
+    CHECK(segments[1].start == 6 * SECOND && segments[1].end == 13 * SECOND);
+    CHECK(segments[1].score == 0.9f);
+    CHECK(segments[2].start == 46 * SECOND && segments[2].end == 52 * SECOND);
+    for (const ReelSegment& s: segments) CHECK(s.copyFrom == s.start && s.keyframe == s.start);
+}
+
+TEST(reel_builder, plans_precise_cuts){
+    std::vector<ReelSegment> segments = twoClips(true).Plan();
+    REQUIRE(segments.size() == 3);
+
+    // on a keyframe already, nothing to re-encode
+    CHECK(segments[0].start == 0 && segments[0].copyFrom == 0);
+    // re-encoded up to the next keyframe, the keyframe before is the fallback
+    CHECK(segments[1].start == 6500000);
+    CHECK(segments[1].copyFrom == 8 * SECOND);
+    CHECK(segments[1].keyframe == 6 * SECOND);
+    CHECK(segments[2].start == 46 * SECOND && segments[2].copyFrom == 46 * SECOND);
+}
+
+TEST(reel_builder, snapping_merges_neighbours){
+    std::string clip = writeClip("reel_merge.mp4", 100, { marker(10 * SECOND, 0.5f), marker(16500000, 0.6f) });
+
+    ReelBuilder keyframes(ReelOptions{});
+    REQUIRE(keyframes.AddClip(clip));
+    std::vector<ReelSegment> segments = keyframes.Plan();
+    REQUIRE(segments.size() == 1);
+    CHECK(segments[0].start == 6 * SECOND && segments[0].end == 18500000);
+    CHECK(segments[0].score == 0.6f);
+
+    // precise cuts don't move back, so they stay apart
+    ReelBuilder precise(ReelOptions{ .precise = true });
+    REQUIRE(precise.AddClip(clip));
+    segments = precise.Plan();
+    REQUIRE(segments.size() == 2);
+    CHECK(segments[1].start == 12500000 && segments[1].copyFrom == 14 * SECOND && segments[1].keyframe == 12 * SECOND);
+}
+
+TEST(reel_builder, clips_without_sidecar_are_skipped){
+    ReelBuilder builder(ReelOptions{});
+    CHECK(!builder.AddClip("reel_missing.mp4"));
+    CHECK(builder.Plan().empty());
+}
+
+TEST(reel_builder, finds_parameter_sets){
+    // four and three byte start codes, the SPS (7), PPS (8) and an IDR slice
+    std::string annexB("\0\0\0\1\x67\x64\x00\x28\0\0\1\x68\xee\x3c\x80\0\0\0\1\x65\x88\x84", 22);
+    H264ParameterSets sets = FindParameterSets(annexB);
+    CHECK(sets.sps == std::string("\x67\x64\x00\x28", 4));
+    CHECK(sets.pps == std::string("\x68\xee\x3c\x80", 4));
+
+    CHECK(FindParameterSets(std::string("\0\0\1\x65\x88", 5)).sps.empty());
+    CHECK(FindParameterSets("").pps.empty());
+}
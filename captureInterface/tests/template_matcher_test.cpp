@@ -0,0 +1,120 @@
+#include "test.h"
+#include "template_matcher.h"
+
+#include <random>
+
+// soft blobs over a little noise, like a game frame the NCC has something to
+// lock on to at both scales
+static void scene(LumaImage& image, uint32_t width, uint32_t height, uint32_t seed){
+    std::mt19937 rng(seed);
+    image.Resize(width, height);
+    std::vector<uint8_t> cells(std::size_t(width / 16 + 2) * (height / 16 + 2));
+    for (uint8_t& c: cells) c = static_cast<uint8_t>(rng() % 200);
+    const uint32_t cellsWide = width / 16 + 2;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            // bilinear between the 16 pixel cells
+            uint32_t cx = x / 16, cy = y / 16, fx = x % 16, fy = y % 16;
+            uint32_t a = cells[cy * cellsWide + cx], b = cells[cy * cellsWide + cx + 1];
+            uint32_t c = cells[(cy + 1) * cellsWide + cx], d = cells[(cy + 1) * cellsWide + cx + 1];
+            uint32_t v = (a * (16 - fx) * (16 - fy) + b * fx * (16 - fy) + c * (16 - fx) * fy + d * fx * fy) / 256;
+            image.Row(y)[x] = static_cast<uint8_t>(v + rng() % 16);
+        }
+    }
+}
+
+static void cut(const LumaImage& image, uint32_t x, uint32_t y, uint32_t w, uint32_t h, LumaImage& out){
+    out.Resize(w, h);
+    for (uint32_t row = 0; row < h; row++) {
+        for (uint32_t col = 0; col < w; col++) out.Row(row)[col] = image.Row(y + row)[x + col];
+    }
+}
+
+// the full and the 1/4 scale template, like TemplateMatcher::Load builds them
+static void prepare(const LumaImage& pixels, NccTemplate& full, NccTemplate& coarse){
+    LumaImage small;
+    small.Resize(pixels.width / 4, pixels.height / 4);
+    for (uint32_t y = 0; y < small.height; y++) {
+        for (uint32_t x = 0; x < small.width; x++) {
+            uint32_t sum = 0;
+            for (uint32_t dy = 0; dy < 4; dy++) {
+                for (uint32_t dx = 0; dx < 4; dx++) sum += pixels.Row(y * 4 + dy)[x * 4 + dx];
+            }
+            small.Row(y)[x] = static_cast<uint8_t>(sum / 16);
+        }
+    }
+    full.Build(pixels);
+    coarse.Build(small);
+}
+
+TEST(template_matcher, finds_a_cut_out_template){
+    LumaImage region;
+    scene(region, 480, 216, 1);
+    // on and off the coarse grid
+    const uint32_t spots[][2] = { {100, 60}, {301, 147}, {0, 0}, {440, 176} };
+    for (const auto& spot: spots) {
+        LumaImage pixels;
+        cut(region, spot[0], spot[1], 40, 40, pixels);
+        NccTemplate full, coarse;
+        prepare(pixels, full, coarse);
+
+        MatchResult match = MatchTemplate(region, full, coarse, 0.8f);
+        CHECK(match.x == spot[0] && match.y == spot[1]);
+        CHECK(match.score > 0.99f);
+    }
+}
+
+TEST(template_matcher, rejects_a_template_from_elsewhere){
+    LumaImage region, other;
+    scene(region, 480, 216, 2);
+    scene(other, 480, 216, 3);
+    LumaImage pixels;
+    cut(other, 200, 100, 40, 40, pixels);
+    NccTemplate full, coarse;
+    prepare(pixels, full, coarse);
+
+    CHECK(MatchTemplate(region, full, coarse, 0.8f).score < 0.8f);
+}
+
+TEST(template_matcher, small_templates_are_searched_directly){
+    LumaImage region;
+    scene(region, 120, 80, 4);
+    LumaImage pixels;
+    cut(region, 33, 21, 12, 12, pixels);
+    NccTemplate full, coarse;
+    prepare(pixels, full, coarse);
+    REQUIRE(coarse.width < 4);
+
+    MatchResult match = MatchTemplate(region, full, coarse, 0.8f);
+    CHECK(match.x == 33 && match.y == 21);
+}
+
+BENCH(template_matcher){
+    // a 1080p frame, the kill feed region from data/templates.txt (a
+    // quarter of the width, a fifth of the height) and the whole frame
+    LumaImage frame;
+    scene(frame, 1920, 1080, 5);
+    LumaImage region;
+    cut(frame, 1440, 0, 480, 216, region);
+
+    LumaImage pixels;
+    cut(region, 301, 147, 40, 40, pixels);
+    NccTemplate full, coarse;
+    prepare(pixels, full, coarse);
+
+    const int RUNS = 500;
+    BenchTimer timer;
+    float score = 0.0f;
+    for (int i = 0; i < RUNS; i++) score += MatchTemplate(region, full, coarse, 0.85f).score;
+    BenchReport("40x40 in a 480x216 region", RUNS / timer.Seconds(), "matches/s");
+    CHECK(score > 0.99f * RUNS);
+
+    cut(frame, 1001, 603, 64, 64, pixels);
+    prepare(pixels, full, coarse);
+    const int FRAMES = 20;
+    BenchTimer whole;
+    score = 0.0f;
+    for (int i = 0; i < FRAMES; i++) score += MatchTemplate(frame, full, coarse, 0.85f).score;
+    BenchReport("64x64 in a whole 1920x1080 frame", FRAMES / whole.Seconds(), "matches/s");
+    CHECK(score > 0.99f * FRAMES);
+}
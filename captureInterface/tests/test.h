@@ -0,0 +1,67 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Minimal test and benchmark registry for macroscaleTests, see main.cpp.
+//
+//     TEST(suite, name){ CHECK(a == b); }
+//     BENCH(name){ BenchTimer timer; ...; BenchReport("things", n / timer.Seconds(), "/s"); }
+//
+// A suite is one file, ctest runs each suite on its own. Benchmarks only run
+// with --bench.
+
+struct TestCase {
+    const char* suite;
+    const char* name;
+    void (*run)();
+    bool bench;
+};
+
+std::vector<TestCase>& TestCases();
+// records a failed check, the test keeps running
+void TestFail(const char* file, int line, const char* expr);
+// calls to operator new made by the calling thread so far
+uint64_t TestAllocations();
+
+struct TestRegistrar {
+    TestRegistrar(const char* suite, const char* name, void (*run)(), bool bench){
+        TestCases().push_back({suite, name, run, bench});
+    }
+};
+
+#define TEST(suite, name) \
+    static void suite##_##name(); \
+    static TestRegistrar suite##_##name##_registrar(#suite, #name, suite##_##name, false); \
+    static void suite##_##name()
+
+#define BENCH(name) \
+    static void bench_##name(); \
+    static TestRegistrar bench_##name##_registrar("bench", #name, bench_##name, true); \
+    static void bench_##name()
+
+#define CHECK(cond) do { if (!(cond)) TestFail(__FILE__, __LINE__, #cond); } while (0)
+// stops the test, for checks the rest of it depends on
+#define REQUIRE(cond) do { if (!(cond)) { TestFail(__FILE__, __LINE__, #cond); return; } } while (0)
+
+class BenchTimer {
+
+public:
+    BenchTimer(): start(std::chrono::steady_clock::now()) {};
+
+    double Seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+inline void BenchReport(const char* what, double value, const char* unit){
+    std::printf("    %-40s %14.2f %s\n", what, value, unit);
+}
+
+#endif
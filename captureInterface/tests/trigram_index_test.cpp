@@ -0,0 +1,189 @@
+#include "test.h"
+#include "trigram_index.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// the index's trigrams spelled out: every word padded with a space on both
+// sides, a query's words only at the front since the last one may not be
+// finished
+static std::set<std::string> naiveTrigrams(const std::string& text, bool query){
+    std::set<std::string> grams;
+    std::string word;
+    auto flush = [&]() {
+        if (word.empty()) return;
+        std::string padded = " " + word + (query ? "" : " ");
+        for (std::size_t i = 0; i + 3 <= padded.size(); i++) grams.insert(padded.substr(i, 3));
+        word.clear();
+    };
+    for (char c: text) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+        bool keep = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || static_cast<uint8_t>(c) >= 0x80;
+        if (keep) word += c;
+        else flush();
+    }
+    flush();
+    return grams;
+}
+
+struct Doc {
+    uint64_t id;
+    std::set<std::string> grams;
+    bool live;
+};
+
+// ids of the live documents with every query trigram, newest first
+static std::vector<uint64_t> naiveSearch(const std::vector<Doc>& docs, const std::string& query, std::size_t limit){
+    std::set<std::string> want = naiveTrigrams(query, true);
+    std::vector<uint64_t> ids;
+    for (auto it = docs.rbegin(); it != docs.rend() && ids.size() < limit; ++it) {
+        if (it->live && std::includes(it->grams.begin(), it->grams.end(), want.begin(), want.end())) ids.push_back(it->id);
+    }
+    return ids;
+}
+
+static std::vector<std::string> makeWords(int count, std::mt19937& rng){
+    std::vector<std::string> words;
+    for (int i = 0; i < count; i++) {
+        std::string word;
+        int length = 3 + rng() % 6;
+        for (int j = 0; j < length; j++) word += char('a' + rng() % 12);
+        words.push_back(word);
+    }
+    return words;
+}
+
+// the exact hits of a search, the ones carrying every query trigram
+static std::vector<uint64_t> exactHits(const TrigramIndex& index, const std::string& query, std::size_t limit){
+    std::size_t full = naiveTrigrams(query, true).size();
+    std::vector<uint64_t> ids;
+    for (const SearchHit& hit: index.Search(query, limit)) {
+        if (hit.matched == full) ids.push_back(hit.id);
+    }
+    return ids;
+}
+
+static void checkQueries(const TrigramIndex& index, const std::vector<Doc>& docs, const std::vector<std::string>& words, std::mt19937& rng){
+    for (int i = 0; i < 300; i++) {
+        std::string query = words[rng() % words.size()];
+        // a prefix still being typed, or two words
+        if (i % 3 == 1) query = query.substr(0, 2 + rng() % (query.size() - 1));
+        if (i % 3 == 2) query += " " + words[rng() % words.size()];
+        std::size_t limit = 1 + rng() % 60;
+        CHECK(exactHits(index, query, limit) == naiveSearch(docs, query, limit));
+    }
+}
+
+TEST(trigram_index, exact_search_matches_a_naive_scan){
+    std::mt19937 rng(7);
+    std::vector<std::string> words = makeWords(400, rng);
+    TrigramIndex index;
+    std::vector<Doc> docs;
+    for (uint64_t id = 1; id <= 20000; id++) {
+        std::string text = words[rng() % words.size()] + " " + words[rng() % words.size()] + "-" + words[rng() % words.size()];
+        index.Add(id, text);
+        docs.push_back(Doc{ id, naiveTrigrams(text, false), true });
+    }
+    CHECK(index.Size() == docs.size());
+    checkQueries(index, docs, words, rng);
+}
+
+TEST(trigram_index, fuzzy_hits_share_half_of_the_trigrams){
+    TrigramIndex index;
+    index.Add(1, "Rocket jump");
+    index.Add(2, "Grenade bounce");
+    index.Add(3, "rocket arena");
+
+    // 4 of the 6 trigrams of "rockeet" are in "rocket"
+    std::vector<SearchHit> hits = index.Search("rockeet", 10);
+    REQUIRE(hits.size() == 2);
+    // newest first within the same count
+    CHECK(hits[0].id == 3);
+    CHECK(hits[1].id == 1);
+    CHECK(hits[0].matched == 4);
+    CHECK(index.Search("grenade", 10).size() == 1);
+}
+
+TEST(trigram_index, compacts_removed_documents){
+    std::mt19937 rng(11);
+    std::vector<std::string> words = makeWords(400, rng);
+    TrigramIndex index;
+    std::vector<Doc> docs;
+    for (uint64_t id = 1; id <= 20000; id++) {
+        std::string text = words[rng() % words.size()] + " " + words[rng() % words.size()];
+        index.Add(id, text);
+        docs.push_back(Doc{ id, naiveTrigrams(text, false), true });
+    }
+    std::size_t before = index.PostingBytes();
+
+    // three in four removed
+    for (Doc& doc: docs) {
+        if (doc.id % 4 == 0) continue;
+        index.Remove(doc.id);
+        doc.live = false;
+    }
+    // a retag moves the document to the end
+    index.Add(4, "retagged " + words[0]);
+    docs[3].live = false;
+    docs.push_back(Doc{ 4, naiveTrigrams("retagged " + words[0], false), true });
+    CHECK(index.Size() == 5000);
+    // compacted once the tombstones outnumbered the live documents
+    CHECK(index.PostingBytes() < before / 2);
+    checkQueries(index, docs, words, rng);
+    CHECK(index.Search("retagged", 10).size() == 1);
+    CHECK(index.Search("retagged", 10)[0].id == 4);
+
+    // everything removed, nothing left to find
+    for (Doc& doc: docs) {
+        if (doc.live) index.Remove(doc.id);
+    }
+    CHECK(index.Size() == 0);
+    CHECK(index.Search(words[1], 10).empty());
+}
+
+BENCH(trigram_search){
+    const uint64_t DOCS = 1000000;
+    std::mt19937 rng(3);
+    std::vector<std::string> words = makeWords(20000, rng);
+    TrigramIndex index;
+    BenchTimer build;
+    for (uint64_t id = 1; id <= DOCS; id++) {
+        index.Add(id, words[rng() % words.size()] + " " + words[rng() % words.size()] + " " + words[rng() % words.size()]);
+    }
+    BenchReport("indexed documents", DOCS / build.Seconds(), "/s");
+    BenchReport("posting bytes", index.PostingBytes() / 1e6, "MB");
+
+    const int QUERIES = 200;
+    std::vector<std::string> exact, misspelled;
+    for (int i = 0; i < QUERIES; i++) {
+        std::string word = words[rng() % words.size()];
+        exact.push_back(word);
+        std::swap(word[1], word[2]);
+        misspelled.push_back(word);
+    }
+
+    std::size_t hits = 0;
+    BenchTimer timer;
+    for (const std::string& query: exact) hits += index.Search(query, 20).size();
+    BenchReport("exact word, 20 results", timer.Seconds() / QUERIES * 1e6, "us");
+
+    BenchTimer fuzzy;
+    for (const std::string& query: misspelled) hits += index.Search(query, 20).size();
+    BenchReport("misspelled word, 20 results", fuzzy.Seconds() / QUERIES * 1e6, "us");
+    CHECK(hits > 0);
+
+    // removing 60% triggers one compaction along the way
+    BenchTimer removal;
+    for (uint64_t id = 1; id <= DOCS; id++) {
+        if (id % 5 < 3) index.Remove(id);
+    }
+    BenchReport("removing 600k, compaction included", removal.Seconds() * 1000.0, "ms");
+    BenchReport("posting bytes after", index.PostingBytes() / 1e6, "MB");
+
+    BenchTimer after;
+    for (const std::string& query: exact) hits += index.Search(query, 20).size();
+    BenchReport("exact word after removal", after.Seconds() / QUERIES * 1e6, "us");
+}
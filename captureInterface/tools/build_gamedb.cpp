@@ -0,0 +1,232 @@
+// Builds the known games database (games.db) from a CSV file.
+//
+//     buildGameDb <games.csv> <games.db>
+//
+// CSV columns: key,title,game_id,profile. key is an executable name or hex
+// executable hash, game_id a number and profile the name of the default
+// capture profile (may be empty). Fields can be quoted with '"'. A first line
+// starting with "key," is treated as the header.
+//
+// Only depends on the standard library so it can also be built natively:
+//     g++ -std=c++20 -Iinclude tools/build_gamedb.cpp -o buildGameDb
+
+#include "game_db_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Row {
+    std::string key;
+    std::string title;
+    uint32_t gameId;
+    std::string profile;
+};
+
+// splits one CSV line, returns false on an unterminated quote
+static bool splitCsv(const std::string& line, std::vector<std::string>& fields){
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+
+    for (std::size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(std::move(field));
+    return !quoted;
+}
+
+static bool readCsv(const char* filename, std::vector<Row>& rows){
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "unable to open " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::vector<std::string> fields;
+    int lineNo = 0;
+
+    while (std::getline(file, line)) {
+        lineNo++;
+        if (line.empty() || line == "\r") continue;
+        if (lineNo == 1 && line.rfind("key,", 0) == 0) continue;
+
+        if (!splitCsv(line, fields) || fields.size() != 4) {
+            std::cerr << filename << ":" << lineNo << ": expected 4 fields" << std::endl;
+            return false;
+        }
+
+        Row row;
+        row.key = fields[0];
+        std::transform(row.key.begin(), row.key.end(), row.key.begin(), [](char c) {
+            return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+        });
+        row.title = fields[1];
+        row.profile = fields[3];
+
+        char* end;
+        row.gameId = std::strtoul(fields[2].c_str(), &end, 10);
+        if (row.key.empty() || fields[2].empty() || *end != '\0') {
+            std::cerr << filename << ":" << lineNo << ": invalid key or game_id" << std::endl;
+            return false;
+        }
+
+        rows.push_back(std::move(row));
+    }
+
+    return true;
+}
+
+// hash and displace: keys are grouped into buckets, then starting with the
+// largest bucket a seed is searched that sends every key of the bucket to a
+// free slot
+static bool buildPerfectHash(const std::vector<Row>& rows, uint32_t bucketCount, uint32_t slotCount, 
+        std::vector<uint32_t>& seeds, std::vector<uint32_t>& slots){
+    std::vector<uint64_t> hashes(rows.size());
+    std::vector<std::vector<uint32_t>> buckets(bucketCount);
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        hashes[i] = GameDbHash(rows[i].key);
+        buckets[hashes[i] % bucketCount].push_back(i);
+    }
+
+    std::vector<uint32_t> order(bucketCount);
+    for (uint32_t b = 0; b < bucketCount; b++) order[b] = b;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    seeds.assign(bucketCount, 0);
+    slots.assign(slotCount, GAMEDB_EMPTY_SLOT);
+    std::vector<uint32_t> taken;
+
+    for (uint32_t b: order) {
+        const std::vector<uint32_t>& keys = buckets[b];
+        if (keys.empty()) break;
+
+        bool placed = false;
+        for (uint32_t seed = 0; seed < (1u << 24) && !placed; seed++) {
+            taken.clear();
+            placed = true;
+            for (uint32_t k: keys) {
+                uint32_t slot = GameDbSlot(hashes[k], seed, slotCount);
+                if (slots[slot] != GAMEDB_EMPTY_SLOT || 
+                    std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+                    placed = false;
+                    break;
+                }
+                taken.push_back(slot);
+            }
+            if (placed) {
+                seeds[b] = seed;
+                for (std::size_t i = 0; i < keys.size(); i++) slots[taken[i]] = keys[i];
+            }
+        }
+
+        if (!placed) return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv){
+    if (argc != 3) {
+        std::cerr << "usage: buildGameDb <games.csv> <games.db>" << std::endl;
+        return 1;
+    }
+
+    std::vector<Row> rows;
+    if (!readCsv(argv[1], rows)) return 1;
+
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.key < b.key; });
+    for (std::size_t i = 1; i < rows.size(); i++) {
+        if (rows[i].key == rows[i - 1].key) {
+            std::cerr << "duplicate key " << rows[i].key << std::endl;
+            return 1;
+        }
+    }
+
+    const uint32_t count = rows.size();
+    const uint32_t bucketCount = std::max(1u, (count + 3) / 4);
+    const uint32_t slotCount = std::max(1u, count + count / 8);
+
+    std::vector<uint32_t> seeds, slots;
+    if (!buildPerfectHash(rows, bucketCount, slotCount, seeds, slots)) {
+        std::cerr << "unable to find a perfect hash for " << count << " keys" << std::endl;
+        return 1;
+    }
+
+    // string pool, profile names are shared between records
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> profileOffsets;
+    std::vector<GameDbRecord> records(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const Row& row = rows[i];
+        GameDbRecord& rec = records[i];
+
+        rec.keyOffset = strings.size();
+        rec.keyLength = row.key.size();
+        strings += row.key;
+
+        rec.titleOffset = strings.size();
+        rec.titleLength = row.title.size();
+        strings += row.title;
+
+        auto [it, inserted] = profileOffsets.try_emplace(row.profile, strings.size());
+        if (inserted) strings += row.profile;
+        rec.profileOffset = it->second;
+        rec.profileLength = row.profile.size();
+
+        rec.gameId = row.gameId;
+    }
+
+    GameDbHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = GAMEDB_MAGIC;
+    header.version = GAMEDB_VERSION;
+    header.recordCount = count;
+    header.bucketCount = bucketCount;
+    header.slotCount = slotCount;
+    header.seedsOffset = sizeof(GameDbHeader);
+    header.slotsOffset = header.seedsOffset + bucketCount * sizeof(uint32_t);
+    header.recordsOffset = header.slotsOffset + slotCount * sizeof(uint32_t);
+    header.stringsOffset = header.recordsOffset + count * sizeof(GameDbRecord);
+    header.stringsSize = strings.size();
+
+    std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(seeds.data()), seeds.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(GameDbRecord));
+    out.write(strings.data(), strings.size());
+    out.close();
+
+    if (!out.good()) {
+        std::cerr << "unable to write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "wrote " << count << " games to " << argv[2] << std::endl;
+    return 0;
+}
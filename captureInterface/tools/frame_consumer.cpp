@@ -0,0 +1,84 @@
+// Reference consumer of the shared memory frame ring, prints what it sees
+// once a second.
+//
+//     frameConsumer [name]
+//
+// name defaults to FRAME_RING_MAPPING on windows and FRAME_RING_SHM
+// elsewhere. With the capture interface running under wine and
+// frames.file = Z:\dev\shm\macroscale_frames in config.ini, the native
+// linux build (native/CMakeLists.txt) reads the same ring:
+//     ./frameConsumer /macroscale_frames
+
+#include "frame_client.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <thread>
+
+static volatile std::sig_atomic_t running = 1;
+
+static void onSignal(int){
+    running = 0;
+}
+
+// mean luma of a BGRA frame, stands in for real analysis
+static double meanLuma(const FrameView& frame){
+    uint64_t sum = 0;
+    for (uint32_t y = 0; y < frame.height; y++) {
+        const uint8_t* row = frame.pixels + std::size_t(y) * frame.stride;
+        for (uint32_t x = 0; x < frame.width; x++) {
+            sum += (row[4 * x + 2] * 77u + row[4 * x + 1] * 150u + row[4 * x] * 29u) >> 8;
+        }
+    }
+    return double(sum) / (double(frame.width) * frame.height);
+}
+
+int main(int argc, char** argv){
+#ifdef _WIN32
+    const char* name = argc > 1 ? argv[1] : FRAME_RING_MAPPING;
+#else
+    const char* name = argc > 1 ? argv[1] : FRAME_RING_SHM;
+#endif
+    std::signal(SIGINT, onSignal);
+
+    FrameRingReader reader;
+    while (running && !reader.Open(name)) {
+        std::fprintf(stderr, "waiting for frame ring %s\n", name);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    uint64_t last = 0;
+    uint64_t frames = 0, skipped = 0, torn = 0;
+    double luma = 0.0;
+    FrameView frame;
+    auto reportAt = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+    while (running) {
+        if (reader.Next(last, frame)) {
+            // frames published while we were busy, newest wins
+            if (last != 0 && frame.number > last + 1) skipped += frame.number - last - 1;
+            last = frame.number;
+
+            double value = meanLuma(frame);
+            if (reader.StillValid(frame)) {
+                frames++;
+                luma = value;
+            } else {
+                torn++;
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        if (std::chrono::steady_clock::now() >= reportAt) {
+            std::printf("frame %llu %ux%u (from %ux%u) motion %.2f luma %.1f | %llu fps, %llu skipped, %llu torn\n",
+                static_cast<unsigned long long>(last), frame.width, frame.height, frame.sourceWidth, frame.sourceHeight,
+                frame.motion, luma, static_cast<unsigned long long>(frames),
+                static_cast<unsigned long long>(skipped), static_cast<unsigned long long>(torn));
+            frames = skipped = torn = 0;
+            reportAt += std::chrono::seconds(1);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Measures the local API's round trip latency and pipelined throughput with
+// pings, which the server answers without touching the rest of the capture
+// interface.
+//
+//     ipcBench [name] [count] [payload bytes]
+//
+// name defaults to IPC_DEFAULT_NAME.
+
+#include "ipc_client.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// requests in flight during the throughput run
+static const uint32_t WINDOW = 64;
+
+static double micros(Clock::duration d){
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+int main(int argc, char** argv){
+    const char* name = argc > 1 ? argv[1] : IPC_DEFAULT_NAME;
+    uint32_t count = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 100000;
+    std::size_t size = argc > 3 ? static_cast<std::size_t>(std::atoi(argv[3])) : 64;
+    if (count == 0) count = 1;
+
+    IpcClient client;
+    if (!client.Connect(name)) {
+        std::fprintf(stderr, "unable to connect to %s\n", name);
+        return 1;
+    }
+
+    std::string payload(size, 'x');
+    IpcMessage msg;
+
+    // one request at a time
+    std::vector<double> latencies;
+    latencies.reserve(count / 10 + 1);
+    for (uint32_t i = 0; i < count / 10 + 1; i++) {
+        Clock::time_point start = Clock::now();
+        if (!client.Call(IPC_PING, payload, msg) || msg.payload.size() != size) {
+            std::fprintf(stderr, "ping failed\n");
+            return 1;
+        }
+        latencies.push_back(micros(Clock::now() - start));
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("round trip: p50 %.1f us, p99 %.1f us, max %.1f us (%zu pings)\n",
+        latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back(), latencies.size());
+
+    // WINDOW requests in flight, topped up as responses arrive
+    Clock::time_point start = Clock::now();
+    uint32_t sent = 0, received = 0, first = 0;
+    while (received < count) {
+        uint32_t batch = std::min(count - sent, WINDOW - (sent - received));
+        for (uint32_t i = 0; i < batch; i++) {
+            uint32_t id = client.Queue(IPC_PING, payload);
+            if (first == 0) first = id;
+        }
+        if (batch > 0 && !client.Flush()) break;
+        sent += batch;
+
+        if (!client.Receive(msg)) break;
+        // responses come back in request order
+        if (msg.header.id != 0 && msg.header.id != first + received) {
+            std::fprintf(stderr, "response %u out of order\n", msg.header.id);
+            return 1;
+        }
+        if (msg.header.id != 0) received++;
+    }
+    double seconds = micros(Clock::now() - start) / 1000000.0;
+    if (received < count) {
+        std::fprintf(stderr, "connection closed after %u responses\n", received);
+        return 1;
+    }
+    double bytes = double(count) * 2 * (sizeof(uint32_t) + sizeof(IpcHeader) + size);
+    std::printf("pipelined: %.0f requests/s, %.1f MB/s both ways (%u pings, window %u)\n",
+        count / seconds, bytes / seconds / 1e6, count, WINDOW);
+    return 0;
+}